@@ -0,0 +1,292 @@
+#include "assembler.h"
+#include <QRegularExpression>
+#include <algorithm>
+#include <climits>
+
+void Assembler::parseLine(const QString& text) {
+    if (!parseCache.contains(text)) {
+        parseCache.insert(text, parseSourceLine(text));
+    }
+}
+
+Assembler::SourceLine Assembler::parseSourceLine(const QString& text) {
+    SourceLine line;
+    QString code = text.trimmed();
+    if (code.isEmpty() || code.startsWith(';')) return line;
+
+    static const QRegularExpression labelRe("^([A-Za-z_.@$?][\\w.@$?]*):\\s*(.*)$");
+    QRegularExpressionMatch labelMatch = labelRe.match(code);
+    if (labelMatch.hasMatch()) {
+        line.label = labelMatch.captured(1).toUpper();
+        code = labelMatch.captured(2);
+    }
+
+    static const QRegularExpression equRe("^([A-Za-z_.@$?][\\w.@$?]*)\\s+EQU\\s+(.+)$", QRegularExpression::CaseInsensitiveOption);
+    QRegularExpressionMatch equMatch = equRe.match(code);
+    if (equMatch.hasMatch()) {
+        line.constant = equMatch.captured(1).toUpper();
+        line.constantValue = equMatch.captured(2).section(';', 0, 0).trimmed().toUpper();
+        return line;
+    }
+
+    static const QRegularExpression dataRe("^([A-Za-z_.@$?][\\w.@$?]*)\\s+(DB|DW)\\s+(.*)$", QRegularExpression::CaseInsensitiveOption);
+    QRegularExpressionMatch dataMatch = dataRe.match(code);
+    if (dataMatch.hasMatch() && line.label.isEmpty()) {
+        line.label = dataMatch.captured(1).toUpper();
+        code = dataMatch.captured(2) + " " + dataMatch.captured(3);
+    }
+
+    static const QRegularExpression orgRe("^ORG\\s+(\\S+)", QRegularExpression::CaseInsensitiveOption);
+    QRegularExpressionMatch orgMatch = orgRe.match(code);
+    if (orgMatch.hasMatch()) {
+        int value;
+        line.origin = ScriptParser::parseNumber(orgMatch.captured(1), value) ? value : DEFAULT_ORIGIN;
+        return line;
+    }
+
+    line.instruction = ScriptParser::parse(code);
+    for (const Operand& operand : line.instruction.operands) {
+        if (!operand.label.isEmpty() && operand.type != Operand::String) {
+            line.references.append(operand.label);
+        }
+    }
+    return line;
+}
+
+int AssemblyResult::lineForAddress(int address) const {
+    auto it = std::upper_bound(lines.begin(), lines.end(), address, [](int value, const AssembledLine& line) {
+        return value < line.address;
+    });
+    while (it != lines.begin()) {
+        --it;
+        if (address < it->address + it->bytes.size()) return int(it - lines.begin());
+        if (!it->bytes.isEmpty()) break;
+    }
+    return -1;
+}
+
+const AssemblyResult& Assembler::result() const {
+    return current;
+}
+
+const EncodedInstruction& Assembler::encodeLine(const QString& text, const SourceLine& line, int address,
+                                                bool longJump, const SymbolTable& symbols) {
+    QVector<int> symbolValues;
+    symbolValues.reserve(2 * line.references.size());
+    for (const QString& name : line.references) {
+        // The encoder rejects unknown symbols, takes undefined addresses as forward references and constants as immediates.
+        auto it = symbols.constFind(name);
+        if (it == symbols.constEnd()) {
+            symbolValues << INT_MIN << 0;
+        } else {
+            symbolValues << (it->defined ? it->value : INT_MIN) << (it->isAddress ? 1 : 2);
+        }
+    }
+
+    QHash<EncodingKey, CachedEncoding>& cache = longJump ? longEncodings : shortEncodings;
+    auto entry = cache.find({text, -1});
+    if (entry == cache.end() || entry->symbolValues != symbolValues) {
+        entry = cache.find({text, address});
+    }
+    if (entry == cache.end() || entry->symbolValues != symbolValues) {
+        EncodeOptions options;
+        options.symbols = &symbols;
+        options.longJump = longJump;
+        EncodedInstruction encoded = InstructionEncoder::encode(line.instruction, address, options);
+        entry = cache.insert({text, encoded.addressDependent ? address : -1}, {symbolValues, encoded});
+    }
+    return entry->encoded;
+}
+
+const AssemblyResult& Assembler::assemble(const QStringList& source) {
+    for (const QString& text : source) {
+        parseLine(text);
+    }
+    QVector<const SourceLine*> lines;
+    lines.reserve(source.size());
+    for (const QString& text : source) {
+        lines.append(&*parseCache.constFind(text));
+    }
+
+    AssemblyResult result;
+    for (int i = 0; i < lines.size(); ++i) {
+        const SourceLine& line = *lines[i];
+        QString name = !line.constant.isEmpty() ? line.constant : line.label;
+        if (name.isEmpty()) continue;
+        if (result.symbols.contains(name)) {
+            result.errors.append({i, tr("Symbol \"%1\" is already defined on line %2").arg(name).arg(result.symbols[name].line + 1)});
+            continue;
+        }
+        Symbol symbol;
+        symbol.isAddress = line.constant.isEmpty();
+        symbol.line = i;
+        result.symbols.insert(name, symbol);
+    }
+
+    bool progress = true;
+    while (progress) {
+        progress = false;
+        for (int i = 0; i < lines.size(); ++i) {
+            const SourceLine& line = *lines[i];
+            if (line.constant.isEmpty() || result.symbols[line.constant].defined || result.symbols[line.constant].line != i) continue;
+            int value;
+            if (ScriptParser::parseNumber(line.constantValue, value)) {
+                result.symbols[line.constant].value = value;
+                result.symbols[line.constant].defined = true;
+                progress = true;
+            } else if (result.symbols.contains(line.constantValue) && result.symbols[line.constantValue].defined) {
+                result.symbols[line.constant].value = result.symbols[line.constantValue].value;
+                result.symbols[line.constant].defined = true;
+                progress = true;
+            }
+        }
+    }
+    for (int i = 0; i < lines.size(); ++i) {
+        const SourceLine& line = *lines[i];
+        if (!line.constant.isEmpty() && result.symbols[line.constant].line == i && !result.symbols[line.constant].defined) {
+            result.errors.append({i, tr("Cannot evaluate constant \"%1\"").arg(line.constant)});
+        }
+    }
+
+    // Every line starts short so jumps whose targets came closer shrink again, the caches make the passes cheap.
+    QVector<bool> longJumps(lines.size(), false);
+
+    QVector<EncodedInstruction> encoded(lines.size());
+    for (int pass = 0; pass < MAX_RELAXATION_PASSES; ++pass) {
+        bool changed = false;
+        int address = DEFAULT_ORIGIN;
+        bool originSet = false;
+
+        for (int i = 0; i < lines.size(); ++i) {
+            const SourceLine& line = *lines[i];
+            if (line.origin >= 0) {
+                address = line.origin;
+                if (!originSet) result.origin = address;
+                originSet = true;
+            }
+            if (!line.label.isEmpty() && result.symbols[line.label].line == i) {
+                Symbol& symbol = result.symbols[line.label];
+                if (!symbol.defined || symbol.value != address) changed = true;
+                symbol.value = address;
+                symbol.defined = true;
+            }
+            if (line.instruction.mnemonic.isEmpty()) continue;
+            if (!originSet) {
+                result.origin = address;
+                originSet = true;
+            }
+
+            encoded[i] = encodeLine(source[i], line, address, longJumps[i], result.symbols);
+            if (encoded[i].needsLongJump) {
+                longJumps[i] = true;
+                changed = true;
+            }
+            address += encoded[i].bytes.size();
+        }
+        if (!changed) break;
+    }
+
+    int address = result.origin;
+    result.lines.resize(lines.size());
+    for (int i = 0; i < lines.size(); ++i) {
+        const SourceLine& line = *lines[i];
+        if (line.origin >= 0) {
+            if (line.origin < address && address > result.origin) {
+                result.errors.append({i, tr("ORG moves backwards over code already emitted")});
+            }
+            address = line.origin;
+        }
+        result.lines[i].address = address;
+        if (line.instruction.mnemonic.isEmpty()) continue;
+
+        if (!InstructionEncoder::isKnownMnemonic(line.instruction.mnemonic)) {
+            result.errors.append({i, tr("Unknown mnemonic \"%1\"").arg(line.instruction.mnemonic)});
+        } else if (!encoded[i].isValid()) {
+            result.errors.append({i, encoded[i].error});
+        }
+        result.lines[i].bytes = encoded[i].bytes;
+        result.lines[i].isData = line.instruction.mnemonic == "DB" || line.instruction.mnemonic == "DW";
+        address += encoded[i].bytes.size();
+    }
+    if (address > 0x10000) {
+        result.errors.append({int(lines.size()) - 1, tr("Program does not fit in a 64K segment")});
+    }
+
+    patchImage(result);
+    current = result;
+    pruneCaches(source);
+    return current;
+}
+
+void Assembler::patchImage(AssemblyResult& result) const {
+    int first = 0;
+    if (result.origin == current.origin) {
+        int common = qMin(result.lines.size(), current.lines.size());
+        while (first < common && result.lines[first].address == current.lines[first].address &&
+               result.lines[first].bytes == current.lines[first].bytes) {
+            ++first;
+        }
+        result.image = current.image;
+    }
+
+    int start = 0;
+    if (first < result.lines.size()) {
+        start = result.lines[first].address - result.origin;
+    } else {
+        // Only trailing lines were deleted, keep the image up to the end of the furthest code still emitted.
+        for (const AssembledLine& line : result.lines) {
+            if (!line.bytes.isEmpty()) {
+                start = qMax(start, line.address + int(line.bytes.size()) - result.origin);
+            }
+        }
+    }
+    result.image.truncate(qBound(0, start, int(result.image.size())));
+    for (int i = first; i < result.lines.size(); ++i) {
+        const AssembledLine& line = result.lines[i];
+        if (line.bytes.isEmpty()) continue;
+        int offset = line.address - result.origin;
+        if (offset < 0) continue;
+        if (offset > result.image.size()) {
+            result.image.append(QByteArray(offset - result.image.size(), '\0'));
+        }
+        result.image.replace(offset, qMin(int(line.bytes.size()), int(result.image.size()) - offset), line.bytes);
+    }
+}
+
+void Assembler::pruneCaches(const QStringList& source) {
+    int limit = 4 * int(source.size()) + 256;
+    if (parseCache.size() <= limit && shortEncodings.size() <= limit && longEncodings.size() <= limit) return;
+
+    QHash<QString, SourceLine> liveLines;
+    QHash<EncodingKey, CachedEncoding> liveShort;
+    QHash<EncodingKey, CachedEncoding> liveLong;
+    for (int i = 0; i < source.size(); ++i) {
+        const QString& text = source[i];
+        liveLines.insert(text, parseCache.value(text));
+        for (const EncodingKey& key : {EncodingKey(text, -1), EncodingKey(text, current.lines[i].address)}) {
+            if (shortEncodings.contains(key)) liveShort.insert(key, shortEncodings.value(key));
+            if (longEncodings.contains(key)) liveLong.insert(key, longEncodings.value(key));
+        }
+    }
+    parseCache.swap(liveLines);
+    shortEncodings.swap(liveShort);
+    longEncodings.swap(liveLong);
+}
+
+QString Assembler::toDebugScript(const AssemblyResult& result, const QString& fileName) {
+    QString script;
+    for (int offset = 0; offset < result.image.size(); offset += SCRIPT_BYTES_PER_LINE) {
+        script += QString("e %1").arg(result.origin + offset, 4, 16, QChar('0')).toUpper();
+        QByteArray chunk = result.image.mid(offset, SCRIPT_BYTES_PER_LINE);
+        for (char byte : chunk) {
+            script += QString(" %1").arg(quint8(byte), 2, 16, QChar('0')).toUpper();
+        }
+        script += "\n";
+    }
+    script += "rcx\n";
+    script += QString("%1\n").arg(result.image.size(), 0, 16).toUpper();
+    script += QString("n %1\n").arg(fileName);
+    script += "w\n";
+    script += "q\n";
+    return script;
+}
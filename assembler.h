@@ -0,0 +1,75 @@
+#ifndef ASSEMBLER_H
+#define ASSEMBLER_H
+
+#include <QCoreApplication>
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QVector>
+#include <QHash>
+#include <QPair>
+#include "scriptparser.h"
+#include "instructionencoder.h"
+
+struct AssemblyError {
+    int line;
+    QString message;
+};
+
+struct AssembledLine {
+    int address = 0;
+    QByteArray bytes;
+    bool isData = false;
+};
+
+struct AssemblyResult {
+    int origin = 0x100;
+    QByteArray image;
+    QVector<AssembledLine> lines;
+    SymbolTable symbols;
+    QVector<AssemblyError> errors;
+    bool isValid() const { return errors.isEmpty(); }
+    int lineForAddress(int address) const;
+};
+
+class Assembler {
+    Q_DECLARE_TR_FUNCTIONS(Assembler)
+public:
+    const AssemblyResult& assemble(const QStringList& source);
+    const AssemblyResult& result() const;
+    static QString toDebugScript(const AssemblyResult& result, const QString& fileName);
+private:
+    static constexpr int DEFAULT_ORIGIN = 0x100;
+    static constexpr int MAX_RELAXATION_PASSES = 64;
+    static constexpr int SCRIPT_BYTES_PER_LINE = 16;
+
+    struct SourceLine {
+        QString label;
+        QString constant;
+        QString constantValue;
+        int origin = -1;
+        ScriptLine instruction;
+        QStringList references;
+    };
+
+    struct CachedEncoding {
+        QVector<int> symbolValues;
+        EncodedInstruction encoded;
+    };
+    // Line text and the address it was encoded at, -1 when the encoding does not depend on the address.
+    typedef QPair<QString, int> EncodingKey;
+
+    QHash<QString, SourceLine> parseCache;
+    QHash<EncodingKey, CachedEncoding> shortEncodings;
+    QHash<EncodingKey, CachedEncoding> longEncodings;
+    AssemblyResult current;
+
+    void parseLine(const QString& text);
+    static SourceLine parseSourceLine(const QString& text);
+    const EncodedInstruction& encodeLine(const QString& text, const SourceLine& line, int address,
+                                         bool longJump, const SymbolTable& symbols);
+    void patchImage(AssemblyResult& result) const;
+    void pruneCaches(const QStringList& source);
+};
+
+#endif // ASSEMBLER_H
@@ -0,0 +1,67 @@
+# Builds the inverted search index for the native help browser.
+#
+# Usage: cmake -DHELP_HTML=<help.html> -DHELP_INDEX=<output> -P HelpIndex.cmake
+#
+# Every <section id="..."> of the help page is a topic. The output has one
+# "@<id>\t<title>" line per topic followed by one "<term>\t<id> <id> ..." line
+# per lower-cased term, sorted by term.
+
+cmake_minimum_required(VERSION 3.16)
+
+file(READ "${HELP_HTML}" html)
+
+# Characters that CMake treats as list syntax must go before splitting.
+string(REPLACE ";" " " html "${html}")
+string(REPLACE "[" " " html "${html}")
+string(REPLACE "]" " " html "${html}")
+string(REPLACE "\\" " " html "${html}")
+string(REPLACE "<section id=\"" ";" sections "${html}")
+list(REMOVE_AT sections 0)
+
+set(output "")
+set(all_terms "")
+foreach(section IN LISTS sections)
+    string(FIND "${section}" "\"" quote)
+    string(SUBSTRING "${section}" 0 ${quote} id)
+    string(FIND "${section}" ">" open)
+    math(EXPR open "${open} + 1")
+    string(SUBSTRING "${section}" ${open} -1 section)
+    string(FIND "${section}" "</section>" end)
+    if(end GREATER -1)
+        string(SUBSTRING "${section}" 0 ${end} section)
+    endif()
+
+    set(title "${id}")
+    if(section MATCHES "<h1>([^<]*)</h1>")
+        set(title "${CMAKE_MATCH_1}")
+    endif()
+    string(APPEND output "@${id}\t${title}\n")
+
+    string(REGEX REPLACE "<[^>]*>" " " text "${section}")
+    string(REPLACE "&lt" " " text "${text}")
+    string(REPLACE "&gt" " " text "${text}")
+    string(REPLACE "&amp" " " text "${text}")
+    string(TOLOWER "${text}" text)
+    string(REGEX REPLACE "[ \t\r\n,.:()=<>!?\"'/+*#{}|-]+" ";" terms "${text}")
+    list(REMOVE_DUPLICATES terms)
+    foreach(term IN LISTS terms)
+        string(LENGTH "${term}" length)
+        if(length LESS 2)
+            continue()
+        endif()
+        get_property(known GLOBAL PROPERTY "help_term_${term}" SET)
+        if(NOT known)
+            list(APPEND all_terms "${term}")
+        endif()
+        set_property(GLOBAL APPEND PROPERTY "help_term_${term}" "${id}")
+    endforeach()
+endforeach()
+
+list(SORT all_terms)
+foreach(term IN LISTS all_terms)
+    get_property(postings GLOBAL PROPERTY "help_term_${term}")
+    string(REPLACE ";" " " postings "${postings}")
+    string(APPEND output "${term}\t${postings}\n")
+endforeach()
+
+file(WRITE "${HELP_INDEX}" "${output}")
@@ -3,20 +3,37 @@
 #include <QTextBlock>
 #include <QPainter>
 #include <QFontMetrics>
+#include <QTextLayout>
 #include <QKeyEvent>
 #include <QApplication>
 #include <QClipboard>
+#include <QMimeData>
+#include <QMouseEvent>
+#include <QHelpEvent>
+#include <QToolTip>
+#include <QMenu>
+#include <QContextMenuEvent>
+#include <QTimer>
+#include <algorithm>
+#include <QFontInfo>
+#include <QtMath>
+#include <QHash>
+#include <cstring>
+#include "instructionencoder.h"
+#include "instructiondecoder.h"
 
 const QString CodeEditor::ADDRESS_FORMAT = "CS:0000";
 
 CodeEditor::SyntaxHighlighter::SyntaxHighlighter(QTextDocument* parent) : QSyntaxHighlighter(parent), enabled(true), commentColor(Qt::gray) {}
 
 void CodeEditor::SyntaxHighlighter::setEnabled(bool enabled) {
+    if (this->enabled == enabled) return;
     this->enabled = enabled;
     rehighlight();
 }
 
 void CodeEditor::SyntaxHighlighter::setCommentColor(const QColor& color) {
+    if (commentColor == color) return;
     commentColor = color;
     rehighlight();
 }
@@ -34,7 +51,9 @@ void CodeEditor::SyntaxHighlighter::highlightBlock(const QString& text) {
 
     QTextCharFormat instructionFormat;
     instructionFormat.setForeground(Qt::blue);
-    QRegularExpression instructionRegex("\\b(mov|int|add|sub|cmp|jmp|je|jne|jb|jbe|ja|jae|jg|jge|jl|jle|mul|div|imul|idiv|inc|dec|push|pop|call|ret|xor|and|or|not|loop|nop)\\b", QRegularExpression::CaseInsensitiveOption);
+    // The keywords are the assembler's own mnemonics, so whatever is coloured also assembles.
+    static const QRegularExpression instructionRegex("\\b(" + InstructionEncoder::mnemonics().join('|') + ")\\b",
+                                                     QRegularExpression::CaseInsensitiveOption);
     QRegularExpressionMatchIterator it = instructionRegex.globalMatch(text);
     while (it.hasNext()) {
         QRegularExpressionMatch match = it.next();
@@ -51,17 +70,26 @@ void CodeEditor::SyntaxHighlighter::highlightBlock(const QString& text) {
     }
 }
 
-CodeEditor::CodeEditor(QWidget* parent) : QPlainTextEdit(parent), standardLineNumbering(true), addressLineNumbering(true), currentLineHighlight(true), lineWrap(false), syntaxHighlighting(true), showMemoryDump(false), commentColor(Qt::darkGray) {
+CodeEditor::CodeEditor(QWidget* parent) : QPlainTextEdit(parent), standardLineNumbering(true), addressLineNumbering(true), currentLineHighlight(true), lineWrap(false), syntaxHighlighting(true), showMemoryDump(false), commentColor(Qt::darkGray), loading(false), readOnlyBeforeLoad(false), fixedPitch(false), cachedLineHeight(0), gutterCurrentBlock(-1), transactionDepth(0), transactionDirty(false), executionLine(-1), sourceMode(false), diagnosticsCurrent(false), changedFirst(0), changedLast(INT_MAX), changedBlockCount(1), valueHintsBlockCount(0), controlFlowDirty(true), hasFolds(false) {
     lineNumberArea = new LineNumberArea(this);
     memoryDumpArea = new MemoryDumpArea(this);
+    jumpArrowArea = new JumpArrowArea(this);
     highlighter = new SyntaxHighlighter(document());
     setFont(QFont("Courier New", 10));
     setTabStopDistance(4 * fontMetrics().horizontalAdvance(' '));
     connect(this, &QPlainTextEdit::blockCountChanged, this, &CodeEditor::updateLineNumberAreaWidth);
     connect(this, &QPlainTextEdit::updateRequest, this, &CodeEditor::updateLineNumberArea);
-    connect(this, &QPlainTextEdit::updateRequest, this, &CodeEditor::updateMemoryDumpArea);
     connect(this, &QPlainTextEdit::cursorPositionChanged, this, &CodeEditor::highlightCurrentLine);
-    connect(this, &QPlainTextEdit::textChanged, this, &CodeEditor::updateMemoryDump);
+    connect(document(), &QTextDocument::contentsChange, this, &CodeEditor::handleContentsChange);
+    connect(this, &QPlainTextEdit::textChanged, this, &CodeEditor::handleTextChanged);
+    diagnosticsEngine = new DiagnosticsEngine(this);
+    diagnosticsTimer = new QTimer(this);
+    diagnosticsTimer->setSingleShot(true);
+    diagnosticsTimer->setInterval(DIAGNOSTICS_DELAY_MS);
+    connect(diagnosticsTimer, &QTimer::timeout, this, &CodeEditor::requestDiagnostics);
+    connect(diagnosticsEngine, &DiagnosticsEngine::diagnosticsReady, this, &CodeEditor::applyDiagnostics);
+    connect(diagnosticsEngine, &DiagnosticsEngine::valuesReady, this, &CodeEditor::applyValueHints);
+    updateAddressTable();
     updateLineNumberAreaWidth();
     highlightCurrentLine();
     lineNumberArea->setVisible(true);
@@ -71,6 +99,7 @@ CodeEditor::CodeEditor(QWidget* parent) : QPlainTextEdit(parent), standardLineNu
 CodeEditor::~CodeEditor() {
     delete lineNumberArea;
     delete memoryDumpArea;
+    delete jumpArrowArea;
     delete highlighter;
 }
 
@@ -89,6 +118,7 @@ void CodeEditor::setAddressLineNumbering(bool enabled) {
 void CodeEditor::setCurrentLineHighlight(bool enabled) {
     currentLineHighlight = enabled;
     highlightCurrentLine();
+    updateGutterRow(gutterCurrentBlock);
 }
 
 void CodeEditor::setShowMemoryDump(bool enabled, const QString& segment, const QString& offset, int lineCount) {
@@ -98,7 +128,39 @@ void CodeEditor::setShowMemoryDump(bool enabled, const QString& segment, const Q
     memoryDumpLineCount = lineCount;
     memoryDumpArea->setVisible(enabled);
     updateLineNumberAreaWidth();
-    memoryDumpArea->update();
+    updateDumpRows(true);
+}
+
+void CodeEditor::applySettings(const EditorSettings& settings, const QSet<QString>& changedKeys) {
+    auto changed = [&changedKeys](std::initializer_list<const char*> keys) {
+        for (const char* key : keys) {
+            if (changedKeys.contains(QLatin1String(key))) return true;
+        }
+        return false;
+    };
+
+    if (changed({"theme", "backgroundColor", "textColor", "highlightColor"})) {
+        setTheme(settings.theme, settings.backgroundColor, settings.textColor, settings.highlightColor);
+    }
+    if (changed({"font"})) {
+        setFont(settings.font);
+    }
+    if (changed({"standardLineNumbering"})) {
+        setStandardLineNumbering(settings.standardLineNumbering);
+    }
+    if (changed({"addressLineNumbering"})) {
+        setAddressLineNumbering(settings.addressLineNumbering);
+    }
+    if (changed({"lineWrap"})) {
+        setLineWrap(settings.lineWrap);
+    }
+    if (changed({"syntaxHighlighting"})) {
+        setSyntaxHighlighting(settings.syntaxHighlighting);
+    }
+    if (changed({"showMemoryDump", "memoryDumpSegment", "memoryDumpOffset", "memoryDumpLineCount"})) {
+        setShowMemoryDump(settings.showMemoryDump, settings.memoryDumpSegment,
+                          settings.memoryDumpOffset, settings.memoryDumpLineCount);
+    }
 }
 
 void CodeEditor::setTheme(const QString& theme, const QColor& backgroundColor, const QColor& textColor, const QColor& highlightColor, const QColor& commentColor) {
@@ -113,19 +175,24 @@ void CodeEditor::setTheme(const QString& theme, const QColor& backgroundColor, c
     setPalette(palette);
     static_cast<SyntaxHighlighter*>(highlighter)->setCommentColor(commentColor);
     highlightCurrentLine();
+    lineNumberArea->update();
 }
 
 void CodeEditor::setFont(const QFont& font) {
     QPlainTextEdit::setFont(font);
     setTabStopDistance(4 * fontMetrics().horizontalAdvance(' '));
+    fixedPitch = QFontInfo(font).fixedPitch();
+    setWordWrapMode(fixedPitch ? QTextOption::WrapAnywhere : QTextOption::WrapAtWordBoundaryOrAnywhere);
+    cachedLineHeight = 0;
     updateLineNumberAreaWidth();
     lineNumberArea->update();
-    memoryDumpArea->update();
+    updateDumpRows(true);
 }
 
 void CodeEditor::setLineWrap(bool enabled) {
     setLineWrapMode(enabled ? QPlainTextEdit::WidgetWidth : QPlainTextEdit::NoWrap);
     lineWrap = enabled;
+    cachedLineHeight = 0;
     lineNumberArea->update();
     memoryDumpArea->update();
 }
@@ -136,14 +203,374 @@ void CodeEditor::setSyntaxHighlighting(bool enabled) {
 }
 
 QString CodeEditor::getText() const { return toPlainText(); }
+
+QString CodeEditor::wordUnderCursor() const {
+    QTextCursor cursor = textCursor();
+    cursor.select(QTextCursor::WordUnderCursor);
+    return cursor.selectedText();
+}
 void CodeEditor::setText(const QString& text) { setPlainText(text); }
 
+void CodeEditor::beginBulkLoad() {
+    loading = true;
+    extraCursors.clear();
+    breakpoints.clear();
+    executionLine = -1;
+    readOnlyBeforeLoad = isReadOnly();
+    setReadOnly(true);
+    setUndoRedoEnabled(false);
+    clear();
+}
+
+void CodeEditor::appendChunk(const QString& text) {
+    QTextCursor cursor(document());
+    cursor.movePosition(QTextCursor::End);
+    cursor.insertText(text);
+}
+
+void CodeEditor::endBulkLoad() {
+    loading = false;
+    setUndoRedoEnabled(true);
+    setReadOnly(readOnlyBeforeLoad);
+    document()->setModified(false);
+    recomputeDerivedState();
+}
+
+bool CodeEditor::isLoading() const {
+    return loading;
+}
+
+void CodeEditor::beginTransaction() {
+    ++transactionDepth;
+}
+
+void CodeEditor::endTransaction() {
+    if (transactionDepth == 0 || --transactionDepth > 0) return;
+    if (transactionDirty) {
+        transactionDirty = false;
+        recomputeDerivedState();
+        emit contentChanged();
+    }
+}
+
+void CodeEditor::handleContentsChange(int position, int charsRemoved, int charsAdded) {
+    Q_UNUSED(charsRemoved)
+    QTextBlock block = document()->findBlock(position);
+    QTextBlock last = document()->findBlock(position + charsAdded);
+    while (block.isValid()) {
+        block.setUserData(nullptr);
+        if (block == last) break;
+        block = block.next();
+    }
+    DiagnosticsEngine::mergeChanges(changedFirst, changedLast, document()->findBlock(position).blockNumber(),
+                                    last.isValid() ? last.blockNumber() : blockCount() - 1, blockCount() - changedBlockCount);
+    changedBlockCount = blockCount();
+}
+
+void CodeEditor::handleTextChanged() {
+    if (loading) return;
+    if (transactionDepth > 0) {
+        transactionDirty = true;
+        return;
+    }
+    recomputeDerivedState();
+    emit contentChanged();
+}
+
+void CodeEditor::recomputeDerivedState() {
+    if (hasFolds) unfoldAll();
+    updateAddressTable();
+    updateMemoryDump();
+    controlFlowDirty = true;
+    diagnosticsCurrent = false;
+    diagnosticsTimer->start();
+}
+
+void CodeEditor::requestDiagnostics() {
+    if (loading) return;
+    if (sourceMode) {
+        QVector<Diagnostic> errors;
+        for (const AssemblyError& error : assembler.result().errors) {
+            errors.append({error.line, Diagnostic::Error, error.message});
+        }
+        applyDiagnostics(errors);
+        applyValueHints(QVector<ValueHint>());
+        return;
+    }
+    QVector<ScriptLine> lines;
+    lines.reserve(blockCount());
+    for (QTextBlock block = document()->begin(); block.isValid(); block = block.next()) {
+        lines.append(blockData(block)->line);
+    }
+    diagnosticsEngine->analyze(lines, changedFirst, changedLast);
+    changedFirst = INT_MAX;
+    changedLast = -1;
+}
+
+void CodeEditor::applyDiagnostics(const QVector<Diagnostic>& diagnostics) {
+    this->diagnostics = diagnostics;
+    diagnosticsCurrent = !diagnosticsTimer->isActive();
+    diagnosticSelections.clear();
+    for (const Diagnostic& diagnostic : diagnostics) {
+        QTextBlock block = document()->findBlockByNumber(diagnostic.line);
+        if (!block.isValid()) continue;
+
+        QString text = block.text();
+        int start = 0;
+        while (start < text.size() && text[start].isSpace()) ++start;
+
+        QTextEdit::ExtraSelection selection;
+        selection.cursor = QTextCursor(block);
+        selection.cursor.setPosition(block.position() + start);
+        selection.cursor.movePosition(QTextCursor::EndOfBlock, QTextCursor::KeepAnchor);
+        if (diagnostic.severity == Diagnostic::Hint) {
+            selection.format.setUnderlineStyle(QTextCharFormat::DotLine);
+            selection.format.setUnderlineColor(QColor(0, 140, 200));
+        } else {
+            selection.format.setUnderlineStyle(QTextCharFormat::WaveUnderline);
+            selection.format.setUnderlineColor(diagnostic.severity == Diagnostic::Error ? QColor(Qt::red) : QColor(230, 140, 0));
+        }
+        diagnosticSelections.append(selection);
+    }
+    highlightCurrentLine();
+}
+
+void CodeEditor::applyValueHints(const QVector<ValueHint>& hints) {
+    valueHints.clear();
+    for (const ValueHint& hint : hints) {
+        valueHints.insert(hint.line, hint.text);
+    }
+    valueHintsBlockCount = blockCount();
+    viewport()->update();
+}
+
+void CodeEditor::drawValueHints(QPainter& painter, const QRect& rect) {
+    // Hints are keyed by line number, hide them while inserted or removed lines have shifted them.
+    if (valueHints.isEmpty() || valueHintsBlockCount != blockCount()) return;
+
+    QFont hintFont = QPlainTextEdit::font();
+    hintFont.setItalic(true);
+    painter.setFont(hintFont);
+    painter.setPen(commentColor);
+    for (QTextBlock block = firstVisibleBlock(); block.isValid(); block = block.next()) {
+        const QRectF geometry = blockBoundingGeometry(block).translated(contentOffset());
+        if (geometry.top() > rect.bottom()) break;
+        if (!block.isVisible() || geometry.bottom() < rect.top()) continue;
+        auto hint = valueHints.constFind(block.blockNumber());
+        if (hint == valueHints.constEnd() || !block.layout() || block.layout()->lineCount() == 0) continue;
+
+        const QTextLine line = block.layout()->lineAt(block.layout()->lineCount() - 1);
+        const qreal x = geometry.left() + line.x() + line.naturalTextWidth() + VALUE_HINT_SPACING;
+        const qreal y = geometry.top() + line.y() + line.ascent();
+        painter.drawText(QPointF(x, y), "; " + *hint);
+    }
+}
+
+bool CodeEditor::viewportEvent(QEvent* event) {
+    if (event->type() == QEvent::ToolTip) {
+        QHelpEvent* helpEvent = static_cast<QHelpEvent*>(event);
+        int blockNumber = cursorForPosition(helpEvent->pos()).blockNumber();
+        QStringList messages;
+        for (const Diagnostic& diagnostic : diagnostics) {
+            if (diagnostic.line == blockNumber) {
+                messages.append(diagnostic.message);
+            }
+        }
+        if (messages.isEmpty()) {
+            QToolTip::hideText();
+            event->ignore();
+        } else {
+            QToolTip::showText(helpEvent->globalPos(), messages.join('\n'), viewport());
+        }
+        return true;
+    }
+    return QPlainTextEdit::viewportEvent(event);
+}
+
+void CodeEditor::contextMenuEvent(QContextMenuEvent* event) {
+    QMenu* menu = createStandardContextMenu(event->pos());
+    int blockNumber = cursorForPosition(event->pos()).blockNumber();
+    if (diagnosticsCurrent && !isReadOnly()) {
+        QAction* before = menu->actions().value(0);
+        for (const Diagnostic& diagnostic : diagnostics) {
+            if (diagnostic.line != blockNumber || !diagnostic.hasFix) continue;
+            QString title = diagnostic.replacement.isEmpty()
+                                ? tr("Remove this line")
+                                : tr("Replace with \"%1\"").arg(diagnostic.replacement.trimmed());
+            QAction* action = new QAction(title, menu);
+            action->setToolTip(diagnostic.message);
+            connect(action, &QAction::triggered, this, [this, diagnostic]() { applyFix(diagnostic); });
+            menu->insertAction(before, action);
+        }
+        if (before && menu->actions().first() != before) {
+            menu->insertSeparator(before);
+        }
+    }
+    if (!textCursor().hasSelection() && textCursor().blockNumber() != blockNumber) {
+        setTextCursor(cursorForPosition(event->pos()));
+    }
+    const int line = textCursor().blockNumber();
+    const bool hasAddress = line < blockAddresses.size() && blockAddresses[line] >= 0;
+    menu->addSeparator();
+    QAction* targetAction = menu->addAction(tr("Go to Target"), this, &CodeEditor::goToTarget);
+    targetAction->setShortcut(QKeySequence(Qt::Key_F12));
+    targetAction->setEnabled(!referenceIndex.referencesFrom(line).isEmpty());
+    QAction* referencesAction = menu->addAction(tr("Find References"), this, &CodeEditor::findReferences);
+    referencesAction->setShortcut(QKeySequence(Qt::SHIFT | Qt::Key_F12));
+    referencesAction->setEnabled(hasAddress);
+    QAction* callersAction = menu->addAction(tr("Callers Of"), this, &CodeEditor::findCallers);
+    callersAction->setShortcut(QKeySequence(Qt::CTRL | Qt::SHIFT | Qt::Key_F12));
+    callersAction->setEnabled(hasAddress);
+    menu->exec(event->globalPos());
+    delete menu;
+}
+
+void CodeEditor::applyQuickFix() {
+    if (!diagnosticsCurrent || isReadOnly()) return;
+    int blockNumber = textCursor().blockNumber();
+    for (const Diagnostic& diagnostic : diagnostics) {
+        if (diagnostic.line == blockNumber && diagnostic.hasFix) {
+            applyFix(diagnostic);
+            return;
+        }
+    }
+}
+
+void CodeEditor::applyFix(const Diagnostic& diagnostic) {
+    QTextBlock block = document()->findBlockByNumber(diagnostic.line);
+    if (!block.isValid()) return;
+
+    beginTransaction();
+    QTextCursor cursor(block);
+    if (!diagnostic.replacement.isEmpty()) {
+        cursor.movePosition(QTextCursor::EndOfBlock, QTextCursor::KeepAnchor);
+        cursor.insertText(diagnostic.replacement);
+    } else if (block.next().isValid()) {
+        cursor.movePosition(QTextCursor::NextBlock, QTextCursor::KeepAnchor);
+        cursor.removeSelectedText();
+    } else {
+        if (block.previous().isValid()) {
+            cursor.movePosition(QTextCursor::PreviousBlock);
+            cursor.movePosition(QTextCursor::EndOfBlock);
+        }
+        cursor.setPosition(block.position() + block.length() - 1, QTextCursor::KeepAnchor);
+        cursor.removeSelectedText();
+    }
+    diagnosticsCurrent = false;
+    endTransaction();
+}
+
+CodeEditor::BlockData* CodeEditor::blockData(const QTextBlock& block) {
+    BlockData* data = static_cast<BlockData*>(block.userData());
+    if (data) return data;
+
+    data = new BlockData;
+    data->line = ScriptParser::parse(block.text());
+    QTextBlock(block).setUserData(data);
+    return data;
+}
+
+const QByteArray& CodeEditor::encodedBytes(const QTextBlock& block, int address) {
+    BlockData* data = blockData(block);
+    if (data->encodedAddress < 0 || (data->addressDependent && data->encodedAddress != address)) {
+        EncodedInstruction encoded = InstructionEncoder::encode(data->line, address);
+        data->encodedBytes = encoded.bytes;
+        data->addressDependent = encoded.addressDependent;
+    }
+    data->encodedAddress = address;
+    return data->encodedBytes;
+}
+
+void CodeEditor::setSourceMode(bool enabled) {
+    if (sourceMode == enabled) return;
+    sourceMode = enabled;
+    recomputeDerivedState();
+}
+
+bool CodeEditor::isSourceMode() const {
+    return sourceMode;
+}
+
+const ControlFlowGraph& CodeEditor::controlFlowGraph() {
+    if (!controlFlowDirty) return controlFlow;
+    controlFlowDirty = false;
+    controlFlow = ControlFlowGraph();
+    if (imageWrites.isEmpty() || memoryImage.isEmpty()) return controlFlow;
+
+    int low = MEMORY_IMAGE_SIZE;
+    int high = 0;
+    for (const ImageWrite& write : imageWrites) {
+        low = qMin(low, write.address & (MEMORY_IMAGE_SIZE - 1));
+        high = qMax(high, qMin(MEMORY_IMAGE_SIZE, (write.address & (MEMORY_IMAGE_SIZE - 1)) + int(write.bytes.size())));
+    }
+    const int entry = entryPoint();
+    Disassembly disassembly = Disassembler::disassemble(memoryImage.mid(low, high - low), low,
+                                                        {entry >= low && entry < high ? entry : low});
+    controlFlow = disassembly.graph;
+    return controlFlow;
+}
+
+int CodeEditor::lineForAddress(int address) {
+    return addressLines.value(address, -1);
+}
+
+void CodeEditor::toggleFold() {
+    const int line = textCursor().blockNumber();
+    if (line >= blockAddresses.size() || blockAddresses[line] < 0) return;
+    const ControlFlowGraph& graph = controlFlowGraph();
+    const int index = graph.blockAt(blockAddresses[line]);
+    if (index < 0) return;
+
+    const BasicBlock& basicBlock = graph.blocks[index];
+    const int first = lineForAddress(basicBlock.start);
+    const int last = lineForAddress(basicBlock.instructions.last());
+    if (first < 0 || last <= first) return;
+
+    QTextBlock header = document()->findBlockByNumber(first);
+    const bool fold = header.next().isVisible();
+    for (QTextBlock block = header.next(); block.isValid() && block.blockNumber() <= last; block = block.next()) {
+        block.setVisible(!fold);
+    }
+    hasFolds = hasFolds || fold;
+
+    QTextBlock end = document()->findBlockByNumber(last);
+    document()->markContentsDirty(header.position(), end.position() + end.length() - header.position());
+    if (fold) {
+        QTextCursor cursor = textCursor();
+        cursor.setPosition(header.position());
+        setTextCursor(cursor);
+    }
+    viewport()->update();
+    lineNumberArea->update();
+}
+
+void CodeEditor::unfoldAll() {
+    hasFolds = false;
+    for (QTextBlock block = document()->begin(); block.isValid(); block = block.next()) {
+        block.setVisible(true);
+    }
+    document()->markContentsDirty(0, document()->characterCount());
+    viewport()->update();
+    lineNumberArea->update();
+}
+
+const AssemblyResult& CodeEditor::assembly() {
+    if (!sourceMode || loading) {
+        return assembler.assemble(toPlainText().split('\n'));
+    }
+    return assembler.result();
+}
+
 void CodeEditor::keyPressEvent(QKeyEvent* event) {
     if (event->matches(QKeySequence::Paste)) {
         QPlainTextEdit::keyPressEvent(event);
         return;
     }
 
+    if (!extraCursors.isEmpty() && handleMultiCursorKey(event)) {
+        return;
+    }
+
     if (event->key() == Qt::Key_X && event->modifiers() == Qt::ControlModifier) {
         deleteLine();
         return;
@@ -154,6 +581,31 @@ void CodeEditor::keyPressEvent(QKeyEvent* event) {
         return;
     }
 
+    if (event->key() == Qt::Key_Period && event->modifiers() == Qt::ControlModifier) {
+        applyQuickFix();
+        return;
+    }
+
+    if (event->key() == Qt::Key_M && event->modifiers() == Qt::ControlModifier) {
+        toggleFold();
+        return;
+    }
+
+    if (event->key() == Qt::Key_F12 && event->modifiers() == Qt::NoModifier) {
+        goToTarget();
+        return;
+    }
+
+    if (event->key() == Qt::Key_F12 && event->modifiers() == Qt::ShiftModifier) {
+        findReferences();
+        return;
+    }
+
+    if (event->key() == Qt::Key_F12 && event->modifiers() == (Qt::ControlModifier | Qt::ShiftModifier)) {
+        findCallers();
+        return;
+    }
+
     if (event->key() == Qt::Key_Up && event->modifiers() == Qt::AltModifier) {
         moveLineUp();
         return;
@@ -187,6 +639,26 @@ void CodeEditor::keyPressEvent(QKeyEvent* event) {
     QPlainTextEdit::keyPressEvent(event);
 }
 
+void CodeEditor::insertFromMimeData(const QMimeData* source) {
+    if (!extraCursors.isEmpty() && source->hasText()) {
+        QString text = source->text();
+        text.replace("\r\n", "\n");
+        QStringList lines = text.split('\n');
+        if (lines.size() > 1 && lines.last().isEmpty()) {
+            lines.removeLast();
+        }
+        const bool distribute = lines.size() == extraCursors.size() + 1;
+        editAllCursors([&](QTextCursor& cursor, int index) {
+            cursor.insertText(distribute ? lines[index] : text);
+        });
+        return;
+    }
+
+    beginTransaction();
+    QPlainTextEdit::insertFromMimeData(source);
+    endTransaction();
+}
+
 void CodeEditor::toggleComment() {
     QTextCursor cursor = textCursor();
     bool hasSelection = cursor.hasSelection();
@@ -212,6 +684,7 @@ void CodeEditor::toggleComment() {
         block = block.next();
     }
 
+    beginTransaction();
     cursor.beginEditBlock();
     block = startBlock;
     while (block.isValid() && block.position() <= endBlock.position()) {
@@ -237,8 +710,7 @@ void CodeEditor::toggleComment() {
         cursor.setPosition(startBlock.position());
         setTextCursor(cursor);
     }
-
-    static_cast<SyntaxHighlighter*>(highlighter)->rehighlight();
+    endTransaction();
 }
 
 void CodeEditor::moveLineUp() {
@@ -246,6 +718,7 @@ void CodeEditor::moveLineUp() {
     QTextBlock block = cursor.block();
     if (!block.isValid() || block.previous().position() < 0) return;
 
+    beginTransaction();
     cursor.beginEditBlock();
     QString currentText = block.text();
     QString prevText = block.previous().text();
@@ -265,6 +738,7 @@ void CodeEditor::moveLineUp() {
     cursor.setPosition(block.previous().position() + cursor.position() - block.position());
     setTextCursor(cursor);
     cursor.endEditBlock();
+    endTransaction();
 }
 
 void CodeEditor::moveLineDown() {
@@ -272,6 +746,7 @@ void CodeEditor::moveLineDown() {
     QTextBlock block = cursor.block();
     if (!block.isValid() || !block.next().isValid()) return;
 
+    beginTransaction();
     cursor.beginEditBlock();
     QString currentText = block.text();
     QString nextText = block.next().text();
@@ -291,6 +766,7 @@ void CodeEditor::moveLineDown() {
     cursor.setPosition(block.next().position() + cursor.position() - block.position());
     setTextCursor(cursor);
     cursor.endEditBlock();
+    endTransaction();
 }
 
 void CodeEditor::duplicateLine(bool up) {
@@ -298,6 +774,7 @@ void CodeEditor::duplicateLine(bool up) {
     QTextBlock block = cursor.block();
     QString text = block.text();
 
+    beginTransaction();
     cursor.beginEditBlock();
     QTextCursor newCursor(document());
     if (up) {
@@ -311,89 +788,189 @@ void CodeEditor::duplicateLine(bool up) {
     }
     setTextCursor(cursor);
     cursor.endEditBlock();
+    endTransaction();
 }
 
 void CodeEditor::addCursorUp() {
-    QList<QTextCursor> allCursors;
-    allCursors.append(textCursor());
-    for (const auto& sel : extraSelections()) {
-        allCursors.append(sel.cursor);
-    }
+    addCursorVertically(true);
+}
 
-    QList<QTextEdit::ExtraSelection> newSelections = extraSelections();
+void CodeEditor::addCursorDown() {
+    addCursorVertically(false);
+}
+
+void CodeEditor::addCursorVertically(bool up) {
+    QList<QTextCursor> allCursors = extraCursors;
+    allCursors.prepend(textCursor());
 
-    for (const QTextCursor &cursor : allCursors) {
+    for (const QTextCursor& cursor : allCursors) {
         QTextBlock block = cursor.block();
-        if (!block.previous().isValid()) continue;
+        QTextBlock target = up ? block.previous() : block.next();
+        if (!target.isValid()) continue;
 
-        QTextBlock prevBlock = block.previous();
         int relativePos = cursor.position() - block.position();
-        int newPos = prevBlock.position() + qMin(relativePos, prevBlock.length() - 1);
-
-        QTextCursor newCursor(document());
-        newCursor.setPosition(newPos);
+        int newPos = target.position() + qMin(relativePos, target.length() - 1);
 
-        bool exists = false;
-        for (const auto& sel : newSelections) {
-            if (sel.cursor.position() == newPos) {
+        bool exists = textCursor().position() == newPos;
+        for (const QTextCursor& extra : extraCursors) {
+            if (extra.position() == newPos) {
                 exists = true;
                 break;
             }
         }
 
         if (!exists) {
-            QTextEdit::ExtraSelection extra;
-            extra.cursor = newCursor;
-            extra.format.setBackground(highlightColor);
-            newSelections.append(extra);
+            QTextCursor newCursor(document());
+            newCursor.setPosition(newPos);
+            extraCursors.append(newCursor);
         }
     }
 
-    setExtraSelections(newSelections);
+    highlightCurrentLine();
+    viewport()->update();
 }
 
-void CodeEditor::addCursorDown() {
-    QList<QTextCursor> allCursors;
-    allCursors.append(textCursor());
-    for (const auto& sel : extraSelections()) {
-        allCursors.append(sel.cursor);
-    }
-
-    QList<QTextEdit::ExtraSelection> newSelections = extraSelections();
-
-    for (const QTextCursor &cursor : allCursors) {
-        QTextBlock block = cursor.block();
-        if (!block.next().isValid()) continue;
+void CodeEditor::clearExtraCursors() {
+    if (extraCursors.isEmpty()) return;
+    extraCursors.clear();
+    highlightCurrentLine();
+    viewport()->update();
+}
 
-        QTextBlock nextBlock = block.next();
-        int relativePos = cursor.position() - block.position();
-        int newPos = nextBlock.position() + qMin(relativePos, nextBlock.length() - 1);
+bool CodeEditor::hasExtraCursors() const {
+    return !extraCursors.isEmpty();
+}
 
-        QTextCursor newCursor(document());
-        newCursor.setPosition(newPos);
+void CodeEditor::editAllCursors(const std::function<void(QTextCursor& cursor, int index)>& edit) {
+    QList<QTextCursor> cursors = extraCursors;
+    cursors.prepend(textCursor());
 
-        bool exists = false;
-        for (const auto& sel : newSelections) {
-            if (sel.cursor.position() == newPos) {
-                exists = true;
+    QList<int> order;
+    for (int i = 0; i < cursors.size(); ++i) {
+        order.append(i);
+    }
+    std::sort(order.begin(), order.end(), [&cursors](int a, int b) {
+        return cursors[a].position() < cursors[b].position();
+    });
+
+    beginTransaction();
+    QTextCursor editBlock(document());
+    editBlock.beginEditBlock();
+    for (int rank = 0; rank < order.size(); ++rank) {
+        edit(cursors[order[rank]], rank);
+    }
+    editBlock.endEditBlock();
+
+    setTextCursor(cursors.takeFirst());
+    extraCursors.clear();
+    for (const QTextCursor& cursor : cursors) {
+        bool duplicate = cursor.position() == textCursor().position();
+        for (const QTextCursor& extra : extraCursors) {
+            if (extra.position() == cursor.position()) {
+                duplicate = true;
                 break;
             }
         }
+        if (!duplicate) {
+            extraCursors.append(cursor);
+        }
+    }
+    endTransaction();
 
-        if (!exists) {
-            QTextEdit::ExtraSelection extra;
-            extra.cursor = newCursor;
-            extra.format.setBackground(highlightColor);
-            newSelections.append(extra);
+    highlightCurrentLine();
+    viewport()->update();
+}
+
+bool CodeEditor::handleMultiCursorKey(QKeyEvent* event) {
+    if (event->key() == Qt::Key_Escape) {
+        clearExtraCursors();
+        return true;
+    }
+
+    const Qt::KeyboardModifiers modifiers = event->modifiers() & ~Qt::KeypadModifier;
+    const QTextCursor::MoveMode mode = (modifiers & Qt::ShiftModifier) ? QTextCursor::KeepAnchor : QTextCursor::MoveAnchor;
+    auto move = [this, mode](QTextCursor::MoveOperation operation) {
+        QList<QTextCursor> cursors = extraCursors;
+        cursors.prepend(textCursor());
+        for (QTextCursor& cursor : cursors) {
+            cursor.movePosition(operation, mode);
+        }
+        setTextCursor(cursors.takeFirst());
+        extraCursors = cursors;
+        highlightCurrentLine();
+        viewport()->update();
+    };
+
+    if (modifiers == Qt::NoModifier || modifiers == Qt::ShiftModifier) {
+        switch (event->key()) {
+        case Qt::Key_Left:
+            move(QTextCursor::Left);
+            return true;
+        case Qt::Key_Right:
+            move(QTextCursor::Right);
+            return true;
+        case Qt::Key_Home:
+            move(QTextCursor::StartOfBlock);
+            return true;
+        case Qt::Key_End:
+            move(QTextCursor::EndOfBlock);
+            return true;
+        default:
+            break;
+        }
+    }
+
+    if (isReadOnly()) return false;
+
+    if (event->key() == Qt::Key_Backspace && modifiers == Qt::NoModifier) {
+        editAllCursors([](QTextCursor& cursor, int) { cursor.deletePreviousChar(); });
+        return true;
+    }
+    if (event->key() == Qt::Key_Delete && modifiers == Qt::NoModifier) {
+        editAllCursors([](QTextCursor& cursor, int) { cursor.deleteChar(); });
+        return true;
+    }
+    if ((event->key() == Qt::Key_Return || event->key() == Qt::Key_Enter) && modifiers == Qt::NoModifier) {
+        editAllCursors([](QTextCursor& cursor, int) { cursor.insertBlock(); });
+        return true;
+    }
+
+    const QString text = event->text();
+    if (!text.isEmpty() && text.at(0).isPrint() && !(modifiers & (Qt::ControlModifier | Qt::AltModifier | Qt::MetaModifier))) {
+        editAllCursors([&text](QTextCursor& cursor, int) { cursor.insertText(text); });
+        return true;
+    }
+
+    if ((modifiers == Qt::NoModifier || modifiers == Qt::ShiftModifier) &&
+        (event->key() == Qt::Key_Up || event->key() == Qt::Key_Down || event->key() == Qt::Key_PageUp || event->key() == Qt::Key_PageDown)) {
+        clearExtraCursors();
+    }
+    return false;
+}
+
+void CodeEditor::paintEvent(QPaintEvent* event) {
+    QPlainTextEdit::paintEvent(event);
+
+    QPainter painter(viewport());
+    drawValueHints(painter, event->rect());
+    for (const QTextCursor& cursor : extraCursors) {
+        QRect rect = cursorRect(cursor);
+        rect.setWidth(qMax(1, cursorWidth()));
+        if (rect.intersects(event->rect())) {
+            painter.fillRect(rect, textColor);
         }
     }
+}
 
-    setExtraSelections(newSelections);
+void CodeEditor::mousePressEvent(QMouseEvent* event) {
+    clearExtraCursors();
+    QPlainTextEdit::mousePressEvent(event);
 }
 
 void CodeEditor::deleteLine() {
     QTextCursor cursor = textCursor();
     bool hasSelection = cursor.hasSelection();
+    beginTransaction();
 
     if (hasSelection) {
         QString selectedText = cursor.selectedText();
@@ -420,150 +997,478 @@ void CodeEditor::deleteLine() {
     }
 
     setTextCursor(cursor);
-}
-
-int CodeEditor::calculateInstructionLength(const QString& text) {
-    QString trimmed = text.trimmed().toUpper();
-    if (trimmed.isEmpty() || trimmed.startsWith("A ") || trimmed.startsWith("E ")) return 0;
-
-    QStringList parts = trimmed.split(QRegularExpression("\\s+|,"), Qt::SkipEmptyParts);
-    if (parts.isEmpty()) return 0;
-
-    QString instruction = parts[0].toUpper();
-    QString arg1 = parts.size() > 1 ? parts[1].toUpper() : "";
-    QString arg2 = parts.size() > 2 ? parts[2].toUpper() : "";
-
-    auto isRegister = [](const QString& arg) {
-        return QStringList{"AX", "BX", "CX", "DX", "AL", "AH", "BL", "BH", "CL", "CH", "DL", "DH", "SP", "BP", "SI", "DI"}.contains(arg);
-    };
-    auto isNumber = [](const QString& arg) {
-        bool ok;
-        arg.toInt(&ok, 16);
-        return ok;
-    };
-    auto isMemory = [](const QString& arg) {
-        return arg.startsWith("[") && arg.endsWith("]") &&
-               QStringList{"BX", "SI", "DI"}.contains(arg.mid(1, arg.length() - 2).toUpper());
-    };
-
-    bool isReg1 = isRegister(arg1);
-    bool isNum2 = isNumber(arg2);
-    bool isReg2 = isRegister(arg2);
-    bool isMem1 = isMemory(arg1);
-    bool isMem2 = isMemory(arg2);
-
-    if (instruction == "MOV") {
-        if (isReg1 && isNum2) {
-            return (arg1 == "AL" || arg1 == "AH" || arg1 == "BL" || arg1 == "BH" ||
-                    arg1 == "CL" || arg1 == "CH" || arg1 == "DL" || arg1 == "DH") ? 2 : 3;
-        } else if (isReg1 && isReg2) {
-            return 2;
-        } else if (isReg1 && isMem2 || isMem1 && isReg2) {
-            return 2;
-        }
-    } else if (instruction == "ADD" || instruction == "SUB" || instruction == "CMP" ||
-               instruction == "XOR" || instruction == "AND" || instruction == "OR") {
-        if (isReg1 && isNum2) {
-            return (arg2.toInt(nullptr, 16) <= 0xFF) ? 3 : 4;
-        } else if (isReg1 && isReg2 || isReg1 && isMem2 || isMem1 && isReg2) {
-            return 2;
-        }
-    } else if (instruction == "NOT") {
-        if (isReg1 || isMem1) {
-            return 2;
-        }
-    } else if (instruction == "JMP" || instruction == "JE" || instruction == "JNE" ||
-               instruction == "JB" || instruction == "JBE" || instruction == "JA" ||
-               instruction == "JAE" || instruction == "JG" || instruction == "JGE" ||
-               instruction == "JL" || instruction == "JLE") {
-        return 2;
-    } else if (instruction == "MUL" || instruction == "DIV" || instruction == "IMUL" || instruction == "IDIV") {
-        return 2;
-    } else if (instruction == "INC" || instruction == "DEC" || instruction == "PUSH" || instruction == "POP" || instruction == "NOP") {
-        return 1;
-    } else if (instruction == "INT") {
-        return 2;
-    } else if (instruction == "CALL" || instruction == "LOOP") {
-        return 2;
-    }
-
-    return 0;
+    endTransaction();
 }
 
 void CodeEditor::lineNumberAreaPaintEvent(QPaintEvent* event) {
     QPainter painter(lineNumberArea);
     painter.fillRect(event->rect(), Qt::lightGray);
+    painter.setPen(Qt::black);
+    if (fixedPitch) {
+        gutterAtlas.update(QPlainTextEdit::font(), Qt::black, lineNumberArea->devicePixelRatioF());
+    }
 
     QTextBlock block = firstVisibleBlock();
     int blockNumber = block.blockNumber();
     int top = qRound(blockBoundingGeometry(block).translated(contentOffset()).top());
-    int bottom = top + qRound(blockBoundingRect(block).height());
 
     const int standardWidth = calculateStandardWidth();
     const int addressWidth = calculateAddressWidth();
+    const int rowHeight = fontMetrics().height();
+    QHash<int, const Breakpoint*> breakpointLines;
+    for (const Breakpoint& breakpoint : breakpoints) {
+        breakpointLines.insert(breakpoint.cursor.blockNumber(), &breakpoint);
+    }
 
-    int currentAddress = -1;
-    bool addressMode = false;
-    int nextAddress = -1;
-    bool showNextEmptyAddress = false;
+    while (block.isValid() && top <= event->rect().bottom()) {
+        int bottom = top;
+        if (block.isVisible()) {
+            bottom += fixedPitch ? lineHeight() * visualRowCount(block) : qRound(blockBoundingRect(block).height());
+        }
+        if (block.isVisible() && bottom >= event->rect().top()) {
+            if (currentLineHighlight && blockNumber == gutterCurrentBlock) {
+                painter.fillRect(QRect(0, top, lineNumberArea->width(), bottom - top), highlightColor);
+            }
+            if (blockNumber == executionLine || breakpointLines.contains(blockNumber)) {
+                drawGutterMarkers(painter, QRect(0, top, BREAKPOINT_AREA_WIDTH, rowHeight),
+                                  breakpointLines.value(blockNumber), blockNumber == executionLine);
+            }
+            if (standardLineNumbering) {
+                drawGutterText(painter, QRect(BREAKPOINT_AREA_WIDTH + MARGIN_LEFT, top, standardWidth - MARGIN_RIGHT, rowHeight),
+                               QString::number(blockNumber + 1));
+            }
+            if (addressLineNumbering && blockNumber < blockAddresses.size() && blockAddresses[blockNumber] >= 0) {
+                QString addressText = QString("CS:%1").arg(blockAddresses[blockNumber], 4, 16, QChar('0')).toUpper();
+                drawGutterText(painter, QRect(BREAKPOINT_AREA_WIDTH + standardWidth + MARGIN_LEFT, top, addressWidth - MARGIN_RIGHT, rowHeight),
+                               addressText);
+            }
+        }
+        block = block.next();
+        top = bottom;
+        ++blockNumber;
+    }
+}
 
-    QTextBlock currentBlock = document()->begin();
-    int currentBlockNumber = 0;
+void CodeEditor::drawGutterMarkers(QPainter& painter, const QRect& rect, const Breakpoint* breakpoint, bool execution) {
+    painter.save();
+    painter.setRenderHint(QPainter::Antialiasing);
+    const int size = qMin(rect.width(), rect.height()) - 4;
+    const QRect marker(rect.left() + (rect.width() - size) / 2, rect.top() + (rect.height() - size) / 2, size, size);
+    if (breakpoint) {
+        painter.setPen(Qt::NoPen);
+        painter.setBrush(breakpoint->condition.isEmpty() ? QColor(200, 30, 30) : QColor(230, 130, 20));
+        painter.drawEllipse(marker);
+    }
+    if (execution) {
+        const QPolygon arrow({marker.topLeft(), QPoint(marker.right(), marker.center().y()), marker.bottomLeft()});
+        painter.setPen(Qt::black);
+        painter.setBrush(QColor(255, 210, 40));
+        painter.drawPolygon(arrow);
+    }
+    painter.restore();
+}
 
-    while (currentBlock.isValid()) {
-        QString trimmed = currentBlock.text().trimmed();
+void CodeEditor::lineNumberAreaMousePressEvent(QMouseEvent* event) {
+    if (event->button() != Qt::LeftButton) return;
+    const QTextBlock block = cursorForPosition(QPoint(0, event->pos().y())).block();
+    if (block.isValid() && block.isVisible()) {
+        toggleBreakpoint(block.blockNumber());
+    }
+}
 
-        if (trimmed.startsWith("E ", Qt::CaseInsensitive)) {
-            processEditCommand(trimmed, currentBlockNumber);
+void CodeEditor::drawGutterText(QPainter& painter, const QRect& rect, const QString& text) {
+    if (fixedPitch) {
+        gutterAtlas.drawText(painter, rect.right() + 1 - gutterAtlas.textWidth(text),
+                             rect.top() + (rect.height() - gutterAtlas.glyphHeight()) / 2, text);
+    } else {
+        painter.drawText(rect, Qt::AlignRight | Qt::AlignVCenter, text);
+    }
+}
+
+QRect CodeEditor::gutterRowRect(int blockNumber) {
+    QTextBlock block = document()->findBlockByNumber(blockNumber);
+    if (!block.isValid() || !block.isVisible()) {
+        return QRect();
+    }
+    QRectF geometry = blockBoundingGeometry(block).translated(contentOffset());
+    return QRect(0, qFloor(geometry.top()), lineNumberArea->width(), qCeil(geometry.height()));
+}
+
+void CodeEditor::updateGutterRow(int blockNumber) {
+    QRect rect = gutterRowRect(blockNumber);
+    if (rect.intersects(lineNumberArea->rect())) {
+        lineNumberArea->update(rect);
+    }
+}
+
+int CodeEditor::lineHeight() {
+    if (cachedLineHeight <= 0) {
+        QTextBlock block = document()->firstBlock();
+        int lines = qMax(1, block.lineCount());
+        cachedLineHeight = qRound(blockBoundingRect(block).height()) / lines;
+        if (cachedLineHeight <= 0) {
+            cachedLineHeight = fontMetrics().lineSpacing();
+        }
+    }
+    return cachedLineHeight;
+}
+
+int CodeEditor::visualRowCount(const QTextBlock& block) {
+    if (!lineWrap) {
+        return 1;
+    }
+    if (block.lineCount() > 0) {
+        return block.lineCount();
+    }
+
+    const int charWidth = qMax(1, fontMetrics().horizontalAdvance(QLatin1Char(' ')));
+    const int tabColumns = qMax(1, qRound(tabStopDistance() / charWidth));
+    const int columnsPerRow = qMax(1, int((viewport()->width() - 2 * document()->documentMargin()) / charWidth));
+    int columns = 0;
+    for (const QChar& c : block.text()) {
+        columns = (c == QLatin1Char('\t')) ? (columns / tabColumns + 1) * tabColumns : columns + 1;
+    }
+    return qMax(1, (columns + columnsPerRow - 1) / columnsPerRow);
+}
+
+void CodeEditor::updateAddressTable() {
+    if (loading) return;
+    const QVector<int> previous = blockAddresses;
+    blockAddresses.fill(-1, blockCount());
+    imageWrites.clear();
+    addressLines.clear();
+    QVector<CodeReference> references;
+    auto collect = [&references](const QVector<CodeReference>& found, int line) {
+        for (CodeReference reference : found) {
+            reference.line = line;
+            references.append(reference);
         }
+    };
 
-        if (addressLineNumbering) {
-            if (trimmed.startsWith("A ", Qt::CaseInsensitive)) {
-                QStringList parts = trimmed.split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
-                if (parts.size() >= 2) {
-                    bool ok;
-                    currentAddress = parts[1].toInt(&ok, 16);
-                    if (ok) {
-                        addressMode = true;
-                        nextAddress = currentAddress;
-                        showNextEmptyAddress = true;
-                    }
-                }
+    if (sourceMode) {
+        QStringList source;
+        source.reserve(blockCount());
+        for (QTextBlock block = document()->begin(); block.isValid(); block = block.next()) {
+            source.append(block.text());
+        }
+        const AssemblyResult& result = assembler.assemble(source);
+        QTextBlock block = document()->begin();
+        for (int i = 0; i < result.lines.size() && i < blockAddresses.size(); ++i, block = block.next()) {
+            const AssembledLine& line = result.lines[i];
+            if (line.bytes.isEmpty()) continue;
+            blockAddresses[i] = line.address;
+            imageWrites.append({line.address, line.bytes});
+            if (!line.isData) {
+                collect(lineReferences(block, line.address, line.bytes), i);
             }
-            else if (trimmed.isEmpty() && addressMode && showNextEmptyAddress) {
-                if (currentBlockNumber >= blockNumber && currentBlock.isVisible() && bottom >= event->rect().top()) {
-                    QString addressText = QString("CS:%1").arg(nextAddress, 4, 16, QChar('0')).toUpper();
-                    painter.setPen(Qt::black);
-                    painter.drawText(standardWidth + MARGIN_LEFT, top, addressWidth - MARGIN_RIGHT, fontMetrics().height(),
-                                     Qt::AlignRight | Qt::AlignVCenter, addressText);
+        }
+    } else {
+        bool addressMode = false;
+        int nextAddress = -1;
+        int blockNumber = 0;
+        for (QTextBlock block = document()->begin(); block.isValid(); block = block.next(), ++blockNumber) {
+            const ScriptLine& line = blockData(block)->line;
+            if (line.head == "A") {
+                if (line.commandAddress >= 0) {
+                    addressMode = true;
+                    nextAddress = line.commandAddress;
                 }
+            } else if (addressMode && line.empty) {
+                blockAddresses[blockNumber] = nextAddress;
                 addressMode = false;
-                showNextEmptyAddress = false;
-            }
-            else if (addressMode && !trimmed.isEmpty()) {
-                if (currentBlockNumber >= blockNumber && currentBlock.isVisible() && bottom >= event->rect().top()) {
-                    QString addressText = QString("CS:%1").arg(nextAddress, 4, 16, QChar('0')).toUpper();
-                    painter.setPen(Qt::black);
-                    painter.drawText(standardWidth + MARGIN_LEFT, top, addressWidth - MARGIN_RIGHT, fontMetrics().height(),
-                                     Qt::AlignRight | Qt::AlignVCenter, addressText);
+            } else if (addressMode) {
+                blockAddresses[blockNumber] = nextAddress;
+                const QByteArray& bytes = encodedBytes(block, nextAddress);
+                if (!bytes.isEmpty()) {
+                    imageWrites.append({nextAddress, bytes});
+                    if (line.mnemonic != "DB" && line.mnemonic != "DW") {
+                        collect(lineReferences(block, nextAddress, bytes), blockNumber);
+                    }
                 }
-                nextAddress += calculateInstructionLength(trimmed);
+                nextAddress += bytes.size();
+            } else if (line.head == "E" && line.commandAddress >= 0 && !line.editData.isEmpty()) {
+                imageWrites.append({line.commandAddress, line.editData});
             }
         }
+    }
+
+    int blockNumber = 0;
+    for (QTextBlock block = document()->begin(); block.isValid(); block = block.next(), ++blockNumber) {
+        if (blockAddresses[blockNumber] >= 0 && !block.text().trimmed().isEmpty()
+            && !addressLines.contains(blockAddresses[blockNumber])) {
+            addressLines.insert(blockAddresses[blockNumber], blockNumber);
+        }
+    }
+    updateReferenceIndex(references);
+
+    if (!addressLineNumbering) return;
+    for (QTextBlock block = firstVisibleBlock(); block.isValid(); block = block.next()) {
+        QRectF geometry = blockBoundingGeometry(block).translated(contentOffset());
+        if (geometry.top() > lineNumberArea->height()) break;
+        int number = block.blockNumber();
+        if (number >= previous.size() || previous[number] != blockAddresses[number]) {
+            updateGutterRow(number);
+        }
+    }
+}
+
+const QVector<CodeReference>& CodeEditor::lineReferences(const QTextBlock& block, int address, const QByteArray& bytes) {
+    BlockData* data = blockData(block);
+    if (data->referencesAddress == address && data->referencedBytes == bytes) return data->references;
+    data->referencesAddress = address;
+    data->referencedBytes = bytes;
+    data->references.clear();
+
+    DecodedInstruction instruction = InstructionDecoder::decode(bytes, 0, address);
+    if (!instruction.isValid()) return data->references;
+
+    CodeReference reference;
+    reference.address = address;
+    if (instruction.target >= 0) {
+        switch (instruction.flow) {
+        case DecodedInstruction::Call: reference.kind = CodeReference::Call; break;
+        case DecodedInstruction::Branch: reference.kind = CodeReference::Branch; break;
+        default: reference.kind = CodeReference::Jump; break;
+        }
+        reference.target = instruction.target;
+        data->references.append(reference);
+        return data->references;
+    }
+
+    // Direct memory operands and word immediates (MOV DX,0109 before INT 21) point at data in the image.
+    reference.kind = CodeReference::Data;
+    for (const QString& text : instruction.operands) {
+        Operand operand = ScriptParser::parseOperand(text);
+        const bool direct = operand.type == Operand::Memory && operand.rm < 0;
+        const bool word = operand.type == Operand::Immediate && text.size() == 4;
+        if (direct || word) {
+            reference.target = operand.value & 0xFFFF;
+            data->references.append(reference);
+        }
+    }
+    return data->references;
+}
+
+void CodeEditor::updateReferenceIndex(const QVector<CodeReference>& references) {
+    QVector<CodeReference> resolved;
+    resolved.reserve(references.size());
+    for (CodeReference reference : references) {
+        reference.targetLine = addressLines.value(reference.target, -1);
+        if (reference.kind == CodeReference::Data && reference.targetLine < 0) continue;
+        resolved.append(reference);
+    }
+    if (resolved == indexedReferences) return;
+
+    const bool hadArcs = referenceIndex.hasArcs();
+    indexedReferences = resolved;
+    referenceIndex.rebuild(indexedReferences);
+    if (referenceIndex.hasArcs() != hadArcs) {
+        updateLineNumberAreaWidth();
+    }
+    jumpArrowArea->update();
+}
+
+void CodeEditor::goToTarget() {
+    const QVector<CodeReference> references = referenceIndex.referencesFrom(textCursor().blockNumber());
+    for (const CodeReference& reference : references) {
+        if (reference.targetLine >= 0) {
+            goToLine(reference.targetLine);
+            return;
+        }
+    }
+    showReferences(QVector<CodeReference>(),
+                   references.isEmpty() ? tr("No target on this line")
+                                        : tr("Target %1 is outside the script").arg(InstructionDecoder::hexWord(references.first().target)));
+}
+
+void CodeEditor::findReferences() {
+    const int line = textCursor().blockNumber();
+    if (line >= blockAddresses.size() || blockAddresses[line] < 0) return;
+    showReferences(referenceIndex.referencesTo(blockAddresses[line]),
+                   tr("No references to %1").arg(InstructionDecoder::hexWord(blockAddresses[line])));
+}
+
+void CodeEditor::findCallers() {
+    const int line = textCursor().blockNumber();
+    if (line >= blockAddresses.size() || blockAddresses[line] < 0) return;
+    showReferences(referenceIndex.callersOf(blockAddresses[line]),
+                   tr("No calls lead to %1").arg(InstructionDecoder::hexWord(blockAddresses[line])));
+}
+
+void CodeEditor::showReferences(const QVector<CodeReference>& references, const QString& emptyMessage) {
+    const QPoint position = viewport()->mapToGlobal(cursorRect().bottomLeft());
+    if (references.isEmpty()) {
+        QToolTip::showText(position, emptyMessage, viewport());
+        return;
+    }
+    if (references.size() == 1) {
+        goToLine(references.first().line);
+        return;
+    }
+
+    QMenu menu(this);
+    for (const CodeReference& reference : references) {
+        QTextBlock block = document()->findBlockByNumber(reference.line);
+        QAction* action = menu.addAction(tr("Line %1: %2").arg(reference.line + 1).arg(block.text().trimmed()));
+        const int line = reference.line;
+        connect(action, &QAction::triggered, this, [this, line]() { goToLine(line); });
+    }
+    menu.exec(position);
+}
+
+void CodeEditor::goToLine(int line) {
+    QTextBlock block = document()->findBlockByNumber(line);
+    if (!block.isValid()) return;
+    if (!block.isVisible()) unfoldAll();
+
+    QTextCursor cursor = textCursor();
+    cursor.setPosition(block.position());
+    setTextCursor(cursor);
+    centerCursor();
+}
+
+void CodeEditor::toggleBreakpoint(int line) {
+    if (addressForLine(line) < 0 || document()->findBlockByNumber(line).text().trimmed().isEmpty()) return;
+    const int count = breakpoints.size();
+    breakpoints.erase(std::remove_if(breakpoints.begin(), breakpoints.end(),
+                                     [line](const Breakpoint& breakpoint) { return breakpoint.cursor.blockNumber() == line; }),
+                      breakpoints.end());
+    if (breakpoints.size() == count) {
+        breakpoints.append({QTextCursor(document()->findBlockByNumber(line)), QString()});
+    }
+    updateGutterRow(line);
+    emit breakpointsChanged();
+}
+
+void CodeEditor::setBreakpointCondition(int line, const QString& condition) {
+    if (addressForLine(line) < 0 || document()->findBlockByNumber(line).text().trimmed().isEmpty()) return;
+    auto it = std::find_if(breakpoints.begin(), breakpoints.end(),
+                           [line](const Breakpoint& breakpoint) { return breakpoint.cursor.blockNumber() == line; });
+    if (it == breakpoints.end()) {
+        breakpoints.append({QTextCursor(document()->findBlockByNumber(line)), condition.trimmed()});
+    } else {
+        it->condition = condition.trimmed();
+    }
+    updateGutterRow(line);
+    emit breakpointsChanged();
+}
+
+QString CodeEditor::breakpointCondition(int line) const {
+    for (const Breakpoint& breakpoint : breakpoints) {
+        if (breakpoint.cursor.blockNumber() == line) return breakpoint.condition;
+    }
+    return QString();
+}
+
+QHash<int, QString> CodeEditor::breakpointConditions() const {
+    QHash<int, QString> conditions;
+    for (const Breakpoint& breakpoint : breakpoints) {
+        const int address = addressForLine(breakpoint.cursor.blockNumber());
+        if (address >= 0) conditions.insert(address, breakpoint.condition);
+    }
+    return conditions;
+}
+
+int CodeEditor::addressForLine(int line) const {
+    return line >= 0 && line < blockAddresses.size() ? blockAddresses[line] : -1;
+}
+
+QByteArray CodeEditor::programImage() const {
+    return memoryImage.isEmpty() ? QByteArray(MEMORY_IMAGE_SIZE, 0) : memoryImage;
+}
+
+int CodeEditor::entryPoint() const {
+    return sourceMode ? assembler.result().origin : DEFAULT_ENTRY_POINT;
+}
+
+void CodeEditor::setExecutionAddress(int address) {
+    const int line = address >= 0 ? lineForAddress(address) : -1;
+    if (line == executionLine) return;
+    const int previous = executionLine;
+    executionLine = line;
+    if (line >= 0) {
+        QTextBlock block = document()->findBlockByNumber(line);
+        if (!block.isVisible()) unfoldAll();
+        QTextCursor cursor = textCursor();
+        cursor.setPosition(block.position());
+        setTextCursor(cursor);
+        ensureCursorVisible();
+    }
+    highlightCurrentLine();
+    updateGutterRow(previous);
+    updateGutterRow(line);
+}
+
+void CodeEditor::jumpArrowAreaPaintEvent(QPaintEvent* event) {
+    QPainter painter(jumpArrowArea);
+    painter.fillRect(event->rect(), Qt::lightGray);
+    if (!referenceIndex.hasArcs()) return;
+
+    QTextBlock block = firstVisibleBlock();
+    const int firstLine = block.blockNumber();
+    int top = qRound(blockBoundingGeometry(block).translated(contentOffset()).top());
+    QVector<int> centres;
+    while (block.isValid() && top <= jumpArrowArea->height()) {
+        if (block.isVisible()) {
+            const int height = fixedPitch ? lineHeight() * visualRowCount(block) : qRound(blockBoundingRect(block).height());
+            centres.append(top + qMin(height, lineHeight()) / 2);
+            top += height;
+        } else {
+            centres.append(-1);
+        }
+        block = block.next();
+    }
+    const int lastLine = firstLine + int(centres.size()) - 1;
+
+    struct Arc {
+        CodeReference reference;
+        int low;
+        int high;
+        int lane;
+    };
+    QVector<Arc> arcs;
+    for (const CodeReference& reference : referenceIndex.arcsInRange(firstLine, lastLine)) {
+        arcs.append({reference, qMin(reference.line, reference.targetLine), qMax(reference.line, reference.targetLine), 0});
+    }
+    std::sort(arcs.begin(), arcs.end(), [](const Arc& a, const Arc& b) { return a.high - a.low < b.high - b.low; });
+
+    // Shorter arcs take the inner lanes; an arc moves outwards until it no longer overlaps a placed one.
+    for (int i = 0; i < arcs.size(); ++i) {
+        QVector<bool> taken(JUMP_ARROW_LANES, false);
+        for (int j = 0; j < i; ++j) {
+            if (arcs[j].low <= arcs[i].high && arcs[i].low <= arcs[j].high) taken[arcs[j].lane] = true;
+        }
+        while (arcs[i].lane < JUMP_ARROW_LANES - 1 && taken[arcs[i].lane]) ++arcs[i].lane;
+    }
 
-        if (standardLineNumbering && currentBlockNumber >= blockNumber && currentBlock.isVisible() && bottom >= event->rect().top()) {
-            painter.setPen(Qt::black);
-            const QString number = QString::number(currentBlockNumber + 1);
-            painter.drawText(MARGIN_LEFT, top, standardWidth - MARGIN_RIGHT, fontMetrics().height(),
-                             Qt::AlignRight | Qt::AlignVCenter, number);
+    auto lineY = [&](int line) {
+        if (line < firstLine) return -1;
+        if (line > lastLine) return jumpArrowArea->height() + 1;
+        return centres[line - firstLine];
+    };
+    const int right = jumpArrowArea->width() - 2;
+    const int current = textCursor().blockNumber();
+    painter.setRenderHint(QPainter::Antialiasing);
+    for (const Arc& arc : arcs) {
+        const int from = lineY(arc.reference.line);
+        const int to = lineY(arc.reference.targetLine);
+        if ((arc.reference.line >= firstLine && arc.reference.line <= lastLine && from < 0)
+            || (arc.reference.targetLine >= firstLine && arc.reference.targetLine <= lastLine && to < 0)) {
+            continue;
         }
 
-        if (currentBlockNumber >= blockNumber) {
-            top = bottom;
-            bottom = top + qRound(blockBoundingRect(currentBlock).height());
+        const int x = right - (arc.lane + 1) * JUMP_ARROW_LANE_WIDTH;
+        QColor color = arc.reference.kind == CodeReference::Branch ? QColor(0, 90, 200) : QColor(Qt::darkGray);
+        const bool active = arc.reference.line == current || arc.reference.targetLine == current;
+        painter.setPen(QPen(color, active ? 2 : 1));
+        const QPoint points[] = {QPoint(right, from), QPoint(x, from), QPoint(x, to), QPoint(right - JUMP_ARROW_HEAD, to)};
+        painter.drawPolyline(points, 4);
+        if (to >= 0 && to <= jumpArrowArea->height()) {
+            const QPoint head[] = {QPoint(right, to), QPoint(right - JUMP_ARROW_HEAD, to - JUMP_ARROW_HEAD),
+                                   QPoint(right - JUMP_ARROW_HEAD, to + JUMP_ARROW_HEAD)};
+            painter.setBrush(color);
+            painter.drawPolygon(head, 3);
         }
-        currentBlock = currentBlock.next();
-        ++currentBlockNumber;
     }
 }
 
@@ -572,8 +1477,18 @@ void CodeEditor::memoryDumpAreaPaintEvent(QPaintEvent* event) {
 
     QPainter painter(memoryDumpArea);
     painter.fillRect(event->rect(), Qt::lightGray);
+    painter.setPen(Qt::black);
+    painter.setFont(QPlainTextEdit::font());
+
+    const int rowHeight = fontMetrics().height();
+    const int first = qMax(0, event->rect().top() / rowHeight);
+    const int last = qMin(int(dumpRows.size()) - 1, event->rect().bottom() / rowHeight);
+    for (int i = first; i <= last; ++i) {
+        painter.drawStaticText(MARGIN_LEFT, i * rowHeight, dumpRows[i].text);
+    }
+}
 
-    int top = 0;
+void CodeEditor::updateDumpRows(bool force) {
     bool ok;
     int offset = memoryDumpOffset.toInt(&ok, 16);
     if (!ok) offset = 0x200;
@@ -581,15 +1496,20 @@ void CodeEditor::memoryDumpAreaPaintEvent(QPaintEvent* event) {
     int segment = memoryDumpSegment.toInt(&ok, 16);
     if (!ok) segment = 0x1000;
 
-    for (int i = 0; i < memoryDumpLineCount; ++i) {
-        QString dumpLine;
+    const int rowHeight = fontMetrics().height();
+    dumpRows.resize(qMax(0, memoryDumpLineCount));
+    for (int i = 0; i < dumpRows.size(); ++i) {
         int currentOffset = offset + i * 16;
-        dumpLine += QString("%1:%2  ")
-                        .arg(segment, 4, 16, QChar('0'))
-                        .arg(currentOffset, 4, 16, QChar('0'))
-                        .toUpper();
+        QByteArray data = memoryRow(currentOffset);
+        DumpRow& row = dumpRows[i];
+        if (!force && !row.text.text().isEmpty() && row.bytes == data) {
+            continue;
+        }
 
-        QByteArray data = memoryChanges.value(currentOffset, QByteArray(16, 0));
+        QString dumpLine = QString("%1:%2  ")
+                               .arg(segment, 4, 16, QChar('0'))
+                               .arg(currentOffset, 4, 16, QChar('0'))
+                               .toUpper();
         for (int j = 0; j < 16; ++j) {
             dumpLine += QString("%1 ").arg((unsigned char)data[j], 2, 16, QChar('0')).toUpper();
         }
@@ -599,9 +1519,16 @@ void CodeEditor::memoryDumpAreaPaintEvent(QPaintEvent* event) {
             dumpLine += (c >= 32 && c <= 126) ? QChar(c) : QChar('.');
         }
 
-        painter.setPen(Qt::black);
-        painter.drawText(MARGIN_LEFT, top + i * fontMetrics().height(), memoryDumpAreaWidth() - MARGIN_RIGHT, fontMetrics().height(),
-                         Qt::AlignLeft | Qt::AlignVCenter, dumpLine);
+        row.bytes = data;
+        row.text.setTextFormat(Qt::PlainText);
+        row.text.setText(dumpLine);
+        row.text.prepare(QTransform(), QPlainTextEdit::font());
+        if (!force) {
+            memoryDumpArea->update(0, i * rowHeight, memoryDumpArea->width(), rowHeight);
+        }
+    }
+    if (force) {
+        memoryDumpArea->update();
     }
 }
 
@@ -609,6 +1536,7 @@ void CodeEditor::resizeEvent(QResizeEvent* event) {
     QPlainTextEdit::resizeEvent(event);
     QRect cr = contentsRect();
     lineNumberArea->setGeometry(QRect(cr.left(), cr.top(), lineNumberAreaWidth(), cr.height()));
+    jumpArrowArea->setGeometry(QRect(cr.left() + lineNumberAreaWidth(), cr.top(), jumpArrowAreaWidth(), cr.height()));
     memoryDumpArea->setGeometry(QRect(cr.right() - memoryDumpAreaWidth(), cr.top(), memoryDumpAreaWidth(), cr.height()));
     lineNumberArea->update();
     memoryDumpArea->update();
@@ -616,13 +1544,20 @@ void CodeEditor::resizeEvent(QResizeEvent* event) {
 
 void CodeEditor::updateLineNumberAreaWidth() {
     int width = lineNumberAreaWidth();
-    setViewportMargins(width, 0, showMemoryDump ? memoryDumpAreaWidth() : 0, 0);
+    QRect cr = contentsRect();
+    jumpArrowArea->setGeometry(QRect(cr.left() + width, cr.top(), jumpArrowAreaWidth(), cr.height()));
+    setViewportMargins(width + jumpArrowAreaWidth(), 0, showMemoryDump ? memoryDumpAreaWidth() : 0, 0);
     lineNumberArea->update();
     memoryDumpArea->update();
 }
 
 int CodeEditor::lineNumberAreaWidth() {
-    return calculateStandardWidth() + calculateAddressWidth();
+    return BREAKPOINT_AREA_WIDTH + calculateStandardWidth() + calculateAddressWidth();
+}
+
+int CodeEditor::jumpArrowAreaWidth() {
+    if (!referenceIndex.hasArcs()) return 0;
+    return JUMP_ARROW_LANES * JUMP_ARROW_LANE_WIDTH + JUMP_ARROW_HEAD + MARGIN_LEFT;
 }
 
 int CodeEditor::memoryDumpAreaWidth() {
@@ -635,13 +1570,11 @@ void CodeEditor::updateLineNumberArea(const QRect& rect, int dy) {
         lineNumberArea->scroll(0, dy);
     }
     lineNumberArea->update(0, rect.y(), lineNumberArea->width(), rect.height());
-}
-
-void CodeEditor::updateMemoryDumpArea(const QRect& rect, int dy) {
     if (dy) {
-        memoryDumpArea->scroll(0, dy);
+        jumpArrowArea->update();
+    } else {
+        jumpArrowArea->update(0, rect.y(), jumpArrowArea->width(), rect.height());
     }
-    memoryDumpArea->update(0, rect.y(), memoryDumpArea->width(), rect.height());
 }
 
 void CodeEditor::highlightCurrentLine() {
@@ -654,24 +1587,91 @@ void CodeEditor::highlightCurrentLine() {
         selection.cursor.clearSelection();
         extraSelections.append(selection);
     }
+    if (executionLine >= 0) {
+        QColor executionColor = palette().color(QPalette::Highlight);
+        executionColor.setAlpha(96);
+        QTextEdit::ExtraSelection selection;
+        selection.format.setBackground(executionColor);
+        selection.format.setProperty(QTextFormat::FullWidthSelection, true);
+        selection.cursor = QTextCursor(document()->findBlockByNumber(executionLine));
+        extraSelections.append(selection);
+    }
+    for (const QTextCursor& cursor : extraCursors) {
+        if (!cursor.hasSelection()) continue;
+        QTextEdit::ExtraSelection selection;
+        selection.format.setBackground(palette().color(QPalette::Highlight));
+        selection.format.setForeground(palette().color(QPalette::HighlightedText));
+        selection.cursor = cursor;
+        extraSelections.append(selection);
+    }
+    extraSelections.append(diagnosticSelections);
     setExtraSelections(extraSelections);
-    lineNumberArea->update();
-    memoryDumpArea->update();
+
+    int blockNumber = textCursor().blockNumber();
+    if (blockNumber != gutterCurrentBlock) {
+        updateGutterRow(gutterCurrentBlock);
+        gutterCurrentBlock = blockNumber;
+        updateGutterRow(gutterCurrentBlock);
+        if (referenceIndex.hasArcs()) jumpArrowArea->update();
+    }
 }
 
 void CodeEditor::updateMemoryDump() {
-    memoryChanges.clear();
-    QTextBlock block = document()->begin();
-    int blockNumber = 0;
-    while (block.isValid()) {
-        QString line = block.text().trimmed();
-        if (line.startsWith("E ", Qt::CaseInsensitive)) {
-            processEditCommand(line, blockNumber);
+    if (loading) return;
+    if (memoryImage.isEmpty()) {
+        memoryImage = QByteArray(MEMORY_IMAGE_SIZE, 0);
+    }
+
+    auto key = [](const ImageWrite& write) {
+        QByteArray key(reinterpret_cast<const char*>(&write.address), sizeof(write.address));
+        return key + write.bytes;
+    };
+    QHash<QByteArray, int> balance;
+    for (const ImageWrite& write : appliedWrites) {
+        --balance[key(write)];
+    }
+    for (const ImageWrite& write : imageWrites) {
+        ++balance[key(write)];
+    }
+
+    QSet<int> dirtyRows;
+    auto markRows = [&dirtyRows](int address, int size) {
+        for (int row = address >> 4; row <= (address + size - 1) >> 4; ++row) {
+            dirtyRows.insert(row & 0xFFF);
         }
-        block = block.next();
-        ++blockNumber;
+    };
+    for (auto it = balance.constBegin(); it != balance.constEnd(); ++it) {
+        if (it.value() == 0) continue;
+        int address;
+        memcpy(&address, it.key().constData(), sizeof(address));
+        markRows(address, int(it.key().size() - sizeof(address)));
     }
-    memoryDumpArea->update();
+    appliedWrites = imageWrites;
+    if (dirtyRows.isEmpty()) return;
+
+    for (int row : dirtyRows) {
+        memset(memoryImage.data() + row * 16, 0, 16);
+    }
+    for (const ImageWrite& write : imageWrites) {
+        for (int i = 0; i < write.bytes.size(); ++i) {
+            int address = (write.address + i) & (MEMORY_IMAGE_SIZE - 1);
+            if (dirtyRows.contains(address >> 4)) {
+                memoryImage[address] = write.bytes[i];
+            } else {
+                i += 15 - (address & 0xF);
+            }
+        }
+    }
+    updateDumpRows(false);
+}
+
+QByteArray CodeEditor::memoryRow(int offset) const {
+    QByteArray row(16, 0);
+    if (memoryImage.isEmpty()) return row;
+    for (int i = 0; i < 16; ++i) {
+        row[i] = memoryImage[(offset + i) & (MEMORY_IMAGE_SIZE - 1)];
+    }
+    return row;
 }
 
 int CodeEditor::calculateStandardWidth() const {
@@ -693,52 +1693,3 @@ int CodeEditor::calculateAddressWidth() const {
     }
     return fontMetrics().horizontalAdvance(ADDRESS_FORMAT) + ADDRESS_EXTRA_WIDTH;
 }
-
-void CodeEditor::processEditCommand(const QString& line, int blockNumber) {
-    Q_UNUSED(blockNumber)
-    QString trimmed = line.trimmed();
-    QRegularExpression re("^E\\s+([0-9A-Fa-f]+:)?([0-9A-Fa-f]+)\\s+(.+)$", QRegularExpression::CaseInsensitiveOption);
-    QRegularExpressionMatch match = re.match(trimmed);
-    if (!match.hasMatch()) return;
-
-    bool ok;
-    int address = match.captured(2).toInt(&ok, 16);
-    if (!ok) return;
-
-    QString dataPart = match.captured(3);
-    QByteArray data;
-
-    QRegularExpression stringRe("^\"(.+)\"$", QRegularExpression::CaseInsensitiveOption);
-    QRegularExpressionMatch stringMatch = stringRe.match(dataPart);
-    if (stringMatch.hasMatch()) {
-        QString str = stringMatch.captured(1);
-        data = str.toLatin1();
-    } else {
-        QStringList byteParts = dataPart.split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
-        for (const QString& byteStr : byteParts) {
-            int byte = byteStr.toInt(&ok, 16);
-            if (ok && byte >= 0 && byte <= 255) {
-                data.append(static_cast<char>(byte));
-            }
-        }
-    }
-
-    if (!data.isEmpty()) {
-        int globalOffset = address;
-        int pos = 0;
-        while (pos < data.size()) {
-            int blockAddress = globalOffset & ~0xF;
-            int offsetInBlock = globalOffset & 0xF;
-            int bytesToWrite = qMin(16 - offsetInBlock, data.size() - pos);
-
-            QByteArray block = memoryChanges.value(blockAddress, QByteArray(16, 0));
-            for (int i = 0; i < bytesToWrite; ++i) {
-                block[offsetInBlock + i] = data[pos + i];
-            }
-            memoryChanges[blockAddress] = block;
-
-            pos += bytesToWrite;
-            globalOffset += bytesToWrite;
-        }
-    }
-}
@@ -10,19 +10,47 @@
 #include <QRegularExpression>
 #include <QColor>
 #include <QMap>
+#include <QHash>
+#include <QSet>
+#include <QVector>
+#include <QList>
+#include <QTextCursor>
+#include <functional>
+#include <QStaticText>
+#include "editorsettings.h"
+#include "glyphatlas.h"
+#include "scriptparser.h"
+#include "diagnosticsengine.h"
+#include "assembler.h"
+#include "disassembler.h"
+#include "referenceindex.h"
 
 class LineNumberArea;
+class QTimer;
 class MemoryDumpArea;
+class JumpArrowArea;
 
 class CodeEditor : public QPlainTextEdit {
     Q_OBJECT
 protected:
     void resizeEvent(QResizeEvent* event) override;
     void keyPressEvent(QKeyEvent* event) override;
+    void insertFromMimeData(const QMimeData* source) override;
+    void paintEvent(QPaintEvent* event) override;
+    void mousePressEvent(QMouseEvent* event) override;
+    bool viewportEvent(QEvent* event) override;
+    void contextMenuEvent(QContextMenuEvent* event) override;
+signals:
+    void contentChanged();
+    void breakpointsChanged();
 private slots:
     void updateLineNumberArea(const QRect& rect, int dy);
-    void updateMemoryDumpArea(const QRect& rect, int dy);
     void highlightCurrentLine();
+    void handleContentsChange(int position, int charsRemoved, int charsAdded);
+    void handleTextChanged();
+    void requestDiagnostics();
+    void applyDiagnostics(const QVector<Diagnostic>& diagnostics);
+    void applyValueHints(const QVector<ValueHint>& hints);
 public:
     CodeEditor(QWidget* parent = nullptr);
     ~CodeEditor();
@@ -34,11 +62,40 @@ public:
     void setLineWrap(bool enabled);
     void setSyntaxHighlighting(bool enabled);
     void setShowMemoryDump(bool enabled, const QString& segment, const QString& offset, int lineCount);
+    void applySettings(const EditorSettings& settings, const QSet<QString>& changedKeys);
     QString getText() const;
+    QString wordUnderCursor() const;
     void setText(const QString& text);
+    void beginBulkLoad();
+    void appendChunk(const QString& text);
+    void endBulkLoad();
+    bool isLoading() const;
+    void setSourceMode(bool enabled);
+    bool isSourceMode() const;
+    const AssemblyResult& assembly();
+    const ControlFlowGraph& controlFlowGraph();
+    int lineForAddress(int address);
+    void toggleFold();
+    void unfoldAll();
+    void goToTarget();
+    void findReferences();
+    void findCallers();
+    void toggleBreakpoint(int line);
+    void setBreakpointCondition(int line, const QString& condition);
+    QString breakpointCondition(int line) const;
+    QHash<int, QString> breakpointConditions() const;
+    int addressForLine(int line) const;
+    QByteArray programImage() const;
+    int entryPoint() const;
+    void setExecutionAddress(int address);
+    void beginTransaction();
+    void endTransaction();
     void lineNumberAreaPaintEvent(QPaintEvent* event);
+    void lineNumberAreaMousePressEvent(QMouseEvent* event);
     void memoryDumpAreaPaintEvent(QPaintEvent* event);
+    void jumpArrowAreaPaintEvent(QPaintEvent* event);
     int lineNumberAreaWidth();
+    int jumpArrowAreaWidth();
     int memoryDumpAreaWidth();
     void updateMemoryDump();
     void toggleComment();
@@ -47,11 +104,22 @@ public:
     void duplicateLine(bool up);
     void addCursorUp();
     void addCursorDown();
+    void clearExtraCursors();
+    bool hasExtraCursors() const;
     void deleteLine();
+    void applyQuickFix();
 private:
-    static const int MARGIN_LEFT = 5;
-    static const int MARGIN_RIGHT = 10;
-    static const int ADDRESS_EXTRA_WIDTH = 15;
+    static constexpr int MARGIN_LEFT = 5;
+    static constexpr int MARGIN_RIGHT = 10;
+    static constexpr int ADDRESS_EXTRA_WIDTH = 15;
+    static constexpr int BREAKPOINT_AREA_WIDTH = 14;
+    static constexpr int DIAGNOSTICS_DELAY_MS = 300;
+    static constexpr int MEMORY_IMAGE_SIZE = 0x10000;
+    static constexpr int DEFAULT_ENTRY_POINT = 0x100;
+    static constexpr int JUMP_ARROW_LANES = 6;
+    static constexpr int JUMP_ARROW_LANE_WIDTH = 5;
+    static constexpr int JUMP_ARROW_HEAD = 4;
+    static constexpr int VALUE_HINT_SPACING = 24;
     static const QString ADDRESS_FORMAT;
 
     QString theme;
@@ -66,13 +134,72 @@ private:
     QString memoryDumpOffset;
     LineNumberArea* lineNumberArea;
     MemoryDumpArea* memoryDumpArea;
+    JumpArrowArea* jumpArrowArea;
     QSyntaxHighlighter* highlighter;
     QColor backgroundColor;
     QColor textColor;
     QColor highlightColor;
     QColor commentColor;
     int memoryDumpLineCount;
-    QMap<int, QByteArray> memoryChanges;
+    struct ImageWrite {
+        int address;
+        QByteArray bytes;
+    };
+    QVector<ImageWrite> imageWrites;
+    QVector<ImageWrite> appliedWrites;
+    QByteArray memoryImage;
+    bool sourceMode;
+    Assembler assembler;
+    bool loading;
+    bool readOnlyBeforeLoad;
+    bool fixedPitch;
+    int cachedLineHeight;
+    QVector<int> blockAddresses;
+    GlyphAtlas gutterAtlas;
+    int gutterCurrentBlock;
+
+    struct DumpRow {
+        QByteArray bytes;
+        QStaticText text;
+    };
+    QVector<DumpRow> dumpRows;
+    int transactionDepth;
+    bool transactionDirty;
+    QList<QTextCursor> extraCursors;
+    struct Breakpoint {
+        QTextCursor cursor;
+        QString condition;
+    };
+    QList<Breakpoint> breakpoints;
+    int executionLine;
+    DiagnosticsEngine* diagnosticsEngine;
+    QTimer* diagnosticsTimer;
+    QVector<Diagnostic> diagnostics;
+    QList<QTextEdit::ExtraSelection> diagnosticSelections;
+    bool diagnosticsCurrent;
+    // Blocks edited since the last diagnostics request, and the block count that request will compare against.
+    int changedFirst;
+    int changedLast;
+    int changedBlockCount;
+    QHash<int, QString> valueHints;
+    int valueHintsBlockCount;
+    ControlFlowGraph controlFlow;
+    QHash<int, int> addressLines;
+    bool controlFlowDirty;
+    bool hasFolds;
+    ReferenceIndex referenceIndex;
+    QVector<CodeReference> indexedReferences;
+
+    class BlockData : public QTextBlockUserData {
+    public:
+        ScriptLine line;
+        int encodedAddress = -1;
+        bool addressDependent = false;
+        QByteArray encodedBytes;
+        int referencesAddress = -1;
+        QByteArray referencedBytes;
+        QVector<CodeReference> references;
+    };
 
     class SyntaxHighlighter : public QSyntaxHighlighter {
     public:
@@ -87,10 +214,29 @@ private:
     };
 
     void updateLineNumberAreaWidth();
+    void updateAddressTable();
+    int lineHeight();
+    int visualRowCount(const QTextBlock& block);
+    void drawValueHints(QPainter& painter, const QRect& rect);
+    void drawGutterText(QPainter& painter, const QRect& rect, const QString& text);
+    void drawGutterMarkers(QPainter& painter, const QRect& rect, const Breakpoint* breakpoint, bool execution);
+    QRect gutterRowRect(int blockNumber);
+    void updateGutterRow(int blockNumber);
+    void updateDumpRows(bool force);
     int calculateStandardWidth() const;
     int calculateAddressWidth() const;
-    int calculateInstructionLength(const QString &text);
-    void processEditCommand(const QString& line, int blockNumber);
+    const QByteArray& encodedBytes(const QTextBlock& block, int address);
+    QByteArray memoryRow(int offset) const;
+    const QVector<CodeReference>& lineReferences(const QTextBlock& block, int address, const QByteArray& bytes);
+    void updateReferenceIndex(const QVector<CodeReference>& references);
+    void showReferences(const QVector<CodeReference>& references, const QString& emptyMessage);
+    void goToLine(int line);
+    void applyFix(const Diagnostic& diagnostic);
+    BlockData* blockData(const QTextBlock& block);
+    void addCursorVertically(bool up);
+    bool handleMultiCursorKey(QKeyEvent* event);
+    void editAllCursors(const std::function<void(QTextCursor& cursor, int index)>& edit);
+    void recomputeDerivedState();
 };
 
 class LineNumberArea : public QWidget {
@@ -103,6 +249,9 @@ protected:
     void paintEvent(QPaintEvent* event) override {
         codeEditor->lineNumberAreaPaintEvent(event);
     }
+    void mousePressEvent(QMouseEvent* event) override {
+        codeEditor->lineNumberAreaMousePressEvent(event);
+    }
 private:
     CodeEditor* codeEditor;
 };
@@ -121,4 +270,18 @@ private:
     CodeEditor* codeEditor;
 };
 
+class JumpArrowArea : public QWidget {
+public:
+    JumpArrowArea(CodeEditor* editor) : QWidget(editor), codeEditor(editor) {}
+    QSize sizeHint() const override {
+        return QSize(codeEditor->jumpArrowAreaWidth(), 0);
+    }
+protected:
+    void paintEvent(QPaintEvent* event) override {
+        codeEditor->jumpArrowAreaPaintEvent(event);
+    }
+private:
+    CodeEditor* codeEditor;
+};
+
 #endif // CODEEDITOR_H
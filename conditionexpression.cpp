@@ -0,0 +1,390 @@
+#include "conditionexpression.h"
+#include <QStringList>
+#include <QPair>
+#include "emulator.h"
+
+namespace {
+
+const QStringList REGISTERS_8 = {"AL", "CL", "DL", "BL", "AH", "CH", "DH", "BH"};
+const QStringList REGISTERS_16 = {"AX", "CX", "DX", "BX", "SP", "BP", "SI", "DI"};
+const QStringList SEGMENT_REGISTERS = {"ES", "CS", "SS", "DS"};
+
+struct FlagName {
+    const char* name;
+    quint16 mask;
+};
+const FlagName FLAG_NAMES[] = {
+    {"CF", Emulator::CF}, {"PF", Emulator::PF}, {"AF", Emulator::AF}, {"ZF", Emulator::ZF}, {"SF", Emulator::SF},
+    {"TF", Emulator::TF}, {"IF", Emulator::IF}, {"DF", Emulator::DF}, {"OF", Emulator::OF}
+};
+
+}
+
+// Recursive descent over the expression, emitting postfix code as it goes.
+class ExpressionParser {
+public:
+    explicit ExpressionParser(const QString& text) : text(text.toUpper()), position(0), depth(0), maxDepth(0) {}
+
+    bool parse(QVector<ConditionExpression::Instruction>& code, QString& error) {
+        skipSpaces();
+        if (position >= text.size()) {
+            error = ConditionExpression::tr("The expression is empty");
+            return false;
+        }
+        if (!logicalOr()) {
+            error = message;
+            return false;
+        }
+        skipSpaces();
+        if (position < text.size()) {
+            error = ConditionExpression::tr("Unexpected \"%1\"").arg(text.mid(position));
+            return false;
+        }
+        if (maxDepth > ConditionExpression::MAX_DEPTH) {
+            error = ConditionExpression::tr("The expression is nested too deeply");
+            return false;
+        }
+        code = output;
+        return true;
+    }
+private:
+    using Opcode = ConditionExpression::Opcode;
+
+    QString text;
+    int position;
+    int depth;
+    int maxDepth;
+    QString message;
+    QVector<ConditionExpression::Instruction> output;
+
+    void append(Opcode opcode, quint16 operand = 0) {
+        output.append({opcode, operand});
+        if (opcode <= ConditionExpression::Flag) {
+            maxDepth = qMax(maxDepth, ++depth);
+        } else if (opcode >= ConditionExpression::Add && opcode <= ConditionExpression::LogicalOr) {
+            --depth;
+        }
+    }
+
+    bool fail(const QString& text) {
+        if (message.isEmpty()) message = text;
+        return false;
+    }
+
+    void skipSpaces() {
+        while (position < text.size() && text[position].isSpace()) ++position;
+    }
+
+    bool accept(const char* token) {
+        skipSpaces();
+        const QLatin1String expected(token);
+        if (!QStringView(text).mid(position).startsWith(expected)) return false;
+        position += expected.size();
+        return true;
+    }
+
+    QString peekWord() {
+        skipSpaces();
+        int end = position;
+        while (end < text.size() && (text[end].isLetterOrNumber() || text[end] == '_')) ++end;
+        return text.mid(position, end - position);
+    }
+
+    bool binary(bool (ExpressionParser::*operand)(), const QVector<QPair<const char*, Opcode>>& operators) {
+        if (!(this->*operand)()) return false;
+        forever {
+            bool matched = false;
+            for (const auto& candidate : operators) {
+                if (accept(candidate.first)) {
+                    if (!(this->*operand)()) return false;
+                    append(candidate.second);
+                    matched = true;
+                    break;
+                }
+            }
+            if (!matched) return true;
+        }
+    }
+
+    bool logicalOr() {
+        return binary(&ExpressionParser::logicalAnd, {{"||", ConditionExpression::LogicalOr}});
+    }
+
+    bool logicalAnd() {
+        return binary(&ExpressionParser::comparison, {{"&&", ConditionExpression::LogicalAnd}});
+    }
+
+    bool comparison() {
+        if (!bitOr()) return false;
+        // Longer tokens first so "<=" is not read as "<".
+        static const QVector<QPair<const char*, Opcode>> OPERATORS = {
+            {"==", ConditionExpression::Equal}, {"!=", ConditionExpression::NotEqual},
+            {"<>", ConditionExpression::NotEqual}, {"<=", ConditionExpression::LessEqual},
+            {">=", ConditionExpression::GreaterEqual}, {"<", ConditionExpression::Less},
+            {">", ConditionExpression::Greater}, {"=", ConditionExpression::Equal}
+        };
+        for (const auto& candidate : OPERATORS) {
+            if (accept(candidate.first)) {
+                if (!bitOr()) return false;
+                append(candidate.second);
+                return true;
+            }
+        }
+        return true;
+    }
+
+    // "|" and "&" share their first character with "||" and "&&", which belong to the levels above.
+    bool single(const char* token) {
+        skipSpaces();
+        if (text.mid(position, 2) == QString(token) + token) return false;
+        return accept(token);
+    }
+
+    bool bitOr() {
+        if (!bitXor()) return false;
+        while (single("|")) {
+            if (!bitXor()) return false;
+            append(ConditionExpression::BitOr);
+        }
+        return true;
+    }
+
+    bool bitXor() {
+        return binary(&ExpressionParser::bitAnd, {{"^", ConditionExpression::BitXor}});
+    }
+
+    bool bitAnd() {
+        if (!additive()) return false;
+        while (single("&")) {
+            if (!additive()) return false;
+            append(ConditionExpression::BitAnd);
+        }
+        return true;
+    }
+
+    bool additive() {
+        return binary(&ExpressionParser::multiplicative,
+                      {{"+", ConditionExpression::Add}, {"-", ConditionExpression::Subtract}});
+    }
+
+    bool multiplicative() {
+        return binary(&ExpressionParser::unary, {{"*", ConditionExpression::Multiply}});
+    }
+
+    bool unary() {
+        skipSpaces();
+        if (text.mid(position, 2) != "!=" && accept("!")) {
+            if (!unary()) return false;
+            append(ConditionExpression::LogicalNot);
+            return true;
+        }
+        if (accept("-")) {
+            if (!unary()) return false;
+            append(ConditionExpression::Negate);
+            return true;
+        }
+        if (accept("~")) {
+            if (!unary()) return false;
+            append(ConditionExpression::Complement);
+            return true;
+        }
+        return primary();
+    }
+
+    bool memory(Opcode size, int segment) {
+        if (!accept("[")) return fail(ConditionExpression::tr("Expected \"[\""));
+        if (!logicalOr()) return false;
+        if (!accept("]")) return fail(ConditionExpression::tr("Missing \"]\""));
+        append(size, quint16(segment));
+        return true;
+    }
+
+    bool primary() {
+        skipSpaces();
+        if (accept("(")) {
+            if (!logicalOr()) return false;
+            if (!accept(")")) return fail(ConditionExpression::tr("Missing \")\""));
+            return true;
+        }
+        if (text.mid(position, 1) == "[") return memory(ConditionExpression::Byte, Emulator::DS);
+
+        const QString word = peekWord();
+        if (word.isEmpty()) {
+            return fail(position < text.size() ? ConditionExpression::tr("Unexpected \"%1\"").arg(text.mid(position))
+                                               : ConditionExpression::tr("The expression ends too early"));
+        }
+        position += word.size();
+
+        Opcode size = ConditionExpression::Byte;
+        QString name = word;
+        if (word == "BYTE" || word == "WORD") {
+            size = word == "WORD" ? ConditionExpression::Word : ConditionExpression::Byte;
+            if (accept("PTR")) skipSpaces();
+            name = peekWord();
+            if (name.isEmpty()) return memory(size, Emulator::DS);
+            position += name.size();
+            if (!SEGMENT_REGISTERS.contains(name)) {
+                return fail(ConditionExpression::tr("Expected a memory operand after \"%1\"").arg(word));
+            }
+        }
+        if (SEGMENT_REGISTERS.contains(name)) {
+            const int segment = SEGMENT_REGISTERS.indexOf(name);
+            if (accept(":")) return memory(size, segment);
+            if (name != word) return fail(ConditionExpression::tr("Expected \":\" after \"%1\"").arg(name));
+            append(ConditionExpression::Segment, quint16(segment));
+            return true;
+        }
+        if (REGISTERS_16.contains(name)) {
+            append(ConditionExpression::Register16, quint16(REGISTERS_16.indexOf(name)));
+            return true;
+        }
+        if (REGISTERS_8.contains(name)) {
+            append(ConditionExpression::Register8, quint16(REGISTERS_8.indexOf(name)));
+            return true;
+        }
+        if (name == "IP") {
+            append(ConditionExpression::InstructionPointer);
+            return true;
+        }
+        if (name == "FL") {
+            append(ConditionExpression::Flag, 0xFFFF);
+            return true;
+        }
+        for (const FlagName& flag : FLAG_NAMES) {
+            if (name == QLatin1String(flag.name)) {
+                append(ConditionExpression::Flag, flag.mask);
+                return true;
+            }
+        }
+
+        QString digits = name;
+        if (digits.size() > 1 && digits.endsWith('H')) digits.chop(1);
+        bool ok;
+        const uint value = digits.toUInt(&ok, 16);
+        if (!ok || value > 0xFFFF) return fail(ConditionExpression::tr("Unknown name or number \"%1\"").arg(word));
+        append(ConditionExpression::Constant, quint16(value));
+        return true;
+    }
+};
+
+ConditionExpression ConditionExpression::compile(const QString& text, QString* error) {
+    ConditionExpression expression;
+    QString message;
+    ExpressionParser parser(text);
+    if (parser.parse(expression.code, message)) {
+        expression.source = text.trimmed();
+    } else if (error) {
+        *error = message;
+    }
+    return expression;
+}
+
+quint16 ConditionExpression::evaluate(const Emulator& emulator) const {
+    const CpuState& cpu = emulator.state();
+    quint16 stack[MAX_DEPTH];
+    int top = -1;
+    for (const Instruction& instruction : code) {
+        switch (instruction.opcode) {
+        case Constant:
+            stack[++top] = instruction.operand;
+            break;
+        case Register8: {
+            const quint16 word = cpu.registers[instruction.operand & 3];
+            stack[++top] = instruction.operand >= 4 ? word >> 8 : word & 0xFF;
+            break;
+        }
+        case Register16:
+            stack[++top] = cpu.registers[instruction.operand];
+            break;
+        case Segment:
+            stack[++top] = cpu.segments[instruction.operand];
+            break;
+        case InstructionPointer:
+            stack[++top] = cpu.ip;
+            break;
+        case Flag:
+            stack[++top] = instruction.operand == 0xFFFF ? cpu.flags : (cpu.flags & instruction.operand) ? 1 : 0;
+            break;
+        case Byte:
+        case Word: {
+            const quint16 segment = cpu.segments[instruction.operand];
+            const quint16 offset = stack[top];
+            const quint32 address = (quint32(segment) << 4) + offset;
+            quint16 value = emulator.readByte(address);
+            if (instruction.opcode == Word) {
+                value |= emulator.readByte((quint32(segment) << 4) + quint16(offset + 1)) << 8;
+            }
+            stack[top] = value;
+            break;
+        }
+        case LogicalNot:
+            stack[top] = stack[top] ? 0 : 1;
+            break;
+        case Negate:
+            stack[top] = quint16(-stack[top]);
+            break;
+        case Complement:
+            stack[top] = quint16(~stack[top]);
+            break;
+        default: {
+            const quint16 right = stack[top--];
+            quint16& left = stack[top];
+            switch (instruction.opcode) {
+            case Add: left = quint16(left + right); break;
+            case Subtract: left = quint16(left - right); break;
+            case Multiply: left = quint16(left * right); break;
+            case BitAnd: left &= right; break;
+            case BitOr: left |= right; break;
+            case BitXor: left ^= right; break;
+            case Equal: left = left == right; break;
+            case NotEqual: left = left != right; break;
+            case Less: left = left < right; break;
+            case LessEqual: left = left <= right; break;
+            case Greater: left = left > right; break;
+            case GreaterEqual: left = left >= right; break;
+            case LogicalAnd: left = left && right; break;
+            default: left = left || right; break;
+            }
+            break;
+        }
+        }
+    }
+    return top >= 0 ? stack[top] : 0;
+}
+
+AddressExpression AddressExpression::compile(const QString& text, QString* error) {
+    AddressExpression expression;
+    QString segmentText = "DS";
+    QString offsetText = text.trimmed();
+    int nesting = 0;
+    for (int i = 0; i < offsetText.size(); ++i) {
+        if (offsetText[i] == '[') ++nesting;
+        else if (offsetText[i] == ']') --nesting;
+        else if (offsetText[i] == ':' && nesting == 0) {
+            segmentText = offsetText.left(i);
+            offsetText = offsetText.mid(i + 1).trimmed();
+            break;
+        }
+    }
+
+    // "[BX+SI]" names the bytes at BX+SI; only strip the brackets when they enclose the whole offset.
+    if (offsetText.startsWith('[') && offsetText.endsWith(']')) {
+        nesting = 0;
+        bool enclosed = true;
+        for (int i = 0; i < offsetText.size() - 1 && enclosed; ++i) {
+            if (offsetText[i] == '[') ++nesting;
+            else if (offsetText[i] == ']') enclosed = --nesting > 0;
+        }
+        if (enclosed) offsetText = offsetText.mid(1, offsetText.size() - 2);
+    }
+
+    expression.segment = ConditionExpression::compile(segmentText, error);
+    if (!expression.segment.isValid()) return expression;
+    expression.offset = ConditionExpression::compile(offsetText, error);
+    if (expression.offset.isValid()) expression.source = text.trimmed();
+    return expression;
+}
+
+quint32 AddressExpression::evaluate(const Emulator& emulator) const {
+    return ((quint32(segment.evaluate(emulator)) << 4) + offset.evaluate(emulator)) & (Emulator::MEMORY_SIZE - 1);
+}
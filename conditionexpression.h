@@ -0,0 +1,56 @@
+#ifndef CONDITIONEXPRESSION_H
+#define CONDITIONEXPRESSION_H
+
+#include <QCoreApplication>
+#include <QString>
+#include <QVector>
+
+class Emulator;
+
+// An expression over registers, flags and memory such as "CX==0 && BYTE ES:[DI]!=0D", compiled once to a
+// stack bytecode so a breakpoint hit costs an evaluation, not a parse. Numbers are hexadecimal as in DEBUG.
+class ConditionExpression {
+    Q_DECLARE_TR_FUNCTIONS(ConditionExpression)
+public:
+    static ConditionExpression compile(const QString& text, QString* error = nullptr);
+    bool isValid() const { return !code.isEmpty(); }
+    const QString& text() const { return source; }
+    quint16 evaluate(const Emulator& emulator) const;
+    bool test(const Emulator& emulator) const { return evaluate(emulator) != 0; }
+private:
+    friend class ExpressionParser;
+    static constexpr int MAX_DEPTH = 32;
+
+    enum Opcode : quint8 {
+        Constant, Register8, Register16, Segment, InstructionPointer, Flag,
+        Byte, Word,
+        Add, Subtract, Multiply, BitAnd, BitOr, BitXor,
+        Equal, NotEqual, Less, LessEqual, Greater, GreaterEqual,
+        LogicalAnd, LogicalOr, LogicalNot, Negate, Complement
+    };
+    struct Instruction {
+        Opcode opcode;
+        // Constant value, register or flag index, or the segment register of a memory access.
+        quint16 operand;
+    };
+
+    QVector<Instruction> code;
+    QString source;
+};
+
+// A segment:offset pair such as "DS:SI", "ES:[DI+2]" or "1000:0200"; an offset alone is taken in DS.
+class AddressExpression {
+public:
+    static AddressExpression compile(const QString& text, QString* error = nullptr);
+    bool isValid() const { return segment.isValid() && offset.isValid(); }
+    const QString& text() const { return source; }
+    quint32 evaluate(const Emulator& emulator) const;
+    quint16 segmentValue(const Emulator& emulator) const { return segment.evaluate(emulator); }
+    quint16 offsetValue(const Emulator& emulator) const { return offset.evaluate(emulator); }
+private:
+    ConditionExpression segment;
+    ConditionExpression offset;
+    QString source;
+};
+
+#endif // CONDITIONEXPRESSION_H
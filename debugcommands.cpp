@@ -0,0 +1,280 @@
+#include "debugcommands.h"
+#include "emulator.h"
+#include "conditionexpression.h"
+#include "instructiondecoder.h"
+#include "memorykernels.h"
+
+namespace {
+
+const int ROW_ADDRESS_COLUMNS = 11;
+const int ROW_ASCII_COLUMN = 61;
+
+// Splits at blanks and commas; a quoted string stays one token, quotes included, so lists can tell it from a number.
+QStringList tokenize(const QString& text) {
+    QStringList tokens;
+    QString current;
+    QChar quote;
+    for (const QChar c : text) {
+        if (!quote.isNull()) {
+            current += c;
+            if (c == quote) quote = QChar();
+        } else if (c == '\'' || c == '"') {
+            current += c;
+            quote = c;
+        } else if (c.isSpace() || c == ',') {
+            if (!current.isEmpty()) tokens.append(current);
+            current.clear();
+        } else {
+            current += c;
+        }
+    }
+    if (!current.isEmpty()) tokens.append(current);
+    return tokens;
+}
+
+bool parseHex(const QString& text, quint32 limit, quint32& value) {
+    bool ok;
+    value = text.toUInt(&ok, 16);
+    return ok && value <= limit;
+}
+
+}
+
+DebugCommands::DebugCommands() : hasNextDump(false) {}
+
+bool DebugCommands::execute(Emulator& emulator, const QString& command, QString* output, QString* error) {
+    const QString text = command.trimmed();
+    QString result;
+    QString message;
+    if (text.isEmpty()) {
+        message = tr("Enter a command: d, f, s, c or m");
+    } else {
+        // DEBUG accepts "d100" as well as "d 100".
+        QStringList arguments = tokenize(text.mid(1));
+        bool ok = false;
+        switch (text[0].toLower().unicode()) {
+        case 'd': ok = dump(emulator, arguments, result, message); break;
+        case 'f': ok = fill(emulator, arguments, message); break;
+        case 's': ok = search(emulator, arguments, result, message); break;
+        case 'c': ok = compare(emulator, arguments, result, message); break;
+        case 'm': ok = move(emulator, arguments, message); break;
+        default: message = tr("Unknown command %1").arg(text[0]); break;
+        }
+        if (ok && !arguments.isEmpty()) {
+            ok = false;
+            message = tr("Unexpected %1").arg(arguments.first());
+        }
+        if (ok) {
+            if (output) *output = result;
+            return true;
+        }
+    }
+    if (error) *error = message;
+    return false;
+}
+
+bool DebugCommands::dump(const Emulator& emulator, QStringList& arguments, QString& output, QString& error) {
+    Range range;
+    if (arguments.isEmpty()) {
+        if (!hasNextDump) {
+            const CpuState& cpu = emulator.state();
+            nextDump.segment = cpu.segments[Emulator::DS];
+            nextDump.offset = 0x100;
+        }
+        range.start = nextDump;
+        range.size = qMin(int(DEFAULT_DUMP_SIZE), 0x10000 - range.start.offset);
+        if (!checkRange(range.start, range.size, error)) return false;
+    } else if (!parseRange(emulator, arguments, DEFAULT_DUMP_SIZE, range, error)) {
+        return false;
+    }
+
+    // Rows start on paragraph boundaries as in DEBUG, bytes outside the range are left blank.
+    const int first = range.start.offset;
+    const int end = first + range.size;
+    for (int rowOffset = first & ~(BYTES_PER_ROW - 1); rowOffset < end; rowOffset += BYTES_PER_ROW) {
+        Address row;
+        row.segment = range.start.segment;
+        row.offset = quint16(rowOffset);
+        output += dumpRow(emulator, row, qMax(first - rowOffset, 0), qMin(end - rowOffset, int(BYTES_PER_ROW))) + '\n';
+    }
+    nextDump.segment = range.start.segment;
+    nextDump.offset = quint16(end);
+    hasNextDump = true;
+    return true;
+}
+
+QString DebugCommands::dumpRow(const Emulator& emulator, const Address& row, int first, int last) {
+    QByteArray line(ROW_ASCII_COLUMN + BYTES_PER_ROW, ' ');
+    const QString address = addressText(row);
+    for (int i = 0; i < address.size(); ++i) {
+        line[i] = address[i].toLatin1();
+    }
+
+    const quint8* bytes = emulator.memoryData() + row.linear() + first;
+    const int count = last - first;
+    char hex[2 * BYTES_PER_ROW];
+    MemoryKernels::formatHex(bytes, count, hex);
+    MemoryKernels::formatAscii(bytes, count, line.data() + ROW_ASCII_COLUMN + first);
+    for (int i = 0; i < count; ++i) {
+        const int column = ROW_ADDRESS_COLUMNS + 3 * (first + i);
+        line[column] = hex[2 * i];
+        line[column + 1] = hex[2 * i + 1];
+    }
+    if (first < BYTES_PER_ROW / 2 && last > BYTES_PER_ROW / 2) {
+        line[ROW_ADDRESS_COLUMNS + 3 * (BYTES_PER_ROW / 2) - 1] = '-';
+    }
+    return QString::fromLatin1(line);
+}
+
+bool DebugCommands::fill(Emulator& emulator, QStringList& arguments, QString& error) {
+    Range range;
+    QByteArray list;
+    if (!parseRange(emulator, arguments, -1, range, error) || !parseList(arguments, list, error)) return false;
+    emulator.fillMemory(range.start.linear(), range.size, list);
+    return true;
+}
+
+bool DebugCommands::search(const Emulator& emulator, QStringList& arguments, QString& output, QString& error) {
+    Range range;
+    QByteArray list;
+    if (!parseRange(emulator, arguments, -1, range, error) || !parseList(arguments, list, error)) return false;
+
+    const quint8* data = emulator.memoryData() + range.start.linear();
+    const quint8* pattern = reinterpret_cast<const quint8*>(list.constData());
+    int lines = 0;
+    int position = 0;
+    while (position < range.size) {
+        const int found = MemoryKernels::find(data + position, range.size - position, pattern, list.size());
+        if (found < 0) break;
+        position += found;
+        if (lines++ == MAX_LISTED_LINES) {
+            output += tr("More matches not shown.") + '\n';
+            break;
+        }
+        Address match = range.start;
+        match.offset = quint16(match.offset + position);
+        output += addressText(match) + '\n';
+        ++position;
+    }
+    return true;
+}
+
+bool DebugCommands::compare(const Emulator& emulator, QStringList& arguments, QString& output, QString& error) {
+    Range range;
+    Address target;
+    if (!parseRange(emulator, arguments, -1, range, error) || !parseAddress(emulator, arguments, target, error)
+        || !checkRange(target, range.size, error)) {
+        return false;
+    }
+
+    const quint8* first = emulator.memoryData() + range.start.linear();
+    const quint8* second = emulator.memoryData() + target.linear();
+    int lines = 0;
+    int position = 0;
+    while (position < range.size) {
+        const int found = MemoryKernels::mismatch(first + position, second + position, range.size - position);
+        if (found < 0) break;
+        position += found;
+        if (lines++ == MAX_LISTED_LINES) {
+            output += tr("More differences not shown.") + '\n';
+            break;
+        }
+        Address left = range.start;
+        Address right = target;
+        left.offset = quint16(left.offset + position);
+        right.offset = quint16(right.offset + position);
+        output += QString("%1  %2  %3  %4\n").arg(addressText(left), InstructionDecoder::hexByte(first[position]),
+                                                  InstructionDecoder::hexByte(second[position]), addressText(right));
+        ++position;
+    }
+    return true;
+}
+
+bool DebugCommands::move(Emulator& emulator, QStringList& arguments, QString& error) {
+    Range range;
+    Address target;
+    if (!parseRange(emulator, arguments, -1, range, error) || !parseAddress(emulator, arguments, target, error)
+        || !checkRange(target, range.size, error)) {
+        return false;
+    }
+    emulator.moveMemory(target.linear(), range.start.linear(), range.size);
+    return true;
+}
+
+bool DebugCommands::parseAddress(const Emulator& emulator, QStringList& arguments, Address& address, QString& error) {
+    if (arguments.isEmpty()) {
+        error = tr("Expected an address");
+        return false;
+    }
+    const AddressExpression expression = AddressExpression::compile(arguments.takeFirst(), &error);
+    if (!expression.isValid()) return false;
+    address.segment = expression.segmentValue(emulator);
+    address.offset = expression.offsetValue(emulator);
+    return true;
+}
+
+// "address L length" or "address end-offset"; a negative default size makes the second part mandatory.
+bool DebugCommands::parseRange(const Emulator& emulator, QStringList& arguments, int defaultSize, Range& range, QString& error) {
+    if (!parseAddress(emulator, arguments, range.start, error)) return false;
+
+    quint32 value;
+    if (!arguments.isEmpty() && arguments.first().startsWith('L', Qt::CaseInsensitive)) {
+        QString length = arguments.takeFirst().mid(1);
+        if (length.isEmpty() && !arguments.isEmpty()) length = arguments.takeFirst();
+        if (!parseHex(length, 0x10000, value) || value == 0) {
+            error = tr("Invalid length %1").arg(length);
+            return false;
+        }
+        range.size = int(value);
+    } else if (!arguments.isEmpty() && parseHex(arguments.first(), 0xFFFF, value)) {
+        arguments.removeFirst();
+        if (value < range.start.offset) {
+            error = tr("The range ends before it starts");
+            return false;
+        }
+        range.size = int(value - range.start.offset + 1);
+    } else if (defaultSize > 0) {
+        range.size = qMin(defaultSize, 0x10000 - range.start.offset);
+    } else {
+        error = tr("Expected a range end or L length");
+        return false;
+    }
+    return checkRange(range.start, range.size, error);
+}
+
+bool DebugCommands::parseList(QStringList& arguments, QByteArray& list, QString& error) {
+    while (!arguments.isEmpty()) {
+        const QString token = arguments.takeFirst();
+        if (token.size() >= 2 && (token[0] == '\'' || token[0] == '"') && token.endsWith(token[0])) {
+            list += token.mid(1, token.size() - 2).toLatin1();
+            continue;
+        }
+        quint32 value;
+        if (!parseHex(token, 0xFF, value)) {
+            error = tr("Invalid byte %1").arg(token);
+            return false;
+        }
+        list += char(value);
+    }
+    if (list.isEmpty()) {
+        error = tr("Expected a list of bytes or strings");
+        return false;
+    }
+    return true;
+}
+
+bool DebugCommands::checkRange(const Address& address, int size, QString& error) {
+    if (address.offset + size > 0x10000) {
+        error = tr("The range crosses the end of segment %1").arg(InstructionDecoder::hexWord(address.segment));
+        return false;
+    }
+    if (address.linear() + quint32(size) > quint32(Emulator::MEMORY_SIZE)) {
+        error = tr("The range runs past the end of memory");
+        return false;
+    }
+    return true;
+}
+
+QString DebugCommands::addressText(const Address& address) {
+    return InstructionDecoder::hexWord(address.segment) + ':' + InstructionDecoder::hexWord(address.offset);
+}
@@ -0,0 +1,50 @@
+#ifndef DEBUGCOMMANDS_H
+#define DEBUGCOMMANDS_H
+
+#include <QCoreApplication>
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+
+class Emulator;
+
+// DEBUG's bulk memory commands run against the emulator instead of DEBUG.COM:
+// d [range], f range list, s range list, c range address and m range address.
+class DebugCommands {
+    Q_DECLARE_TR_FUNCTIONS(DebugCommands)
+public:
+    DebugCommands();
+    bool execute(Emulator& emulator, const QString& command, QString* output, QString* error);
+private:
+    static constexpr int DEFAULT_DUMP_SIZE = 0x80;
+    static constexpr int BYTES_PER_ROW = 16;
+    static constexpr int MAX_LISTED_LINES = 4096;
+
+    struct Address {
+        quint16 segment = 0;
+        quint16 offset = 0;
+        quint32 linear() const { return (quint32(segment) << 4) + offset; }
+    };
+    struct Range {
+        Address start;
+        int size = 0;
+    };
+
+    Address nextDump;
+    bool hasNextDump;
+
+    bool dump(const Emulator& emulator, QStringList& arguments, QString& output, QString& error);
+    bool fill(Emulator& emulator, QStringList& arguments, QString& error);
+    bool search(const Emulator& emulator, QStringList& arguments, QString& output, QString& error);
+    bool compare(const Emulator& emulator, QStringList& arguments, QString& output, QString& error);
+    bool move(Emulator& emulator, QStringList& arguments, QString& error);
+
+    static bool parseAddress(const Emulator& emulator, QStringList& arguments, Address& address, QString& error);
+    static bool parseRange(const Emulator& emulator, QStringList& arguments, int defaultSize, Range& range, QString& error);
+    static bool parseList(QStringList& arguments, QByteArray& list, QString& error);
+    static bool checkRange(const Address& address, int size, QString& error);
+    static QString addressText(const Address& address);
+    static QString dumpRow(const Emulator& emulator, const Address& row, int first, int last);
+};
+
+#endif // DEBUGCOMMANDS_H
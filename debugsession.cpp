@@ -0,0 +1,290 @@
+#include "debugsession.h"
+#include <QTimer>
+#include "instructiondecoder.h"
+#include "memorydiff.h"
+#include "opcodetable.h"
+
+namespace {
+
+const int MAX_INSTRUCTION_SIZE = 6;
+
+}
+
+DebugSession::DebugSession(QObject* parent) : QObject(parent), active(false), mode(Idle), leavingStop(false), targetAddress(-1),
+    targetStack(0), latencyMicroseconds(0), clocksAtBegin(0), clocksElapsed(0), lastStop(Emulator::Stepped) {
+    runTimer = new QTimer(this);
+    runTimer->setSingleShot(true);
+    runTimer->setInterval(0);
+    connect(runTimer, &QTimer::timeout, this, &DebugSession::advance);
+}
+
+void DebugSession::start(const QByteArray& image, quint16 entry, const QHash<int, QString>& breakpoints) {
+    runTimer->stop();
+    machine.load(image, entry);
+    setBreakpoints(breakpoints);
+    markedSnapshot = Emulator::Snapshot();
+    runSnapshot = machine.snapshot();
+    commands = DebugCommands();
+    active = true;
+    mode = Idle;
+    lastStop = Emulator::Stepped;
+    previous = machine.state();
+    latencyMicroseconds = 0;
+    clocksElapsed = 0;
+    emit paused();
+}
+
+void DebugSession::stop() {
+    if (!active) return;
+    finish(tr("Debugging stopped."));
+}
+
+void DebugSession::setBreakpoints(const QHash<int, QString>& breakpoints) {
+    QHash<int, ConditionExpression> compiled;
+    for (auto it = breakpoints.constBegin(); it != breakpoints.constEnd(); ++it) {
+        compiled.insert(it.key(), it.value().trimmed().isEmpty() ? ConditionExpression()
+                                                                 : ConditionExpression::compile(it.value()));
+    }
+    machine.setBreakpoints(compiled);
+}
+
+bool DebugSession::addWatchpoint(const QString& text, QString* error) {
+    WatchSpec spec;
+    QString address = text;
+    const int comma = address.lastIndexOf(',');
+    if (comma >= 0) {
+        bool ok;
+        spec.size = address.mid(comma + 1).trimmed().toInt(&ok, 16);
+        if (!ok || spec.size < 1 || spec.size > MAX_WATCH_SIZE) {
+            if (error) *error = tr("The size must be a hexadecimal number from 1 to %1.").arg(MAX_WATCH_SIZE, 0, 16);
+            return false;
+        }
+        address = address.left(comma);
+    }
+    spec.address = AddressExpression::compile(address, error);
+    if (!spec.address.isValid()) return false;
+
+    watchSpecs.append(spec);
+    return true;
+}
+
+void DebugSession::clearWatchpoints() {
+    watchSpecs.clear();
+    applyWatchpoints();
+}
+
+QStringList DebugSession::watchpoints() const {
+    QStringList texts;
+    for (const WatchSpec& spec : watchSpecs) {
+        texts.append(spec.address.text());
+    }
+    return texts;
+}
+
+void DebugSession::markSnapshot() {
+    markedSnapshot = machine.snapshot();
+}
+
+QString DebugSession::memoryDiff() const {
+    if (markedSnapshot.isValid()) {
+        return tr("Since the marked snapshot:") + '\n' + MemoryDiff::format(MemoryDiff::compare(markedSnapshot, machine));
+    }
+    return tr("Since the last run:") + '\n' + MemoryDiff::format(MemoryDiff::compare(runSnapshot, machine));
+}
+
+bool DebugSession::executeCommand(const QString& command, QString* output, QString* error) {
+    if (isRunning()) {
+        if (error) *error = tr("The program is running.");
+        return false;
+    }
+    machine.beginGeneration();
+    return commands.execute(machine, command, output, error);
+}
+
+void DebugSession::applyWatchpoints() {
+    watchRanges.clear();
+    for (const WatchSpec& spec : watchSpecs) {
+        Emulator::MemoryRange range;
+        range.address = spec.address.evaluate(machine);
+        range.size = spec.size;
+        watchRanges.append(range);
+    }
+    machine.setWatchpoints(watchRanges);
+}
+
+QString DebugSession::stopDescription() const {
+    switch (lastStop) {
+    case Emulator::Breakpoint:
+        return tr("Breakpoint at %1.").arg(InstructionDecoder::hexWord(machine.state().ip));
+    case Emulator::Watchpoint: {
+        const quint32 address = machine.watchedWrite();
+        for (int i = 0; i < watchRanges.size(); ++i) {
+            if (((address - watchRanges[i].address) & (Emulator::MEMORY_SIZE - 1)) < quint32(watchRanges[i].size)) {
+                return tr("Watchpoint %1 (%2): write to %3.")
+                    .arg(i + 1)
+                    .arg(watchSpecs[i].address.text(), QString("%1").arg(address, 5, 16, QChar('0')).toUpper());
+            }
+        }
+        return QString();
+    }
+    default:
+        return QString();
+    }
+}
+
+void DebugSession::stepInto() {
+    begin(Step);
+}
+
+void DebugSession::stepOver() {
+    if (!active || mode != Idle) return;
+    const CpuState& cpu = machine.state();
+    const quint32 address = (quint32(cpu.segments[Emulator::CS]) << 4) + cpu.ip;
+    const DecodedInstruction instruction = InstructionDecoder::decode(machine.readMemory(address, MAX_INSTRUCTION_SIZE), 0, cpu.ip);
+    const bool entersRoutine = instruction.flow == DecodedInstruction::Call || instruction.mnemonic == "CALL"
+                               || instruction.mnemonic.startsWith("INT");
+    const bool repeats = instruction.prefix.startsWith("REP");
+    if (!instruction.isValid() || (!entersRoutine && !repeats)) {
+        begin(Step);
+        return;
+    }
+    targetAddress = quint16(cpu.ip + instruction.size);
+    targetStack = cpu.registers[Emulator::SP];
+    begin(UntilAddress);
+}
+
+void DebugSession::stepOut() {
+    if (!active || mode != Idle) return;
+    targetStack = machine.state().registers[Emulator::SP];
+    begin(UntilReturn);
+}
+
+void DebugSession::runTo(int address) {
+    if (!active || mode != Idle) return;
+    targetAddress = address;
+    targetStack = 0;
+    begin(UntilAddress);
+}
+
+void DebugSession::resume() {
+    begin(Continue);
+}
+
+QString DebugSession::currentInstruction() const {
+    const CpuState& cpu = machine.state();
+    const quint32 address = (quint32(cpu.segments[Emulator::CS]) << 4) + cpu.ip;
+    const DecodedInstruction instruction = InstructionDecoder::decode(machine.readMemory(address, MAX_INSTRUCTION_SIZE), 0, cpu.ip);
+    return instruction.isValid() ? instruction.text() : "DB " + InstructionDecoder::hexByte(machine.readByte(address));
+}
+
+quint16 DebugSession::currentFlagsRead() const {
+    const CpuState& cpu = machine.state();
+    const quint32 address = (quint32(cpu.segments[Emulator::CS]) << 4) + cpu.ip;
+    for (int i = 0; i < MAX_INSTRUCTION_SIZE; ++i) {
+        const OpcodeInfo& info = OpcodeTable::info(machine.readByte(address + i));
+        if (info.form != OpcodeInfo::Prefix) return info.flagsRead;
+    }
+    return 0;
+}
+
+void DebugSession::begin(Mode runMode) {
+    if (!active || mode != Idle) return;
+    previous = machine.state();
+    clocksAtBegin = machine.clockCount();
+    machine.beginGeneration();
+    // Register-relative watchpoints follow the registers as they are when each run or step begins.
+    applyWatchpoints();
+    // Single steps keep the baseline of the last run, copying 1 MB per keypress would show in the latency.
+    if (runMode != Step) runSnapshot = machine.snapshot();
+    mode = runMode;
+    leavingStop = true;
+    clock.start();
+    advance();
+}
+
+void DebugSession::advance() {
+    Emulator::StopReason reason = Emulator::Stepped;
+    if (leavingStop) {
+        // The instruction we are stopped on runs even if it carries a breakpoint.
+        leavingStop = false;
+        reason = machine.step();
+        if (reason == Emulator::Stepped && reachedTarget()) {
+            lastStop = reason;
+            pause();
+            return;
+        }
+    }
+    if (reason == Emulator::Stepped) {
+        reason = mode == Continue ? machine.run(RUN_CHUNK_STEPS) : stepUntilTarget(RUN_CHUNK_STEPS);
+    }
+
+    lastStop = reason;
+    switch (reason) {
+    case Emulator::StepLimit:
+        flushOutput();
+        runTimer->start();
+        break;
+    case Emulator::Stepped:
+    case Emulator::Breakpoint:
+    case Emulator::Watchpoint:
+        pause();
+        break;
+    case Emulator::Exited:
+        finish(tr("Program terminated normally (%1).").arg(machine.exitCode()));
+        break;
+    case Emulator::Halted:
+        finish(tr("Processor halted at %1.").arg(InstructionDecoder::hexWord(machine.state().ip)));
+        break;
+    case Emulator::DivideError:
+        finish(tr("Divide overflow at %1.").arg(InstructionDecoder::hexWord(machine.state().ip)));
+        break;
+    }
+}
+
+Emulator::StopReason DebugSession::stepUntilTarget(int maxSteps) {
+    for (int n = 0; n < maxSteps; ++n) {
+        if (machine.atBreakpoint()) return Emulator::Breakpoint;
+        const Emulator::StopReason reason = machine.step();
+        if (reason != Emulator::Stepped) return reason;
+        if (reachedTarget()) return Emulator::Stepped;
+    }
+    return Emulator::StepLimit;
+}
+
+bool DebugSession::reachedTarget() const {
+    const CpuState& cpu = machine.state();
+    switch (mode) {
+    case Step:
+        return true;
+    case UntilAddress:
+        // A recursive call passes the same address deeper in the stack, wait until the frame is back.
+        return cpu.segments[Emulator::CS] == Emulator::PROGRAM_SEGMENT && cpu.ip == targetAddress
+               && cpu.registers[Emulator::SP] >= targetStack;
+    case UntilReturn:
+        return machine.lastWasReturn() && cpu.registers[Emulator::SP] > targetStack;
+    default:
+        return false;
+    }
+}
+
+void DebugSession::pause() {
+    runTimer->stop();
+    mode = Idle;
+    latencyMicroseconds = clock.nsecsElapsed() / 1000.0;
+    clocksElapsed = machine.clockCount() - clocksAtBegin;
+    flushOutput();
+    emit paused();
+}
+
+void DebugSession::finish(const QString& message) {
+    runTimer->stop();
+    mode = Idle;
+    active = false;
+    flushOutput();
+    emit finished(message);
+}
+
+void DebugSession::flushOutput() {
+    const QString text = machine.takeOutput();
+    if (!text.isEmpty()) emit output(text);
+}
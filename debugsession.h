@@ -0,0 +1,95 @@
+#ifndef DEBUGSESSION_H
+#define DEBUGSESSION_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QHash>
+#include <QVector>
+#include <QStringList>
+#include <QElapsedTimer>
+#include "emulator.h"
+#include "debugcommands.h"
+
+class QTimer;
+
+// Drives an Emulator for the editor: single steps run synchronously, longer runs in chunks from the event loop.
+class DebugSession : public QObject {
+    Q_OBJECT
+signals:
+    void paused();
+    void output(const QString& text);
+    void finished(const QString& message);
+public:
+    explicit DebugSession(QObject* parent = nullptr);
+    void start(const QByteArray& image, quint16 entry, const QHash<int, QString>& breakpoints);
+    void stop();
+    bool isActive() const { return active; }
+    bool isRunning() const { return mode != Idle; }
+    // Breakpoint offsets with their conditions, an empty condition stops every time.
+    void setBreakpoints(const QHash<int, QString>& breakpoints);
+    // "[BX+SI]", "ES:DI,2": the address is taken from the registers each time a run or step begins.
+    bool addWatchpoint(const QString& text, QString* error);
+    void clearWatchpoints();
+    QStringList watchpoints() const;
+    // Memory changes since the last marked snapshot, or since the last run when none is marked.
+    void markSnapshot();
+    QString memoryDiff() const;
+    // One of DEBUG's d, f, s, c or m commands; refused while the program runs.
+    bool executeCommand(const QString& command, QString* output, QString* error);
+
+    void stepInto();
+    void stepOver();
+    void stepOut();
+    void runTo(int address);
+    void resume();
+
+    const Emulator& emulator() const { return machine; }
+    const CpuState& previousState() const { return previous; }
+    quint16 currentAddress() const { return machine.state().ip; }
+    QString currentInstruction() const;
+    double lastLatency() const { return latencyMicroseconds; }
+    quint64 lastClocks() const { return clocksElapsed; }
+    // Flags the instruction at CS:IP depends on, from the opcode table.
+    quint16 currentFlagsRead() const;
+    QString stopDescription() const;
+private:
+    static constexpr int RUN_CHUNK_STEPS = 200000;
+    static constexpr int MAX_WATCH_SIZE = 0x100;
+
+    enum Mode { Idle, Step, Continue, UntilAddress, UntilReturn };
+
+    struct WatchSpec {
+        AddressExpression address;
+        int size = 1;
+    };
+
+    Emulator machine;
+    QTimer* runTimer;
+    bool active;
+    Mode mode;
+    bool leavingStop;
+    CpuState previous;
+    int targetAddress;
+    quint16 targetStack;
+    double latencyMicroseconds;
+    quint64 clocksAtBegin;
+    quint64 clocksElapsed;
+    QElapsedTimer clock;
+    Emulator::StopReason lastStop;
+    QVector<WatchSpec> watchSpecs;
+    QVector<Emulator::MemoryRange> watchRanges;
+    Emulator::Snapshot markedSnapshot;
+    Emulator::Snapshot runSnapshot;
+    DebugCommands commands;
+
+    void begin(Mode runMode);
+    void advance();
+    Emulator::StopReason stepUntilTarget(int maxSteps);
+    bool reachedTarget() const;
+    void pause();
+    void finish(const QString& message);
+    void flushOutput();
+    void applyWatchpoints();
+};
+
+#endif // DEBUGSESSION_H
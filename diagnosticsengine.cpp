@@ -0,0 +1,320 @@
+#include "diagnosticsengine.h"
+#include "instructionencoder.h"
+#include "peepholeoptimizer.h"
+#include <QThread>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QWaitCondition>
+#include <QHash>
+#include <algorithm>
+
+namespace {
+
+struct Range {
+    int line;
+    int start;
+    int end;
+};
+
+bool rangeStartsBefore(const Range& a, const Range& b) {
+    return a.start < b.start;
+}
+
+}
+
+// One low-priority thread serves every DiagnosticsEngine, taking requests in the order they came in.
+// A request replaces one of the same engine that is still waiting.
+class DiagnosticsWorker {
+public:
+    // Engines are created and destroyed on the GUI thread, so the shared instance needs no lock.
+    static DiagnosticsWorker* acquire();
+    void release();
+    void submit(DiagnosticsEngine* engine, const DiagnosticsEngine::Request& request);
+    // Drops the waiting request of engine and waits until the worker is no longer analysing for it.
+    void cancel(DiagnosticsEngine* engine);
+private:
+    DiagnosticsWorker();
+    ~DiagnosticsWorker();
+    void loop();
+
+    static DiagnosticsWorker* instance;
+    int users;
+    QThread* thread;
+    QMutex mutex;
+    QWaitCondition condition;
+    QHash<DiagnosticsEngine*, DiagnosticsEngine::Request> pending;
+    QList<DiagnosticsEngine*> order;
+    DiagnosticsEngine* running;
+    bool stopping;
+};
+
+DiagnosticsWorker* DiagnosticsWorker::instance = nullptr;
+
+DiagnosticsWorker* DiagnosticsWorker::acquire() {
+    if (!instance) {
+        instance = new DiagnosticsWorker();
+    }
+    ++instance->users;
+    return instance;
+}
+
+void DiagnosticsWorker::release() {
+    if (--users > 0) return;
+    instance = nullptr;
+    delete this;
+}
+
+DiagnosticsWorker::DiagnosticsWorker() : users(0), running(nullptr), stopping(false) {
+    thread = QThread::create([this]() { loop(); });
+    thread->start(QThread::LowPriority);
+}
+
+DiagnosticsWorker::~DiagnosticsWorker() {
+    {
+        QMutexLocker locker(&mutex);
+        stopping = true;
+        condition.wakeAll();
+    }
+    thread->wait();
+    delete thread;
+}
+
+void DiagnosticsWorker::submit(DiagnosticsEngine* engine, const DiagnosticsEngine::Request& request) {
+    QMutexLocker locker(&mutex);
+    auto waiting = pending.find(engine);
+    if (waiting == pending.end()) {
+        pending.insert(engine, request);
+        order.append(engine);
+    } else {
+        // The engine's cache still matches the waiting request's predecessor, so keep its changes too.
+        int first = waiting.value().firstChanged;
+        int last = waiting.value().lastChanged;
+        DiagnosticsEngine::mergeChanges(first, last, request.firstChanged, request.lastChanged,
+                                        int(request.lines.size() - waiting.value().lines.size()));
+        waiting.value() = request;
+        waiting.value().firstChanged = first;
+        waiting.value().lastChanged = last;
+    }
+    condition.wakeAll();
+}
+
+void DiagnosticsWorker::cancel(DiagnosticsEngine* engine) {
+    QMutexLocker locker(&mutex);
+    if (pending.remove(engine)) {
+        order.removeOne(engine);
+    }
+    while (running == engine) {
+        condition.wait(&mutex);
+    }
+}
+
+void DiagnosticsWorker::loop() {
+    forever {
+        DiagnosticsEngine* engine;
+        DiagnosticsEngine::Request request;
+        quint64 requestGeneration;
+        {
+            QMutexLocker locker(&mutex);
+            running = nullptr;
+            condition.wakeAll();
+            while (order.isEmpty() && !stopping) {
+                condition.wait(&mutex);
+            }
+            if (stopping) return;
+            engine = order.takeFirst();
+            request = pending.take(engine);
+            running = engine;
+            requestGeneration = engine->generation;
+        }
+        engine->process(request, requestGeneration);
+    }
+}
+
+DiagnosticsEngine::DiagnosticsEngine(QObject* parent) : QObject(parent), worker(DiagnosticsWorker::acquire()), generation(0) {
+}
+
+DiagnosticsEngine::~DiagnosticsEngine() {
+    worker->cancel(this);
+    worker->release();
+}
+
+void DiagnosticsEngine::analyze(const QVector<ScriptLine>& lines, int firstChanged, int lastChanged) {
+    ++generation;
+    worker->submit(this, {lines, firstChanged, lastChanged});
+}
+
+void DiagnosticsEngine::mergeChanges(int& changedFirst, int& changedLast, int first, int last, int delta) {
+    if (changedLast >= first) {
+        changedLast += delta;
+    }
+    changedFirst = qMin(changedFirst, first);
+    changedLast = qMax(changedLast, last);
+}
+
+void DiagnosticsEngine::process(const Request& request, quint64 requestGeneration) {
+    encodings = encodeLines(request);
+    encodedTexts.clear();
+    encodedTexts.reserve(request.lines.size());
+    for (const ScriptLine& line : request.lines) {
+        encodedTexts.append(line.text);
+    }
+
+    QVector<Diagnostic> diagnostics = run(request.lines, encodings);
+    QVector<ValueHint> hints = valueAnalyzer.analyze(request.lines, encodings);
+    QMetaObject::invokeMethod(this, [this, diagnostics, hints, requestGeneration]() {
+        if (requestGeneration != generation) return;
+        emit diagnosticsReady(diagnostics);
+        emit valuesReady(hints);
+    }, Qt::QueuedConnection);
+}
+
+// Encodes every assembled line, reusing the previous request's encoding of an unchanged line at an unchanged address.
+QVector<LineEncoding> DiagnosticsEngine::encodeLines(const Request& request) {
+    const QVector<ScriptLine>& lines = request.lines;
+    int delta = int(lines.size() - encodedTexts.size());
+    QVector<LineEncoding> result(lines.size());
+    bool assembling = false;
+    int address = DEFAULT_ASSEMBLY_ADDRESS;
+
+    for (int i = 0; i < lines.size(); ++i) {
+        const ScriptLine& line = lines[i];
+        if (!assembling) {
+            if (!line.empty && !line.comment && line.head == "A") {
+                assembling = true;
+                if (line.commandAddress >= 0) {
+                    address = line.commandAddress;
+                }
+            }
+            continue;
+        }
+        if (line.empty) {
+            assembling = false;
+            continue;
+        }
+        if (line.comment || !InstructionEncoder::isKnownMnemonic(line.mnemonic)) continue;
+
+        int previous = i < request.firstChanged ? i : (i > request.lastChanged ? i - delta : -1);
+        if (previous >= 0 && previous < encodings.size() && encodings[previous].address == address
+            && encodedTexts[previous] == line.text) {
+            result[i] = encodings[previous];
+        } else {
+            result[i] = {address, InstructionEncoder::encode(line, address)};
+        }
+        address += result[i].encoded.bytes.size();
+    }
+    return result;
+}
+
+QVector<Diagnostic> DiagnosticsEngine::run(const QVector<ScriptLine>& lines, const QVector<LineEncoding>& encodings) {
+    QVector<Diagnostic> diagnostics;
+    auto report = [&diagnostics](int line, Diagnostic::Severity severity, const QString& message) {
+        diagnostics.append({line, severity, message});
+    };
+
+    QVector<Range> code;
+    QVector<Range> writes;
+    bool assembling = false;
+    int address = DEFAULT_ASSEMBLY_ADDRESS;
+    int nameLine = -1;
+    bool cxSet = false;
+    bool written = false;
+    bool quit = false;
+    int lastLine = -1;
+
+    for (int i = 0; i < lines.size(); ++i) {
+        const ScriptLine& line = lines[i];
+        if (assembling) {
+            if (line.empty) {
+                assembling = false;
+                continue;
+            }
+            if (line.comment) continue;
+            lastLine = i;
+
+            if (!InstructionEncoder::isKnownMnemonic(line.mnemonic)) {
+                report(i, Diagnostic::Error, tr("Unknown mnemonic \"%1\"").arg(line.mnemonic));
+                continue;
+            }
+            EncodedInstruction encoded = InstructionEncoder::encode(encodings, i, line, address);
+            if (!encoded.isValid()) {
+                report(i, Diagnostic::Error, encoded.error);
+            }
+            if (!encoded.bytes.isEmpty()) {
+                code.append({i, address, address + int(encoded.bytes.size())});
+            }
+            address += encoded.bytes.size();
+            continue;
+        }
+
+        if (line.empty || line.comment) continue;
+        lastLine = i;
+        quit = false;
+
+        const QString& command = line.head;
+        if (command == "A") {
+            assembling = true;
+            if (line.commandAddress >= 0) {
+                address = line.commandAddress;
+            }
+        } else if (command == "E") {
+            if (line.editData.isEmpty()) {
+                report(i, Diagnostic::Error, tr("Malformed E command, expected an address and data"));
+            } else {
+                writes.append({i, line.commandAddress, line.commandAddress + int(line.editData.size())});
+            }
+        } else if (command == "N") {
+            if (line.tail.isEmpty()) {
+                report(i, Diagnostic::Error, tr("N requires a file name"));
+            }
+            nameLine = i;
+        } else if (command == "RCX" || (command == "R" && line.tail.compare("CX", Qt::CaseInsensitive) == 0)) {
+            cxSet = true;
+        } else if (command == "W") {
+            if (nameLine < 0) {
+                report(i, Diagnostic::Error, tr("W without a preceding N, no file name is set"));
+            }
+            if (!cxSet) {
+                report(i, Diagnostic::Warning, tr("CX was never set with RCX, W writes BX:CX bytes"));
+            }
+            written = true;
+        } else if (command == "Q") {
+            quit = true;
+        } else if (!QStringList{"C", "D", "F", "G", "H", "I", "L", "M", "O", "P", "R", "S", "T", "U", "XA", "XD", "XM", "XS", "?"}.contains(command)
+                   && !command.startsWith("R")) {
+            report(i, Diagnostic::Warning, tr("Unknown DEBUG command \"%1\"").arg(command));
+        }
+    }
+
+    // Code ranges of different A blocks may overlap, so after sorting by start keep the range reaching furthest so far.
+    std::sort(code.begin(), code.end(), rangeStartsBefore);
+    QVector<Range> reach(code.size());
+    for (int c = 0; c < code.size(); ++c) {
+        reach[c] = c > 0 && reach[c - 1].end >= code[c].end ? reach[c - 1] : code[c];
+    }
+    for (const Range& write : writes) {
+        // Ranges starting before the write ends form a prefix, its furthest reaching range overlaps when it ends past the write's start.
+        int count = int(std::lower_bound(code.begin(), code.end(), Range{0, write.end, 0}, rangeStartsBefore) - code.begin());
+        if (count > 0 && reach[count - 1].end > write.start) {
+            report(write.line, Diagnostic::Warning,
+                   tr("E overwrites code assembled on line %1").arg(reach[count - 1].line + 1));
+        }
+    }
+
+    if (nameLine >= 0 && !written) {
+        report(nameLine, Diagnostic::Warning, tr("File name set with N but never written with W"));
+    }
+    if (lastLine >= 0 && !quit) {
+        report(lastLine, Diagnostic::Warning, tr("Script does not end with Q, DEBUG will wait for input"));
+    }
+
+    for (const PeepholeSuggestion& suggestion : PeepholeOptimizer::analyze(lines, encodings)) {
+        Diagnostic diagnostic;
+        diagnostic.line = suggestion.line;
+        diagnostic.severity = Diagnostic::Hint;
+        diagnostic.message = suggestion.message;
+        diagnostic.hasFix = true;
+        diagnostic.replacement = suggestion.replacement;
+        diagnostics.append(diagnostic);
+    }
+    return diagnostics;
+}
@@ -0,0 +1,59 @@
+#ifndef DIAGNOSTICSENGINE_H
+#define DIAGNOSTICSENGINE_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QStringList>
+#include <atomic>
+#include <climits>
+#include "scriptparser.h"
+#include "valueanalyzer.h"
+
+struct Diagnostic {
+    enum Severity { Error, Warning, Hint };
+    int line = 0;
+    Severity severity = Error;
+    QString message;
+    bool hasFix = false;
+    QString replacement; // an empty replacement removes the line
+};
+
+class DiagnosticsWorker;
+
+// Diagnostics for one editor. All engines share a single low-priority worker thread.
+class DiagnosticsEngine : public QObject {
+    Q_OBJECT
+public:
+    explicit DiagnosticsEngine(QObject* parent = nullptr);
+    ~DiagnosticsEngine();
+    // Lines firstChanged..lastChanged (numbered as in lines) are the only ones edited since the previous call.
+    void analyze(const QVector<ScriptLine>& lines, int firstChanged, int lastChanged);
+    static QVector<Diagnostic> run(const QVector<ScriptLine>& lines, const QVector<LineEncoding>& encodings);
+    // Widens a changed line range by a later edit of lines first..last that added delta lines.
+    static void mergeChanges(int& changedFirst, int& changedLast, int first, int last, int delta);
+signals:
+    void diagnosticsReady(const QVector<Diagnostic>& diagnostics);
+    void valuesReady(const QVector<ValueHint>& hints);
+private:
+    friend class DiagnosticsWorker;
+    static constexpr int DEFAULT_ASSEMBLY_ADDRESS = 0x100;
+
+    struct Request {
+        QVector<ScriptLine> lines;
+        int firstChanged = 0;
+        int lastChanged = INT_MAX;
+    };
+
+    DiagnosticsWorker* worker;
+    std::atomic<quint64> generation;
+    // Only touched by the worker thread, while it analyses a request of this engine.
+    QVector<LineEncoding> encodings;
+    QStringList encodedTexts;
+    ValueAnalyzer valueAnalyzer;
+
+    void process(const Request& request, quint64 requestGeneration);
+    QVector<LineEncoding> encodeLines(const Request& request);
+};
+
+#endif // DIAGNOSTICSENGINE_H
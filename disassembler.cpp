@@ -0,0 +1,179 @@
+#include "disassembler.h"
+#include <QSet>
+#include <QStringList>
+#include <algorithm>
+
+namespace {
+
+bool endsBlock(const DecodedInstruction& instruction) {
+    return instruction.flow == DecodedInstruction::Jump || instruction.flow == DecodedInstruction::Branch
+           || instruction.flow == DecodedInstruction::Return || instruction.flow == DecodedInstruction::Indirect;
+}
+
+bool isAccumulatorHigh(const QString& operand) {
+    return operand == "AH" || operand == "AX";
+}
+
+// Follows the value of AH closely enough to recognise the DOS terminate calls.
+int trackHighByte(const DecodedInstruction& instruction, int high) {
+    static const QSet<QString> CLOBBERS = {
+        "MUL", "IMUL", "DIV", "IDIV", "CBW", "LAHF", "AAM", "AAD", "AAA", "AAS", "LODSW", "XCHG", "POP", "IN", "INT"
+    };
+    const QStringList& operands = instruction.operands;
+    if (instruction.mnemonic == "MOV" && operands.size() == 2 && isAccumulatorHigh(operands[0])) {
+        bool ok;
+        int value = operands[1].toInt(&ok, 16);
+        if (!ok) return -1;
+        return operands[0] == "AH" ? value : value >> 8;
+    }
+    if (instruction.flow == DecodedInstruction::Call || CLOBBERS.contains(instruction.mnemonic)) return -1;
+    if (!operands.isEmpty() && isAccumulatorHigh(operands[0])) return -1;
+    return high;
+}
+
+bool terminates(const DecodedInstruction& instruction, int high) {
+    if (instruction.mnemonic != "INT" || instruction.operands.size() != 1) return false;
+    const QString& number = instruction.operands[0];
+    return number == "20" || number == "27" || (number == "21" && (high == 0x00 || high == 0x4C || high == 0x31));
+}
+
+bool isPrintable(char c) {
+    return c >= 0x20 && c < 0x7F && c != '"';
+}
+
+}
+
+int ControlFlowGraph::blockAt(int address) const {
+    auto it = std::upper_bound(blocks.constBegin(), blocks.constEnd(), address,
+                               [](int value, const BasicBlock& block) { return value < block.start; });
+    if (it == blocks.constBegin()) return -1;
+    --it;
+    return address < it->end ? int(it - blocks.constBegin()) : -1;
+}
+
+bool Disassembly::isCode(int address) const {
+    auto it = instructions.upperBound(address);
+    if (it == instructions.constBegin()) return false;
+    --it;
+    return address < it.key() + it->size;
+}
+
+Disassembly Disassembler::disassemble(const QByteArray& image, int origin, const QVector<int>& entries) {
+    Disassembly result;
+    result.origin = origin;
+    result.image = image;
+    const int end = origin + int(image.size());
+    auto inImage = [origin, end](int address) { return address >= origin && address < end; };
+
+    QVector<bool> owned(image.size(), false);
+    QSet<int> leaders;
+    QSet<int> stops;
+    QVector<int> pending = entries.isEmpty() ? QVector<int>{origin} : entries;
+    for (int entry : pending) leaders.insert(entry);
+
+    while (!pending.isEmpty()) {
+        int address = pending.takeLast();
+        int high = -1;
+        while (inImage(address) && !owned[address - origin]) {
+            DecodedInstruction instruction = InstructionDecoder::decode(image, address - origin, address);
+            if (!instruction.isValid()) break;
+            bool overlaps = false;
+            for (int k = 0; k < instruction.size && !overlaps; ++k) {
+                overlaps = !inImage(address + k) || owned[address + k - origin];
+            }
+            if (overlaps) break;
+
+            for (int k = 0; k < instruction.size; ++k) {
+                owned[address + k - origin] = true;
+            }
+            result.instructions.insert(address, instruction);
+
+            if (instruction.target >= 0 && inImage(instruction.target)) {
+                leaders.insert(instruction.target);
+                pending.append(instruction.target);
+            }
+            if (instruction.flow == DecodedInstruction::Branch) {
+                leaders.insert(address + instruction.size);
+            }
+            if (terminates(instruction, high)) {
+                stops.insert(address);
+                break;
+            }
+            if (endsBlock(instruction) && instruction.flow != DecodedInstruction::Branch) break;
+            high = trackHighByte(instruction, high);
+            address += instruction.size;
+        }
+    }
+
+    BasicBlock current;
+    bool open = false;
+    auto close = [&]() {
+        if (!open) return;
+        const DecodedInstruction& last = *result.instructions.constFind(current.instructions.last());
+        const bool fallsThrough = !stops.contains(last.address) && last.flow != DecodedInstruction::Jump
+                                  && last.flow != DecodedInstruction::Return && last.flow != DecodedInstruction::Indirect;
+        if (last.target >= 0 && last.flow != DecodedInstruction::Call && result.instructions.contains(last.target)) {
+            current.successors.append(last.target);
+        }
+        if (fallsThrough && result.instructions.contains(current.end) && !current.successors.contains(current.end)) {
+            current.successors.append(current.end);
+        }
+        result.graph.blocks.append(current);
+        open = false;
+    };
+    for (auto it = result.instructions.constBegin(); it != result.instructions.constEnd(); ++it) {
+        const int address = it.key();
+        if (open && (leaders.contains(address) || current.end != address)) close();
+        if (!open) {
+            current = BasicBlock();
+            current.start = address;
+            open = true;
+        }
+        current.instructions.append(address);
+        current.end = address + it->size;
+        if (endsBlock(*it) || stops.contains(address)) close();
+    }
+    close();
+    return result;
+}
+
+QString Disassembler::toScript(const Disassembly& disassembly) {
+    QStringList lines;
+    lines.append("a " + QString::number(disassembly.origin, 16).toUpper());
+
+    const int end = disassembly.origin + int(disassembly.image.size());
+    int address = disassembly.origin;
+    while (address < end) {
+        auto it = disassembly.instructions.constFind(address);
+        if (it != disassembly.instructions.constEnd()) {
+            lines.append(it->text());
+            address += it->size;
+            continue;
+        }
+        int dataEnd = address;
+        while (dataEnd < end && dataEnd - address < BYTES_PER_DATA_LINE && !disassembly.instructions.contains(dataEnd)) {
+            ++dataEnd;
+        }
+        lines.append(dataLine(disassembly.image.mid(address - disassembly.origin, dataEnd - address)));
+        address = dataEnd;
+    }
+    lines.append(QString());
+    return lines.join('\n');
+}
+
+QString Disassembler::dataLine(const QByteArray& bytes) {
+    QStringList items;
+    int i = 0;
+    while (i < bytes.size()) {
+        int run = i;
+        while (run < bytes.size() && isPrintable(bytes[run])) ++run;
+        if (run - i >= MIN_STRING_LENGTH) {
+            items.append("\"" + QString::fromLatin1(bytes.mid(i, run - i)) + "\"");
+            i = run;
+        } else {
+            items.append(InstructionDecoder::hexByte(quint8(bytes[i])));
+            ++i;
+        }
+    }
+    return "DB " + items.join(',');
+}
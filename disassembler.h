@@ -0,0 +1,42 @@
+#ifndef DISASSEMBLER_H
+#define DISASSEMBLER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include <QMap>
+#include "instructiondecoder.h"
+
+struct BasicBlock {
+    int start = 0;
+    int end = 0;
+    QVector<int> instructions;
+    QVector<int> successors;
+};
+
+struct ControlFlowGraph {
+    QVector<BasicBlock> blocks;
+    int blockAt(int address) const;
+    bool isEmpty() const { return blocks.isEmpty(); }
+};
+
+struct Disassembly {
+    int origin = 0x100;
+    QByteArray image;
+    QMap<int, DecodedInstruction> instructions;
+    ControlFlowGraph graph;
+    bool isCode(int address) const;
+};
+
+class Disassembler {
+public:
+    static Disassembly disassemble(const QByteArray& image, int origin = 0x100, const QVector<int>& entries = QVector<int>());
+    static QString toScript(const Disassembly& disassembly);
+private:
+    static constexpr int BYTES_PER_DATA_LINE = 16;
+    static constexpr int MIN_STRING_LENGTH = 3;
+
+    static QString dataLine(const QByteArray& bytes);
+};
+
+#endif // DISASSEMBLER_H
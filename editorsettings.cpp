@@ -0,0 +1,98 @@
+#include "editorsettings.h"
+
+EditorSettings EditorSettings::defaults() {
+    EditorSettings s;
+    s.theme = "Light";
+    s.backgroundColor = QColor(Qt::white);
+    s.textColor = QColor(Qt::black);
+    s.highlightColor = QColor(Qt::darkGray).lighter(160);
+    s.font = QFont("Courier New", 10);
+    s.standardLineNumbering = true;
+    s.addressLineNumbering = true;
+    s.lineWrap = false;
+    s.autoSave = false;
+    s.syntaxHighlighting = true;
+    s.language = "English";
+    s.showMemoryDump = false;
+    s.memoryDumpSegment = "1000";
+    s.memoryDumpOffset = "200";
+    s.memoryDumpLineCount = 8;
+    s.showOutputConsole = false;
+    s.unloadIdleTabs = false;
+    return s;
+}
+
+EditorSettings EditorSettings::fromMap(const QMap<QString, QVariant>& map, const EditorSettings& base) {
+    EditorSettings s = base;
+    if (map.contains("theme")) s.theme = map["theme"].toString();
+    if (map.contains("backgroundColor")) s.backgroundColor = map["backgroundColor"].value<QColor>();
+    if (map.contains("textColor")) s.textColor = map["textColor"].value<QColor>();
+    if (map.contains("highlightColor")) s.highlightColor = map["highlightColor"].value<QColor>();
+    if (map.contains("font")) s.font = map["font"].value<QFont>();
+    if (map.contains("standardLineNumbering")) s.standardLineNumbering = map["standardLineNumbering"].toBool();
+    if (map.contains("addressLineNumbering")) s.addressLineNumbering = map["addressLineNumbering"].toBool();
+    if (map.contains("lineWrap")) s.lineWrap = map["lineWrap"].toBool();
+    if (map.contains("autoSave")) s.autoSave = map["autoSave"].toBool();
+    if (map.contains("syntaxHighlighting")) s.syntaxHighlighting = map["syntaxHighlighting"].toBool();
+    if (map.contains("language")) s.language = map["language"].toString();
+    if (map.contains("showMemoryDump")) s.showMemoryDump = map["showMemoryDump"].toBool();
+    if (map.contains("memoryDumpSegment")) s.memoryDumpSegment = map["memoryDumpSegment"].toString();
+    if (map.contains("memoryDumpOffset")) s.memoryDumpOffset = map["memoryDumpOffset"].toString();
+    if (map.contains("memoryDumpLineCount")) s.memoryDumpLineCount = map["memoryDumpLineCount"].toInt();
+    if (map.contains("showOutputConsole")) s.showOutputConsole = map["showOutputConsole"].toBool();
+    if (map.contains("unloadIdleTabs")) s.unloadIdleTabs = map["unloadIdleTabs"].toBool();
+    return s;
+}
+
+QSet<QString> EditorSettings::allKeys() {
+    QSet<QString> keys;
+    const QMap<QString, QVariant> map = defaults().toMap();
+    for (auto it = map.constBegin(); it != map.constEnd(); ++it) {
+        keys.insert(it.key());
+    }
+    return keys;
+}
+
+QMap<QString, QVariant> EditorSettings::toMap() const {
+    QMap<QString, QVariant> map;
+    map["theme"] = theme;
+    map["backgroundColor"] = backgroundColor;
+    map["textColor"] = textColor;
+    map["highlightColor"] = highlightColor;
+    map["font"] = font;
+    map["standardLineNumbering"] = standardLineNumbering;
+    map["addressLineNumbering"] = addressLineNumbering;
+    map["lineWrap"] = lineWrap;
+    map["autoSave"] = autoSave;
+    map["syntaxHighlighting"] = syntaxHighlighting;
+    map["language"] = language;
+    map["showMemoryDump"] = showMemoryDump;
+    map["memoryDumpSegment"] = memoryDumpSegment;
+    map["memoryDumpOffset"] = memoryDumpOffset;
+    map["memoryDumpLineCount"] = memoryDumpLineCount;
+    map["showOutputConsole"] = showOutputConsole;
+    map["unloadIdleTabs"] = unloadIdleTabs;
+    return map;
+}
+
+QSet<QString> EditorSettings::changedKeys(const EditorSettings& other) const {
+    QSet<QString> keys;
+    if (theme != other.theme) keys.insert("theme");
+    if (backgroundColor != other.backgroundColor) keys.insert("backgroundColor");
+    if (textColor != other.textColor) keys.insert("textColor");
+    if (highlightColor != other.highlightColor) keys.insert("highlightColor");
+    if (font != other.font) keys.insert("font");
+    if (standardLineNumbering != other.standardLineNumbering) keys.insert("standardLineNumbering");
+    if (addressLineNumbering != other.addressLineNumbering) keys.insert("addressLineNumbering");
+    if (lineWrap != other.lineWrap) keys.insert("lineWrap");
+    if (autoSave != other.autoSave) keys.insert("autoSave");
+    if (syntaxHighlighting != other.syntaxHighlighting) keys.insert("syntaxHighlighting");
+    if (language != other.language) keys.insert("language");
+    if (showMemoryDump != other.showMemoryDump) keys.insert("showMemoryDump");
+    if (memoryDumpSegment != other.memoryDumpSegment) keys.insert("memoryDumpSegment");
+    if (memoryDumpOffset != other.memoryDumpOffset) keys.insert("memoryDumpOffset");
+    if (memoryDumpLineCount != other.memoryDumpLineCount) keys.insert("memoryDumpLineCount");
+    if (showOutputConsole != other.showOutputConsole) keys.insert("showOutputConsole");
+    if (unloadIdleTabs != other.unloadIdleTabs) keys.insert("unloadIdleTabs");
+    return keys;
+}
@@ -0,0 +1,37 @@
+#ifndef EDITORSETTINGS_H
+#define EDITORSETTINGS_H
+
+#include <QString>
+#include <QColor>
+#include <QFont>
+#include <QMap>
+#include <QSet>
+#include <QVariant>
+
+struct EditorSettings {
+    QString theme;
+    QColor backgroundColor;
+    QColor textColor;
+    QColor highlightColor;
+    QFont font;
+    bool standardLineNumbering;
+    bool addressLineNumbering;
+    bool lineWrap;
+    bool autoSave;
+    bool syntaxHighlighting;
+    QString language;
+    bool showMemoryDump;
+    QString memoryDumpSegment;
+    QString memoryDumpOffset;
+    int memoryDumpLineCount;
+    bool showOutputConsole;
+    bool unloadIdleTabs;
+
+    static EditorSettings defaults();
+    static EditorSettings fromMap(const QMap<QString, QVariant>& map, const EditorSettings& base = defaults());
+    static QSet<QString> allKeys();
+    QMap<QString, QVariant> toMap() const;
+    QSet<QString> changedKeys(const EditorSettings& other) const;
+};
+
+#endif // EDITORSETTINGS_H
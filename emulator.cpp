@@ -0,0 +1,1165 @@
+#include "emulator.h"
+#include "memorykernels.h"
+#include "opcodetable.h"
+#include <QDate>
+#include <QTime>
+
+namespace {
+
+const quint16 INITIAL_FLAGS = 0xF202;
+const quint16 STACK_TOP = 0xFFFE;
+
+bool evenParity(quint8 value) {
+    value ^= value >> 4;
+    return !((0x6996 >> (value & 0x0F)) & 1);
+}
+
+// The 8086 keeps bits 12-15 of FLAGS set and bits 1, 3 and 5 fixed.
+quint16 normalizedFlags(quint16 value) {
+    return (value & 0x0FD5) | 0xF002;
+}
+
+static_assert(int(OpcodeInfo::CF) == Emulator::CF && int(OpcodeInfo::ZF) == Emulator::ZF && int(OpcodeInfo::SF) == Emulator::SF
+              && int(OpcodeInfo::OF) == Emulator::OF && int(OpcodeInfo::DF) == Emulator::DF,
+              "the opcode table and the emulator agree on FLAGS bits");
+
+}
+
+bool CpuState::operator==(const CpuState& other) const {
+    for (int i = 0; i < 8; ++i) {
+        if (registers[i] != other.registers[i]) return false;
+    }
+    for (int i = 0; i < 4; ++i) {
+        if (segments[i] != other.segments[i]) return false;
+    }
+    return ip == other.ip && flags == other.flags;
+}
+
+Emulator::Emulator() : memory(MEMORY_SIZE, 0), writeStamps(MEMORY_SIZE, 0), generation(1),
+    lastWriters(MEMORY_SIZE, 0), pageEpochs(DIRTY_PAGE_COUNT, 0), epoch(1), instructionStart(0), breakpointMap(0x10000, NoBreakpoint), hasBreakpoints(false),
+    watchedPages(MEMORY_SIZE >> WATCH_PAGE_SHIFT, 0), watching(false), watchTriggered(false), watchAddress(0),
+    segmentOverride(-1), finished(false), returned(false), exitStatus(0), executed(0), clocks(0) {}
+
+void Emulator::load(const QByteArray& image, quint16 entry) {
+    std::fill(memory.begin(), memory.end(), 0);
+    const quint32 base = linear(PROGRAM_SEGMENT, 0);
+    for (int i = 0; i < image.size() && i < 0x10000; ++i) {
+        memory[base + i] = quint8(image[i]);
+    }
+
+    // A minimal PSP: RET to offset 0 reaches INT 20h, and the command tail is empty.
+    if (!memory[base] && !memory[base + 1]) {
+        memory[base] = 0xCD;
+        memory[base + 1] = 0x20;
+    }
+    if (!memory[base + 0x81]) memory[base + 0x81] = 0x0D;
+
+    cpu = CpuState();
+    for (quint16& segment : cpu.segments) segment = PROGRAM_SEGMENT;
+    cpu.registers[SP] = STACK_TOP;
+    cpu.ip = entry;
+    cpu.flags = INITIAL_FLAGS;
+    write16(PROGRAM_SEGMENT, STACK_TOP, 0);
+    finished = false;
+    returned = false;
+    exitStatus = 0;
+    executed = 0;
+    clocks = 0;
+    output.clear();
+    watchTriggered = false;
+    std::fill(writeStamps.begin(), writeStamps.end(), 0);
+    generation = 1;
+    std::fill(lastWriters.begin(), lastWriters.end(), 0);
+    std::fill(pageEpochs.begin(), pageEpochs.end(), 0);
+    epoch = 1;
+}
+
+Emulator::Snapshot Emulator::snapshot() {
+    Snapshot result;
+    result.memory = memory;
+    result.epoch = epoch++;
+    return result;
+}
+
+void Emulator::setBreakpoints(const QHash<int, ConditionExpression>& breakpoints) {
+    std::fill(breakpointMap.begin(), breakpointMap.end(), NoBreakpoint);
+    conditions.clear();
+    for (auto it = breakpoints.constBegin(); it != breakpoints.constEnd(); ++it) {
+        const int offset = it.key() & 0xFFFF;
+        if (it.value().isValid()) {
+            breakpointMap[offset] = Conditional;
+            conditions.insert(offset, it.value());
+        } else {
+            breakpointMap[offset] = Unconditional;
+        }
+    }
+    hasBreakpoints = !breakpoints.isEmpty();
+}
+
+void Emulator::setWatchpoints(const QVector<MemoryRange>& ranges) {
+    std::fill(watchedPages.begin(), watchedPages.end(), 0);
+    watchRanges = ranges;
+    for (const MemoryRange& range : ranges) {
+        for (int i = 0; i < range.size; ++i) {
+            watchedPages[((range.address + i) & (MEMORY_SIZE - 1)) >> WATCH_PAGE_SHIFT] = 1;
+        }
+    }
+    watching = !ranges.isEmpty();
+    watchTriggered = false;
+}
+
+void Emulator::noteWrite(quint32 address) {
+    for (const MemoryRange& range : watchRanges) {
+        if (((address - range.address) & (MEMORY_SIZE - 1)) < quint32(range.size)) {
+            watchTriggered = true;
+            watchAddress = address;
+            return;
+        }
+    }
+}
+
+QString Emulator::takeOutput() {
+    QString text;
+    text.swap(output);
+    return text;
+}
+
+QByteArray Emulator::readMemory(quint32 address, int size) const {
+    QByteArray bytes(size, 0);
+    for (int i = 0; i < size; ++i) {
+        bytes[i] = char(memory[(address + i) & (MEMORY_SIZE - 1)]);
+    }
+    return bytes;
+}
+
+void Emulator::fillMemory(quint32 address, int size, const QByteArray& pattern) {
+    MemoryKernels::fill(memory.data() + address, size, reinterpret_cast<const quint8*>(pattern.constData()), pattern.size());
+    markCommandWrite(address, size);
+}
+
+void Emulator::moveMemory(quint32 target, quint32 source, int size) {
+    MemoryKernels::move(memory.data() + target, memory.data() + source, size);
+    markCommandWrite(target, size);
+}
+
+void Emulator::markCommandWrite(quint32 address, int size) {
+    if (size <= 0) return;
+    std::fill(writeStamps.begin() + address, writeStamps.begin() + address + size, generation);
+    std::fill(lastWriters.begin() + address, lastWriters.begin() + address + size, COMMAND_WRITER);
+    const int lastPage = int((address + size - 1) >> DIRTY_PAGE_SHIFT);
+    for (int page = int(address >> DIRTY_PAGE_SHIFT); page <= lastPage; ++page) {
+        pageEpochs[page] = epoch;
+    }
+}
+
+bool Emulator::atBreakpoint() const {
+    if (!hasBreakpoints || cpu.segments[CS] != PROGRAM_SEGMENT) return false;
+    switch (breakpointMap[cpu.ip]) {
+    case NoBreakpoint: return false;
+    case Unconditional: return true;
+    default: return conditions.value(cpu.ip).test(*this);
+    }
+}
+
+Emulator::StopReason Emulator::run(quint64 maxSteps) {
+    for (quint64 n = 0; n < maxSteps; ++n) {
+        if (atBreakpoint()) return Breakpoint;
+        StopReason reason = step();
+        if (reason != Stepped) return reason;
+    }
+    return StepLimit;
+}
+
+quint16 Emulator::read16(quint16 segment, quint16 offset) const {
+    return read8(segment, offset) | (read8(segment, quint16(offset + 1)) << 8);
+}
+
+void Emulator::write16(quint16 segment, quint16 offset, quint16 value) {
+    write8(segment, offset, quint8(value));
+    write8(segment, quint16(offset + 1), quint8(value >> 8));
+}
+
+quint8 Emulator::fetch8() {
+    return read8(cpu.segments[CS], cpu.ip++);
+}
+
+quint16 Emulator::fetch16() {
+    quint16 value = read16(cpu.segments[CS], cpu.ip);
+    cpu.ip += 2;
+    return value;
+}
+
+void Emulator::push(quint16 value) {
+    cpu.registers[SP] -= 2;
+    write16(cpu.segments[SS], cpu.registers[SP], value);
+}
+
+quint16 Emulator::pop() {
+    quint16 value = read16(cpu.segments[SS], cpu.registers[SP]);
+    cpu.registers[SP] += 2;
+    return value;
+}
+
+quint16 Emulator::dataSegment() const {
+    return cpu.segments[segmentOverride >= 0 ? segmentOverride : DS];
+}
+
+Emulator::ModRM Emulator::decodeModRM() {
+    ModRM modrm;
+    const quint8 byte = fetch8();
+    modrm.mod = byte >> 6;
+    modrm.reg = (byte >> 3) & 7;
+    modrm.rm = byte & 7;
+    if (modrm.mod == 3) return modrm;
+
+    const quint16* r = cpu.registers;
+    int segment = DS;
+    quint16 offset = 0;
+    switch (modrm.rm) {
+    case 0: offset = r[BX] + r[SI]; break;
+    case 1: offset = r[BX] + r[DI]; break;
+    case 2: offset = r[BP] + r[SI]; segment = SS; break;
+    case 3: offset = r[BP] + r[DI]; segment = SS; break;
+    case 4: offset = r[SI]; break;
+    case 5: offset = r[DI]; break;
+    case 6:
+        if (modrm.mod == 0) {
+            offset = fetch16();
+        } else {
+            offset = r[BP];
+            segment = SS;
+        }
+        break;
+    default: offset = r[BX]; break;
+    }
+    if (modrm.mod == 1) offset += quint16(qint8(fetch8()));
+    else if (modrm.mod == 2) offset += fetch16();
+
+    modrm.segment = cpu.segments[segmentOverride >= 0 ? segmentOverride : segment];
+    modrm.offset = offset;
+    return modrm;
+}
+
+quint8 Emulator::getReg8(int reg) const {
+    const quint16 word = cpu.registers[reg & 3];
+    return reg >= 4 ? quint8(word >> 8) : quint8(word);
+}
+
+void Emulator::setReg8(int reg, quint8 value) {
+    quint16& word = cpu.registers[reg & 3];
+    word = reg >= 4 ? quint16((word & 0x00FF) | (value << 8)) : quint16((word & 0xFF00) | value);
+}
+
+quint8 Emulator::getRM8(const ModRM& modrm) const {
+    return modrm.mod == 3 ? getReg8(modrm.rm) : read8(modrm.segment, modrm.offset);
+}
+
+quint16 Emulator::getRM16(const ModRM& modrm) const {
+    return modrm.mod == 3 ? cpu.registers[modrm.rm] : read16(modrm.segment, modrm.offset);
+}
+
+void Emulator::setRM8(const ModRM& modrm, quint8 value) {
+    if (modrm.mod == 3) setReg8(modrm.rm, value);
+    else write8(modrm.segment, modrm.offset, value);
+}
+
+void Emulator::setRM16(const ModRM& modrm, quint16 value) {
+    if (modrm.mod == 3) cpu.registers[modrm.rm] = value;
+    else write16(modrm.segment, modrm.offset, value);
+}
+
+void Emulator::setFlag(int flag, bool value) {
+    if (value) cpu.flags |= flag;
+    else cpu.flags &= ~flag;
+}
+
+void Emulator::setResultFlags(quint32 result, bool word) {
+    const quint32 mask = word ? 0xFFFF : 0xFF;
+    setFlag(ZF, (result & mask) == 0);
+    setFlag(SF, result & (word ? 0x8000 : 0x80));
+    setFlag(PF, evenParity(quint8(result)));
+}
+
+// Operations in the order of the ModRM reg field: ADD, OR, ADC, SBB, AND, SUB, XOR, CMP.
+quint32 Emulator::alu(int operation, quint32 a, quint32 b, bool word) {
+    const quint32 mask = word ? 0xFFFF : 0xFF;
+    const quint32 sign = word ? 0x8000 : 0x80;
+    quint32 result;
+    switch (operation) {
+    case 0:
+    case 2: {
+        const quint32 carry = operation == 2 && flag(CF) ? 1 : 0;
+        result = a + b + carry;
+        setFlag(CF, result > mask);
+        setFlag(OF, (~(a ^ b) & (a ^ result) & sign) != 0);
+        setFlag(AF, ((a ^ b ^ result) & 0x10) != 0);
+        break;
+    }
+    case 3:
+    case 5:
+    case 7: {
+        const quint32 borrow = operation == 3 && flag(CF) ? 1 : 0;
+        result = a - b - borrow;
+        setFlag(CF, b + borrow > a);
+        setFlag(OF, ((a ^ b) & (a ^ result) & sign) != 0);
+        setFlag(AF, ((a ^ b ^ result) & 0x10) != 0);
+        break;
+    }
+    default:
+        result = operation == 1 ? a | b : operation == 4 ? a & b : a ^ b;
+        setFlag(CF, false);
+        setFlag(OF, false);
+        setFlag(AF, false);
+        break;
+    }
+    result &= mask;
+    setResultFlags(result, word);
+    return result;
+}
+
+quint32 Emulator::incDec(quint32 value, bool decrement, bool word) {
+    const quint32 mask = word ? 0xFFFF : 0xFF;
+    const quint32 sign = word ? 0x8000 : 0x80;
+    const quint32 result = (decrement ? value - 1 : value + 1) & mask;
+    setFlag(OF, decrement ? value == sign : result == sign);
+    setFlag(AF, ((value ^ result) & 0x10) != 0);
+    setResultFlags(result, word);
+    return result;
+}
+
+// Operations in the order of the ModRM reg field: ROL, ROR, RCL, RCR, SHL, SHR, SHL (undocumented alias), SAR.
+quint32 Emulator::shift(int operation, quint32 value, int count, bool word) {
+    if (count == 0) return value;
+    const quint32 mask = word ? 0xFFFF : 0xFF;
+    const quint32 sign = word ? 0x8000 : 0x80;
+    quint32 result = value & mask;
+    for (int k = 0; k < count; ++k) {
+        bool carry;
+        switch (operation) {
+        case 0:
+            carry = result & sign;
+            result = ((result << 1) | carry) & mask;
+            break;
+        case 1:
+            carry = result & 1;
+            result = (result >> 1) | (carry ? sign : 0);
+            break;
+        case 2:
+            carry = result & sign;
+            result = ((result << 1) | (flag(CF) ? 1 : 0)) & mask;
+            break;
+        case 3:
+            carry = result & 1;
+            result = (result >> 1) | (flag(CF) ? sign : 0);
+            break;
+        case 5:
+            carry = result & 1;
+            result >>= 1;
+            break;
+        case 7:
+            carry = result & 1;
+            result = (result >> 1) | (result & sign);
+            break;
+        default:
+            carry = result & sign;
+            result = (result << 1) & mask;
+            break;
+        }
+        setFlag(CF, carry);
+    }
+
+    switch (operation) {
+    case 1:
+    case 3:
+        setFlag(OF, ((result ^ (result << 1)) & sign) != 0);
+        break;
+    case 5:
+        setFlag(OF, count == 1 && (value & sign));
+        break;
+    case 7:
+        setFlag(OF, false);
+        break;
+    default:
+        setFlag(OF, ((result & sign) != 0) != flag(CF));
+        break;
+    }
+    if (operation >= 4) setResultFlags(result, word);
+    return result;
+}
+
+// TEST, NOT, NEG, MUL, IMUL, DIV, IDIV; false when a division faults.
+bool Emulator::group3(const ModRM& modrm, bool word) {
+    quint16* r = cpu.registers;
+    const quint32 value = word ? getRM16(modrm) : getRM8(modrm);
+    switch (modrm.reg) {
+    case 0:
+    case 1:
+        alu(4, value, word ? fetch16() : fetch8(), word);
+        break;
+    case 2:
+        if (word) setRM16(modrm, quint16(~value));
+        else setRM8(modrm, quint8(~value));
+        break;
+    case 3: {
+        const quint32 result = alu(5, 0, value, word);
+        if (word) setRM16(modrm, quint16(result));
+        else setRM8(modrm, quint8(result));
+        break;
+    }
+    case 4:
+        if (word) {
+            const quint32 product = quint32(r[AX]) * value;
+            r[AX] = quint16(product);
+            r[DX] = quint16(product >> 16);
+            setFlag(CF, r[DX] != 0);
+        } else {
+            r[AX] = quint16(getReg8(0) * value);
+            setFlag(CF, (r[AX] >> 8) != 0);
+        }
+        setFlag(OF, flag(CF));
+        break;
+    case 5:
+        if (word) {
+            const qint32 product = qint32(qint16(r[AX])) * qint16(value);
+            r[AX] = quint16(product);
+            r[DX] = quint16(quint32(product) >> 16);
+            setFlag(CF, product != qint16(product));
+        } else {
+            const qint16 product = qint16(qint8(getReg8(0)) * qint8(value));
+            r[AX] = quint16(product);
+            setFlag(CF, product != qint8(product));
+        }
+        setFlag(OF, flag(CF));
+        break;
+    case 6:
+        if (value == 0) return false;
+        if (word) {
+            const quint32 dividend = (quint32(r[DX]) << 16) | r[AX];
+            const quint32 quotient = dividend / value;
+            if (quotient > 0xFFFF) return false;
+            r[AX] = quint16(quotient);
+            r[DX] = quint16(dividend % value);
+        } else {
+            const quint32 quotient = r[AX] / value;
+            if (quotient > 0xFF) return false;
+            r[AX] = quint16(((r[AX] % value) << 8) | quotient);
+        }
+        break;
+    default:
+        if (value == 0) return false;
+        if (word) {
+            const qint32 dividend = qint32((quint32(r[DX]) << 16) | r[AX]);
+            const qint32 divisor = qint16(value);
+            const qint32 quotient = dividend / divisor;
+            if (quotient > 0x7FFF || quotient < -0x7FFF) return false;
+            r[AX] = quint16(quotient);
+            r[DX] = quint16(dividend % divisor);
+        } else {
+            const qint32 dividend = qint16(r[AX]);
+            const qint32 divisor = qint8(value);
+            const qint32 quotient = dividend / divisor;
+            if (quotient > 0x7F || quotient < -0x7F) return false;
+            r[AX] = quint16(((quint8(dividend % divisor)) << 8) | quint8(quotient));
+        }
+        break;
+    }
+    return true;
+}
+
+// Condition codes in opcode order: O, NO, B, NB, Z, NZ, BE, A, S, NS, P, NP, L, GE, LE, G.
+bool Emulator::condition(int code) const {
+    bool result;
+    switch (code >> 1) {
+    case 0: result = flag(OF); break;
+    case 1: result = flag(CF); break;
+    case 2: result = flag(ZF); break;
+    case 3: result = flag(CF) || flag(ZF); break;
+    case 4: result = flag(SF); break;
+    case 5: result = flag(PF); break;
+    case 6: result = flag(SF) != flag(OF); break;
+    default: result = flag(ZF) || flag(SF) != flag(OF); break;
+    }
+    return (code & 1) ? !result : result;
+}
+
+void Emulator::stringOperation(quint8 opcode, int repeat) {
+    quint16* r = cpu.registers;
+    const bool word = opcode & 1;
+    const quint16 delta = quint16((flag(DF) ? -1 : 1) * (word ? 2 : 1));
+    const quint16 source = dataSegment();
+    const quint16 es = cpu.segments[ES];
+    auto once = [&]() {
+        switch (opcode & 0xFE) {
+        case 0xA4:
+            if (word) write16(es, r[DI], read16(source, r[SI]));
+            else write8(es, r[DI], read8(source, r[SI]));
+            r[SI] += delta;
+            r[DI] += delta;
+            break;
+        case 0xA6:
+            if (word) alu(7, read16(source, r[SI]), read16(es, r[DI]), true);
+            else alu(7, read8(source, r[SI]), read8(es, r[DI]), false);
+            r[SI] += delta;
+            r[DI] += delta;
+            break;
+        case 0xAA:
+            if (word) write16(es, r[DI], r[AX]);
+            else write8(es, r[DI], getReg8(0));
+            r[DI] += delta;
+            break;
+        case 0xAC:
+            if (word) r[AX] = read16(source, r[SI]);
+            else setReg8(0, read8(source, r[SI]));
+            r[SI] += delta;
+            break;
+        default:
+            if (word) alu(7, r[AX], read16(es, r[DI]), true);
+            else alu(7, getReg8(0), read8(es, r[DI]), false);
+            r[DI] += delta;
+            break;
+        }
+    };
+
+    if (!repeat) {
+        once();
+        return;
+    }
+    const bool compares = (opcode & 0xFE) == 0xA6 || (opcode & 0xFE) == 0xAE;
+    while (r[CX] != 0) {
+        once();
+        --r[CX];
+        // REPE stops on the first difference, REPNE on the first match.
+        if (compares && (repeat == 1) != flag(ZF)) break;
+    }
+}
+
+Emulator::StopReason Emulator::interrupt(quint8 number) {
+    const quint16 vectorOffset = read16(0, number * 4);
+    const quint16 vectorSegment = read16(0, number * 4 + 2);
+    if (vectorOffset || vectorSegment) {
+        push(cpu.flags);
+        push(cpu.segments[CS]);
+        push(cpu.ip);
+        setFlag(IF, false);
+        setFlag(TF, false);
+        cpu.segments[CS] = vectorSegment;
+        cpu.ip = vectorOffset;
+        return Stepped;
+    }
+
+    quint16* r = cpu.registers;
+    switch (number) {
+    case 0x20:
+        exitProgram(0);
+        return Exited;
+    case 0x21:
+        return dosService();
+    case 0x10:
+        if (getReg8(4) == 0x0E) output += QChar(getReg8(0));
+        return Stepped;
+    case 0x16:
+        // There is no keyboard, every read returns Enter and a status check reports an empty buffer.
+        if (getReg8(4) == 0x00 || getReg8(4) == 0x10) r[AX] = 0x1C0D;
+        else if (getReg8(4) == 0x01 || getReg8(4) == 0x11) setFlag(ZF, true);
+        return Stepped;
+    default:
+        return Stepped;
+    }
+}
+
+Emulator::StopReason Emulator::dosService() {
+    quint16* r = cpu.registers;
+    const quint16 ds = cpu.segments[DS];
+    switch (getReg8(4)) {
+    case 0x00:
+        exitProgram(0);
+        return Exited;
+    case 0x01:
+    case 0x07:
+    case 0x08:
+        setReg8(0, 0x0D);
+        break;
+    case 0x02:
+        output += QChar(getReg8(2));
+        break;
+    case 0x06:
+        if (getReg8(2) == 0xFF) {
+            setReg8(0, 0);
+            setFlag(ZF, true);
+        } else {
+            output += QChar(getReg8(2));
+        }
+        break;
+    case 0x09:
+        for (quint16 offset = r[DX], count = 0; count < 0xFFFF; ++offset, ++count) {
+            const quint8 c = read8(ds, offset);
+            if (c == '$') break;
+            output += QChar(c);
+        }
+        break;
+    case 0x0A:
+        write8(ds, quint16(r[DX] + 1), 0);
+        write8(ds, quint16(r[DX] + 2), 0x0D);
+        break;
+    case 0x0B:
+        setReg8(0, 0);
+        break;
+    case 0x25:
+        write16(0, getReg8(0) * 4, r[DX]);
+        write16(0, getReg8(0) * 4 + 2, ds);
+        break;
+    case 0x2A: {
+        const QDate date = QDate::currentDate();
+        r[CX] = quint16(date.year());
+        setReg8(6, quint8(date.month()));
+        setReg8(2, quint8(date.day()));
+        setReg8(0, quint8(date.dayOfWeek() % 7));
+        break;
+    }
+    case 0x2C: {
+        const QTime time = QTime::currentTime();
+        setReg8(5, quint8(time.hour()));
+        setReg8(1, quint8(time.minute()));
+        setReg8(6, quint8(time.second()));
+        setReg8(2, quint8(time.msec() / 10));
+        break;
+    }
+    case 0x30:
+        r[AX] = 0x0005;
+        break;
+    case 0x31:
+    case 0x4C:
+        exitProgram(getReg8(0));
+        return Exited;
+    case 0x35:
+        r[BX] = read16(0, getReg8(0) * 4);
+        cpu.segments[ES] = read16(0, getReg8(0) * 4 + 2);
+        break;
+    case 0x40:
+        if (r[BX] == 1 || r[BX] == 2) {
+            for (quint16 k = 0; k < r[CX]; ++k) {
+                output += QChar(read8(ds, quint16(r[DX] + k)));
+            }
+            r[AX] = r[CX];
+            setFlag(CF, false);
+        } else {
+            r[AX] = 0x0006;
+            setFlag(CF, true);
+        }
+        break;
+    default:
+        // File, memory and process services are not available, report "function not supported".
+        r[AX] = 0x0001;
+        setFlag(CF, true);
+        break;
+    }
+    return Stepped;
+}
+
+void Emulator::exitProgram(int code) {
+    finished = true;
+    exitStatus = code;
+}
+
+Emulator::StopReason Emulator::step() {
+    instructionStart = linear(cpu.segments[CS], cpu.ip);
+    const StopReason reason = execute();
+    if (Q_UNLIKELY(watchTriggered)) {
+        watchTriggered = false;
+        if (reason == Stepped) return Watchpoint;
+    }
+    return reason;
+}
+
+Emulator::StopReason Emulator::execute() {
+    if (finished) return Exited;
+    quint16* r = cpu.registers;
+    quint16* s = cpu.segments;
+    const quint16 start = cpu.ip;
+    returned = false;
+    segmentOverride = -1;
+    int repeat = 0;
+    ++executed;
+
+    // Undocumented aliases run as the opcode the table names for them.
+    quint8 opcode;
+    forever {
+        opcode = fetch8();
+        const OpcodeInfo& info = OpcodeTable::info(opcode);
+        if (info.alias >= 0) opcode = quint8(info.alias);
+        if (OpcodeTable::info(opcode).form != OpcodeInfo::Prefix) break;
+        if (opcode < 0x40) {
+            segmentOverride = (opcode >> 3) & 3;
+        } else if (opcode == 0xF2 || opcode == 0xF3) {
+            repeat = opcode == 0xF3 ? 1 : 2;
+        }
+    }
+    clocks += OpcodeTable::info(opcode).cycles;
+
+    if (opcode < 0x40 && (opcode & 7) < 6) {
+        const int operation = opcode >> 3;
+        switch (opcode & 7) {
+        case 0: {
+            const ModRM modrm = decodeModRM();
+            const quint32 result = alu(operation, getRM8(modrm), getReg8(modrm.reg), false);
+            if (operation != 7) setRM8(modrm, quint8(result));
+            break;
+        }
+        case 1: {
+            const ModRM modrm = decodeModRM();
+            const quint32 result = alu(operation, getRM16(modrm), r[modrm.reg], true);
+            if (operation != 7) setRM16(modrm, quint16(result));
+            break;
+        }
+        case 2: {
+            const ModRM modrm = decodeModRM();
+            const quint32 result = alu(operation, getReg8(modrm.reg), getRM8(modrm), false);
+            if (operation != 7) setReg8(modrm.reg, quint8(result));
+            break;
+        }
+        case 3: {
+            const ModRM modrm = decodeModRM();
+            const quint32 result = alu(operation, r[modrm.reg], getRM16(modrm), true);
+            if (operation != 7) r[modrm.reg] = quint16(result);
+            break;
+        }
+        case 4: {
+            const quint32 result = alu(operation, getReg8(0), fetch8(), false);
+            if (operation != 7) setReg8(0, quint8(result));
+            break;
+        }
+        default: {
+            const quint32 result = alu(operation, r[AX], fetch16(), true);
+            if (operation != 7) r[AX] = quint16(result);
+            break;
+        }
+        }
+        return Stepped;
+    }
+
+    switch (opcode) {
+    case 0x06: case 0x0E: case 0x16: case 0x1E:
+        push(s[(opcode >> 3) & 3]);
+        break;
+    case 0x07: case 0x0F: case 0x17: case 0x1F:
+        s[(opcode >> 3) & 3] = pop();
+        break;
+    case 0x27: {
+        const quint8 al = getReg8(0);
+        const bool carry = flag(CF);
+        quint8 result = al;
+        setFlag(CF, false);
+        if ((al & 0x0F) > 9 || flag(AF)) {
+            result += 6;
+            setFlag(CF, carry || al > 0xF9);
+            setFlag(AF, true);
+        } else {
+            setFlag(AF, false);
+        }
+        if (al > 0x99 || carry) {
+            result += 0x60;
+            setFlag(CF, true);
+        }
+        setReg8(0, result);
+        setResultFlags(result, false);
+        break;
+    }
+    case 0x2F: {
+        const quint8 al = getReg8(0);
+        const bool carry = flag(CF);
+        quint8 result = al;
+        setFlag(CF, false);
+        if ((al & 0x0F) > 9 || flag(AF)) {
+            result -= 6;
+            setFlag(CF, carry || al < 6);
+            setFlag(AF, true);
+        } else {
+            setFlag(AF, false);
+        }
+        if (al > 0x99 || carry) {
+            result -= 0x60;
+            setFlag(CF, true);
+        }
+        setReg8(0, result);
+        setResultFlags(result, false);
+        break;
+    }
+    case 0x37:
+    case 0x3F: {
+        const bool adjust = (getReg8(0) & 0x0F) > 9 || flag(AF);
+        if (adjust) {
+            r[AX] = opcode == 0x37 ? quint16(r[AX] + 0x106) : quint16(((r[AX] - 0x100) & 0xFF00) | ((r[AX] - 6) & 0xFF));
+        }
+        setFlag(AF, adjust);
+        setFlag(CF, adjust);
+        setReg8(0, getReg8(0) & 0x0F);
+        break;
+    }
+    case 0x40: case 0x41: case 0x42: case 0x43: case 0x44: case 0x45: case 0x46: case 0x47:
+    case 0x48: case 0x49: case 0x4A: case 0x4B: case 0x4C: case 0x4D: case 0x4E: case 0x4F:
+        r[opcode & 7] = quint16(incDec(r[opcode & 7], opcode & 8, true));
+        break;
+    case 0x50: case 0x51: case 0x52: case 0x53: case 0x54: case 0x55: case 0x56: case 0x57:
+        // The 8086 pushes the already decremented SP for PUSH SP.
+        r[SP] -= 2;
+        write16(s[SS], r[SP], r[opcode & 7]);
+        break;
+    case 0x58: case 0x59: case 0x5A: case 0x5B: case 0x5C: case 0x5D: case 0x5E: case 0x5F: {
+        const quint16 value = pop();
+        r[opcode & 7] = value;
+        break;
+    }
+    case 0x80: case 0x81: case 0x82: case 0x83: {
+        const bool word = opcode & 1;
+        const ModRM modrm = decodeModRM();
+        quint32 immediate = opcode == 0x81 ? fetch16() : fetch8();
+        if (opcode == 0x83) immediate = quint16(qint8(immediate));
+        const quint32 result = alu(modrm.reg, word ? getRM16(modrm) : getRM8(modrm), immediate, word);
+        if (modrm.reg != 7) {
+            if (word) setRM16(modrm, quint16(result));
+            else setRM8(modrm, quint8(result));
+        }
+        break;
+    }
+    case 0x84: {
+        const ModRM modrm = decodeModRM();
+        alu(4, getRM8(modrm), getReg8(modrm.reg), false);
+        break;
+    }
+    case 0x85: {
+        const ModRM modrm = decodeModRM();
+        alu(4, getRM16(modrm), r[modrm.reg], true);
+        break;
+    }
+    case 0x86: {
+        const ModRM modrm = decodeModRM();
+        const quint8 value = getRM8(modrm);
+        setRM8(modrm, getReg8(modrm.reg));
+        setReg8(modrm.reg, value);
+        break;
+    }
+    case 0x87: {
+        const ModRM modrm = decodeModRM();
+        const quint16 value = getRM16(modrm);
+        setRM16(modrm, r[modrm.reg]);
+        r[modrm.reg] = value;
+        break;
+    }
+    case 0x88: {
+        const ModRM modrm = decodeModRM();
+        setRM8(modrm, getReg8(modrm.reg));
+        break;
+    }
+    case 0x89: {
+        const ModRM modrm = decodeModRM();
+        setRM16(modrm, r[modrm.reg]);
+        break;
+    }
+    case 0x8A: {
+        const ModRM modrm = decodeModRM();
+        setReg8(modrm.reg, getRM8(modrm));
+        break;
+    }
+    case 0x8B: {
+        const ModRM modrm = decodeModRM();
+        r[modrm.reg] = getRM16(modrm);
+        break;
+    }
+    case 0x8C: {
+        const ModRM modrm = decodeModRM();
+        setRM16(modrm, s[modrm.reg & 3]);
+        break;
+    }
+    case 0x8D: {
+        const ModRM modrm = decodeModRM();
+        r[modrm.reg] = modrm.offset;
+        break;
+    }
+    case 0x8E: {
+        const ModRM modrm = decodeModRM();
+        s[modrm.reg & 3] = getRM16(modrm);
+        break;
+    }
+    case 0x8F: {
+        const ModRM modrm = decodeModRM();
+        setRM16(modrm, pop());
+        break;
+    }
+    case 0x90: case 0x91: case 0x92: case 0x93: case 0x94: case 0x95: case 0x96: case 0x97: {
+        const quint16 value = r[opcode & 7];
+        r[opcode & 7] = r[AX];
+        r[AX] = value;
+        break;
+    }
+    case 0x98:
+        r[AX] = quint16(qint16(qint8(getReg8(0))));
+        break;
+    case 0x99:
+        r[DX] = (r[AX] & 0x8000) ? 0xFFFF : 0;
+        break;
+    case 0x9A: {
+        const quint16 offset = fetch16();
+        const quint16 segment = fetch16();
+        push(s[CS]);
+        push(cpu.ip);
+        s[CS] = segment;
+        cpu.ip = offset;
+        break;
+    }
+    case 0x9B:
+        break;
+    case 0x9C:
+        push(cpu.flags);
+        break;
+    case 0x9D:
+        cpu.flags = normalizedFlags(pop());
+        break;
+    case 0x9E:
+        cpu.flags = normalizedFlags((cpu.flags & 0xFF00) | getReg8(4));
+        break;
+    case 0x9F:
+        setReg8(4, quint8(cpu.flags));
+        break;
+    case 0xA0:
+        setReg8(0, read8(dataSegment(), fetch16()));
+        break;
+    case 0xA1:
+        r[AX] = read16(dataSegment(), fetch16());
+        break;
+    case 0xA2:
+        write8(dataSegment(), fetch16(), getReg8(0));
+        break;
+    case 0xA3:
+        write16(dataSegment(), fetch16(), r[AX]);
+        break;
+    case 0xA4: case 0xA5: case 0xA6: case 0xA7: case 0xAA: case 0xAB: case 0xAC: case 0xAD: case 0xAE: case 0xAF:
+        stringOperation(opcode, repeat);
+        break;
+    case 0xA8:
+        alu(4, getReg8(0), fetch8(), false);
+        break;
+    case 0xA9:
+        alu(4, r[AX], fetch16(), true);
+        break;
+    case 0xB0: case 0xB1: case 0xB2: case 0xB3: case 0xB4: case 0xB5: case 0xB6: case 0xB7:
+        setReg8(opcode & 7, fetch8());
+        break;
+    case 0xB8: case 0xB9: case 0xBA: case 0xBB: case 0xBC: case 0xBD: case 0xBE: case 0xBF:
+        r[opcode & 7] = fetch16();
+        break;
+    case 0xC2: {
+        const quint16 release = fetch16();
+        cpu.ip = pop();
+        r[SP] += release;
+        returned = true;
+        break;
+    }
+    case 0xC3:
+        cpu.ip = pop();
+        returned = true;
+        break;
+    case 0xC4: case 0xC5: {
+        const ModRM modrm = decodeModRM();
+        r[modrm.reg] = read16(modrm.segment, modrm.offset);
+        s[opcode == 0xC4 ? ES : DS] = read16(modrm.segment, quint16(modrm.offset + 2));
+        break;
+    }
+    case 0xC6: {
+        const ModRM modrm = decodeModRM();
+        setRM8(modrm, fetch8());
+        break;
+    }
+    case 0xC7: {
+        const ModRM modrm = decodeModRM();
+        setRM16(modrm, fetch16());
+        break;
+    }
+    case 0xCA: {
+        const quint16 release = fetch16();
+        cpu.ip = pop();
+        s[CS] = pop();
+        r[SP] += release;
+        returned = true;
+        break;
+    }
+    case 0xCB:
+        cpu.ip = pop();
+        s[CS] = pop();
+        returned = true;
+        break;
+    case 0xCC:
+        return Breakpoint;
+    case 0xCD:
+        return interrupt(fetch8());
+    case 0xCE:
+        if (flag(OF)) return interrupt(4);
+        break;
+    case 0xCF:
+        cpu.ip = pop();
+        s[CS] = pop();
+        cpu.flags = normalizedFlags(pop());
+        returned = true;
+        break;
+    case 0xD0: case 0xD1: case 0xD2: case 0xD3: {
+        const bool word = opcode & 1;
+        const ModRM modrm = decodeModRM();
+        const int count = (opcode & 2) ? getReg8(1) : 1;
+        const quint32 result = shift(modrm.reg, word ? getRM16(modrm) : getRM8(modrm), count, word);
+        if (word) setRM16(modrm, quint16(result));
+        else setRM8(modrm, quint8(result));
+        break;
+    }
+    case 0xD4: {
+        const quint8 base = fetch8();
+        if (base == 0) {
+            cpu.ip = start;
+            return DivideError;
+        }
+        const quint8 al = getReg8(0);
+        setReg8(4, al / base);
+        setReg8(0, al % base);
+        setResultFlags(getReg8(0), false);
+        break;
+    }
+    case 0xD5: {
+        const quint8 base = fetch8();
+        r[AX] = quint8(getReg8(0) + getReg8(4) * base);
+        setResultFlags(r[AX], false);
+        break;
+    }
+    case 0xD6:
+        setReg8(0, flag(CF) ? 0xFF : 0x00);
+        break;
+    case 0xD7:
+        setReg8(0, read8(dataSegment(), quint16(r[BX] + getReg8(0))));
+        break;
+    case 0xD8: case 0xD9: case 0xDA: case 0xDB: case 0xDC: case 0xDD: case 0xDE: case 0xDF:
+        // Coprocessor escapes: decode the operand and carry on, there is no 8087.
+        decodeModRM();
+        break;
+    case 0xE0: case 0xE1: case 0xE2: {
+        const qint8 displacement = qint8(fetch8());
+        --r[CX];
+        bool taken = r[CX] != 0;
+        if (opcode == 0xE0) taken = taken && !flag(ZF);
+        else if (opcode == 0xE1) taken = taken && flag(ZF);
+        if (taken) cpu.ip += quint16(displacement);
+        break;
+    }
+    case 0xE3: {
+        const qint8 displacement = qint8(fetch8());
+        if (r[CX] == 0) cpu.ip += quint16(displacement);
+        break;
+    }
+    case 0xE4:
+        fetch8();
+        setReg8(0, 0xFF);
+        break;
+    case 0xE5:
+        fetch8();
+        r[AX] = 0xFFFF;
+        break;
+    case 0xE6: case 0xE7:
+        fetch8();
+        break;
+    case 0xE8: {
+        const quint16 displacement = fetch16();
+        push(cpu.ip);
+        cpu.ip += displacement;
+        break;
+    }
+    case 0xE9: {
+        const quint16 displacement = fetch16();
+        cpu.ip += displacement;
+        break;
+    }
+    case 0xEA: {
+        const quint16 offset = fetch16();
+        s[CS] = fetch16();
+        cpu.ip = offset;
+        break;
+    }
+    case 0xEB: {
+        const qint8 displacement = qint8(fetch8());
+        cpu.ip += quint16(displacement);
+        break;
+    }
+    case 0xEC:
+        setReg8(0, 0xFF);
+        break;
+    case 0xED:
+        r[AX] = 0xFFFF;
+        break;
+    case 0xEE: case 0xEF:
+        break;
+    case 0xF4:
+        return Halted;
+    case 0xF5:
+        cpu.flags ^= CF;
+        break;
+    case 0xF6: case 0xF7:
+        if (!group3(decodeModRM(), opcode & 1)) {
+            cpu.ip = start;
+            return DivideError;
+        }
+        break;
+    case 0xF8: case 0xF9:
+        setFlag(CF, opcode & 1);
+        break;
+    case 0xFA: case 0xFB:
+        setFlag(IF, opcode & 1);
+        break;
+    case 0xFC: case 0xFD:
+        setFlag(DF, opcode & 1);
+        break;
+    case 0xFE: {
+        const ModRM modrm = decodeModRM();
+        if (modrm.reg < 2) setRM8(modrm, quint8(incDec(getRM8(modrm), modrm.reg == 1, false)));
+        break;
+    }
+    case 0xFF: {
+        const ModRM modrm = decodeModRM();
+        switch (modrm.reg) {
+        case 0:
+        case 1:
+            setRM16(modrm, quint16(incDec(getRM16(modrm), modrm.reg == 1, true)));
+            break;
+        case 2: {
+            const quint16 target = getRM16(modrm);
+            push(cpu.ip);
+            cpu.ip = target;
+            break;
+        }
+        case 3: {
+            const quint16 offset = read16(modrm.segment, modrm.offset);
+            const quint16 segment = read16(modrm.segment, quint16(modrm.offset + 2));
+            push(s[CS]);
+            push(cpu.ip);
+            s[CS] = segment;
+            cpu.ip = offset;
+            break;
+        }
+        case 4:
+            cpu.ip = getRM16(modrm);
+            break;
+        case 5: {
+            const quint16 offset = read16(modrm.segment, modrm.offset);
+            s[CS] = read16(modrm.segment, quint16(modrm.offset + 2));
+            cpu.ip = offset;
+            break;
+        }
+        default:
+            push(getRM16(modrm));
+            break;
+        }
+        break;
+    }
+    default:
+        if (opcode >= 0x70 && opcode <= 0x7F) {
+            const qint8 displacement = qint8(fetch8());
+            if (condition(opcode & 0x0F)) cpu.ip += quint16(displacement);
+        }
+        break;
+    }
+    return Stepped;
+}
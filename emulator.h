@@ -0,0 +1,169 @@
+#ifndef EMULATOR_H
+#define EMULATOR_H
+
+#include <QByteArray>
+#include <QString>
+#include <QHash>
+#include <QVector>
+#include <vector>
+#include "conditionexpression.h"
+
+struct CpuState {
+    quint16 registers[8] = {};
+    quint16 segments[4] = {};
+    quint16 ip = 0;
+    quint16 flags = 0;
+    bool operator==(const CpuState& other) const;
+    bool operator!=(const CpuState& other) const { return !(*this == other); }
+};
+
+// An 8086 interpreter with just enough DOS behind INT 20h/21h to run the programs written in the editor.
+class Emulator {
+public:
+    enum Register { AX, CX, DX, BX, SP, BP, SI, DI };
+    enum Segment { ES, CS, SS, DS };
+    enum Flag {
+        CF = 0x001,
+        PF = 0x004,
+        AF = 0x010,
+        ZF = 0x040,
+        SF = 0x080,
+        TF = 0x100,
+        IF = 0x200,
+        DF = 0x400,
+        OF = 0x800
+    };
+    enum StopReason { Stepped, Breakpoint, Watchpoint, Halted, Exited, DivideError, StepLimit };
+
+    struct MemoryRange {
+        quint32 address = 0;
+        int size = 1;
+    };
+
+    // A copy of memory; pages written after it was taken have a newer epoch than the snapshot.
+    struct Snapshot {
+        std::vector<quint8> memory;
+        quint32 epoch = 0;
+        bool isValid() const { return !memory.empty(); }
+    };
+
+    static constexpr int MEMORY_SIZE = 0x100000;
+    static constexpr quint16 PROGRAM_SEGMENT = 0x1000;
+    static constexpr int WATCH_PAGE_SHIFT = 8;
+    static constexpr int DIRTY_PAGE_SHIFT = 12;
+    static constexpr int DIRTY_PAGE_COUNT = MEMORY_SIZE >> DIRTY_PAGE_SHIFT;
+    // lastWriter() of bytes changed by fillMemory() and moveMemory() rather than by an instruction.
+    static constexpr quint32 COMMAND_WRITER = MEMORY_SIZE;
+
+    Emulator();
+    void load(const QByteArray& image, quint16 entry);
+    StopReason step();
+    // Stops before an instruction at a breakpoint, so callers leave a breakpoint with step() first.
+    StopReason run(quint64 maxSteps);
+    // Offsets in the program segment; an invalid condition makes the breakpoint unconditional.
+    void setBreakpoints(const QHash<int, ConditionExpression>& breakpoints);
+    bool atBreakpoint() const;
+    void setWatchpoints(const QVector<MemoryRange>& ranges);
+    quint32 watchedWrite() const { return watchAddress; }
+    // Every write is stamped with the current generation, so a viewer can tell what the last command changed.
+    void beginGeneration() { ++generation; }
+    bool writtenLastGeneration(quint32 address) const { return writeStamps[address & (MEMORY_SIZE - 1)] == generation; }
+    Snapshot snapshot();
+    bool pageWrittenSince(int page, const Snapshot& snapshot) const { return pageEpochs[page] > snapshot.epoch; }
+    // Linear address of the instruction that last wrote a byte.
+    quint32 lastWriter(quint32 address) const { return lastWriters[address & (MEMORY_SIZE - 1)]; }
+    const quint8* memoryData() const { return memory.data(); }
+
+    const CpuState& state() const { return cpu; }
+    bool isFinished() const { return finished; }
+    int exitCode() const { return exitStatus; }
+    bool lastWasReturn() const { return returned; }
+    quint64 instructionCount() const { return executed; }
+    // Estimated 8086 clocks from the opcode table, without effective address or repeat costs.
+    quint64 clockCount() const { return clocks; }
+    QString takeOutput();
+    quint8 readByte(quint32 address) const { return memory[address & (MEMORY_SIZE - 1)]; }
+    QByteArray readMemory(quint32 address, int size) const;
+    // Debugger writes; the range must not run past the end of memory.
+    void fillMemory(quint32 address, int size, const QByteArray& pattern);
+    void moveMemory(quint32 target, quint32 source, int size);
+private:
+    enum BreakpointKind : quint8 { NoBreakpoint, Unconditional, Conditional };
+
+    std::vector<quint8> memory;
+    std::vector<quint32> writeStamps;
+    quint32 generation;
+    std::vector<quint32> lastWriters;
+    std::vector<quint32> pageEpochs;
+    quint32 epoch;
+    quint32 instructionStart;
+    std::vector<quint8> breakpointMap;
+    QHash<int, ConditionExpression> conditions;
+    bool hasBreakpoints;
+    // Pages holding a watched byte; writes elsewhere, or with nothing watched, never leave the fast path.
+    std::vector<quint8> watchedPages;
+    QVector<MemoryRange> watchRanges;
+    bool watching;
+    bool watchTriggered;
+    quint32 watchAddress;
+    CpuState cpu;
+    int segmentOverride;
+    bool finished;
+    bool returned;
+    int exitStatus;
+    quint64 executed;
+    quint64 clocks;
+    QString output;
+
+    struct ModRM {
+        int mod = 0;
+        int reg = 0;
+        int rm = 0;
+        quint16 segment = 0;
+        quint16 offset = 0;
+    };
+
+    quint32 linear(quint16 segment, quint16 offset) const { return ((quint32(segment) << 4) + offset) & (MEMORY_SIZE - 1); }
+    quint8 read8(quint16 segment, quint16 offset) const { return memory[linear(segment, offset)]; }
+    quint16 read16(quint16 segment, quint16 offset) const;
+    void write8(quint16 segment, quint16 offset, quint8 value) {
+        const quint32 address = linear(segment, offset);
+        memory[address] = value;
+        writeStamps[address] = generation;
+        lastWriters[address] = instructionStart;
+        pageEpochs[address >> DIRTY_PAGE_SHIFT] = epoch;
+        if (Q_UNLIKELY(watching) && watchedPages[address >> WATCH_PAGE_SHIFT]) noteWrite(address);
+    }
+    void noteWrite(quint32 address);
+    void markCommandWrite(quint32 address, int size);
+    void write16(quint16 segment, quint16 offset, quint16 value);
+    quint8 fetch8();
+    quint16 fetch16();
+    void push(quint16 value);
+    quint16 pop();
+    quint16 dataSegment() const;
+
+    ModRM decodeModRM();
+    quint8 getRM8(const ModRM& modrm) const;
+    quint16 getRM16(const ModRM& modrm) const;
+    void setRM8(const ModRM& modrm, quint8 value);
+    void setRM16(const ModRM& modrm, quint16 value);
+    quint8 getReg8(int reg) const;
+    void setReg8(int reg, quint8 value);
+
+    void setFlag(int flag, bool value);
+    bool flag(int flag) const { return cpu.flags & flag; }
+    void setResultFlags(quint32 result, bool word);
+    quint32 alu(int operation, quint32 a, quint32 b, bool word);
+    quint32 incDec(quint32 value, bool decrement, bool word);
+    quint32 shift(int operation, quint32 value, int count, bool word);
+    bool group3(const ModRM& modrm, bool word);
+    bool condition(int code) const;
+    void stringOperation(quint8 opcode, int repeat);
+    StopReason interrupt(quint8 number);
+    StopReason dosService();
+    void exitProgram(int code);
+    StopReason execute();
+};
+
+#endif // EMULATOR_H
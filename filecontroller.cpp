@@ -16,14 +16,7 @@ FileController::~FileController() {
 }
 
 QString FileController::openFile(const QString& path) {
-    if (path.endsWith(".txt")) {
-        QFile file(path);
-        if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-            QTextStream in(&file);
-            QString content = in.readAll();
-            file.close();
-            return content;
-        }
+    if (path.endsWith(".txt") || path.endsWith(".asm")) {
         return processor->readTxtFile(path);
     } else if (path.endsWith(".COM") || path.endsWith(".com")) {
         return processor->readComFile(path);
@@ -31,20 +24,31 @@ QString FileController::openFile(const QString& path) {
     return QString();
 }
 
+FileLoader* FileController::openFileAsync(const QString& path, QObject* owner) {
+    if (!path.endsWith(".txt") && !path.endsWith(".asm")) {
+        return nullptr;
+    }
+    return new FileLoader(path, owner);
+}
+
 bool FileController::saveFile(const QString& path, const QString& content) {
-    if (path.endsWith(".txt")) {
+    if (path.endsWith(".txt") || path.endsWith(".asm")) {
         return processor->saveTxtFile(path, content);
     }
     return false;
 }
 
 bool FileController::saveAsFile(const QString& path, const QString& content) {
-    if (path.endsWith(".txt")) {
+    if (path.endsWith(".txt") || path.endsWith(".asm")) {
         return processor->saveTxtFile(path, content);
     }
     return false;
 }
 
+bool FileController::saveComImage(const QString& path, const QByteArray& image) {
+    return processor->saveComFile(path, image);
+}
+
 QString FileController::pasteCodeToDebug(const QString& filePath) {
     return runner->pasteCodeToDebug(filePath);
 }
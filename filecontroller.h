@@ -4,6 +4,7 @@
 #include <QString>
 #include "fileprocessor.h"
 #include "scriptrunner.h"
+#include "fileloader.h"
 
 class FileController : public QObject {
     Q_OBJECT
@@ -11,8 +12,10 @@ public:
     FileController(QObject* parent = nullptr);
     ~FileController();
     QString openFile(const QString& path);
+    FileLoader* openFileAsync(const QString& path, QObject* owner);
     bool saveFile(const QString& path, const QString& content);
     bool saveAsFile(const QString& path, const QString& content);
+    bool saveComImage(const QString& path, const QByteArray& image);
     QString pasteCodeToDebug(const QString& filePath);
     void compileAndRunCom(const QString& filePath);
 signals:
@@ -0,0 +1,83 @@
+#include "fileloader.h"
+#include <QFile>
+#include <QStringDecoder>
+#include <QDebug>
+
+FileLoader::FileLoader(const QString& path, QObject* parent) : QObject(parent), path(path), thread(nullptr), cancelled(false) {}
+
+FileLoader::~FileLoader() {
+    cancel();
+    if (thread) {
+        thread->wait();
+        delete thread;
+    }
+}
+
+void FileLoader::start() {
+    if (thread) return;
+    thread = QThread::create([this]() { run(); });
+    thread->start();
+}
+
+void FileLoader::cancel() {
+    cancelled = true;
+}
+
+bool FileLoader::isRunning() const {
+    return thread && thread->isRunning();
+}
+
+QString FileLoader::filePath() const {
+    return path;
+}
+
+void FileLoader::run() {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qDebug() << "Failed to open text file for reading:" << path << "-" << file.errorString();
+        emit finished(false);
+        return;
+    }
+
+    const qint64 totalBytes = file.size();
+    const uchar* mapped = totalBytes > 0 ? file.map(0, totalBytes) : nullptr;
+    QByteArray buffer;
+    QStringDecoder decoder(QStringDecoder::Utf8);
+    bool pendingCarriageReturn = false;
+    qint64 bytesRead = 0;
+
+    while (bytesRead < totalBytes && !cancelled) {
+        const qint64 chunkSize = qMin(bytesRead == 0 ? FIRST_CHUNK_SIZE : CHUNK_SIZE, totalBytes - bytesRead);
+        QByteArrayView bytes;
+        if (mapped) {
+            bytes = QByteArrayView(mapped + bytesRead, chunkSize);
+        } else {
+            buffer = file.read(chunkSize);
+            if (buffer.isEmpty()) break;
+            bytes = QByteArrayView(buffer);
+        }
+        bytesRead += bytes.size();
+
+        QString text = decoder.decode(bytes);
+        if (pendingCarriageReturn) {
+            text.prepend(QChar('\r'));
+            pendingCarriageReturn = false;
+        }
+        if (bytesRead < totalBytes && text.endsWith(QChar('\r'))) {
+            text.chop(1);
+            pendingCarriageReturn = true;
+        }
+        text.replace(QLatin1String("\r\n"), QLatin1String("\n"));
+
+        if (!text.isEmpty()) {
+            emit chunkLoaded(text);
+        }
+        emit progress(bytesRead, totalBytes);
+    }
+
+    if (mapped) {
+        file.unmap(const_cast<uchar*>(mapped));
+    }
+    file.close();
+    emit finished(!cancelled && bytesRead == totalBytes);
+}
@@ -0,0 +1,32 @@
+#ifndef FILELOADER_H
+#define FILELOADER_H
+
+#include <QObject>
+#include <QString>
+#include <QThread>
+#include <atomic>
+
+class FileLoader : public QObject {
+    Q_OBJECT
+public:
+    explicit FileLoader(const QString& path, QObject* parent = nullptr);
+    ~FileLoader();
+    void start();
+    void cancel();
+    bool isRunning() const;
+    QString filePath() const;
+signals:
+    void chunkLoaded(const QString& text);
+    void progress(qint64 bytesRead, qint64 totalBytes);
+    void finished(bool completed);
+private:
+    static constexpr qint64 FIRST_CHUNK_SIZE = 16 * 1024;
+    static constexpr qint64 CHUNK_SIZE = 256 * 1024;
+
+    QString path;
+    QThread* thread;
+    std::atomic<bool> cancelled;
+    void run();
+};
+
+#endif // FILELOADER_H
@@ -8,7 +8,7 @@
 #include <QStringDecoder>
 #include <QFileInfo>
 #include <QRegularExpression>
-#include "scriptrunner.h"
+#include "disassembler.h"
 
 FileProcessor::FileProcessor(QObject* parent) : QObject(parent) {}
 
@@ -40,7 +40,24 @@ bool FileProcessor::saveTxtFile(const QString& path, const QString& content) {
     return true;
 }
 
+bool FileProcessor::saveComFile(const QString& path, const QByteArray& image) {
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "Failed to open COM file for writing:" << path << "-" << file.errorString();
+        return false;
+    }
+    bool written = file.write(image) == image.size();
+    file.close();
+    return written;
+}
+
 QString FileProcessor::readComFile(const QString& path) {
-    ScriptRunner runner;
-    return runner.convertComToTxt(path);
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qDebug() << "Failed to open COM file for reading:" << path << "-" << file.errorString();
+        return QString();
+    }
+    QByteArray image = file.read(MAX_COM_SIZE);
+    file.close();
+    return Disassembler::toScript(Disassembler::disassemble(image));
 }
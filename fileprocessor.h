@@ -12,6 +12,9 @@ public:
     QString readTxtFile(const QString& path);
     QString readComFile(const QString& path);
     bool saveTxtFile(const QString& path, const QString& content);
+    bool saveComFile(const QString& path, const QByteArray& image);
+private:
+    static constexpr int MAX_COM_SIZE = 0xFF00;
 };
 
 #endif // FILEPROCESSOR_H
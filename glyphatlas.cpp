@@ -0,0 +1,69 @@
+#include "glyphatlas.h"
+#include <QFontMetrics>
+#include <QtMath>
+#include <algorithm>
+#include <iterator>
+
+const QString GlyphAtlas::CHARACTERS = "0123456789ABCDEFabcdef:CS ";
+
+GlyphAtlas::GlyphAtlas() : devicePixelRatio(0), width(0), height(0) {
+    std::fill(std::begin(columns), std::end(columns), -1);
+}
+
+void GlyphAtlas::update(const QFont& font, const QColor& color, qreal devicePixelRatio) {
+    if (!atlas.isNull() && this->font == font && this->color == color && this->devicePixelRatio == devicePixelRatio) {
+        return;
+    }
+    this->font = font;
+    this->color = color;
+    this->devicePixelRatio = devicePixelRatio;
+
+    QFontMetrics metrics(font);
+    width = 0;
+    for (const QChar& c : CHARACTERS) {
+        width = qMax(width, metrics.horizontalAdvance(c));
+    }
+    height = metrics.height();
+
+    atlas = QPixmap(qCeil(width * CHARACTERS.size() * devicePixelRatio), qCeil(height * devicePixelRatio));
+    atlas.setDevicePixelRatio(devicePixelRatio);
+    atlas.fill(Qt::transparent);
+
+    QPainter painter(&atlas);
+    painter.setFont(font);
+    painter.setPen(color);
+    std::fill(std::begin(columns), std::end(columns), -1);
+    for (int i = 0; i < CHARACTERS.size(); ++i) {
+        painter.drawText(QRect(i * width, 0, width, height), Qt::AlignCenter, QString(CHARACTERS[i]));
+        columns[CHARACTERS[i].unicode()] = i;
+    }
+}
+
+int GlyphAtlas::glyphWidth() const {
+    return width;
+}
+
+int GlyphAtlas::glyphHeight() const {
+    return height;
+}
+
+int GlyphAtlas::textWidth(const QString& text) const {
+    return width * text.size();
+}
+
+void GlyphAtlas::drawText(QPainter& painter, int x, int y, const QString& text) const {
+    for (int i = 0; i < text.size(); ++i) {
+        ushort code = text[i].unicode();
+        QRect target(x + i * width, y, width, height);
+        if (code < 128 && columns[code] >= 0) {
+            painter.drawPixmap(target, atlas, QRectF(columns[code] * width * devicePixelRatio, 0,
+                                                     width * devicePixelRatio, height * devicePixelRatio));
+        } else {
+            painter.save();
+            painter.setFont(font);
+            painter.setPen(color);
+            painter.drawText(target, Qt::AlignCenter, QString(text[i]));
+            painter.restore();
+        }
+    }
+}
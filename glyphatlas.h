@@ -0,0 +1,30 @@
+#ifndef GLYPHATLAS_H
+#define GLYPHATLAS_H
+
+#include <QPixmap>
+#include <QFont>
+#include <QColor>
+#include <QString>
+#include <QPainter>
+
+class GlyphAtlas {
+public:
+    GlyphAtlas();
+    void update(const QFont& font, const QColor& color, qreal devicePixelRatio);
+    int glyphWidth() const;
+    int glyphHeight() const;
+    int textWidth(const QString& text) const;
+    void drawText(QPainter& painter, int x, int y, const QString& text) const;
+private:
+    static const QString CHARACTERS;
+
+    QPixmap atlas;
+    QFont font;
+    QColor color;
+    qreal devicePixelRatio;
+    int width;
+    int height;
+    int columns[128];
+};
+
+#endif // GLYPHATLAS_H
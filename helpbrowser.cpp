@@ -0,0 +1,218 @@
+#include "helpbrowser.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QSplitter>
+#include <QFile>
+#include <QRegularExpression>
+#include <QSet>
+#include <QEvent>
+#include <QDebug>
+#include <algorithm>
+#ifdef DEBUG3000_WEBENGINE_HELP
+#include <QWebEngineView>
+#include <QUrl>
+#endif
+
+HelpBrowser::HelpBrowser(QWidget* parent) : QWidget(parent, Qt::Window) {
+    setMinimumSize(800, 600);
+
+    searchEdit = new QLineEdit(this);
+    searchEdit->setClearButtonEnabled(true);
+    resultList = new QListWidget(this);
+    contentView = new QTextBrowser(this);
+    contentView->setOpenLinks(false);
+    contentView->document()->setDefaultStyleSheet(
+        "pre { background-color: #f8f8f8; }"
+        "table { border-collapse: collapse; }"
+        "th, td { border: 1px solid #dddddd; padding: 4px; }"
+        "th { background-color: #f2f2f2; }");
+
+    QWidget* sidebar = new QWidget(this);
+    QVBoxLayout* sidebarLayout = new QVBoxLayout(sidebar);
+    sidebarLayout->setContentsMargins(0, 0, 0, 0);
+    sidebarLayout->addWidget(searchEdit);
+    sidebarLayout->addWidget(resultList);
+#ifdef DEBUG3000_WEBENGINE_HELP
+    fullPageWindow = nullptr;
+    fullPageButton = new QPushButton(this);
+    sidebarLayout->addWidget(fullPageButton);
+    connect(fullPageButton, &QPushButton::clicked, this, &HelpBrowser::showFullPage);
+#endif
+
+    QSplitter* splitter = new QSplitter(Qt::Horizontal, this);
+    splitter->addWidget(sidebar);
+    splitter->addWidget(contentView);
+    splitter->setSizes({250, 550});
+
+    QVBoxLayout* layout = new QVBoxLayout(this);
+    layout->addWidget(splitter);
+
+    connect(searchEdit, &QLineEdit::textChanged, this, &HelpBrowser::search);
+    connect(resultList, &QListWidget::currentItemChanged, this, &HelpBrowser::onCurrentResultChanged);
+
+    loadContent();
+    loadIndex();
+    retranslateUi();
+    populateResults(topicOrder);
+}
+
+void HelpBrowser::changeEvent(QEvent* event) {
+    if (event->type() == QEvent::LanguageChange) {
+        retranslateUi();
+    }
+    QWidget::changeEvent(event);
+}
+
+void HelpBrowser::retranslateUi() {
+    setWindowTitle(tr("Debug3000 Help"));
+    searchEdit->setPlaceholderText(tr("Search help..."));
+#ifdef DEBUG3000_WEBENGINE_HELP
+    fullPageButton->setText(tr("Open Full Page"));
+#endif
+}
+
+void HelpBrowser::loadContent() {
+    QFile file(":/help/help.html");
+    if (!file.open(QIODevice::ReadOnly)) {
+        qDebug() << "Failed to open help file:" << file.errorString();
+        return;
+    }
+    const QString html = QString::fromUtf8(file.readAll());
+    file.close();
+
+    static const QRegularExpression sectionRe("<section id=\"([^\"]+)\"[^>]*>(.*?)</section>",
+                                              QRegularExpression::DotMatchesEverythingOption);
+    static const QRegularExpression titleRe("<h1>(.*?)</h1>", QRegularExpression::DotMatchesEverythingOption);
+    QRegularExpressionMatchIterator it = sectionRe.globalMatch(html);
+    while (it.hasNext()) {
+        QRegularExpressionMatch match = it.next();
+        Topic topic;
+        topic.html = match.captured(2);
+        QRegularExpressionMatch title = titleRe.match(topic.html);
+        topic.title = title.hasMatch() ? title.captured(1).trimmed() : match.captured(1);
+        topics.insert(match.captured(1), topic);
+        topicOrder.append(match.captured(1));
+    }
+}
+
+void HelpBrowser::loadIndex() {
+    QFile file(":/help/help_index.txt");
+    if (!file.open(QIODevice::ReadOnly)) {
+        qDebug() << "Failed to open help index:" << file.errorString();
+        return;
+    }
+    while (!file.atEnd()) {
+        const QString line = QString::fromUtf8(file.readLine()).trimmed();
+        int tab = line.indexOf('\t');
+        if (tab <= 0 || line.startsWith('@')) continue;
+        const QString term = line.left(tab).toLower();
+        const QStringList ids = line.mid(tab + 1).split(' ', Qt::SkipEmptyParts);
+        QStringList& postings = index[term];
+        for (const QString& id : ids) {
+            if (!postings.contains(id)) postings.append(id);
+        }
+    }
+    file.close();
+    terms = index.keys();
+    std::sort(terms.begin(), terms.end());
+}
+
+QStringList HelpBrowser::lookup(const QString& word) const {
+    QSet<QString> found;
+    auto it = std::lower_bound(terms.constBegin(), terms.constEnd(), word);
+    for (; it != terms.constEnd() && it->startsWith(word); ++it) {
+        for (const QString& id : index.value(*it)) {
+            found.insert(id);
+        }
+    }
+    QStringList result;
+    for (const QString& id : topicOrder) {
+        if (found.contains(id)) result.append(id);
+    }
+    return result;
+}
+
+void HelpBrowser::search(const QString& query) {
+    const QStringList words = query.toLower().split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
+    if (words.isEmpty()) {
+        highlightTerm.clear();
+        populateResults(topicOrder);
+        return;
+    }
+
+    QStringList ids = lookup(words.first());
+    for (int i = 1; i < words.size() && !ids.isEmpty(); ++i) {
+        const QStringList next = lookup(words[i]);
+        QStringList intersection;
+        for (const QString& id : ids) {
+            if (next.contains(id)) intersection.append(id);
+        }
+        ids = intersection;
+    }
+    highlightTerm = words.first();
+    populateResults(ids);
+}
+
+void HelpBrowser::populateResults(const QStringList& ids) {
+    resultList->clear();
+    for (const QString& id : ids) {
+        QListWidgetItem* item = new QListWidgetItem(topics.value(id).title, resultList);
+        item->setData(Qt::UserRole, id);
+    }
+    if (resultList->count() > 0) {
+        resultList->setCurrentRow(0);
+    }
+}
+
+void HelpBrowser::onCurrentResultChanged(QListWidgetItem* current) {
+    if (!current) return;
+    showTopic(current->data(Qt::UserRole).toString());
+}
+
+void HelpBrowser::showTopic(const QString& id) {
+    if (!topics.contains(id)) return;
+    contentView->setHtml(topics.value(id).html);
+    if (!highlightTerm.isEmpty()) {
+        contentView->find(highlightTerm);
+    }
+}
+
+bool HelpBrowser::showTopicForKeyword(const QString& keyword) {
+    const QString word = keyword.trimmed().toLower();
+    if (word.isEmpty()) return false;
+
+    QStringList ids;
+    if (topics.contains("cmd-" + word)) {
+        ids.append("cmd-" + word);
+    } else {
+        for (const QString& id : index.value(word)) {
+            if (id.startsWith("cmd-")) ids.append(id);
+        }
+    }
+    if (ids.isEmpty()) {
+        searchEdit->setText(word);
+        return false;
+    }
+
+    searchEdit->blockSignals(true);
+    searchEdit->setText(word);
+    searchEdit->blockSignals(false);
+    highlightTerm = word;
+    populateResults(ids);
+    return true;
+}
+
+#ifdef DEBUG3000_WEBENGINE_HELP
+void HelpBrowser::showFullPage() {
+    if (!fullPageWindow) {
+        QWebEngineView* view = new QWebEngineView(this);
+        view->setWindowFlag(Qt::Window);
+        view->setMinimumSize(800, 600);
+        view->load(QUrl("qrc:/help/help.html"));
+        fullPageWindow = view;
+    }
+    fullPageWindow->setWindowTitle(windowTitle());
+    fullPageWindow->show();
+    fullPageWindow->raise();
+}
+#endif
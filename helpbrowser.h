@@ -0,0 +1,52 @@
+#ifndef HELPBROWSER_H
+#define HELPBROWSER_H
+
+#include <QWidget>
+#include <QLineEdit>
+#include <QListWidget>
+#include <QTextBrowser>
+#include <QPushButton>
+#include <QHash>
+#include <QStringList>
+
+class HelpBrowser : public QWidget {
+    Q_OBJECT
+public:
+    explicit HelpBrowser(QWidget* parent = nullptr);
+    void showTopic(const QString& id);
+    bool showTopicForKeyword(const QString& keyword);
+protected:
+    void changeEvent(QEvent* event) override;
+private slots:
+    void search(const QString& query);
+    void onCurrentResultChanged(QListWidgetItem* current);
+#ifdef DEBUG3000_WEBENGINE_HELP
+    void showFullPage();
+#endif
+private:
+    struct Topic {
+        QString title;
+        QString html;
+    };
+
+    QLineEdit* searchEdit;
+    QListWidget* resultList;
+    QTextBrowser* contentView;
+#ifdef DEBUG3000_WEBENGINE_HELP
+    QPushButton* fullPageButton;
+    QWidget* fullPageWindow;
+#endif
+    QHash<QString, Topic> topics;
+    QStringList topicOrder;
+    QHash<QString, QStringList> index;
+    QStringList terms;
+    QString highlightTerm;
+
+    void loadContent();
+    void loadIndex();
+    QStringList lookup(const QString& word) const;
+    void populateResults(const QStringList& ids);
+    void retranslateUi();
+};
+
+#endif // HELPBROWSER_H
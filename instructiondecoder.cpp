@@ -0,0 +1,289 @@
+#include "instructiondecoder.h"
+#include "opcodetable.h"
+
+namespace {
+
+const char* const REGISTERS_8[] = {"AL", "CL", "DL", "BL", "AH", "CH", "DH", "BH"};
+const char* const REGISTERS_16[] = {"AX", "CX", "DX", "BX", "SP", "BP", "SI", "DI"};
+const char* const SEGMENT_REGISTERS[] = {"ES", "CS", "SS", "DS"};
+const char* const BASES[] = {"BX+SI", "BX+DI", "BP+SI", "BP+DI", "SI", "DI", "BP", "BX"};
+
+class Decoder {
+public:
+    Decoder(const QByteArray& image, int offset, int address) : image(image), start(offset), position(offset), address(address) {}
+    DecodedInstruction run();
+private:
+    const QByteArray& image;
+    int start;
+    int position;
+    int address;
+    int segmentOverride = -1;
+    bool overrideUsed = false;
+    bool truncated = false;
+    DecodedInstruction result;
+
+    int byte() {
+        if (position >= image.size()) {
+            truncated = true;
+            return 0;
+        }
+        return quint8(image[position++]);
+    }
+    int word() {
+        int low = byte();
+        return low | (byte() << 8);
+    }
+    int nextAddress() const { return (address + position - start) & 0xFFFF; }
+
+    void set(const char* mnemonic, const QStringList& operands = QStringList()) {
+        result.mnemonic = mnemonic;
+        result.operands = operands;
+    }
+    QString rm(int modrm, int size, bool qualified);
+    QString reg(int index, int size) const { return size == 1 ? REGISTERS_8[index] : REGISTERS_16[index]; }
+    QString immediate(int size) { return size == 1 ? InstructionDecoder::hexByte(byte()) : InstructionDecoder::hexWord(word()); }
+    void branch(DecodedInstruction::Flow flow, int displacement) {
+        result.flow = flow;
+        result.target = (nextAddress() + displacement) & 0xFFFF;
+    }
+    bool decodeOpcode(int opcode);
+    bool decodeGroup(int opcode, const OpcodeInfo& info);
+};
+
+QString Decoder::rm(int modrm, int size, bool qualified) {
+    const int mod = modrm >> 6;
+    const int index = modrm & 7;
+    if (mod == 3) return reg(index, size);
+
+    QString inner;
+    if (mod == 0 && index == 6) {
+        inner = InstructionDecoder::hexWord(word());
+    } else {
+        inner = BASES[index];
+        if (mod == 1) {
+            int displacement = qint8(byte());
+            inner += (displacement < 0 ? "-" : "+") + InstructionDecoder::hexByte(qAbs(displacement));
+        } else if (mod == 2) {
+            inner += "+" + InstructionDecoder::hexWord(word());
+        }
+    }
+
+    QString text = "[" + inner + "]";
+    if (segmentOverride >= 0) {
+        text = QString(SEGMENT_REGISTERS[segmentOverride]) + ":" + text;
+        overrideUsed = true;
+    }
+    if (qualified) {
+        text = (size == 1 ? "BYTE PTR " : "WORD PTR ") + text;
+    }
+    return text;
+}
+
+bool Decoder::decodeOpcode(int opcode) {
+    const OpcodeInfo& info = OpcodeTable::info(opcode);
+    const int size = info.size;
+    // Bit 1 of the opcode is the direction bit wherever two operands can swap places.
+    const bool reversed = opcode & 2;
+    const QString accumulator = size == 1 ? "AL" : "AX";
+
+    switch (info.form) {
+    case OpcodeInfo::Implied:
+        set(info.mnemonic);
+        if (opcode == 0xC3 || opcode == 0xCB || opcode == 0xCF) result.flow = DecodedInstruction::Return;
+        return true;
+    case OpcodeInfo::AsciiAdjust:
+        if (byte() != 0x0A) return false;
+        set(info.mnemonic);
+        return true;
+    case OpcodeInfo::RegisterMemory:
+    case OpcodeInfo::MemoryRegister: {
+        int modrm = byte();
+        QString registerText = reg((modrm >> 3) & 7, size);
+        QString rmText = rm(modrm, size, false);
+        const bool registerFirst = info.form == OpcodeInfo::RegisterMemory && reversed;
+        set(info.mnemonic, registerFirst ? QStringList{registerText, rmText} : QStringList{rmText, registerText});
+        return true;
+    }
+    case OpcodeInfo::SegmentMemory: {
+        int modrm = byte();
+        if (((modrm >> 3) & 7) > 3) return false;
+        QString segment = SEGMENT_REGISTERS[(modrm >> 3) & 3];
+        QString rmText = rm(modrm, 2, false);
+        set(info.mnemonic, reversed ? QStringList{segment, rmText} : QStringList{rmText, segment});
+        return true;
+    }
+    case OpcodeInfo::LoadAddress: {
+        int modrm = byte();
+        if ((modrm >> 6) == 3) return false;
+        set(info.mnemonic, {REGISTERS_16[(modrm >> 3) & 7], rm(modrm, 2, false)});
+        return true;
+    }
+    case OpcodeInfo::Group:
+        return decodeGroup(opcode, info);
+    case OpcodeInfo::AccumulatorImmediate:
+        set(info.mnemonic, {accumulator, immediate(size)});
+        return true;
+    case OpcodeInfo::AccumulatorRegister:
+        set(info.mnemonic, {"AX", REGISTERS_16[opcode & 7]});
+        return true;
+    case OpcodeInfo::SegmentRegister:
+        set(info.mnemonic, {SEGMENT_REGISTERS[opcode >> 3]});
+        return true;
+    case OpcodeInfo::Register:
+        set(info.mnemonic, {REGISTERS_16[opcode & 7]});
+        return true;
+    case OpcodeInfo::RegisterImmediate:
+        set(info.mnemonic, {reg(opcode & 7, size), immediate(size)});
+        return true;
+    case OpcodeInfo::MemoryOffset: {
+        QString memory = rm(0x06, 2, false);
+        set(info.mnemonic, reversed ? QStringList{memory, accumulator} : QStringList{accumulator, memory});
+        return true;
+    }
+    case OpcodeInfo::Relative8:
+        set(info.mnemonic);
+        branch(opcode == 0xEB ? DecodedInstruction::Jump : DecodedInstruction::Branch, qint8(byte()));
+        result.operands = QStringList{InstructionDecoder::hexWord(result.target)};
+        return true;
+    case OpcodeInfo::Relative16:
+        set(info.mnemonic);
+        if (opcode == 0xE8) {
+            branch(DecodedInstruction::Call, qint16(word()));
+            result.operands = QStringList{InstructionDecoder::hexWord(result.target)};
+        } else {
+            branch(DecodedInstruction::Jump, qint16(word()));
+            int shortOffset = result.target - ((address + 2) & 0xFFFF);
+            bool fitsShort = shortOffset >= -128 && shortOffset <= 127;
+            result.operands = QStringList{(fitsShort ? "NEAR " : "") + InstructionDecoder::hexWord(result.target)};
+        }
+        return true;
+    case OpcodeInfo::FarPointer: {
+        int offset = word();
+        int segment = word();
+        set(info.mnemonic, {InstructionDecoder::hexWord(segment) + ":" + InstructionDecoder::hexWord(offset)});
+        if (opcode == 0xEA) result.flow = DecodedInstruction::Indirect;
+        return true;
+    }
+    case OpcodeInfo::Interrupt:
+        set(info.mnemonic, {immediate(1)});
+        return true;
+    case OpcodeInfo::Breakpoint:
+        set(info.mnemonic, {"3"});
+        return true;
+    case OpcodeInfo::ReturnImmediate:
+        set(info.mnemonic, {immediate(2)});
+        result.flow = DecodedInstruction::Return;
+        return true;
+    case OpcodeInfo::PortImmediate: {
+        QString port = immediate(1);
+        set(info.mnemonic, reversed ? QStringList{port, accumulator} : QStringList{accumulator, port});
+        return true;
+    }
+    case OpcodeInfo::PortDX:
+        set(info.mnemonic, reversed ? QStringList{"DX", accumulator} : QStringList{accumulator, "DX"});
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool Decoder::decodeGroup(int opcode, const OpcodeInfo& info) {
+    int modrm = byte();
+    const int operation = (modrm >> 3) & 7;
+    const bool memory = (modrm >> 6) != 3;
+    const char* mnemonic = OpcodeTable::groupMnemonic(info.group, operation);
+    if (!mnemonic) return false;
+    const int size = info.size;
+
+    switch (info.group) {
+    case OpcodeInfo::Arithmetic: {
+        QString target = rm(modrm, size, memory);
+        QString value;
+        if (opcode == 0x83) {
+            int signedValue = qint8(byte());
+            value = (signedValue < 0 ? "-" : "+") + InstructionDecoder::hexByte(qAbs(signedValue));
+        } else {
+            value = immediate(size);
+        }
+        set(mnemonic, {target, value});
+        return true;
+    }
+    case OpcodeInfo::Shift:
+        set(mnemonic, {rm(modrm, size, memory), opcode < 0xD2 ? "1" : "CL"});
+        return true;
+    case OpcodeInfo::Unary: {
+        QString target = rm(modrm, size, memory);
+        if (operation == 0) set(mnemonic, {target, immediate(size)});
+        else set(mnemonic, {target});
+        return true;
+    }
+    case OpcodeInfo::IncrementWord:
+        if ((operation == 3 || operation == 5) && !memory) return false;
+        if (operation == 4 || operation == 5) result.flow = DecodedInstruction::Indirect;
+        if (operation == 3 || operation == 5) {
+            set(mnemonic, {"FAR " + rm(modrm, 2, false)});
+        } else {
+            set(mnemonic, {rm(modrm, 2, memory && operation < 2)});
+        }
+        return true;
+    case OpcodeInfo::PopMemory:
+        set(mnemonic, {rm(modrm, 2, false)});
+        return true;
+    default:
+        set(mnemonic, {rm(modrm, size, memory)});
+        if (info.group == OpcodeInfo::MoveImmediate) result.operands.append(immediate(size));
+        return true;
+    }
+}
+
+DecodedInstruction Decoder::run() {
+    result.address = address;
+    int opcode = byte();
+    while (OpcodeTable::info(opcode).form == OpcodeInfo::Prefix) {
+        if (opcode < 0x40) {
+            segmentOverride = (opcode >> 3) & 3;
+        } else {
+            result.prefix = OpcodeTable::info(opcode).mnemonic;
+        }
+        if (position - start > 3) break;
+        opcode = byte();
+    }
+
+    const bool decoded = decodeOpcode(opcode);
+    if (truncated || !decoded) return DecodedInstruction();
+
+    if (segmentOverride >= 0 && !overrideUsed) {
+        // A segment prefix with no memory operand to apply to, show it as a byte of its own.
+        DecodedInstruction prefix;
+        prefix.address = address;
+        prefix.size = 1;
+        prefix.mnemonic = "DB";
+        prefix.operands = QStringList{InstructionDecoder::hexByte(quint8(image[start]))};
+        return prefix;
+    }
+    result.size = position - start;
+    return result;
+}
+
+}
+
+QString DecodedInstruction::text() const {
+    QString text = prefix.isEmpty() ? mnemonic : prefix + " " + mnemonic;
+    if (!operands.isEmpty()) {
+        text += " " + operands.join(',');
+    }
+    return text;
+}
+
+DecodedInstruction InstructionDecoder::decode(const QByteArray& image, int offset, int address) {
+    if (offset < 0 || offset >= image.size()) return DecodedInstruction();
+    return Decoder(image, offset, address).run();
+}
+
+QString InstructionDecoder::hexByte(int value) {
+    return QString("%1").arg(value & 0xFF, 2, 16, QChar('0')).toUpper();
+}
+
+QString InstructionDecoder::hexWord(int value) {
+    return QString("%1").arg(value & 0xFFFF, 4, 16, QChar('0')).toUpper();
+}
@@ -0,0 +1,28 @@
+#ifndef INSTRUCTIONDECODER_H
+#define INSTRUCTIONDECODER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+
+struct DecodedInstruction {
+    enum Flow { Next, Jump, Branch, Call, Return, Indirect };
+    int address = 0;
+    int size = 0;
+    QString prefix;
+    QString mnemonic;
+    QStringList operands;
+    Flow flow = Next;
+    int target = -1;
+    bool isValid() const { return size > 0; }
+    QString text() const;
+};
+
+class InstructionDecoder {
+public:
+    static DecodedInstruction decode(const QByteArray& image, int offset, int address);
+    static QString hexByte(int value);
+    static QString hexWord(int value);
+};
+
+#endif // INSTRUCTIONDECODER_H
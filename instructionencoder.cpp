@@ -0,0 +1,724 @@
+#include "instructionencoder.h"
+#include <algorithm>
+#include "opcodetable.h"
+
+namespace {
+
+// How the encoder handles a mnemonic, value is its opcode or the reg field of its ModR/M group.
+struct Mnemonic {
+    enum Kind : quint8 { Implied, Arithmetic, Unary, Shift, ShortJump, Other };
+    const char* name = nullptr;
+    Kind kind = Other;
+    quint8 value = 0;
+};
+
+constexpr int compareNames(const char* a, const char* b) {
+    while (*a && *a == *b) {
+        ++a;
+        ++b;
+    }
+    return int(quint8(*a)) - int(quint8(*b));
+}
+
+// Every mnemonic the assembler accepts, sorted by name. The opcode table supplies all but the aliases and the
+// mnemonics with encodings of their own, so this is generated by the compiler instead of hashed at startup.
+struct MnemonicList {
+    static const int CAPACITY = 160;
+    Mnemonic entries[CAPACITY] = {};
+    int count = 0;
+    bool unique = true;
+
+    constexpr void add(const char* name, Mnemonic::Kind kind, int value) {
+        entries[count++] = {name, kind, quint8(value)};
+    }
+    constexpr const Mnemonic* find(const char* name) const {
+        for (int i = 0; i < count; ++i) {
+            if (compareNames(entries[i].name, name) == 0) return &entries[i];
+        }
+        return nullptr;
+    }
+};
+
+constexpr MnemonicList collectMnemonics() {
+    MnemonicList list;
+    for (int opcode = 0; opcode < 0x100; ++opcode) {
+        const OpcodeInfo& info = OpcodeTable::info(opcode);
+        // Segment prefixes are written as overrides, LOCK and the REP prefixes as mnemonics of their own.
+        if (info.form == OpcodeInfo::Implied || info.form == OpcodeInfo::AsciiAdjust
+            || (info.form == OpcodeInfo::Prefix && opcode >= 0x40)) {
+            list.add(info.mnemonic, Mnemonic::Implied, opcode);
+        } else if (info.form == OpcodeInfo::Relative8 && opcode != 0xEB) {
+            list.add(info.mnemonic, Mnemonic::ShortJump, opcode);
+        }
+    }
+    for (int operation = 0; operation < 8; ++operation) {
+        list.add(OpcodeTable::groupMnemonic(OpcodeInfo::Arithmetic, operation), Mnemonic::Arithmetic, operation);
+        // TEST has encodings of its own and is not part of the unary group here.
+        if (operation > 0 && OpcodeTable::groupMnemonic(OpcodeInfo::Unary, operation)) {
+            list.add(OpcodeTable::groupMnemonic(OpcodeInfo::Unary, operation), Mnemonic::Unary, operation);
+        }
+        if (OpcodeTable::groupMnemonic(OpcodeInfo::Shift, operation)) {
+            list.add(OpcodeTable::groupMnemonic(OpcodeInfo::Shift, operation), Mnemonic::Shift, operation);
+        }
+    }
+
+    constexpr const char* ALIASES[][2] = {
+        {"JC", "JB"}, {"JNAE", "JB"}, {"JAE", "JNB"}, {"JNC", "JNB"}, {"JE", "JZ"}, {"JNE", "JNZ"}, {"JNA", "JBE"},
+        {"JNBE", "JA"}, {"JP", "JPE"}, {"JNP", "JPO"}, {"JNGE", "JL"}, {"JNL", "JGE"}, {"JNG", "JLE"}, {"JNLE", "JG"},
+        {"LOOPNE", "LOOPNZ"}, {"LOOPE", "LOOPZ"}, {"SAL", "SHL"}, {"REP", "REPZ"}, {"REPE", "REPZ"}, {"REPNE", "REPNZ"}
+    };
+    for (const auto& alias : ALIASES) {
+        const Mnemonic* target = list.find(alias[1]);
+        list.add(alias[0], target->kind, target->value);
+    }
+    constexpr const char* OTHERS[] = {
+        "MOV", "TEST", "INC", "DEC", "PUSH", "POP", "XCHG", "LEA", "LDS", "LES", "IN", "OUT", "INT",
+        "JMP", "CALL", "DB", "DW"
+    };
+    for (const char* name : OTHERS) {
+        list.add(name, Mnemonic::Other, 0);
+    }
+
+    for (int i = 1; i < list.count; ++i) {
+        const Mnemonic entry = list.entries[i];
+        int j = i;
+        for (; j > 0 && compareNames(list.entries[j - 1].name, entry.name) > 0; --j) {
+            list.entries[j] = list.entries[j - 1];
+        }
+        list.entries[j] = entry;
+    }
+    for (int i = 1; i < list.count; ++i) {
+        if (compareNames(list.entries[i - 1].name, list.entries[i].name) == 0) list.unique = false;
+    }
+    return list;
+}
+
+constexpr MnemonicList MNEMONICS = collectMnemonics();
+static_assert(MNEMONICS.unique, "every mnemonic is encoded one way");
+
+const Mnemonic* findMnemonic(const QString& name) {
+    const Mnemonic* end = MNEMONICS.entries + MNEMONICS.count;
+    const Mnemonic* it = std::lower_bound(MNEMONICS.entries, end, name, [](const Mnemonic& entry, const QString& value) {
+        return value.compare(QLatin1String(entry.name)) > 0;
+    });
+    return it != end && name == QLatin1String(it->name) ? it : nullptr;
+}
+
+// The bytes of an implied mnemonic, AAM and AAD carry their base 0A.
+QByteArray impliedBytes(const Mnemonic& entry) {
+    QByteArray bytes(1, char(entry.value));
+    if (OpcodeTable::info(entry.value).form == OpcodeInfo::AsciiAdjust) bytes.append(char(0x0A));
+    return bytes;
+}
+
+class Encoder {
+public:
+    Encoder(const ScriptLine& line, int address, const EncodeOptions& options) : line(line), address(address), options(options) {}
+    EncodedInstruction run();
+private:
+    const ScriptLine& line;
+    int address;
+    const EncodeOptions& options;
+    QByteArray bytes;
+    QString error;
+    bool needsLongJump = false;
+    bool addressDependent = false;
+
+    void emitByte(int value) { bytes.append(char(value & 0xFF)); }
+    void emitWord(int value) { emitByte(value); emitByte(value >> 8); }
+    bool fail(const char* message) { if (error.isEmpty()) error = InstructionEncoder::tr(message); return false; }
+
+    static bool isRegister(const Operand& op) { return op.type == Operand::Register8 || op.type == Operand::Register16; }
+    static bool isRm(const Operand& op) { return isRegister(op) || op.type == Operand::Memory; }
+    static bool fitsByte(int value) { return value >= -128 && value <= 255; }
+    static bool fitsWord(int value) { return value >= -32768 && value <= 65535; }
+    static bool fitsSignedByte(int value) { qint16 word = qint16(value & 0xFFFF); return word >= -128 && word <= 127; }
+    static int sizeOf(const Operand& op);
+    bool isRelocatable(const Operand& op) const;
+
+    bool resolve(const Operand& op, int& value);
+    bool operandSize(const Operand& a, const Operand& b, int& size);
+    void emitModRm(int regField, const Operand& rm);
+    bool emitImmediate(const Operand& op, int size);
+    bool emitRelative(const Operand& target, int opcode, bool allowNear);
+
+    bool encodeAlu(int operation);
+    bool encodeMov();
+    bool encodeTest();
+    bool encodeUnary(int operation);
+    bool encodeIncDec(bool decrement);
+    bool encodeShift(int operation);
+    bool encodePushPop(bool pop);
+    bool encodeXchg();
+    bool encodeLoadAddress(int opcode);
+    bool encodeInOut(bool out);
+    bool encodeInt();
+    bool encodeReturn(int opcode);
+    bool encodeJumpOrCall(bool call);
+    bool encodeData(bool words);
+};
+
+int Encoder::sizeOf(const Operand& op) {
+    switch (op.type) {
+    case Operand::Register8: return 1;
+    case Operand::Register16:
+    case Operand::SegmentRegister: return 2;
+    case Operand::Memory: return op.size;
+    default: return 0;
+    }
+}
+
+bool Encoder::isRelocatable(const Operand& op) const {
+    if (op.label.isEmpty() || !options.symbols) return false;
+    auto it = options.symbols->constFind(op.label);
+    return it == options.symbols->constEnd() || it->isAddress;
+}
+
+bool Encoder::resolve(const Operand& op, int& value) {
+    value = op.value;
+    if (op.label.isEmpty()) return true;
+
+    auto it = options.symbols ? options.symbols->constFind(op.label) : SymbolTable::const_iterator();
+    if (!options.symbols || it == options.symbols->constEnd()) {
+        if (error.isEmpty()) error = InstructionEncoder::tr("Unknown symbol \"%1\"").arg(op.label);
+        return false;
+    }
+    if (!it->defined) addressDependent = true;
+    value += it->defined ? it->value : address;
+    return true;
+}
+
+bool Encoder::operandSize(const Operand& a, const Operand& b, int& size) {
+    int sizeA = sizeOf(a);
+    int sizeB = sizeOf(b);
+    if (sizeA && sizeB && sizeA != sizeB) {
+        return fail(QT_TRANSLATE_NOOP("InstructionEncoder", "Operand size mismatch"));
+    }
+    size = sizeA ? sizeA : sizeB;
+    if (!size) {
+        return fail(QT_TRANSLATE_NOOP("InstructionEncoder", "Operand size not specified, use BYTE PTR or WORD PTR"));
+    }
+    return true;
+}
+
+void Encoder::emitModRm(int regField, const Operand& rm) {
+    if (isRegister(rm)) {
+        emitByte(0xC0 | (regField << 3) | rm.reg);
+        return;
+    }
+    int displacement = 0;
+    resolve(rm, displacement);
+    if (rm.rm < 0) {
+        emitByte(0x06 | (regField << 3));
+        emitWord(displacement);
+    } else if (isRelocatable(rm)) {
+        emitByte(0x80 | (regField << 3) | rm.rm);
+        emitWord(displacement);
+    } else if (displacement == 0 && rm.rm != 6) {
+        emitByte((regField << 3) | rm.rm);
+    } else if (displacement >= -128 && displacement <= 127) {
+        emitByte(0x40 | (regField << 3) | rm.rm);
+        emitByte(displacement);
+    } else {
+        emitByte(0x80 | (regField << 3) | rm.rm);
+        emitWord(displacement);
+    }
+}
+
+bool Encoder::emitImmediate(const Operand& op, int size) {
+    int value;
+    if (!resolve(op, value)) return false;
+    if (size == 1 ? !fitsByte(value) : !fitsWord(value)) {
+        return fail(QT_TRANSLATE_NOOP("InstructionEncoder", "Immediate value out of range"));
+    }
+    if (size == 1) emitByte(value);
+    else emitWord(value);
+    return true;
+}
+
+bool Encoder::emitRelative(const Operand& target, int opcode, bool allowNear) {
+    int value;
+    if (target.type != Operand::Immediate || !resolve(target, value)) {
+        return fail(QT_TRANSLATE_NOOP("InstructionEncoder", "Invalid jump target"));
+    }
+    const bool relaxing = options.symbols != nullptr;
+    addressDependent = true;
+    const bool conditional = opcode != 0xEB;
+    // Displacements count from the end of the instruction, after any prefix bytes already emitted.
+    const int start = address + int(bytes.size());
+    int shortOffset = value - (start + 2);
+    bool fitsShort = shortOffset >= -128 && shortOffset <= 127;
+
+    if (relaxing && options.longJump && !target.isShort) {
+        if (!conditional) {
+            emitByte(0xE9);
+            emitWord(value - (start + 3));
+        } else if (opcode < 0x80) {
+            emitByte(opcode ^ 1);
+            emitByte(3);
+            emitByte(0xE9);
+            emitWord(value - (start + 5));
+        } else {
+            emitByte(opcode);
+            emitByte(2);
+            emitByte(0xEB);
+            emitByte(3);
+            emitByte(0xE9);
+            emitWord(value - (start + 7));
+        }
+        return true;
+    }
+
+    if (relaxing && !fitsShort && !target.isShort) {
+        needsLongJump = true;
+        fitsShort = true;
+        shortOffset = 0;
+    }
+    if (fitsShort && !(target.isNear && allowNear)) {
+        emitByte(opcode);
+        emitByte(shortOffset);
+        return true;
+    }
+    if (!allowNear || target.isShort) {
+        emitByte(opcode);
+        emitByte(0);
+        return fail(QT_TRANSLATE_NOOP("InstructionEncoder", "Short jump target out of range (-128..+127 bytes)"));
+    }
+    emitByte(0xE9);
+    emitWord(value - (start + 3));
+    return true;
+}
+
+bool Encoder::encodeAlu(int operation) {
+    if (line.operands.size() != 2) return fail(QT_TRANSLATE_NOOP("InstructionEncoder", "Expected two operands"));
+    const Operand& dst = line.operands[0];
+    const Operand& src = line.operands[1];
+
+    if (isRm(dst) && isRegister(src)) {
+        int size;
+        if (!operandSize(dst, src, size)) return false;
+        emitByte((operation << 3) | (size == 2 ? 1 : 0));
+        emitModRm(src.reg, dst);
+        return true;
+    }
+    if (isRegister(dst) && src.type == Operand::Memory) {
+        int size;
+        if (!operandSize(dst, src, size)) return false;
+        emitByte((operation << 3) | 2 | (size == 2 ? 1 : 0));
+        emitModRm(dst.reg, src);
+        return true;
+    }
+    if (isRm(dst) && src.type == Operand::Immediate) {
+        int size = sizeOf(dst);
+        if (!size) return fail(QT_TRANSLATE_NOOP("InstructionEncoder", "Operand size not specified, use BYTE PTR or WORD PTR"));
+        int value;
+        if (!resolve(src, value)) return false;
+        const bool shortImmediate = fitsSignedByte(value) && !isRelocatable(src);
+        if (isRegister(dst) && dst.reg == 0 && (size == 1 || !shortImmediate)) {
+            emitByte((operation << 3) | (size == 2 ? 5 : 4));
+            return emitImmediate(src, size);
+        }
+        if (size == 2 && shortImmediate) {
+            emitByte(0x83);
+            emitModRm(operation, dst);
+            emitByte(value);
+            return true;
+        }
+        emitByte(size == 2 ? 0x81 : 0x80);
+        emitModRm(operation, dst);
+        return emitImmediate(src, size);
+    }
+    return fail(QT_TRANSLATE_NOOP("InstructionEncoder", "Illegal operand combination"));
+}
+
+bool Encoder::encodeMov() {
+    if (line.operands.size() != 2) return fail(QT_TRANSLATE_NOOP("InstructionEncoder", "Expected two operands"));
+    const Operand& dst = line.operands[0];
+    const Operand& src = line.operands[1];
+
+    if (dst.type == Operand::SegmentRegister || src.type == Operand::SegmentRegister) {
+        if (dst.type == Operand::SegmentRegister && src.type == Operand::SegmentRegister) {
+            return fail(QT_TRANSLATE_NOOP("InstructionEncoder", "Cannot move between segment registers"));
+        }
+        if (dst.type == Operand::SegmentRegister) {
+            if (dst.reg == 1) return fail(QT_TRANSLATE_NOOP("InstructionEncoder", "Cannot load CS with MOV"));
+            if (!isRm(src) || src.type == Operand::Register8 || src.size == 1) {
+                return fail(QT_TRANSLATE_NOOP("InstructionEncoder", "Illegal operand combination"));
+            }
+            emitByte(0x8E);
+            emitModRm(dst.reg, src);
+            return true;
+        }
+        if (!isRm(dst) || dst.type == Operand::Register8 || dst.size == 1) {
+            return fail(QT_TRANSLATE_NOOP("InstructionEncoder", "Illegal operand combination"));
+        }
+        emitByte(0x8C);
+        emitModRm(src.reg, dst);
+        return true;
+    }
+
+    if (isRegister(dst) && dst.reg == 0 && src.type == Operand::Memory && src.rm < 0) {
+        int size;
+        if (!operandSize(dst, src, size)) return false;
+        int value;
+        if (!resolve(src, value)) return false;
+        emitByte(size == 2 ? 0xA1 : 0xA0);
+        emitWord(value);
+        return true;
+    }
+    if (dst.type == Operand::Memory && dst.rm < 0 && isRegister(src) && src.reg == 0) {
+        int size;
+        if (!operandSize(dst, src, size)) return false;
+        int value;
+        if (!resolve(dst, value)) return false;
+        emitByte(size == 2 ? 0xA3 : 0xA2);
+        emitWord(value);
+        return true;
+    }
+    if (isRm(dst) && isRegister(src)) {
+        int size;
+        if (!operandSize(dst, src, size)) return false;
+        emitByte(size == 2 ? 0x89 : 0x88);
+        emitModRm(src.reg, dst);
+        return true;
+    }
+    if (isRegister(dst) && src.type == Operand::Memory) {
+        int size;
+        if (!operandSize(dst, src, size)) return false;
+        emitByte(size == 2 ? 0x8B : 0x8A);
+        emitModRm(dst.reg, src);
+        return true;
+    }
+    if (isRegister(dst) && src.type == Operand::Immediate) {
+        int size = sizeOf(dst);
+        emitByte((size == 2 ? 0xB8 : 0xB0) + dst.reg);
+        return emitImmediate(src, size);
+    }
+    if (dst.type == Operand::Memory && src.type == Operand::Immediate) {
+        if (!dst.size) return fail(QT_TRANSLATE_NOOP("InstructionEncoder", "Operand size not specified, use BYTE PTR or WORD PTR"));
+        emitByte(dst.size == 2 ? 0xC7 : 0xC6);
+        emitModRm(0, dst);
+        return emitImmediate(src, dst.size);
+    }
+    return fail(QT_TRANSLATE_NOOP("InstructionEncoder", "Illegal operand combination"));
+}
+
+bool Encoder::encodeTest() {
+    if (line.operands.size() != 2) return fail(QT_TRANSLATE_NOOP("InstructionEncoder", "Expected two operands"));
+    const Operand& dst = line.operands[0];
+    const Operand& src = line.operands[1];
+
+    if (isRm(dst) && isRegister(src)) {
+        int size;
+        if (!operandSize(dst, src, size)) return false;
+        emitByte(size == 2 ? 0x85 : 0x84);
+        emitModRm(src.reg, dst);
+        return true;
+    }
+    if (isRegister(dst) && src.type == Operand::Memory) {
+        int size;
+        if (!operandSize(dst, src, size)) return false;
+        emitByte(size == 2 ? 0x85 : 0x84);
+        emitModRm(dst.reg, src);
+        return true;
+    }
+    if (isRm(dst) && src.type == Operand::Immediate) {
+        int size = sizeOf(dst);
+        if (!size) return fail(QT_TRANSLATE_NOOP("InstructionEncoder", "Operand size not specified, use BYTE PTR or WORD PTR"));
+        if (isRegister(dst) && dst.reg == 0) {
+            emitByte(size == 2 ? 0xA9 : 0xA8);
+        } else {
+            emitByte(size == 2 ? 0xF7 : 0xF6);
+            emitModRm(0, dst);
+        }
+        return emitImmediate(src, size);
+    }
+    return fail(QT_TRANSLATE_NOOP("InstructionEncoder", "Illegal operand combination"));
+}
+
+bool Encoder::encodeUnary(int operation) {
+    if (line.operands.size() != 1) return fail(QT_TRANSLATE_NOOP("InstructionEncoder", "Expected one operand"));
+    const Operand& op = line.operands[0];
+    if (!isRm(op)) return fail(QT_TRANSLATE_NOOP("InstructionEncoder", "Illegal operand combination"));
+    int size = sizeOf(op);
+    if (!size) return fail(QT_TRANSLATE_NOOP("InstructionEncoder", "Operand size not specified, use BYTE PTR or WORD PTR"));
+    emitByte(size == 2 ? 0xF7 : 0xF6);
+    emitModRm(operation, op);
+    return true;
+}
+
+bool Encoder::encodeIncDec(bool decrement) {
+    if (line.operands.size() != 1) return fail(QT_TRANSLATE_NOOP("InstructionEncoder", "Expected one operand"));
+    const Operand& op = line.operands[0];
+    if (op.type == Operand::Register16) {
+        emitByte((decrement ? 0x48 : 0x40) + op.reg);
+        return true;
+    }
+    if (!isRm(op)) return fail(QT_TRANSLATE_NOOP("InstructionEncoder", "Illegal operand combination"));
+    int size = sizeOf(op);
+    if (!size) return fail(QT_TRANSLATE_NOOP("InstructionEncoder", "Operand size not specified, use BYTE PTR or WORD PTR"));
+    emitByte(size == 2 ? 0xFF : 0xFE);
+    emitModRm(decrement ? 1 : 0, op);
+    return true;
+}
+
+bool Encoder::encodeShift(int operation) {
+    if (line.operands.size() != 2) return fail(QT_TRANSLATE_NOOP("InstructionEncoder", "Expected two operands"));
+    const Operand& op = line.operands[0];
+    const Operand& count = line.operands[1];
+    if (!isRm(op)) return fail(QT_TRANSLATE_NOOP("InstructionEncoder", "Illegal operand combination"));
+    int size = sizeOf(op);
+    if (!size) return fail(QT_TRANSLATE_NOOP("InstructionEncoder", "Operand size not specified, use BYTE PTR or WORD PTR"));
+
+    if (count.type == Operand::Register8 && count.reg == 1) {
+        emitByte(size == 2 ? 0xD3 : 0xD2);
+    } else if (count.type == Operand::Immediate && count.label.isEmpty() && count.value == 1) {
+        emitByte(size == 2 ? 0xD1 : 0xD0);
+    } else {
+        return fail(QT_TRANSLATE_NOOP("InstructionEncoder", "The 8086 only shifts by 1 or by CL"));
+    }
+    emitModRm(operation, op);
+    return true;
+}
+
+bool Encoder::encodePushPop(bool pop) {
+    if (line.operands.size() != 1) return fail(QT_TRANSLATE_NOOP("InstructionEncoder", "Expected one operand"));
+    const Operand& op = line.operands[0];
+    if (op.type == Operand::Register16) {
+        emitByte((pop ? 0x58 : 0x50) + op.reg);
+        return true;
+    }
+    if (op.type == Operand::SegmentRegister) {
+        if (pop && op.reg == 1) return fail(QT_TRANSLATE_NOOP("InstructionEncoder", "Cannot pop into CS"));
+        emitByte((op.reg << 3) | (pop ? 0x07 : 0x06));
+        return true;
+    }
+    if (op.type == Operand::Memory && op.size != 1) {
+        emitByte(pop ? 0x8F : 0xFF);
+        emitModRm(pop ? 0 : 6, op);
+        return true;
+    }
+    if (op.type == Operand::Immediate) {
+        return fail(QT_TRANSLATE_NOOP("InstructionEncoder", "The 8086 cannot push an immediate value"));
+    }
+    return fail(QT_TRANSLATE_NOOP("InstructionEncoder", "Illegal operand combination"));
+}
+
+bool Encoder::encodeXchg() {
+    if (line.operands.size() != 2) return fail(QT_TRANSLATE_NOOP("InstructionEncoder", "Expected two operands"));
+    const Operand& a = line.operands[0];
+    const Operand& b = line.operands[1];
+    if (a.type == Operand::Register16 && b.type == Operand::Register16 && (a.reg == 0 || b.reg == 0)) {
+        emitByte(0x90 + (a.reg == 0 ? b.reg : a.reg));
+        return true;
+    }
+    const Operand& reg = isRegister(b) ? b : a;
+    const Operand& rm = isRegister(b) ? a : b;
+    if (!isRegister(reg) || !isRm(rm)) return fail(QT_TRANSLATE_NOOP("InstructionEncoder", "Illegal operand combination"));
+    int size;
+    if (!operandSize(reg, rm, size)) return false;
+    emitByte(size == 2 ? 0x87 : 0x86);
+    emitModRm(reg.reg, rm);
+    return true;
+}
+
+bool Encoder::encodeLoadAddress(int opcode) {
+    if (line.operands.size() != 2) return fail(QT_TRANSLATE_NOOP("InstructionEncoder", "Expected two operands"));
+    const Operand& dst = line.operands[0];
+    const Operand& src = line.operands[1];
+    if (dst.type != Operand::Register16 || src.type != Operand::Memory) {
+        return fail(QT_TRANSLATE_NOOP("InstructionEncoder", "Illegal operand combination"));
+    }
+    emitByte(opcode);
+    emitModRm(dst.reg, src);
+    return true;
+}
+
+bool Encoder::encodeInOut(bool out) {
+    if (line.operands.size() != 2) return fail(QT_TRANSLATE_NOOP("InstructionEncoder", "Expected two operands"));
+    const Operand& port = line.operands[out ? 0 : 1];
+    const Operand& acc = line.operands[out ? 1 : 0];
+    if (!isRegister(acc) || acc.reg != 0) return fail(QT_TRANSLATE_NOOP("InstructionEncoder", "IN and OUT transfer through AL or AX"));
+    int wide = acc.type == Operand::Register16 ? 1 : 0;
+    if (port.type == Operand::Register16 && port.reg == 2) {
+        emitByte((out ? 0xEE : 0xEC) | wide);
+        return true;
+    }
+    if (port.type == Operand::Immediate) {
+        emitByte((out ? 0xE6 : 0xE4) | wide);
+        return emitImmediate(port, 1);
+    }
+    return fail(QT_TRANSLATE_NOOP("InstructionEncoder", "Illegal operand combination"));
+}
+
+bool Encoder::encodeInt() {
+    if (line.operands.size() != 1 || line.operands[0].type != Operand::Immediate) {
+        return fail(QT_TRANSLATE_NOOP("InstructionEncoder", "Expected an interrupt number"));
+    }
+    int value;
+    if (!resolve(line.operands[0], value)) return false;
+    if (value < 0 || value > 0xFF) return fail(QT_TRANSLATE_NOOP("InstructionEncoder", "Immediate value out of range"));
+    if (value == 3) {
+        emitByte(0xCC);
+    } else {
+        emitByte(0xCD);
+        emitByte(value);
+    }
+    return true;
+}
+
+bool Encoder::encodeReturn(int opcode) {
+    if (line.operands.isEmpty()) {
+        emitByte(opcode | 1);
+        return true;
+    }
+    if (line.operands.size() != 1 || line.operands[0].type != Operand::Immediate) {
+        return fail(QT_TRANSLATE_NOOP("InstructionEncoder", "Illegal operand combination"));
+    }
+    emitByte(opcode);
+    return emitImmediate(line.operands[0], 2);
+}
+
+bool Encoder::encodeJumpOrCall(bool call) {
+    if (line.operands.size() != 1) return fail(QT_TRANSLATE_NOOP("InstructionEncoder", "Expected one operand"));
+    const Operand& target = line.operands[0];
+    if (target.type == Operand::FarAddress) {
+        emitByte(call ? 0x9A : 0xEA);
+        emitWord(target.value);
+        emitWord(target.segment);
+        return true;
+    }
+    if (target.type == Operand::Memory && target.isFar) {
+        emitByte(0xFF);
+        emitModRm(call ? 3 : 5, target);
+        return true;
+    }
+    if (target.type == Operand::Register16 || (target.type == Operand::Memory && target.size != 1)) {
+        emitByte(0xFF);
+        emitModRm(call ? 2 : 4, target);
+        return true;
+    }
+    if (target.type != Operand::Immediate) return fail(QT_TRANSLATE_NOOP("InstructionEncoder", "Invalid jump target"));
+    if (call) {
+        int value;
+        if (!resolve(target, value)) return false;
+        addressDependent = true;
+        emitByte(0xE8);
+        // The displacement counts from the end of the instruction, prefix bytes included.
+        emitWord(value - (address + int(bytes.size()) + 2));
+        return true;
+    }
+    return emitRelative(target, 0xEB, true);
+}
+
+bool Encoder::encodeData(bool words) {
+    if (line.operands.isEmpty()) return fail(QT_TRANSLATE_NOOP("InstructionEncoder", "Expected data"));
+    for (const Operand& op : line.operands) {
+        if (op.type == Operand::String) {
+            QByteArray text = op.label.toLatin1();
+            bytes.append(text);
+            if (words && text.size() % 2) emitByte(0);
+        } else if (op.type == Operand::Immediate) {
+            if (!emitImmediate(op, words ? 2 : 1)) return false;
+        } else {
+            return fail(QT_TRANSLATE_NOOP("InstructionEncoder", "Illegal operand combination"));
+        }
+    }
+    return true;
+}
+
+EncodedInstruction Encoder::run() {
+    const QString& mnemonic = line.mnemonic;
+    if (!line.prefix.isEmpty()) {
+        if (const Mnemonic* prefix = findMnemonic(line.prefix)) bytes.append(impliedBytes(*prefix));
+    }
+    for (const Operand& op : line.operands) {
+        if (op.type == Operand::Invalid) {
+            fail(QT_TRANSLATE_NOOP("InstructionEncoder", "Invalid operand"));
+            return {bytes, error, needsLongJump, addressDependent};
+        }
+        if (op.type == Operand::Memory && op.segmentOverride >= 0) {
+            emitByte(0x26 | (op.segmentOverride << 3));
+        }
+    }
+
+    const Mnemonic* entry = findMnemonic(mnemonic);
+    const Mnemonic::Kind kind = entry ? entry->kind : Mnemonic::Other;
+    if ((mnemonic == "RET" || mnemonic == "RETF") && !line.operands.isEmpty()) {
+        // C2/CA pop extra argument bytes, without an operand the implied C3/CB below are used.
+        encodeReturn(mnemonic == "RET" ? 0xC2 : 0xCA);
+    } else if (kind == Mnemonic::Implied) {
+        if (!line.operands.isEmpty()) fail(QT_TRANSLATE_NOOP("InstructionEncoder", "This instruction takes no operands"));
+        bytes.append(impliedBytes(*entry));
+    } else if (kind == Mnemonic::Arithmetic) {
+        encodeAlu(entry->value);
+    } else if (kind == Mnemonic::Unary) {
+        encodeUnary(entry->value);
+    } else if (kind == Mnemonic::Shift) {
+        encodeShift(entry->value);
+    } else if (kind == Mnemonic::ShortJump) {
+        if (line.operands.size() != 1) fail(QT_TRANSLATE_NOOP("InstructionEncoder", "Expected one operand"));
+        else emitRelative(line.operands[0], entry->value, false);
+    } else if (mnemonic == "MOV") {
+        encodeMov();
+    } else if (mnemonic == "TEST") {
+        encodeTest();
+    } else if (mnemonic == "INC" || mnemonic == "DEC") {
+        encodeIncDec(mnemonic == "DEC");
+    } else if (mnemonic == "PUSH" || mnemonic == "POP") {
+        encodePushPop(mnemonic == "POP");
+    } else if (mnemonic == "XCHG") {
+        encodeXchg();
+    } else if (mnemonic == "LEA") {
+        encodeLoadAddress(0x8D);
+    } else if (mnemonic == "LDS") {
+        encodeLoadAddress(0xC5);
+    } else if (mnemonic == "LES") {
+        encodeLoadAddress(0xC4);
+    } else if (mnemonic == "IN" || mnemonic == "OUT") {
+        encodeInOut(mnemonic == "OUT");
+    } else if (mnemonic == "INT") {
+        encodeInt();
+    } else if (mnemonic == "JMP" || mnemonic == "CALL") {
+        encodeJumpOrCall(mnemonic == "CALL");
+    } else if (mnemonic == "DB" || mnemonic == "DW") {
+        encodeData(mnemonic == "DW");
+    } else {
+        fail(QT_TRANSLATE_NOOP("InstructionEncoder", "Unknown instruction"));
+    }
+    return {bytes, error, needsLongJump, addressDependent};
+}
+
+}
+
+EncodedInstruction InstructionEncoder::encode(const ScriptLine& line, int address, const EncodeOptions& options) {
+    if (line.mnemonic.isEmpty()) return {};
+    return Encoder(line, address, options).run();
+}
+
+EncodedInstruction InstructionEncoder::encode(const QVector<LineEncoding>& known, int index, const ScriptLine& line, int address) {
+    if (index < known.size() && known[index].address == address) return known[index].encoded;
+    return encode(line, address);
+}
+
+bool InstructionEncoder::isKnownMnemonic(const QString& mnemonic) {
+    return findMnemonic(mnemonic) != nullptr;
+}
+
+QStringList InstructionEncoder::mnemonics() {
+    QStringList names;
+    names.reserve(MNEMONICS.count);
+    for (int i = 0; i < MNEMONICS.count; ++i) {
+        names.append(QLatin1String(MNEMONICS.entries[i].name));
+    }
+    return names;
+}
+
+bool InstructionEncoder::isShortJump(const QString& mnemonic) {
+    const Mnemonic* entry = findMnemonic(mnemonic);
+    return entry && entry->kind == Mnemonic::ShortJump;
+}
+
+bool InstructionEncoder::isJump(const QString& mnemonic) {
+    return isShortJump(mnemonic) || mnemonic == "JMP" || mnemonic == "CALL";
+}
@@ -0,0 +1,53 @@
+#ifndef INSTRUCTIONENCODER_H
+#define INSTRUCTIONENCODER_H
+
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QString>
+#include <QHash>
+#include <QStringList>
+#include <QVector>
+#include "scriptparser.h"
+
+struct Symbol {
+    int value = 0;
+    bool isAddress = false;
+    bool defined = false;
+    int line = -1;
+};
+
+typedef QHash<QString, Symbol> SymbolTable;
+
+struct EncodeOptions {
+    const SymbolTable* symbols = nullptr;
+    bool longJump = false;
+};
+
+struct EncodedInstruction {
+    QByteArray bytes;
+    QString error;
+    bool needsLongJump = false;
+    bool addressDependent = false;
+    bool isValid() const { return error.isEmpty(); }
+};
+
+// The encoding of one script line, made at address during an earlier walk over the same lines.
+struct LineEncoding {
+    int address = -1;
+    EncodedInstruction encoded;
+};
+
+class InstructionEncoder {
+    Q_DECLARE_TR_FUNCTIONS(InstructionEncoder)
+public:
+    static EncodedInstruction encode(const ScriptLine& line, int address, const EncodeOptions& options = EncodeOptions());
+    // known[index] when it was encoded at address, otherwise a fresh encoding of line.
+    static EncodedInstruction encode(const QVector<LineEncoding>& known, int index, const ScriptLine& line, int address);
+    static bool isKnownMnemonic(const QString& mnemonic);
+    // Every mnemonic and alias the assembler accepts.
+    static QStringList mnemonics();
+    static bool isShortJump(const QString& mnemonic);
+    static bool isJump(const QString& mnemonic);
+};
+
+#endif // INSTRUCTIONENCODER_H
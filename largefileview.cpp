@@ -0,0 +1,367 @@
+#include "largefileview.h"
+#include <QPainter>
+#include <QPaintEvent>
+#include <QKeyEvent>
+#include <QMouseEvent>
+#include <QScrollBar>
+#include <QFontMetrics>
+#include <QInputDialog>
+#include <QApplication>
+#include <QClipboard>
+#include <QDebug>
+#include <algorithm>
+#include <functional>
+#include <cctype>
+#include <climits>
+#include <cstring>
+
+namespace {
+
+struct CaseInsensitiveHash {
+    size_t operator()(char c) const {
+        return std::hash<int>()(std::tolower(static_cast<unsigned char>(c)));
+    }
+};
+
+struct CaseInsensitiveEqual {
+    bool operator()(char a, char b) const {
+        return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+    }
+};
+
+const char* findCaseInsensitive(const char* first, const char* last, const QByteArray& pattern) {
+    if (pattern.isEmpty() || last - first < pattern.size()) return last;
+    std::boyer_moore_horspool_searcher<const char*, CaseInsensitiveHash, CaseInsensitiveEqual>
+        searcher(pattern.constData(), pattern.constData() + pattern.size());
+    return std::search(first, last, searcher);
+}
+
+}
+
+LargeFileView::LargeFileView(QWidget* parent) : QAbstractScrollArea(parent), data(nullptr), dataSize(0), longestLine(0), current(0),
+    backgroundColor(Qt::white), textColor(Qt::black), highlightColor(QColor(Qt::darkGray).lighter(160)), indexer(nullptr), stopIndexing(false) {
+    QAbstractScrollArea::setFont(QFont("Courier New", 10));
+    setFocusPolicy(Qt::StrongFocus);
+    viewport()->setAutoFillBackground(false);
+}
+
+LargeFileView::~LargeFileView() {
+    reset();
+}
+
+void LargeFileView::reset() {
+    stopIndexing = true;
+    if (indexer) {
+        indexer->wait();
+        delete indexer;
+        indexer = nullptr;
+    }
+    stopIndexing = false;
+    if (file.isOpen()) {
+        file.close();
+    }
+    ownedData.clear();
+    data = nullptr;
+    dataSize = 0;
+    lineStarts.clear();
+    longestLine = 0;
+    current = 0;
+}
+
+bool LargeFileView::openFile(const QString& path) {
+    reset();
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qDebug() << "Failed to open file for viewing:" << path << "-" << file.errorString();
+        return false;
+    }
+    dataSize = file.size();
+    if (dataSize > 0) {
+        data = reinterpret_cast<const char*>(file.map(0, dataSize));
+        if (!data) {
+            ownedData = file.readAll();
+            data = ownedData.constData();
+            dataSize = ownedData.size();
+        }
+    }
+    startIndexing();
+    return true;
+}
+
+void LargeFileView::setData(const QByteArray& bytes) {
+    reset();
+    ownedData = bytes;
+    data = ownedData.constData();
+    dataSize = ownedData.size();
+    startIndexing();
+}
+
+void LargeFileView::startIndexing() {
+    if (dataSize > 0) {
+        lineStarts.append(0);
+    }
+    updateScrollBars();
+    viewport()->update();
+    if (dataSize == 0) {
+        emit indexingFinished();
+        return;
+    }
+
+    const char* bytes = data;
+    const qint64 size = dataSize;
+    indexer = QThread::create([this, bytes, size]() {
+        QVector<qint64> batch;
+        batch.reserve(INDEX_BATCH_LINES);
+        qint64 lineStart = 0;
+        qint64 longest = 0;
+        const char* position = bytes;
+        const char* end = bytes + size;
+        while (position < end && !stopIndexing) {
+            const char* newline = static_cast<const char*>(memchr(position, '\n', end - position));
+            if (!newline) break;
+            qint64 next = newline - bytes + 1;
+            longest = qMax(longest, next - lineStart);
+            lineStart = next;
+            if (next < size) {
+                batch.append(next);
+            }
+            position = newline + 1;
+            if (batch.size() >= INDEX_BATCH_LINES) {
+                QMetaObject::invokeMethod(this, [this, batch, longest]() { appendLineStarts(batch, longest); }, Qt::QueuedConnection);
+                batch.clear();
+            }
+        }
+        longest = qMax(longest, size - lineStart);
+        QMetaObject::invokeMethod(this, [this, batch, longest]() {
+            appendLineStarts(batch, longest);
+            emit indexingFinished();
+        }, Qt::QueuedConnection);
+    });
+    indexer->start();
+}
+
+void LargeFileView::appendLineStarts(const QVector<qint64>& starts, qint64 longest) {
+    bool visibleChanged = verticalScrollBar()->value() + visibleLineCount() >= lineStarts.size();
+    lineStarts.append(starts);
+    longestLine = qMax(longestLine, longest);
+    updateScrollBars();
+    if (visibleChanged) {
+        viewport()->update();
+    }
+}
+
+void LargeFileView::setFont(const QFont& font) {
+    QAbstractScrollArea::setFont(font);
+    updateScrollBars();
+    viewport()->update();
+}
+
+void LargeFileView::setColors(const QColor& backgroundColor, const QColor& textColor, const QColor& highlightColor) {
+    this->backgroundColor = backgroundColor;
+    this->textColor = textColor;
+    this->highlightColor = highlightColor;
+    viewport()->update();
+}
+
+qint64 LargeFileView::lineCount() const {
+    return lineStarts.size();
+}
+
+int LargeFileView::currentLine() const {
+    return int(current);
+}
+
+int LargeFileView::lineHeight() const {
+    return fontMetrics().height();
+}
+
+int LargeFileView::gutterWidth() const {
+    int digits = 1;
+    qint64 max = qMax<qint64>(1, lineStarts.size());
+    while (max >= 10) {
+        max /= 10;
+        ++digits;
+    }
+    return fontMetrics().horizontalAdvance(QLatin1Char('9')) * (digits + 1) + MARGIN_LEFT + MARGIN_RIGHT;
+}
+
+int LargeFileView::visibleLineCount() const {
+    return qMax(1, viewport()->height() / lineHeight());
+}
+
+void LargeFileView::updateScrollBars() {
+    int visible = visibleLineCount();
+    verticalScrollBar()->setRange(0, int(qMax<qint64>(0, lineStarts.size() - visible)));
+    verticalScrollBar()->setPageStep(visible);
+    verticalScrollBar()->setSingleStep(1);
+
+    int textWidth = viewport()->width() - gutterWidth();
+    int contentWidth = int(qMin<qint64>(longestLine * fontMetrics().horizontalAdvance(QLatin1Char('M')), INT_MAX / 2));
+    horizontalScrollBar()->setRange(0, qMax(0, contentWidth - textWidth + MARGIN_LEFT + MARGIN_RIGHT));
+    horizontalScrollBar()->setPageStep(qMax(1, textWidth));
+}
+
+QString LargeFileView::lineText(qint64 line) const {
+    if (line < 0 || line >= lineStarts.size()) return QString();
+    qint64 start = lineStarts[line];
+    qint64 end = line + 1 < lineStarts.size() ? lineStarts[line + 1] : dataSize;
+    if (line + 1 == lineStarts.size() && indexer && indexer->isRunning()) {
+        const char* newline = static_cast<const char*>(memchr(data + start, '\n', dataSize - start));
+        if (newline) end = newline - data + 1;
+    }
+    while (end > start && (data[end - 1] == '\n' || data[end - 1] == '\r')) {
+        --end;
+    }
+    QString text = QString::fromUtf8(data + start, end - start);
+    text.replace(QLatin1Char('\t'), QLatin1String("    "));
+    return text;
+}
+
+qint64 LargeFileView::lineForOffset(qint64 offset) const {
+    auto it = std::upper_bound(lineStarts.constBegin(), lineStarts.constEnd(), offset);
+    return qMax<qint64>(0, (it - lineStarts.constBegin()) - 1);
+}
+
+void LargeFileView::paintEvent(QPaintEvent* event) {
+    QPainter painter(viewport());
+    painter.fillRect(event->rect(), backgroundColor);
+
+    const int height = lineHeight();
+    const int gutter = gutterWidth();
+    const int ascent = fontMetrics().ascent();
+    const int textX = gutter + MARGIN_LEFT - horizontalScrollBar()->value();
+    const qint64 first = verticalScrollBar()->value();
+    const int firstRow = event->rect().top() / height;
+    const int lastRow = event->rect().bottom() / height;
+
+    painter.fillRect(QRect(0, event->rect().top(), gutter, event->rect().height()), Qt::lightGray);
+    for (int row = firstRow; row <= lastRow; ++row) {
+        qint64 line = first + row;
+        if (line >= lineStarts.size()) break;
+        int y = row * height;
+
+        if (line == current) {
+            painter.fillRect(QRect(gutter, y, viewport()->width() - gutter, height), highlightColor);
+        }
+        painter.setPen(Qt::black);
+        painter.drawText(MARGIN_LEFT, y, gutter - MARGIN_LEFT - MARGIN_RIGHT, height,
+                         Qt::AlignRight | Qt::AlignVCenter, QString::number(line + 1));
+
+        painter.setClipRect(QRect(gutter, y, viewport()->width() - gutter, height));
+        painter.setPen(textColor);
+        painter.drawText(textX, y + ascent, lineText(line));
+        painter.setClipping(false);
+    }
+}
+
+void LargeFileView::resizeEvent(QResizeEvent* event) {
+    QAbstractScrollArea::resizeEvent(event);
+    updateScrollBars();
+}
+
+void LargeFileView::goToLine(qint64 line) {
+    if (lineStarts.isEmpty()) return;
+    current = qBound<qint64>(0, line, lineStarts.size() - 1);
+    qint64 first = verticalScrollBar()->value();
+    int visible = visibleLineCount();
+    if (current < first) {
+        verticalScrollBar()->setValue(int(current));
+    } else if (current >= first + visible) {
+        verticalScrollBar()->setValue(int(current - visible + 1));
+    }
+    viewport()->update();
+}
+
+bool LargeFileView::jumpToAddress(quint16 offset) {
+    const QByteArray pattern = QString(":%1").arg(offset, 4, 16, QChar('0')).toUpper().toLatin1();
+    const char* end = data + dataSize;
+    const char* position = data;
+    while (position && position < end) {
+        const char* match = findCaseInsensitive(position, end, pattern);
+        if (match == end) break;
+        qint64 matchOffset = match - data;
+        qint64 line = lineForOffset(matchOffset);
+        qint64 prefix = matchOffset - lineStarts.value(line, 0);
+        bool lineStartsWithSegment = prefix == 2 || prefix == 4;
+        for (qint64 i = lineStarts.value(line, 0); i < matchOffset && lineStartsWithSegment; ++i) {
+            lineStartsWithSegment = std::isxdigit(static_cast<unsigned char>(data[i])) || data[i] == 'C' || data[i] == 'S';
+        }
+        const char* after = match + pattern.size();
+        if (lineStartsWithSegment && (after == end || !std::isxdigit(static_cast<unsigned char>(*after)))) {
+            goToLine(line);
+            return true;
+        }
+        position = match + 1;
+    }
+    return false;
+}
+
+bool LargeFileView::findNext(const QString& text) {
+    if (text.isEmpty() || lineStarts.isEmpty()) return false;
+    lastSearch = text;
+    const QByteArray pattern = text.toUtf8();
+    const qint64 searchable = (indexer && indexer->isRunning()) ? lineStarts.last() : dataSize;
+    qint64 from = current + 1 < lineStarts.size() ? lineStarts[current + 1] : searchable;
+    from = qMin(from, searchable);
+
+    const char* match = findCaseInsensitive(data + from, data + searchable, pattern);
+    if (match == data + searchable) {
+        match = findCaseInsensitive(data, data + from, pattern);
+        if (match == data + from) return false;
+    }
+    goToLine(lineForOffset(match - data));
+    return true;
+}
+
+void LargeFileView::keyPressEvent(QKeyEvent* event) {
+    if (event->matches(QKeySequence::Find)) {
+        bool ok;
+        QString text = QInputDialog::getText(this, tr("Find"), tr("Find:"), QLineEdit::Normal, lastSearch, &ok);
+        if (ok && !findNext(text)) {
+            QApplication::beep();
+        }
+        return;
+    }
+    if (event->matches(QKeySequence::FindNext)) {
+        if (!findNext(lastSearch)) {
+            QApplication::beep();
+        }
+        return;
+    }
+    if (event->key() == Qt::Key_G && event->modifiers() == Qt::ControlModifier) {
+        bool ok;
+        QString text = QInputDialog::getText(this, tr("Go to Address"), tr("Address (CS:0100 or 0100):"), QLineEdit::Normal, QString(), &ok);
+        if (ok) {
+            int offset = text.section(':', -1).trimmed().toInt(&ok, 16);
+            if (!ok || offset < 0 || offset > 0xFFFF || !jumpToAddress(quint16(offset))) {
+                QApplication::beep();
+            }
+        }
+        return;
+    }
+    if (event->matches(QKeySequence::Copy)) {
+        QApplication::clipboard()->setText(lineText(current));
+        return;
+    }
+
+    switch (event->key()) {
+    case Qt::Key_Up: goToLine(current - 1); return;
+    case Qt::Key_Down: goToLine(current + 1); return;
+    case Qt::Key_PageUp: goToLine(current - visibleLineCount()); return;
+    case Qt::Key_PageDown: goToLine(current + visibleLineCount()); return;
+    case Qt::Key_Home:
+        if (event->modifiers() & Qt::ControlModifier) { goToLine(0); return; }
+        break;
+    case Qt::Key_End:
+        if (event->modifiers() & Qt::ControlModifier) { goToLine(lineStarts.size() - 1); return; }
+        break;
+    default:
+        break;
+    }
+    QAbstractScrollArea::keyPressEvent(event);
+}
+
+void LargeFileView::mousePressEvent(QMouseEvent* event) {
+    goToLine(verticalScrollBar()->value() + event->position().toPoint().y() / lineHeight());
+    QAbstractScrollArea::mousePressEvent(event);
+}
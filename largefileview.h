@@ -0,0 +1,62 @@
+#ifndef LARGEFILEVIEW_H
+#define LARGEFILEVIEW_H
+
+#include <QAbstractScrollArea>
+#include <QFile>
+#include <QByteArray>
+#include <QVector>
+#include <QThread>
+#include <atomic>
+
+class LargeFileView : public QAbstractScrollArea {
+    Q_OBJECT
+public:
+    explicit LargeFileView(QWidget* parent = nullptr);
+    ~LargeFileView();
+    bool openFile(const QString& path);
+    void setData(const QByteArray& data);
+    void setFont(const QFont& font);
+    void setColors(const QColor& backgroundColor, const QColor& textColor, const QColor& highlightColor);
+    qint64 lineCount() const;
+    int currentLine() const;
+    void goToLine(qint64 line);
+    bool jumpToAddress(quint16 offset);
+    bool findNext(const QString& text);
+signals:
+    void indexingFinished();
+protected:
+    void paintEvent(QPaintEvent* event) override;
+    void resizeEvent(QResizeEvent* event) override;
+    void keyPressEvent(QKeyEvent* event) override;
+    void mousePressEvent(QMouseEvent* event) override;
+private:
+    static constexpr int MARGIN_LEFT = 5;
+    static constexpr int MARGIN_RIGHT = 10;
+    static constexpr int INDEX_BATCH_LINES = 65536;
+
+    QFile file;
+    QByteArray ownedData;
+    const char* data;
+    qint64 dataSize;
+    QVector<qint64> lineStarts;
+    qint64 longestLine;
+    qint64 current;
+    QString lastSearch;
+    QColor backgroundColor;
+    QColor textColor;
+    QColor highlightColor;
+    QThread* indexer;
+    std::atomic<bool> stopIndexing;
+
+    void reset();
+    void startIndexing();
+    void appendLineStarts(const QVector<qint64>& starts, qint64 longest);
+    QString lineText(qint64 line) const;
+    qint64 lineForOffset(qint64 offset) const;
+    int lineHeight() const;
+    int gutterWidth() const;
+    int visibleLineCount() const;
+    void updateScrollBars();
+};
+
+#endif // LARGEFILEVIEW_H
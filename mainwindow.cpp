@@ -6,57 +6,76 @@
 #include <QMap>
 #include <QFileInfo>
 #include <QApplication>
-#include <QProcess>
 #include <QMessageBox>
 #include <QCloseEvent>
+#include <QEvent>
 #include <QDesktopServices>
 #include <QUrl>
-#include <QWebEngineView>
 #include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QScrollBar>
+#include <QTextCursor>
+#include <QSignalBlocker>
+#include <QStatusBar>
+#include <QDockWidget>
+#include <QInputDialog>
+#include <QLineEdit>
 
-MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent), isLanguageChangeClosing(false) {
+MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent) {
+    settingsManager = new SettingsManager(this);
     setWindowTitle(tr("Debug3000"));
     tabWidget = new QTabWidget(this);
     tabWidget->setTabsClosable(true);
     setCentralWidget(tabWidget);
-    settingsManager = new SettingsManager(this);
     fileController = new FileController(this);
-    helpView = nullptr;
     helpWindow = nullptr;
+    previousTabIndex = -1;
+    debugSession = new DebugSession(this);
+    createDebugDocks();
     createMenus();
     createToolBar();
+    createStatusBar();
+    loadTranslation(settingsManager->currentSettings().language);
     connect(settingsManager, &SettingsManager::settingsChanged, this, &MainWindow::updateEditors);
+    connect(tabWidget, &QTabWidget::currentChanged, this, &MainWindow::onCurrentTabChanged);
     connect(fileController, &FileController::compileAndRunFinished, this, &MainWindow::onCompileAndRunFinished);
+    connect(debugSession, &DebugSession::paused, this, &MainWindow::onDebugPaused);
+    connect(debugSession, &DebugSession::output, this, &MainWindow::onDebugOutput);
+    connect(debugSession, &DebugSession::finished, this, &MainWindow::onDebugFinished);
     connect(tabWidget, &QTabWidget::tabCloseRequested, this, [this](int index) {
         if (promptSaveChanges(index)) {
-            editorTabs.remove(index);
-            tabWidget->removeTab(index);
             QMap<int, EditorTab> updatedTabs;
-            for (int i = 0, newIndex = 0; i < tabWidget->count(); ++i, ++newIndex) {
-                updatedTabs[newIndex] = editorTabs[i];
+            for (auto it = editorTabs.constBegin(); it != editorTabs.constEnd(); ++it) {
+                if (it.key() != index) {
+                    updatedTabs[it.key() < index ? it.key() : it.key() - 1] = it.value();
+                }
             }
             editorTabs = updatedTabs;
+            QWidget* page = tabWidget->widget(index);
+            previousTabIndex = -1;
+            tabWidget->removeTab(index);
+            page->deleteLater();
         }
     });
     settingsManager->applySettings();
+    restoreSession();
+
+    idleTabTimer = new QTimer(this);
+    connect(idleTabTimer, &QTimer::timeout, this, &MainWindow::unloadIdleTabs);
+    idleTabTimer->start(IDLE_TAB_CHECK_INTERVAL_MS);
 }
 
 MainWindow::~MainWindow() {
-    delete helpWindow;
 }
 
 void MainWindow::closeEvent(QCloseEvent* event) {
-    if (isLanguageChangeClosing) {
-        event->accept();
-        return;
-    }
-
     for (int i = 0; i < tabWidget->count(); ++i) {
         if (!promptSaveChanges(i)) {
             event->ignore();
             return;
         }
     }
+    saveSession();
     event->accept();
 }
 
@@ -74,18 +93,94 @@ void MainWindow::createMenus() {
     pasteCodeAction->setShortcut(Qt::Key_F6);
     runAction = fileMenu->addAction(tr("Run"));
     runAction->setShortcut(Qt::Key_F5);
+    assembleAction = fileMenu->addAction(tr("Assemble to COM"));
+    assembleAction->setShortcut(Qt::CTRL | Qt::Key_B);
+    exportScriptAction = fileMenu->addAction(tr("Export as DEBUG Script"));
+    debugMenu = menuBar()->addMenu(tr("Debug"));
+    continueAction = debugMenu->addAction(tr("Start / Continue"));
+    continueAction->setShortcut(Qt::Key_F8);
+    stepOverAction = debugMenu->addAction(tr("Step Over"));
+    stepOverAction->setShortcut(Qt::Key_F10);
+    stepIntoAction = debugMenu->addAction(tr("Step Into"));
+    stepIntoAction->setShortcut(Qt::Key_F11);
+    stepOutAction = debugMenu->addAction(tr("Step Out"));
+    stepOutAction->setShortcut(Qt::SHIFT | Qt::Key_F11);
+    runToCursorAction = debugMenu->addAction(tr("Run to Cursor"));
+    runToCursorAction->setShortcut(Qt::CTRL | Qt::Key_F10);
+    stopDebugAction = debugMenu->addAction(tr("Stop Debugging"));
+    stopDebugAction->setShortcut(Qt::SHIFT | Qt::Key_F5);
+    debugMenu->addSeparator();
+    breakpointAction = debugMenu->addAction(tr("Toggle Breakpoint"));
+    breakpointAction->setShortcut(Qt::Key_F9);
+    conditionAction = debugMenu->addAction(tr("Breakpoint Condition..."));
+    conditionAction->setShortcut(Qt::CTRL | Qt::Key_F9);
+    watchpointAction = debugMenu->addAction(tr("Add Watchpoint..."));
+    clearWatchpointsAction = debugMenu->addAction(tr("Clear Watchpoints"));
+    snapshotAction = debugMenu->addAction(tr("Mark Memory Snapshot"));
+    memoryDiffAction = debugMenu->addAction(tr("Diff Memory"));
+    debugMenu->addAction(registerDock->toggleViewAction());
+    debugMenu->addAction(memoryDock->toggleViewAction());
     settingsMenu = menuBar()->addMenu(tr("Settings"));
     settingsAction = settingsMenu->addAction(tr("Preferences"));
     helpMenu = menuBar()->addMenu(tr("Help"));
     helpAction = helpMenu->addAction(tr("About Debug3000"));
+    instructionHelpAction = helpMenu->addAction(tr("Help for Instruction"));
+    instructionHelpAction->setShortcut(QKeySequence::HelpContents);
     connect(newAction, &QAction::triggered, this, &MainWindow::newFile);
     connect(openAction, &QAction::triggered, this, &MainWindow::openFile);
     connect(saveAction, &QAction::triggered, this, &MainWindow::saveFile);
     connect(saveAsAction, &QAction::triggered, this, &MainWindow::saveFileAs);
     connect(pasteCodeAction, &QAction::triggered, this, &MainWindow::pasteCode);
     connect(runAction, &QAction::triggered, this, &MainWindow::run);
+    connect(assembleAction, &QAction::triggered, this, &MainWindow::assembleToCom);
+    connect(exportScriptAction, &QAction::triggered, this, &MainWindow::exportDebugScript);
+    connect(continueAction, &QAction::triggered, this, &MainWindow::debugContinue);
+    connect(stepOverAction, &QAction::triggered, this, &MainWindow::debugStepOver);
+    connect(stepIntoAction, &QAction::triggered, this, &MainWindow::debugStepInto);
+    connect(stepOutAction, &QAction::triggered, this, &MainWindow::debugStepOut);
+    connect(runToCursorAction, &QAction::triggered, this, &MainWindow::debugRunToCursor);
+    connect(stopDebugAction, &QAction::triggered, this, &MainWindow::stopDebugging);
+    connect(breakpointAction, &QAction::triggered, this, &MainWindow::toggleBreakpoint);
+    connect(conditionAction, &QAction::triggered, this, &MainWindow::editBreakpointCondition);
+    connect(watchpointAction, &QAction::triggered, this, &MainWindow::addWatchpoint);
+    connect(clearWatchpointsAction, &QAction::triggered, this, &MainWindow::clearWatchpoints);
+    connect(snapshotAction, &QAction::triggered, this, &MainWindow::markMemorySnapshot);
+    connect(memoryDiffAction, &QAction::triggered, this, &MainWindow::showMemoryDiff);
     connect(settingsAction, &QAction::triggered, this, &MainWindow::showSettingsDialog);
     connect(helpAction, &QAction::triggered, this, &MainWindow::showHelp);
+    connect(instructionHelpAction, &QAction::triggered, this, &MainWindow::showInstructionHelp);
+}
+
+void MainWindow::createDebugDocks() {
+    registerView = new RegisterView(this);
+    registerDock = new QDockWidget(tr("Registers"), this);
+    registerDock->setObjectName("registerDock");
+    registerDock->setWidget(registerView);
+    addDockWidget(Qt::RightDockWidgetArea, registerDock);
+    registerDock->hide();
+
+    QWidget* memoryPage = new QWidget(this);
+    QVBoxLayout* memoryLayout = new QVBoxLayout(memoryPage);
+    memoryLayout->setContentsMargins(0, 0, 0, 0);
+    followEdit = new QLineEdit(memoryPage);
+    followEdit->setPlaceholderText(tr("Follow address, e.g. DS:SI"));
+    commandEdit->setPlaceholderText(tr("DEBUG command: d, f, s, c, m"));
+    commandEdit = new QLineEdit(memoryPage);
+    commandEdit->setPlaceholderText(tr("DEBUG command: d, f, s, c, m"));
+    memoryView = new MemoryView(memoryPage);
+    memoryView->setEmulator(&debugSession->emulator());
+    QHBoxLayout* memoryInputLayout = new QHBoxLayout();
+    memoryInputLayout->addWidget(followEdit);
+    memoryInputLayout->addWidget(commandEdit);
+    memoryLayout->addLayout(memoryInputLayout);
+    memoryLayout->addWidget(memoryView);
+    memoryDock = new QDockWidget(tr("Memory"), this);
+    memoryDock->setObjectName("memoryDock");
+    memoryDock->setWidget(memoryPage);
+    addDockWidget(Qt::BottomDockWidgetArea, memoryDock);
+    memoryDock->hide();
+    connect(followEdit, &QLineEdit::returnPressed, this, &MainWindow::followMemoryAddress);
+    connect(commandEdit, &QLineEdit::returnPressed, this, &MainWindow::executeDebugCommand);
 }
 
 void MainWindow::createToolBar() {
@@ -100,6 +195,32 @@ void MainWindow::createToolBar() {
     toolBar->addAction(helpAction);
 }
 
+void MainWindow::changeEvent(QEvent* event) {
+    if (event->type() == QEvent::LanguageChange) {
+        updateInterfaceTranslations();
+    }
+    QMainWindow::changeEvent(event);
+}
+
+void MainWindow::loadTranslation(const QString& language) {
+    qApp->removeTranslator(&translator);
+    QString langCode = (language == "Russian") ? "ru" : "en";
+    if (translator.load(QString(":/translations/DebugCrafter_%1.qm").arg(langCode))) {
+        qApp->installTranslator(&translator);
+    }
+}
+
+void MainWindow::createStatusBar() {
+    loadProgressBar = new QProgressBar(this);
+    loadProgressBar->setMaximumWidth(200);
+    loadProgressBar->setTextVisible(false);
+    cancelLoadButton = new QPushButton(tr("Cancel"), this);
+    statusBar()->addPermanentWidget(loadProgressBar);
+    statusBar()->addPermanentWidget(cancelLoadButton);
+    connect(cancelLoadButton, &QPushButton::clicked, this, &MainWindow::cancelLoading);
+    hideLoadProgress();
+}
+
 void MainWindow::updateInterfaceTranslations() {
     setWindowTitle(tr("Debug3000"));
     fileMenu->setTitle(tr("File"));
@@ -109,13 +230,33 @@ void MainWindow::updateInterfaceTranslations() {
     saveAsAction->setText(tr("Save As"));
     pasteCodeAction->setText(tr("Paste Code"));
     runAction->setText(tr("Run"));
+    assembleAction->setText(tr("Assemble to COM"));
+    exportScriptAction->setText(tr("Export as DEBUG Script"));
+    debugMenu->setTitle(tr("Debug"));
+    continueAction->setText(tr("Start / Continue"));
+    stepOverAction->setText(tr("Step Over"));
+    stepIntoAction->setText(tr("Step Into"));
+    stepOutAction->setText(tr("Step Out"));
+    runToCursorAction->setText(tr("Run to Cursor"));
+    stopDebugAction->setText(tr("Stop Debugging"));
+    breakpointAction->setText(tr("Toggle Breakpoint"));
+    conditionAction->setText(tr("Breakpoint Condition..."));
+    watchpointAction->setText(tr("Add Watchpoint..."));
+    clearWatchpointsAction->setText(tr("Clear Watchpoints"));
+    snapshotAction->setText(tr("Mark Memory Snapshot"));
+    memoryDiffAction->setText(tr("Diff Memory"));
+    registerDock->setWindowTitle(tr("Registers"));
+    memoryDock->setWindowTitle(tr("Memory"));
+    followEdit->setPlaceholderText(tr("Follow address, e.g. DS:SI"));
     settingsMenu->setTitle(tr("Settings"));
     settingsAction->setText(tr("Preferences"));
     helpMenu->setTitle(tr("Help"));
     helpAction->setText(tr("About Debug3000"));
+    instructionHelpAction->setText(tr("Help for Instruction"));
     toolBar->setWindowTitle(tr("Tools"));
+    cancelLoadButton->setText(tr("Cancel"));
     for (int i = 0; i < tabWidget->count(); ++i) {
-        if (tabWidget->tabText(i) == "New File" || tabWidget->tabText(i) == tr("New File")) {
+        if (editorTabs.contains(i) && editorTabs[i].filePath.isEmpty()) {
             tabWidget->setTabText(i, tr("New File"));
         }
     }
@@ -130,7 +271,6 @@ CodeEditor* MainWindow::getCurrentEditor() const {
 }
 
 void MainWindow::newFile() {
-    QMap<QString, QVariant> settings = settingsManager->loadSettings();
     CodeEditor* currentEditor = getCurrentEditor();
     if (currentEditor && currentEditor->document()->isModified()) {
         if (!promptSaveChanges(tabWidget->currentIndex())) {
@@ -138,27 +278,11 @@ void MainWindow::newFile() {
         }
     }
 
-    CodeEditor* editor = new CodeEditor();
-    QSplitter* splitter = new QSplitter(Qt::Vertical);
-    QTextEdit* outputConsole = new QTextEdit();
-    outputConsole->setReadOnly(true);
-    outputConsole->setMinimumHeight(100);
-    splitter->addWidget(editor);
-    splitter->addWidget(outputConsole);
-    splitter->setSizes({400, 100});
-    outputConsole->setVisible(settings["showOutputConsole"].toBool());
-    tabWidget->addTab(splitter, tr("New File"));
-    tabWidget->setCurrentWidget(splitter);
-    EditorTab tab = {editor, splitter, outputConsole, "", false};
-    editorTabs[tabWidget->currentIndex()] = tab;
-    updateTab(tabWidget->currentIndex(), settings);
-    if (settings["autoSave"].toBool()) {
-        connect(editor, &QPlainTextEdit::textChanged, this, &MainWindow::handleTextChanged);
-    }
+    tabWidget->setCurrentIndex(createTab("", tr("New File"), false));
 }
 
 void MainWindow::openFile() {
-    QString fileName = QFileDialog::getOpenFileName(this, tr("Open File"), "", tr("Text and COM Files (*.txt *.com *.COM);;All Files (*)"));
+    QString fileName = QFileDialog::getOpenFileName(this, tr("Open File"), "", tr("Text, Assembly and COM Files (*.txt *.asm *.com *.COM);;All Files (*)"));
     if (fileName.isEmpty()) return;
 
     for (int i = 0; i < tabWidget->count(); ++i) {
@@ -175,13 +299,56 @@ void MainWindow::openFile() {
         }
     }
 
-    QString content = fileController->openFile(fileName);
-    CodeEditor* editor = new CodeEditor();
-    editor->setText(content);
     bool isComFile = fileName.endsWith(".com", Qt::CaseInsensitive);
-    if (isComFile) {
-        editor->setReadOnly(true);
+    tabWidget->setCurrentIndex(createTab(fileName, QFileInfo(fileName).fileName(), isComFile));
+}
+
+int MainWindow::createTab(const QString& filePath, const QString& title, bool isReadOnly) {
+    QWidget* page = new QWidget();
+    QVBoxLayout* layout = new QVBoxLayout(page);
+    layout->setContentsMargins(0, 0, 0, 0);
+
+    EditorTab tab;
+    tab.page = page;
+    tab.filePath = filePath;
+    tab.isReadOnly = isReadOnly;
+    tab.lastActive = QDateTime::currentDateTime();
+    int index = tabWidget->count();
+    editorTabs[index] = tab;
+    tabWidget->addTab(page, title);
+    return index;
+}
+
+void MainWindow::materializeTab(int index) {
+    EditorTab& tab = editorTabs[index];
+    if (tab.editor || tab.viewer) return;
+
+    if (!tab.filePath.isEmpty() && QFileInfo(tab.filePath).size() > LARGE_FILE_VIEW_THRESHOLD) {
+        LargeFileView* viewer = new LargeFileView();
+        viewer->openFile(tab.filePath);
+        tab.page->layout()->addWidget(viewer);
+        tab.viewer = viewer;
+        tab.isReadOnly = true;
+        tab.pendingSettings = EditorSettings::allKeys();
+        updateTab(index, tab.pendingSettings);
+        connect(viewer, &LargeFileView::indexingFinished, viewer, [viewer, line = tab.cursorPosition]() {
+            viewer->goToLine(line);
+        });
+        return;
     }
+
+    CodeEditor* editor = new CodeEditor();
+    editor->setSourceMode(tab.filePath.endsWith(".asm"));
+    FileLoader* loader = nullptr;
+    if (!tab.filePath.isEmpty()) {
+        loader = fileController->openFileAsync(tab.filePath, editor);
+        if (!loader) {
+            editor->setText(fileController->openFile(tab.filePath));
+            editor->document()->setModified(false);
+        }
+    }
+    editor->setReadOnly(tab.isReadOnly);
+
     QSplitter* splitter = new QSplitter(Qt::Vertical);
     QTextEdit* outputConsole = new QTextEdit();
     outputConsole->setReadOnly(true);
@@ -189,27 +356,179 @@ void MainWindow::openFile() {
     splitter->addWidget(editor);
     splitter->addWidget(outputConsole);
     splitter->setSizes({400, 100});
-    QMap<QString, QVariant> settings = settingsManager->loadSettings();
-    outputConsole->setVisible(settings["showOutputConsole"].toBool());
-    tabWidget->addTab(splitter, QFileInfo(fileName).fileName());
-    tabWidget->setCurrentWidget(splitter);
-    EditorTab tab = {editor, splitter, outputConsole, fileName, isComFile};
-    editorTabs[tabWidget->currentIndex()] = tab;
-    updateTab(tabWidget->currentIndex(), settings);
-    if (settings["autoSave"].toBool() && !isComFile) {
-        connect(editor, &QPlainTextEdit::textChanged, this, &MainWindow::handleTextChanged);
+    outputConsole->setVisible(settingsManager->currentSettings().showOutputConsole);
+    tab.page->layout()->addWidget(splitter);
+
+    tab.editor = editor;
+    tab.splitter = splitter;
+    tab.outputConsole = outputConsole;
+    tab.loader = loader;
+    tab.pendingSettings = EditorSettings::allKeys();
+    updateTab(index, tab.pendingSettings);
+
+    if (loader) {
+        startLoading(editor, loader);
+    } else {
+        restoreEditorPosition(index);
+    }
+
+    if (!tab.isReadOnly) {
+        connect(editor, &CodeEditor::contentChanged, this, &MainWindow::handleTextChanged);
+    }
+    connect(editor, &CodeEditor::contentChanged, this, [this, editor]() {
+        if (editor == debugEditor) debugSession->stop();
+    });
+    connect(editor, &CodeEditor::breakpointsChanged, this, [this, editor]() {
+        if (editor == debugEditor) debugSession->setBreakpoints(editor->breakpointConditions());
+    });
+}
+
+void MainWindow::startLoading(CodeEditor* editor, FileLoader* loader) {
+    editor->beginBulkLoad();
+    connect(loader, &FileLoader::chunkLoaded, editor, &CodeEditor::appendChunk);
+    connect(loader, &FileLoader::progress, editor, [this, editor](qint64 bytesRead, qint64 totalBytes) {
+        if (getCurrentEditor() == editor) {
+            showLoadProgress(bytesRead, totalBytes);
+        }
+    });
+    connect(loader, &FileLoader::finished, editor, [this, editor, loader](bool completed) {
+        editor->endBulkLoad();
+        int index = indexOfEditor(editor);
+        if (index >= 0) {
+            EditorTab& tab = editorTabs[index];
+            tab.loader = nullptr;
+            if (!completed) {
+                tab.isPartiallyLoaded = true;
+                editor->setReadOnly(true);
+                statusBar()->showMessage(tr("Loading of '%1' was cancelled; the tab is read-only.").arg(tabWidget->tabText(index)), 5000);
+            }
+            restoreEditorPosition(index);
+        }
+        if (getCurrentEditor() == editor) {
+            hideLoadProgress();
+        }
+        loader->deleteLater();
+    });
+    loader->start();
+}
+
+void MainWindow::cancelLoading() {
+    int index = tabWidget->currentIndex();
+    if (editorTabs.contains(index) && editorTabs[index].loader) {
+        editorTabs[index].loader->cancel();
+    }
+}
+
+void MainWindow::showLoadProgress(qint64 bytesRead, qint64 totalBytes) {
+    loadProgressBar->setRange(0, 1000);
+    loadProgressBar->setValue(totalBytes > 0 ? int(bytesRead * 1000 / totalBytes) : 1000);
+    loadProgressBar->setVisible(true);
+    cancelLoadButton->setVisible(true);
+}
+
+void MainWindow::hideLoadProgress() {
+    loadProgressBar->setVisible(false);
+    cancelLoadButton->setVisible(false);
+}
+
+void MainWindow::restoreEditorPosition(int index) {
+    EditorTab& tab = editorTabs[index];
+    if (tab.cursorPosition > 0) {
+        QTextCursor cursor = tab.editor->textCursor();
+        cursor.setPosition(qMin(tab.cursorPosition, tab.editor->document()->characterCount() - 1));
+        tab.editor->setTextCursor(cursor);
+    }
+    tab.editor->verticalScrollBar()->setValue(tab.scrollPosition);
+}
+
+int MainWindow::indexOfEditor(const CodeEditor* editor) const {
+    for (auto it = editorTabs.constBegin(); it != editorTabs.constEnd(); ++it) {
+        if (it.value().editor == editor) {
+            return it.key();
+        }
+    }
+    return -1;
+}
+
+void MainWindow::dematerializeTab(int index) {
+    EditorTab& tab = editorTabs[index];
+    if (!tab.editor || tab.loader || tab.isPartiallyLoaded || tab.filePath.isEmpty()
+        || tab.editor->document()->isModified() || !tab.outputConsole->document()->isEmpty()) {
+        return;
+    }
+
+    tab.cursorPosition = tab.editor->textCursor().position();
+    tab.scrollPosition = tab.editor->verticalScrollBar()->value();
+    delete tab.splitter;
+    tab.editor = nullptr;
+    tab.splitter = nullptr;
+    tab.outputConsole = nullptr;
+    tab.pendingSettings.clear();
+}
+
+void MainWindow::unloadIdleTabs() {
+    if (!settingsManager->currentSettings().unloadIdleTabs) return;
+
+    const QDateTime threshold = QDateTime::currentDateTime().addSecs(-IDLE_TAB_TIMEOUT_SECONDS);
+    int current = tabWidget->currentIndex();
+    for (int i = 0; i < tabWidget->count(); ++i) {
+        if (i != current && editorTabs[i].lastActive < threshold) {
+            dematerializeTab(i);
+        }
     }
 }
 
+void MainWindow::saveSession() {
+    QList<SessionTab> session;
+    for (int i = 0; i < tabWidget->count(); ++i) {
+        const EditorTab& tab = editorTabs[i];
+        if (tab.filePath.isEmpty() || tab.filePath.endsWith("temp_run.txt")) continue;
+        SessionTab entry;
+        entry.filePath = tab.filePath;
+        entry.cursorPosition = tab.editor ? tab.editor->textCursor().position()
+                             : tab.viewer ? tab.viewer->currentLine() : tab.cursorPosition;
+        entry.scrollPosition = tab.editor ? tab.editor->verticalScrollBar()->value() : tab.scrollPosition;
+        entry.current = (i == tabWidget->currentIndex());
+        session.append(entry);
+    }
+    settingsManager->saveSession(session);
+}
+
+void MainWindow::restoreSession() {
+    int currentIndex = -1;
+    const QList<SessionTab> session = settingsManager->loadSession();
+    {
+        QSignalBlocker blocker(tabWidget);
+        for (const SessionTab& entry : session) {
+            if (!QFileInfo::exists(entry.filePath)) continue;
+            bool isComFile = entry.filePath.endsWith(".com", Qt::CaseInsensitive);
+            int index = createTab(entry.filePath, QFileInfo(entry.filePath).fileName(), isComFile);
+            editorTabs[index].cursorPosition = entry.cursorPosition;
+            editorTabs[index].scrollPosition = entry.scrollPosition;
+            if (entry.current) {
+                currentIndex = index;
+            }
+        }
+        if (currentIndex >= 0) {
+            tabWidget->setCurrentIndex(currentIndex);
+        }
+    }
+    onCurrentTabChanged(tabWidget->currentIndex());
+}
+
 void MainWindow::saveFile() {
     CodeEditor* editor = getCurrentEditor();
-    if (!editor) return;
+    if (!editor || editor->isLoading()) return;
 
     int index = tabWidget->currentIndex();
     if (editorTabs[index].isReadOnly) {
         QMessageBox::warning(this, tr("Read-Only File"), tr("Cannot save a read-only COM file."));
         return;
     }
+    if (editorTabs[index].isPartiallyLoaded) {
+        QMessageBox::warning(this, tr("Partially Loaded File"), tr("The file was only partially loaded and cannot be saved."));
+        return;
+    }
 
     QString fileName = editorTabs[index].filePath;
     if (fileName.isEmpty() || tabWidget->tabText(index) == tr("New File")) {
@@ -226,7 +545,7 @@ void MainWindow::saveFile() {
 
 void MainWindow::saveFileAs() {
     CodeEditor* editor = getCurrentEditor();
-    if (!editor) return;
+    if (!editor || editor->isLoading()) return;
 
     int index = tabWidget->currentIndex();
     if (editorTabs[index].isReadOnly) {
@@ -234,13 +553,14 @@ void MainWindow::saveFileAs() {
         return;
     }
 
-    QString fileName = QFileDialog::getSaveFileName(this, tr("Save File As"), "", tr("Text Files (*.txt);;All Files (*)"));
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Save File As"), "", tr("Text Files (*.txt);;Assembly Source (*.asm);;All Files (*)"));
     if (!fileName.isEmpty()) {
         if (fileController->saveAsFile(fileName, editor->getText())) {
             tabWidget->setTabText(index, QFileInfo(fileName).fileName());
             editorTabs[index].filePath = fileName;
             editorTabs[index].isReadOnly = false;
             editor->setReadOnly(false);
+            editor->setSourceMode(fileName.endsWith(".asm"));
             editor->document()->setModified(false);
         }
     }
@@ -292,8 +612,20 @@ void MainWindow::run() {
         return;
     }
 
-    QMap<QString, QVariant> settings = settingsManager->loadSettings();
-    bool autoSave = settings["autoSave"].toBool();
+    if (editor->isSourceMode()) {
+        AssemblyResult result;
+        if (!assembleCurrentEditor(result)) return;
+        QString comName = QCoreApplication::applicationDirPath() + "/out.com";
+        if (!fileController->saveComImage(comName, result.image)) {
+            qDebug() << "Failed to write assembled image for execution:" << comName;
+            QMessageBox::warning(this, tr("Save Error"), tr("Failed to save the assembled COM file for execution."));
+            return;
+        }
+        fileController->compileAndRunCom(comName);
+        return;
+    }
+
+    bool autoSave = settingsManager->currentSettings().autoSave;
 
     if (isComFile) {
         fileController->compileAndRunCom(fileName);
@@ -337,6 +669,219 @@ void MainWindow::run() {
     }
 }
 
+bool MainWindow::assembleCurrentEditor(AssemblyResult& result) {
+    CodeEditor* editor = getCurrentEditor();
+    if (!editor || editor->isLoading()) return false;
+
+    int index = tabWidget->currentIndex();
+    result = editor->assembly();
+    if (result.isValid()) {
+        updateOutputConsole(index, tr("Assembled %1 bytes at %2.")
+                                       .arg(result.image.size())
+                                       .arg(QString("%1").arg(result.origin, 4, 16, QChar('0')).toUpper()));
+        return true;
+    }
+
+    QStringList messages;
+    for (const AssemblyError& error : result.errors) {
+        messages.append(tr("Line %1: %2").arg(error.line + 1).arg(error.message));
+    }
+    updateOutputConsole(index, messages.join('\n'));
+    QMessageBox::warning(this, tr("Assembly Failed"), messages.mid(0, 10).join('\n'));
+    return false;
+}
+
+void MainWindow::assembleToCom() {
+    AssemblyResult result;
+    if (!assembleCurrentEditor(result)) return;
+
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Save COM File"), "", tr("COM Files (*.com);;All Files (*)"));
+    if (fileName.isEmpty()) return;
+    if (!fileController->saveComImage(fileName, result.image)) {
+        QMessageBox::warning(this, tr("Save Error"), tr("Failed to write the COM file."));
+    }
+}
+
+void MainWindow::exportDebugScript() {
+    AssemblyResult result;
+    if (!assembleCurrentEditor(result)) return;
+
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Export DEBUG Script"), "", tr("Text Files (*.txt);;All Files (*)"));
+    if (fileName.isEmpty()) return;
+
+    QString comName = QFileInfo(fileName).completeBaseName().left(8).toUpper() + ".COM";
+    if (!fileController->saveFile(fileName, Assembler::toDebugScript(result, comName))) {
+        QMessageBox::warning(this, tr("Save Error"), tr("Failed to write the DEBUG script."));
+    }
+}
+
+// Starts a session on the current editor when it has none; true when one was already paused there.
+bool MainWindow::prepareDebugSession() {
+    CodeEditor* editor = getCurrentEditor();
+    if (!editor || editor->isLoading()) return false;
+    if (debugSession->isActive() && editor == debugEditor) return !debugSession->isRunning();
+    debugSession->stop();
+
+    const int index = tabWidget->currentIndex();
+    if (editor->isSourceMode()) {
+        AssemblyResult result;
+        if (!assembleCurrentEditor(result)) return false;
+    } else {
+        updateOutputConsole(index, QString());
+    }
+    debugEditor = editor;
+    registerDock->show();
+    debugSession->start(editor->programImage(), quint16(editor->entryPoint()), editor->breakpointConditions());
+    return false;
+}
+
+void MainWindow::toggleBreakpoint() {
+    CodeEditor* editor = getCurrentEditor();
+    if (editor) editor->toggleBreakpoint(editor->textCursor().blockNumber());
+}
+
+void MainWindow::editBreakpointCondition() {
+    CodeEditor* editor = getCurrentEditor();
+    if (!editor) return;
+    const int line = editor->textCursor().blockNumber();
+    if (editor->addressForLine(line) < 0) return;
+
+    QString condition = editor->breakpointCondition(line);
+    forever {
+        bool ok;
+        condition = QInputDialog::getText(this, tr("Breakpoint Condition"),
+                                          tr("Stop only when this expression is non-zero (empty to always stop),\n"
+                                             "for example CX==0 or BYTE ES:[DI]==24:"),
+                                          QLineEdit::Normal, condition, &ok);
+        if (!ok) return;
+        QString error;
+        if (condition.trimmed().isEmpty() || ConditionExpression::compile(condition, &error).isValid()) break;
+        QMessageBox::warning(this, tr("Breakpoint Condition"), error);
+    }
+    editor->setBreakpointCondition(line, condition);
+}
+
+void MainWindow::addWatchpoint() {
+    bool ok;
+    const QString text = QInputDialog::getText(this, tr("Add Watchpoint"),
+                                               tr("Stop when these bytes are written, for example [BX+SI] or ES:DI,2.\n"
+                                                  "Registers are read each time the program is run or stepped:"),
+                                               QLineEdit::Normal, QString(), &ok);
+    if (!ok || text.trimmed().isEmpty()) return;
+    QString error;
+    if (!debugSession->addWatchpoint(text, &error)) {
+        QMessageBox::warning(this, tr("Add Watchpoint"), error);
+    }
+}
+
+void MainWindow::clearWatchpoints() {
+    debugSession->clearWatchpoints();
+}
+
+void MainWindow::markMemorySnapshot() {
+    if (!debugSession->isActive() || debugSession->isRunning()) return;
+    debugSession->markSnapshot();
+    statusBar()->showMessage(tr("Memory snapshot marked."));
+}
+
+// Also works after the program has exited, the emulator keeps its memory until the next session.
+void MainWindow::showMemoryDiff() {
+    if (debugSession->isRunning()) return;
+    CodeEditor* editor = debugEditor ? debugEditor.data() : getCurrentEditor();
+    appendOutputConsole(indexOfEditor(editor), "\n" + debugSession->memoryDiff());
+}
+
+void MainWindow::debugContinue() {
+    prepareDebugSession();
+    debugSession->resume();
+}
+
+void MainWindow::debugStepInto() {
+    if (prepareDebugSession()) debugSession->stepInto();
+}
+
+void MainWindow::debugStepOver() {
+    if (prepareDebugSession()) debugSession->stepOver();
+}
+
+void MainWindow::debugStepOut() {
+    if (prepareDebugSession()) debugSession->stepOut();
+}
+
+void MainWindow::debugRunToCursor() {
+    prepareDebugSession();
+    if (!debugEditor || debugEditor != getCurrentEditor()) return;
+    const int address = debugEditor->addressForLine(debugEditor->textCursor().blockNumber());
+    if (address >= 0) debugSession->runTo(address);
+}
+
+void MainWindow::stopDebugging() {
+    debugSession->stop();
+}
+
+void MainWindow::onDebugPaused() {
+    if (!debugEditor) {
+        debugSession->stop();
+        return;
+    }
+    const CpuState& state = debugSession->emulator().state();
+    debugEditor->setExecutionAddress(state.segments[Emulator::CS] == Emulator::PROGRAM_SEGMENT ? state.ip : -1);
+    registerView->setState(state, debugSession->previousState(), debugSession->currentInstruction(),
+                           debugSession->currentFlagsRead(), debugSession->lastLatency(), debugSession->lastClocks());
+    statusBar()->showMessage(debugSession->stopDescription());
+    updateMemoryView();
+}
+
+void MainWindow::followMemoryAddress() {
+    const QString text = followEdit->text().trimmed();
+    QString error;
+    followAddress = text.isEmpty() ? AddressExpression() : AddressExpression::compile(text, &error);
+    if (!text.isEmpty() && !followAddress.isValid()) {
+        statusBar()->showMessage(error);
+    }
+    updateMemoryView();
+}
+
+void MainWindow::executeDebugCommand() {
+    const QString command = commandEdit->text().trimmed();
+    if (command.isEmpty()) return;
+    QString output;
+    QString error;
+    if (!debugSession->executeCommand(command, &output, &error)) {
+        statusBar()->showMessage(error);
+        return;
+    }
+    CodeEditor* editor = debugEditor ? debugEditor.data() : getCurrentEditor();
+    appendOutputConsole(indexOfEditor(editor), "\n-" + command + "\n" + output);
+    commandEdit->clear();
+    updateMemoryView();
+}
+
+void MainWindow::updateMemoryView() {
+    if (followAddress.isValid()) {
+        const quint32 address = followAddress.evaluate(debugSession->emulator());
+        memoryView->setMarkedAddress(address);
+        memoryView->scrollToAddress(address);
+    } else {
+        memoryView->setMarkedAddress(-1);
+    }
+    memoryView->refresh();
+}
+
+void MainWindow::onDebugOutput(const QString& text) {
+    appendOutputConsole(indexOfEditor(debugEditor), text);
+}
+
+void MainWindow::onDebugFinished(const QString& message) {
+    if (debugEditor) {
+        debugEditor->setExecutionAddress(-1);
+        appendOutputConsole(indexOfEditor(debugEditor), "\n" + message);
+    }
+    debugEditor = nullptr;
+    registerView->clear();
+    updateMemoryView();
+}
+
 void MainWindow::onCompileAndRunFinished(const QString& output) {
     int index = tabWidget->currentIndex();
     if (editorTabs.contains(index)) {
@@ -353,106 +898,119 @@ void MainWindow::showSettingsDialog() {
     SettingsDialog* dialog = new SettingsDialog(this);
     dialog->setSettings(settingsManager->loadSettings());
     connect(dialog, &SettingsDialog::saveSettingsRequested, settingsManager, &SettingsManager::saveSettings);
-    connect(dialog, &SettingsDialog::saveSettingsRequested, this, &MainWindow::updateEditors);
     connect(dialog, &SettingsDialog::languageChanged, this, &MainWindow::onLanguageChanged);
-    connect(dialog, &SettingsDialog::saveSettingsRequested, this, [this](const QMap<QString, QVariant>& settings) {
-        bool autoSave = settings["autoSave"].toBool();
-        for (int i = 0; i < tabWidget->count(); ++i) {
-            CodeEditor* editor = editorTabs[i].editor;
-            if (editor && !editorTabs[i].isReadOnly) {
-                disconnect(editor, &QPlainTextEdit::textChanged, this, &MainWindow::handleTextChanged);
-                if (autoSave) {
-                    connect(editor, &QPlainTextEdit::textChanged, this, &MainWindow::handleTextChanged);
-                }
-            }
-        }
-    });
     dialog->exec();
     delete dialog;
 }
 
 void MainWindow::showHelp() {
     if (!helpWindow) {
-        helpWindow = new QMainWindow(this);
-        helpWindow->setWindowTitle(tr("Debug3000 Help"));
-        helpWindow->setMinimumSize(800, 600);
-
-        helpView = new QWebEngineView(helpWindow);
-        QVBoxLayout* layout = new QVBoxLayout;
-        layout->addWidget(helpView);
-        QWidget* centralWidget = new QWidget;
-        centralWidget->setLayout(layout);
-        helpWindow->setCentralWidget(centralWidget);
-
-        helpView->load(QUrl("qrc:/help/help.html"));
-        connect(helpView, &QWebEngineView::loadFinished, this, [this](bool ok) {
-            if (!ok) {
-                QMessageBox::warning(this, tr("Error"), tr("Failed to load help file."));
-            }
-        });
+        helpWindow = new HelpBrowser(this);
     }
     helpWindow->show();
     helpWindow->raise();
     helpWindow->activateWindow();
 }
 
-void MainWindow::updateEditors(const QMap<QString, QVariant>& settings) {
-    for (int i = 0; i < tabWidget->count(); ++i) {
-        updateTab(i, settings);
+void MainWindow::showInstructionHelp() {
+    showHelp();
+    CodeEditor* editor = getCurrentEditor();
+    if (editor) {
+        helpWindow->showTopicForKeyword(editor->wordUnderCursor());
     }
 }
 
-void MainWindow::onLanguageChanged(const QString& language) {
+void MainWindow::updateEditors(const EditorSettings& settings, const QSet<QString>& changedKeys) {
+    if (changedKeys.contains("font")) {
+        memoryView->setFont(settings.font);
+    }
+    if (changedKeys.contains("backgroundColor") || changedKeys.contains("textColor") || changedKeys.contains("highlightColor")) {
+        memoryView->setColors(settings.backgroundColor, settings.textColor, settings.highlightColor);
+    }
+    int current = tabWidget->currentIndex();
     for (int i = 0; i < tabWidget->count(); ++i) {
-        if (!promptSaveChanges(i)) {
-            return;
+        editorTabs[i].pendingSettings |= changedKeys;
+        if (i == current) {
+            updateTab(i, editorTabs[i].pendingSettings);
         }
     }
+}
+
+void MainWindow::onCurrentTabChanged(int index) {
+    if (editorTabs.contains(previousTabIndex)) {
+        editorTabs[previousTabIndex].lastActive = QDateTime::currentDateTime();
+    }
+    previousTabIndex = index;
+    if (!editorTabs.contains(index)) return;
 
-    QMap<QString, QVariant> settings = settingsManager->loadSettings();
+    editorTabs[index].lastActive = QDateTime::currentDateTime();
+    if (!editorTabs[index].editor && !editorTabs[index].viewer) {
+        materializeTab(index);
+    } else if (!editorTabs[index].pendingSettings.isEmpty()) {
+        updateTab(index, editorTabs[index].pendingSettings);
+    }
+    if (!editorTabs[index].loader) {
+        hideLoadProgress();
+    }
+}
+
+void MainWindow::onLanguageChanged(const QString& language) {
+    if (language == settingsManager->currentSettings().language) {
+        return;
+    }
+
+    QMap<QString, QVariant> settings;
     settings["language"] = language;
     settingsManager->saveSettings(settings);
-    updateInterfaceTranslations();
-    isLanguageChangeClosing = true;
-    QProcess::startDetached(qApp->arguments()[0], qApp->arguments());
-    close();
+    loadTranslation(language);
 }
 
 void MainWindow::handleTextChanged() {
-    QMap<QString, QVariant> settings = settingsManager->loadSettings();
-    if (settings["autoSave"].toBool()) {
+    CodeEditor* editor = qobject_cast<CodeEditor*>(sender());
+    if (!editor || editor->isLoading() || editor != getCurrentEditor()) return;
+    if (settingsManager->currentSettings().autoSave) {
         saveFile();
     }
 }
 
-void MainWindow::updateTab(int index, const QMap<QString, QVariant>& settings) {
+void MainWindow::updateTab(int index, const QSet<QString>& changedKeys) {
     EditorTab& tab = editorTabs[index];
+    if (tab.viewer) {
+        const EditorSettings& settings = settingsManager->currentSettings();
+        if (changedKeys.contains("font")) {
+            tab.viewer->setFont(settings.font);
+        }
+        if (changedKeys.contains("backgroundColor") || changedKeys.contains("textColor") || changedKeys.contains("highlightColor")) {
+            tab.viewer->setColors(settings.backgroundColor, settings.textColor, settings.highlightColor);
+        }
+    }
     if (tab.editor) {
-        tab.editor->setTheme(settings["theme"].toString(),
-                             settings["backgroundColor"].value<QColor>(),
-                             settings["textColor"].value<QColor>(),
-                             settings["highlightColor"].value<QColor>());
-        tab.editor->setFont(settings["font"].value<QFont>());
-        tab.editor->setStandardLineNumbering(settings["standardLineNumbering"].toBool());
-        tab.editor->setAddressLineNumbering(settings["addressLineNumbering"].toBool());
-        tab.editor->setLineWrap(settings["lineWrap"].toBool());
-        tab.editor->setSyntaxHighlighting(settings["syntaxHighlighting"].toBool());
-        tab.editor->setShowMemoryDump(settings["showMemoryDump"].toBool(),
-                                      settings["memoryDumpSegment"].toString(),
-                                      settings["memoryDumpOffset"].toString(),
-                                      settings["memoryDumpLineCount"].toInt());
-        tab.outputConsole->setVisible(settings["showOutputConsole"].toBool());
+        const EditorSettings& settings = settingsManager->currentSettings();
+        tab.editor->applySettings(settings, changedKeys);
+        if (changedKeys.contains("showOutputConsole")) {
+            tab.outputConsole->setVisible(settings.showOutputConsole);
+        }
     }
+    tab.pendingSettings.clear();
 }
 
 void MainWindow::updateOutputConsole(int index, const QString& output) {
-    if (editorTabs.contains(index)) {
+    if (editorTabs.contains(index) && editorTabs[index].outputConsole) {
         editorTabs[index].outputConsole->setPlainText(output);
     }
 }
 
+void MainWindow::appendOutputConsole(int index, const QString& output) {
+    if (editorTabs.contains(index) && editorTabs[index].outputConsole) {
+        QTextEdit* console = editorTabs[index].outputConsole;
+        console->moveCursor(QTextCursor::End);
+        console->insertPlainText(output);
+        console->ensureCursorVisible();
+    }
+}
+
 bool MainWindow::promptSaveChanges(int index) {
-    if (!editorTabs.contains(index) || !editorTabs[index].editor->document()->isModified() || editorTabs[index].isReadOnly) {
+    if (!editorTabs.contains(index) || !editorTabs[index].editor || !editorTabs[index].editor->document()->isModified() || editorTabs[index].isReadOnly) {
         return true;
     }
 
@@ -6,13 +6,26 @@
 #include <QMap>
 #include <QVariant>
 #include <QTranslator>
-#include <QWebEngineView>
 #include <QSplitter>
 #include <QTextEdit>
+#include <QTimer>
+#include <QDateTime>
+#include <QProgressBar>
+#include <QPushButton>
+#include <QPointer>
 #include "codeeditor.h"
 #include "settingsmanager.h"
 #include "settingsdialog.h"
 #include "filecontroller.h"
+#include "helpbrowser.h"
+#include "largefileview.h"
+#include "assembler.h"
+#include "debugsession.h"
+#include "registerview.h"
+#include "memoryview.h"
+
+class QDockWidget;
+class QLineEdit;
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
@@ -21,6 +34,7 @@ public:
     ~MainWindow();
 protected:
     void closeEvent(QCloseEvent* event) override;
+    void changeEvent(QEvent* event) override;
 private slots:
     void newFile();
     void openFile();
@@ -28,13 +42,40 @@ private slots:
     void saveFileAs();
     void pasteCode();
     void run();
+    void assembleToCom();
+    void exportDebugScript();
     void onCompileAndRunFinished(const QString& output);
     void showSettingsDialog();
     void showHelp();
-    void updateEditors(const QMap<QString, QVariant>& settings);
+    void showInstructionHelp();
+    void updateEditors(const EditorSettings& settings, const QSet<QString>& changedKeys);
+    void onCurrentTabChanged(int index);
     void onLanguageChanged(const QString& language);
     void handleTextChanged();
+    void unloadIdleTabs();
+    void cancelLoading();
+    void toggleBreakpoint();
+    void editBreakpointCondition();
+    void addWatchpoint();
+    void clearWatchpoints();
+    void markMemorySnapshot();
+    void showMemoryDiff();
+    void debugContinue();
+    void debugStepInto();
+    void debugStepOver();
+    void debugStepOut();
+    void debugRunToCursor();
+    void stopDebugging();
+    void onDebugPaused();
+    void onDebugOutput(const QString& text);
+    void onDebugFinished(const QString& message);
+    void followMemoryAddress();
+    void executeDebugCommand();
 private:
+    static constexpr int IDLE_TAB_CHECK_INTERVAL_MS = 60000;
+    static constexpr int IDLE_TAB_TIMEOUT_SECONDS = 600;
+    static constexpr qint64 LARGE_FILE_VIEW_THRESHOLD = 8 * 1024 * 1024;
+
     QTabWidget* tabWidget;
     SettingsManager* settingsManager;
     FileController* fileController;
@@ -45,31 +86,83 @@ private:
     QAction* saveAsAction;
     QAction* pasteCodeAction;
     QAction* runAction;
+    QAction* assembleAction;
+    QAction* exportScriptAction;
     QAction* settingsAction;
     QAction* helpAction;
+    QAction* instructionHelpAction;
+    QAction* breakpointAction;
+    QAction* conditionAction;
+    QAction* watchpointAction;
+    QAction* clearWatchpointsAction;
+    QAction* snapshotAction;
+    QAction* memoryDiffAction;
+    QAction* continueAction;
+    QAction* stepIntoAction;
+    QAction* stepOverAction;
+    QAction* stepOutAction;
+    QAction* runToCursorAction;
+    QAction* stopDebugAction;
     QMenu* fileMenu;
+    QMenu* debugMenu;
     QMenu* settingsMenu;
     QMenu* helpMenu;
     QToolBar* toolBar;
-    QWebEngineView* helpView;
-    QMainWindow* helpWindow;
-    bool isLanguageChangeClosing;
+    HelpBrowser* helpWindow;
+    QTimer* idleTabTimer;
+    QProgressBar* loadProgressBar;
+    QPushButton* cancelLoadButton;
+    DebugSession* debugSession;
+    QPointer<CodeEditor> debugEditor;
+    QDockWidget* registerDock;
+    RegisterView* registerView;
+    QDockWidget* memoryDock;
+    MemoryView* memoryView;
+    QLineEdit* followEdit;
+    QLineEdit* commandEdit;
+    AddressExpression followAddress;
+    int previousTabIndex;
     bool promptSaveChanges(int index);
     void createMenus();
     void createToolBar();
+    void createStatusBar();
     void updateInterfaceTranslations();
+    void loadTranslation(const QString& language);
     CodeEditor* getCurrentEditor() const;
+    bool assembleCurrentEditor(AssemblyResult& result);
+    bool prepareDebugSession();
+    void createDebugDocks();
+    void updateMemoryView();
 
     struct EditorTab {
-        CodeEditor* editor;
-        QSplitter* splitter;
-        QTextEdit* outputConsole;
+        QWidget* page = nullptr;
+        CodeEditor* editor = nullptr;
+        LargeFileView* viewer = nullptr;
+        QSplitter* splitter = nullptr;
+        QTextEdit* outputConsole = nullptr;
         QString filePath;
-        bool isReadOnly;
+        bool isReadOnly = false;
+        QSet<QString> pendingSettings;
+        int cursorPosition = 0;
+        int scrollPosition = 0;
+        QDateTime lastActive;
+        FileLoader* loader = nullptr;
+        bool isPartiallyLoaded = false;
     };
     QMap<int, EditorTab> editorTabs;
     void updateOutputConsole(int index, const QString& output);
-    void updateTab(int index, const QMap<QString, QVariant>& settings);
+    void appendOutputConsole(int index, const QString& output);
+    void updateTab(int index, const QSet<QString>& changedKeys);
+    int createTab(const QString& filePath, const QString& title, bool isReadOnly);
+    void materializeTab(int index);
+    void dematerializeTab(int index);
+    void startLoading(CodeEditor* editor, FileLoader* loader);
+    void showLoadProgress(qint64 bytesRead, qint64 totalBytes);
+    void hideLoadProgress();
+    void restoreEditorPosition(int index);
+    int indexOfEditor(const CodeEditor* editor) const;
+    void saveSession();
+    void restoreSession();
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,107 @@
+#include "memorydiff.h"
+#include <QStringList>
+#include <cstring>
+#include "instructiondecoder.h"
+
+namespace {
+
+const int PAGE_SIZE = 1 << Emulator::DIRTY_PAGE_SHIFT;
+
+QString linearText(quint32 address) {
+    return QString("%1").arg(address, 5, 16, QChar('0')).toUpper();
+}
+
+// Linear addresses inside the program are shown in its segment, everything else in the canonical xxxx0 form.
+QString segmentedText(quint32 address) {
+    const quint32 base = quint32(Emulator::PROGRAM_SEGMENT) << 4;
+    const quint32 segment = address - base < 0x10000 ? Emulator::PROGRAM_SEGMENT : (address >> 4) & 0xF000;
+    return InstructionDecoder::hexWord(segment) + ':' + InstructionDecoder::hexWord(address - (segment << 4));
+}
+
+QString bytesText(const QByteArray& bytes, int limit) {
+    QStringList parts;
+    for (int i = 0; i < bytes.size() && i < limit; ++i) {
+        parts.append(InstructionDecoder::hexByte(quint8(bytes[i])));
+    }
+    if (bytes.size() > limit) parts.append("...");
+    return parts.join(' ');
+}
+
+}
+
+QVector<MemoryChange> MemoryDiff::compare(const Emulator::Snapshot& snapshot, const Emulator& emulator) {
+    QVector<MemoryChange> changes;
+    if (!snapshot.isValid()) return changes;
+    const quint8* before = snapshot.memory.data();
+    const quint8* after = emulator.memoryData();
+    MemoryChange current;
+    bool open = false;
+
+    auto close = [&]() {
+        if (open) changes.append(current);
+        open = false;
+    };
+    auto add = [&](quint32 address) {
+        const quint32 writer = emulator.lastWriter(address);
+        if (!open || address != current.address + quint32(current.after.size()) || writer != current.writer) {
+            close();
+            current = MemoryChange();
+            current.address = address;
+            current.writer = writer;
+            open = true;
+        }
+        current.before.append(char(before[address]));
+        current.after.append(char(after[address]));
+    };
+
+    for (int page = 0; page < Emulator::DIRTY_PAGE_COUNT; ++page) {
+        const quint32 base = quint32(page) * PAGE_SIZE;
+        if (!emulator.pageWrittenSince(page, snapshot) || std::memcmp(before + base, after + base, PAGE_SIZE) == 0) {
+            close();
+            continue;
+        }
+        // Eight bytes per comparison; only differing words are looked at byte by byte.
+        for (quint32 offset = 0; offset < quint32(PAGE_SIZE); offset += sizeof(quint64)) {
+            quint64 oldWord, newWord;
+            std::memcpy(&oldWord, before + base + offset, sizeof(quint64));
+            std::memcpy(&newWord, after + base + offset, sizeof(quint64));
+            if (oldWord == newWord) {
+                close();
+                continue;
+            }
+            for (quint32 i = 0; i < sizeof(quint64); ++i) {
+                const quint32 address = base + offset + i;
+                if (before[address] != after[address]) {
+                    add(address);
+                } else {
+                    close();
+                }
+            }
+        }
+    }
+    close();
+    return changes;
+}
+
+QString MemoryDiff::format(const QVector<MemoryChange>& changes) {
+    if (changes.isEmpty()) return tr("No memory changes.") + '\n';
+    int total = 0;
+    for (const MemoryChange& change : changes) {
+        total += change.after.size();
+    }
+
+    QString text = tr("%1 bytes changed in %2 ranges:").arg(total).arg(changes.size()) + '\n';
+    for (int i = 0; i < changes.size() && i < MAX_LISTED_CHANGES; ++i) {
+        const MemoryChange& change = changes[i];
+        const quint32 last = change.address + quint32(change.after.size()) - 1;
+        text += QString("%1-%2  %3 -> %4  %5\n")
+                    .arg(linearText(change.address), linearText(last),
+                         bytesText(change.before, MAX_LISTED_BYTES), bytesText(change.after, MAX_LISTED_BYTES),
+                         change.writer == Emulator::COMMAND_WRITER ? tr("written by a debugger command")
+                                                                   : tr("written at %1").arg(segmentedText(change.writer)));
+    }
+    if (changes.size() > MAX_LISTED_CHANGES) {
+        text += tr("%1 more ranges not shown.").arg(changes.size() - MAX_LISTED_CHANGES) + '\n';
+    }
+    return text;
+}
@@ -0,0 +1,29 @@
+#ifndef MEMORYDIFF_H
+#define MEMORYDIFF_H
+
+#include <QCoreApplication>
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include "emulator.h"
+
+// A run of bytes that differ between a snapshot and the emulator's memory, all last written by one instruction.
+struct MemoryChange {
+    quint32 address = 0;
+    QByteArray before;
+    QByteArray after;
+    quint32 writer = 0;
+};
+
+// Compares a snapshot with the current memory; pages not written since the snapshot are skipped without reading them.
+class MemoryDiff {
+    Q_DECLARE_TR_FUNCTIONS(MemoryDiff)
+public:
+    static QVector<MemoryChange> compare(const Emulator::Snapshot& snapshot, const Emulator& emulator);
+    static QString format(const QVector<MemoryChange>& changes);
+private:
+    static constexpr int MAX_LISTED_CHANGES = 256;
+    static constexpr int MAX_LISTED_BYTES = 16;
+};
+
+#endif // MEMORYDIFF_H
@@ -0,0 +1,136 @@
+#include "memorykernels.h"
+#include <QtAlgorithms>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MEMORY_KERNELS_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+const char HEX_DIGITS[] = "0123456789ABCDEF";
+
+#ifdef MEMORY_KERNELS_SSE2
+const int VECTOR_SIZE = 16;
+
+inline __m128i load(const quint8* data) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+}
+
+inline void store(char* out, __m128i value) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), value);
+}
+
+// Nibbles 0..15 to '0'..'9', 'A'..'F'.
+inline __m128i hexCharacters(__m128i nibbles) {
+    const __m128i letters = _mm_and_si128(_mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9)), _mm_set1_epi8('A' - '0' - 10));
+    return _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')), letters);
+}
+#endif
+
+inline bool matchesRest(const quint8* candidate, const quint8* pattern, int patternSize) {
+    return patternSize <= 2 || std::memcmp(candidate + 1, pattern + 1, patternSize - 2) == 0;
+}
+
+}
+
+int MemoryKernels::find(const quint8* data, int size, const quint8* pattern, int patternSize) {
+    if (patternSize <= 0 || patternSize > size) return -1;
+    const int lastStart = size - patternSize;
+    int position = 0;
+#ifdef MEMORY_KERNELS_SSE2
+    // Candidates must match both the first and the last byte of the pattern, sixteen start positions at a time.
+    const __m128i first = _mm_set1_epi8(char(pattern[0]));
+    const __m128i last = _mm_set1_epi8(char(pattern[patternSize - 1]));
+    for (; position + VECTOR_SIZE - 1 <= lastStart; position += VECTOR_SIZE) {
+        const __m128i heads = _mm_cmpeq_epi8(load(data + position), first);
+        const __m128i tails = _mm_cmpeq_epi8(load(data + position + patternSize - 1), last);
+        unsigned mask = unsigned(_mm_movemask_epi8(_mm_and_si128(heads, tails)));
+        while (mask) {
+            const int candidate = position + int(qCountTrailingZeroBits(mask));
+            if (matchesRest(data + candidate, pattern, patternSize)) return candidate;
+            mask &= mask - 1;
+        }
+    }
+#endif
+    while (position <= lastStart) {
+        const void* head = std::memchr(data + position, pattern[0], size_t(lastStart - position + 1));
+        if (!head) return -1;
+        position = int(static_cast<const quint8*>(head) - data);
+        if (data[position + patternSize - 1] == pattern[patternSize - 1] && matchesRest(data + position, pattern, patternSize)) {
+            return position;
+        }
+        ++position;
+    }
+    return -1;
+}
+
+int MemoryKernels::mismatch(const quint8* first, const quint8* second, int size) {
+    int position = 0;
+#ifdef MEMORY_KERNELS_SSE2
+    for (; position + VECTOR_SIZE <= size; position += VECTOR_SIZE) {
+        const unsigned equal = unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(load(first + position), load(second + position))));
+        if (equal != 0xFFFF) return position + int(qCountTrailingZeroBits(~equal & 0xFFFF));
+    }
+#endif
+    for (; position < size; ++position) {
+        if (first[position] != second[position]) return position;
+    }
+    return -1;
+}
+
+void MemoryKernels::fill(quint8* data, int size, const quint8* pattern, int patternSize) {
+    if (size <= 0 || patternSize <= 0) return;
+    if (patternSize == 1) {
+        std::memset(data, pattern[0], size_t(size));
+        return;
+    }
+    // Lay the pattern down once, then keep doubling the filled prefix.
+    int filled = qMin(patternSize, size);
+    std::memcpy(data, pattern, size_t(filled));
+    while (filled < size) {
+        const int chunk = qMin(filled, size - filled);
+        std::memcpy(data + filled, data, size_t(chunk));
+        filled += chunk;
+    }
+}
+
+void MemoryKernels::move(quint8* target, const quint8* source, int size) {
+    if (size > 0) std::memmove(target, source, size_t(size));
+}
+
+void MemoryKernels::formatHex(const quint8* data, int size, char* out) {
+    int position = 0;
+#ifdef MEMORY_KERNELS_SSE2
+    const __m128i lowNibble = _mm_set1_epi8(0x0F);
+    for (; position + VECTOR_SIZE <= size; position += VECTOR_SIZE) {
+        const __m128i bytes = load(data + position);
+        const __m128i high = _mm_and_si128(_mm_srli_epi16(bytes, 4), lowNibble);
+        const __m128i low = _mm_and_si128(bytes, lowNibble);
+        store(out + 2 * position, hexCharacters(_mm_unpacklo_epi8(high, low)));
+        store(out + 2 * position + VECTOR_SIZE, hexCharacters(_mm_unpackhi_epi8(high, low)));
+    }
+#endif
+    for (; position < size; ++position) {
+        out[2 * position] = HEX_DIGITS[data[position] >> 4];
+        out[2 * position + 1] = HEX_DIGITS[data[position] & 0x0F];
+    }
+}
+
+void MemoryKernels::formatAscii(const quint8* data, int size, char* out) {
+    int position = 0;
+#ifdef MEMORY_KERNELS_SSE2
+    // Signed compares: bytes from 80h are negative and fail the lower bound.
+    const __m128i dot = _mm_set1_epi8('.');
+    for (; position + VECTOR_SIZE <= size; position += VECTOR_SIZE) {
+        const __m128i bytes = load(data + position);
+        const __m128i printable = _mm_and_si128(_mm_cmpgt_epi8(bytes, _mm_set1_epi8(0x1F)),
+                                                _mm_cmplt_epi8(bytes, _mm_set1_epi8(0x7F)));
+        store(out + position, _mm_or_si128(_mm_and_si128(printable, bytes), _mm_andnot_si128(printable, dot)));
+    }
+#endif
+    for (; position < size; ++position) {
+        out[position] = data[position] >= 0x20 && data[position] < 0x7F ? char(data[position]) : '.';
+    }
+}
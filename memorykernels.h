@@ -0,0 +1,21 @@
+#ifndef MEMORYKERNELS_H
+#define MEMORYKERNELS_H
+
+#include <QtGlobal>
+
+// Bulk operations over flat memory for the DEBUG commands: SSE2 where the compiler targets it, scalar code otherwise.
+class MemoryKernels {
+public:
+    // Offset of the first occurrence of the pattern, or -1.
+    static int find(const quint8* data, int size, const quint8* pattern, int patternSize);
+    // Offset of the first byte that differs, or -1.
+    static int mismatch(const quint8* first, const quint8* second, int size);
+    static void fill(quint8* data, int size, const quint8* pattern, int patternSize);
+    static void move(quint8* target, const quint8* source, int size);
+    // Two uppercase hex digits per byte.
+    static void formatHex(const quint8* data, int size, char* out);
+    // The byte itself when printable ASCII, '.' otherwise.
+    static void formatAscii(const quint8* data, int size, char* out);
+};
+
+#endif // MEMORYKERNELS_H
@@ -0,0 +1,128 @@
+#include "memoryview.h"
+#include <QPainter>
+#include <QPaintEvent>
+#include <QScrollBar>
+#include <QFontMetrics>
+#include "instructiondecoder.h"
+
+MemoryView::MemoryView(QWidget* parent) : QAbstractScrollArea(parent), emulator(nullptr), markedAddress(-1),
+    backgroundColor(Qt::white), textColor(Qt::black), highlightColor(QColor(Qt::darkGray).lighter(160)),
+    writeColor(230, 80, 60, 110) {
+    QAbstractScrollArea::setFont(QFont("Courier New", 10));
+    viewport()->setAutoFillBackground(false);
+    updateScrollBars();
+}
+
+void MemoryView::setEmulator(const Emulator* emulator) {
+    this->emulator = emulator;
+    viewport()->update();
+}
+
+void MemoryView::setFont(const QFont& font) {
+    QAbstractScrollArea::setFont(font);
+    updateScrollBars();
+    viewport()->update();
+}
+
+void MemoryView::setColors(const QColor& backgroundColor, const QColor& textColor, const QColor& highlightColor) {
+    this->backgroundColor = backgroundColor;
+    this->textColor = textColor;
+    this->highlightColor = highlightColor;
+    viewport()->update();
+}
+
+void MemoryView::setMarkedAddress(qint64 address) {
+    if (markedAddress == address) return;
+    markedAddress = address;
+    viewport()->update();
+}
+
+void MemoryView::scrollToAddress(quint32 address) {
+    const int row = int((address & (Emulator::MEMORY_SIZE - 1)) / BYTES_PER_ROW);
+    const int first = verticalScrollBar()->value();
+    const int visible = visibleRowCount();
+    if (row < first || row >= first + visible) {
+        verticalScrollBar()->setValue(row - visible / 3);
+    }
+}
+
+void MemoryView::refresh() {
+    viewport()->update();
+}
+
+int MemoryView::lineHeight() const {
+    return fontMetrics().height();
+}
+
+int MemoryView::visibleRowCount() const {
+    return qMax(1, viewport()->height() / lineHeight());
+}
+
+// Column of the first hex digit of a byte, with an extra space between the two halves of the row.
+int MemoryView::hexColumn(int index) const {
+    return ADDRESS_COLUMNS + index * 3 + (index >= BYTES_PER_ROW / 2 ? 1 : 0);
+}
+
+void MemoryView::updateScrollBars() {
+    const int visible = visibleRowCount();
+    verticalScrollBar()->setRange(0, qMax(0, ROW_COUNT - visible));
+    verticalScrollBar()->setPageStep(visible);
+    verticalScrollBar()->setSingleStep(1);
+
+    const int contentWidth = (hexColumn(BYTES_PER_ROW) + ASCII_GAP_COLUMNS + BYTES_PER_ROW)
+                             * fontMetrics().horizontalAdvance(QLatin1Char('0')) + MARGIN_LEFT;
+    horizontalScrollBar()->setRange(0, qMax(0, contentWidth - viewport()->width()));
+    horizontalScrollBar()->setPageStep(qMax(1, viewport()->width()));
+}
+
+void MemoryView::paintEvent(QPaintEvent* event) {
+    QPainter painter(viewport());
+    painter.fillRect(event->rect(), backgroundColor);
+    if (!emulator) return;
+
+    const int height = lineHeight();
+    const int charWidth = fontMetrics().horizontalAdvance(QLatin1Char('0'));
+    const int ascent = fontMetrics().ascent();
+    const int left = MARGIN_LEFT - horizontalScrollBar()->value();
+    const int asciiColumn = hexColumn(BYTES_PER_ROW) + ASCII_GAP_COLUMNS;
+    const int first = verticalScrollBar()->value();
+    const int firstRow = event->rect().top() / height;
+    const int lastRow = event->rect().bottom() / height;
+
+    for (int row = firstRow; row <= lastRow && first + row < ROW_COUNT; ++row) {
+        const quint32 base = quint32(first + row) * BYTES_PER_ROW;
+        const int y = row * height;
+        const quint32 segment = (base >> 4) & 0xF000;
+        QString text = InstructionDecoder::hexWord(segment) + ':' + InstructionDecoder::hexWord(base - (segment << 4));
+        text = text.leftJustified(asciiColumn + BYTES_PER_ROW, ' ');
+
+        for (int i = 0; i < BYTES_PER_ROW; ++i) {
+            const quint32 address = base + i;
+            const quint8 value = emulator->readByte(address);
+            const QString hex = InstructionDecoder::hexByte(value);
+            text[hexColumn(i)] = hex[0];
+            text[hexColumn(i) + 1] = hex[1];
+            text[asciiColumn + i] = value >= 0x20 && value < 0x7F ? QChar(value) : QChar('.');
+
+            const bool written = emulator->writtenLastGeneration(address);
+            const bool marked = qint64(address) == markedAddress;
+            if (!written && !marked) continue;
+            const QRect hexRect(left + hexColumn(i) * charWidth, y, 2 * charWidth, height);
+            const QRect asciiRect(left + (asciiColumn + i) * charWidth, y, charWidth, height);
+            const QColor& color = marked ? highlightColor : writeColor;
+            painter.fillRect(hexRect, color);
+            painter.fillRect(asciiRect, color);
+            if (marked && written) {
+                painter.setPen(writeColor);
+                painter.drawRect(hexRect.adjusted(0, 0, -1, -1));
+            }
+        }
+        painter.setPen(textColor);
+        painter.drawText(left, y + ascent, text);
+    }
+}
+
+void MemoryView::resizeEvent(QResizeEvent* event) {
+    QAbstractScrollArea::resizeEvent(event);
+    updateScrollBars();
+}
@@ -0,0 +1,42 @@
+#ifndef MEMORYVIEW_H
+#define MEMORYVIEW_H
+
+#include <QAbstractScrollArea>
+#include <QColor>
+#include "emulator.h"
+
+// A hex dump of the emulator's whole 1 MB address space; only the rows on screen are read and formatted.
+class MemoryView : public QAbstractScrollArea {
+    Q_OBJECT
+public:
+    explicit MemoryView(QWidget* parent = nullptr);
+    void setEmulator(const Emulator* emulator);
+    void setFont(const QFont& font);
+    void setColors(const QColor& backgroundColor, const QColor& textColor, const QColor& highlightColor);
+    void setMarkedAddress(qint64 address);
+    void scrollToAddress(quint32 address);
+    void refresh();
+protected:
+    void paintEvent(QPaintEvent* event) override;
+    void resizeEvent(QResizeEvent* event) override;
+private:
+    static constexpr int BYTES_PER_ROW = 16;
+    static constexpr int ROW_COUNT = Emulator::MEMORY_SIZE / BYTES_PER_ROW;
+    static constexpr int MARGIN_LEFT = 5;
+    static constexpr int ADDRESS_COLUMNS = 11;
+    static constexpr int ASCII_GAP_COLUMNS = 2;
+
+    const Emulator* emulator;
+    qint64 markedAddress;
+    QColor backgroundColor;
+    QColor textColor;
+    QColor highlightColor;
+    QColor writeColor;
+
+    int lineHeight() const;
+    int visibleRowCount() const;
+    int hexColumn(int index) const;
+    void updateScrollBars();
+};
+
+#endif // MEMORYVIEW_H
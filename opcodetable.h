@@ -0,0 +1,279 @@
+#ifndef OPCODETABLE_H
+#define OPCODETABLE_H
+
+#include <QtGlobal>
+#include <array>
+
+// What one 8086 opcode byte means: the decoder dispatches on the form, the assembler and the highlighter take their
+// mnemonics from the same entries and the emulator counts clocks from them.
+struct OpcodeInfo {
+    enum Form : quint8 {
+        Invalid,
+        Prefix,
+        Implied,
+        AsciiAdjust,          // AAM, AAD: followed by the base 0A
+        RegisterMemory,       // ModR/M, bit 1 of the opcode puts the register first
+        MemoryRegister,       // ModR/M, always r/m then register (TEST, XCHG)
+        SegmentMemory,        // ModR/M with a segment register in the reg field
+        LoadAddress,          // ModR/M, memory operand only
+        Group,                // ModR/M, the reg field selects the operation
+        AccumulatorImmediate,
+        AccumulatorRegister,  // XCHG AX,reg
+        SegmentRegister,      // segment register in bits 3-4
+        Register,             // 16-bit register in bits 0-2
+        RegisterImmediate,
+        MemoryOffset,         // MOV between the accumulator and a direct address
+        Relative8,
+        Relative16,
+        FarPointer,
+        Interrupt,
+        Breakpoint,           // INT 3
+        ReturnImmediate,
+        PortImmediate,
+        PortDX
+    };
+    enum GroupKind : quint8 { NoGroup, Arithmetic, Shift, Unary, IncrementByte, IncrementWord, PopMemory, MoveImmediate };
+    enum Flag : quint16 {
+        CF = 0x001, PF = 0x004, AF = 0x010, ZF = 0x040, SF = 0x080, TF = 0x100, IF = 0x200, DF = 0x400, OF = 0x800
+    };
+    static constexpr quint16 ARITHMETIC_FLAGS = CF | PF | AF | ZF | SF | OF;
+    static constexpr quint16 ALL_FLAGS = ARITHMETIC_FLAGS | TF | IF | DF;
+
+    const char* mnemonic = nullptr;
+    Form form = Invalid;
+    // 1 for byte operands, 2 for word operands.
+    quint8 size = 0;
+    GroupKind group = NoGroup;
+    // Clocks of the register form from the 8086 manual; memory operands, taken branches and repeats cost more.
+    quint8 cycles = 0;
+    // For groups, the union over the operations.
+    quint16 flagsRead = 0;
+    quint16 flagsWritten = 0;
+    // An undocumented opcode the 8086 executes as the documented one given here, -1 for every other opcode. Aliases
+    // stay Invalid so that nothing decodes or assembles them, but carry the clocks and flags of what they run as.
+    qint16 alias = -1;
+};
+
+class OpcodeTable {
+public:
+    static constexpr const char* ARITHMETIC_MNEMONICS[8] = {"ADD", "OR", "ADC", "SBB", "AND", "SUB", "XOR", "CMP"};
+    static constexpr const char* CONDITION_MNEMONICS[16] = {"JO", "JNO", "JB", "JNB", "JZ", "JNZ", "JBE", "JA",
+                                                            "JS", "JNS", "JPE", "JPO", "JL", "JGE", "JLE", "JG"};
+    static constexpr const char* LOOP_MNEMONICS[4] = {"LOOPNZ", "LOOPZ", "LOOP", "JCXZ"};
+    static constexpr const char* GROUP_MNEMONICS[8][8] = {
+        {},
+        {"ADD", "OR", "ADC", "SBB", "AND", "SUB", "XOR", "CMP"},
+        {"ROL", "ROR", "RCL", "RCR", "SHL", "SHR", nullptr, "SAR"},
+        {"TEST", nullptr, "NOT", "NEG", "MUL", "IMUL", "DIV", "IDIV"},
+        {"INC", "DEC"},
+        {"INC", "DEC", "CALL", "CALL", "JMP", "JMP", "PUSH", nullptr},
+        {"POP"},
+        {"MOV"}
+    };
+
+    static constexpr const OpcodeInfo& info(int opcode) { return TABLE[opcode & 0xFF]; }
+    // The mnemonic a group opcode gets from the reg field of its ModR/M byte, nullptr when undefined.
+    static constexpr const char* groupMnemonic(OpcodeInfo::GroupKind group, int operation) {
+        return GROUP_MNEMONICS[group][operation & 7];
+    }
+private:
+    static constexpr OpcodeInfo entry(const char* mnemonic, OpcodeInfo::Form form, int size, int cycles,
+                                      quint16 flagsRead = 0, quint16 flagsWritten = 0,
+                                      OpcodeInfo::GroupKind group = OpcodeInfo::NoGroup) {
+        OpcodeInfo info;
+        info.mnemonic = mnemonic;
+        info.form = form;
+        info.size = quint8(size);
+        info.group = group;
+        info.cycles = quint8(cycles);
+        info.flagsRead = flagsRead;
+        info.flagsWritten = flagsWritten;
+        return info;
+    }
+
+    static constexpr OpcodeInfo aliasOf(const OpcodeInfo& documented, int opcode) {
+        OpcodeInfo info = documented;
+        info.mnemonic = nullptr;
+        info.form = OpcodeInfo::Invalid;
+        info.alias = qint16(opcode);
+        return info;
+    }
+
+    static constexpr quint16 conditionFlags(int condition) {
+        constexpr quint16 FLAGS[8] = {
+            OpcodeInfo::OF, OpcodeInfo::CF, OpcodeInfo::ZF, OpcodeInfo::CF | OpcodeInfo::ZF, OpcodeInfo::SF, OpcodeInfo::PF,
+            OpcodeInfo::SF | OpcodeInfo::OF, OpcodeInfo::ZF | OpcodeInfo::SF | OpcodeInfo::OF
+        };
+        return FLAGS[(condition >> 1) & 7];
+    }
+
+    static constexpr std::array<OpcodeInfo, 256> build() {
+        using I = OpcodeInfo;
+        constexpr quint16 ARITHMETIC = I::ARITHMETIC_FLAGS;
+        constexpr quint16 COUNTED = I::ARITHMETIC_FLAGS & ~I::CF;
+        constexpr const char* SEGMENT_PREFIXES[4] = {"ES", "CS", "SS", "DS"};
+        std::array<OpcodeInfo, 256> table{};
+
+        for (int opcode = 0; opcode < 0x40; ++opcode) {
+            const int operation = opcode >> 3;
+            const quint16 read = operation == 2 || operation == 3 ? I::CF : 0;
+            const int size = (opcode & 1) ? 2 : 1;
+            switch (opcode & 7) {
+            case 0: case 1: case 2: case 3:
+                table[opcode] = entry(ARITHMETIC_MNEMONICS[operation], I::RegisterMemory, size, 3, read, ARITHMETIC);
+                break;
+            case 4: case 5:
+                table[opcode] = entry(ARITHMETIC_MNEMONICS[operation], I::AccumulatorImmediate, size, 4, read, ARITHMETIC);
+                break;
+            default:
+                if (opcode < 0x20) {
+                    if (opcode != 0x0F) table[opcode] = entry((opcode & 1) ? "POP" : "PUSH", I::SegmentRegister, 2, (opcode & 1) ? 8 : 10);
+                } else if ((opcode & 7) == 6) {
+                    table[opcode] = entry(SEGMENT_PREFIXES[operation & 3], I::Prefix, 0, 2);
+                }
+                break;
+            }
+        }
+        table[0x27] = entry("DAA", I::Implied, 1, 4, I::AF | I::CF, ARITHMETIC);
+        table[0x2F] = entry("DAS", I::Implied, 1, 4, I::AF | I::CF, ARITHMETIC);
+        table[0x37] = entry("AAA", I::Implied, 1, 8, I::AF | I::CF, ARITHMETIC);
+        table[0x3F] = entry("AAS", I::Implied, 1, 8, I::AF | I::CF, ARITHMETIC);
+
+        for (int index = 0; index < 8; ++index) {
+            table[0x40 + index] = entry("INC", I::Register, 2, 2, 0, COUNTED);
+            table[0x48 + index] = entry("DEC", I::Register, 2, 2, 0, COUNTED);
+            table[0x50 + index] = entry("PUSH", I::Register, 2, 11);
+            table[0x58 + index] = entry("POP", I::Register, 2, 8);
+            table[0xB0 + index] = entry("MOV", I::RegisterImmediate, 1, 4);
+            table[0xB8 + index] = entry("MOV", I::RegisterImmediate, 2, 4);
+        }
+        for (int condition = 0; condition < 16; ++condition) {
+            table[0x70 + condition] = entry(CONDITION_MNEMONICS[condition], I::Relative8, 0, 16, conditionFlags(condition));
+            table[0x60 + condition] = aliasOf(table[0x70 + condition], 0x70 + condition);
+        }
+
+        table[0x80] = entry(nullptr, I::Group, 1, 4, I::CF, ARITHMETIC, I::Arithmetic);
+        table[0x81] = entry(nullptr, I::Group, 2, 4, I::CF, ARITHMETIC, I::Arithmetic);
+        table[0x82] = entry(nullptr, I::Group, 1, 4, I::CF, ARITHMETIC, I::Arithmetic);
+        table[0x83] = entry(nullptr, I::Group, 2, 4, I::CF, ARITHMETIC, I::Arithmetic);
+        table[0x84] = entry("TEST", I::MemoryRegister, 1, 3, 0, ARITHMETIC);
+        table[0x85] = entry("TEST", I::MemoryRegister, 2, 3, 0, ARITHMETIC);
+        table[0x86] = entry("XCHG", I::MemoryRegister, 1, 4);
+        table[0x87] = entry("XCHG", I::MemoryRegister, 2, 4);
+        table[0x88] = entry("MOV", I::RegisterMemory, 1, 2);
+        table[0x89] = entry("MOV", I::RegisterMemory, 2, 2);
+        table[0x8A] = entry("MOV", I::RegisterMemory, 1, 2);
+        table[0x8B] = entry("MOV", I::RegisterMemory, 2, 2);
+        table[0x8C] = entry("MOV", I::SegmentMemory, 2, 2);
+        table[0x8D] = entry("LEA", I::LoadAddress, 2, 2);
+        table[0x8E] = entry("MOV", I::SegmentMemory, 2, 2);
+        table[0x8F] = entry(nullptr, I::Group, 2, 17, 0, 0, I::PopMemory);
+
+        table[0x90] = entry("NOP", I::Implied, 1, 3);
+        for (int index = 1; index < 8; ++index) {
+            table[0x90 + index] = entry("XCHG", I::AccumulatorRegister, 2, 3);
+        }
+        table[0x98] = entry("CBW", I::Implied, 1, 2);
+        table[0x99] = entry("CWD", I::Implied, 1, 5);
+        table[0x9A] = entry("CALL", I::FarPointer, 0, 28);
+        table[0x9B] = entry("WAIT", I::Implied, 1, 3);
+        table[0x9C] = entry("PUSHF", I::Implied, 1, 10, I::ALL_FLAGS);
+        table[0x9D] = entry("POPF", I::Implied, 1, 8, 0, I::ALL_FLAGS);
+        table[0x9E] = entry("SAHF", I::Implied, 1, 4, 0, I::SF | I::ZF | I::AF | I::PF | I::CF);
+        table[0x9F] = entry("LAHF", I::Implied, 1, 4, I::SF | I::ZF | I::AF | I::PF | I::CF);
+
+        table[0xA0] = entry("MOV", I::MemoryOffset, 1, 10);
+        table[0xA1] = entry("MOV", I::MemoryOffset, 2, 10);
+        table[0xA2] = entry("MOV", I::MemoryOffset, 1, 10);
+        table[0xA3] = entry("MOV", I::MemoryOffset, 2, 10);
+        table[0xA4] = entry("MOVSB", I::Implied, 1, 18, I::DF);
+        table[0xA5] = entry("MOVSW", I::Implied, 2, 18, I::DF);
+        table[0xA6] = entry("CMPSB", I::Implied, 1, 22, I::DF, ARITHMETIC);
+        table[0xA7] = entry("CMPSW", I::Implied, 2, 22, I::DF, ARITHMETIC);
+        table[0xA8] = entry("TEST", I::AccumulatorImmediate, 1, 4, 0, ARITHMETIC);
+        table[0xA9] = entry("TEST", I::AccumulatorImmediate, 2, 4, 0, ARITHMETIC);
+        table[0xAA] = entry("STOSB", I::Implied, 1, 11, I::DF);
+        table[0xAB] = entry("STOSW", I::Implied, 2, 11, I::DF);
+        table[0xAC] = entry("LODSB", I::Implied, 1, 12, I::DF);
+        table[0xAD] = entry("LODSW", I::Implied, 2, 12, I::DF);
+        table[0xAE] = entry("SCASB", I::Implied, 1, 15, I::DF, ARITHMETIC);
+        table[0xAF] = entry("SCASW", I::Implied, 2, 15, I::DF, ARITHMETIC);
+
+        table[0xC2] = entry("RET", I::ReturnImmediate, 0, 12);
+        table[0xC3] = entry("RET", I::Implied, 1, 8);
+        table[0xC4] = entry("LES", I::LoadAddress, 2, 16);
+        table[0xC5] = entry("LDS", I::LoadAddress, 2, 16);
+        table[0xC6] = entry(nullptr, I::Group, 1, 10, 0, 0, I::MoveImmediate);
+        table[0xC7] = entry(nullptr, I::Group, 2, 10, 0, 0, I::MoveImmediate);
+        table[0xCA] = entry("RETF", I::ReturnImmediate, 0, 17);
+        table[0xCB] = entry("RETF", I::Implied, 1, 18);
+        table[0xCC] = entry("INT", I::Breakpoint, 0, 52, 0, I::TF | I::IF);
+        table[0xCD] = entry("INT", I::Interrupt, 0, 51, 0, I::TF | I::IF);
+        table[0xCE] = entry("INTO", I::Implied, 1, 53, I::OF, I::TF | I::IF);
+        table[0xCF] = entry("IRET", I::Implied, 1, 24, 0, I::ALL_FLAGS);
+        // C0, C1, C8 and C9 run as the RET and RETF two opcodes up.
+        constexpr int RETURN_ALIASES[4] = {0xC0, 0xC1, 0xC8, 0xC9};
+        for (int opcode : RETURN_ALIASES) {
+            table[opcode] = aliasOf(table[opcode + 2], opcode + 2);
+        }
+
+        table[0xD0] = entry(nullptr, I::Group, 1, 2, I::CF, ARITHMETIC, I::Shift);
+        table[0xD1] = entry(nullptr, I::Group, 2, 2, I::CF, ARITHMETIC, I::Shift);
+        table[0xD2] = entry(nullptr, I::Group, 1, 8, I::CF, ARITHMETIC, I::Shift);
+        table[0xD3] = entry(nullptr, I::Group, 2, 8, I::CF, ARITHMETIC, I::Shift);
+        table[0xD4] = entry("AAM", I::AsciiAdjust, 1, 83, 0, ARITHMETIC);
+        table[0xD5] = entry("AAD", I::AsciiAdjust, 1, 60, 0, ARITHMETIC);
+        table[0xD7] = entry("XLAT", I::Implied, 1, 11);
+
+        table[0xE0] = entry(LOOP_MNEMONICS[0], I::Relative8, 0, 19, I::ZF);
+        table[0xE1] = entry(LOOP_MNEMONICS[1], I::Relative8, 0, 18, I::ZF);
+        table[0xE2] = entry(LOOP_MNEMONICS[2], I::Relative8, 0, 17);
+        table[0xE3] = entry(LOOP_MNEMONICS[3], I::Relative8, 0, 18);
+        table[0xE4] = entry("IN", I::PortImmediate, 1, 10);
+        table[0xE5] = entry("IN", I::PortImmediate, 2, 10);
+        table[0xE6] = entry("OUT", I::PortImmediate, 1, 10);
+        table[0xE7] = entry("OUT", I::PortImmediate, 2, 10);
+        table[0xE8] = entry("CALL", I::Relative16, 0, 19);
+        table[0xE9] = entry("JMP", I::Relative16, 0, 15);
+        table[0xEA] = entry("JMP", I::FarPointer, 0, 15);
+        table[0xEB] = entry("JMP", I::Relative8, 0, 15);
+        table[0xEC] = entry("IN", I::PortDX, 1, 8);
+        table[0xED] = entry("IN", I::PortDX, 2, 8);
+        table[0xEE] = entry("OUT", I::PortDX, 1, 8);
+        table[0xEF] = entry("OUT", I::PortDX, 2, 8);
+
+        table[0xF0] = entry("LOCK", I::Prefix, 0, 2);
+        table[0xF2] = entry("REPNZ", I::Prefix, 0, 2);
+        table[0xF3] = entry("REPZ", I::Prefix, 0, 2);
+        table[0xF1] = aliasOf(table[0xF0], 0xF0);
+        table[0xF4] = entry("HLT", I::Implied, 1, 2);
+        table[0xF5] = entry("CMC", I::Implied, 1, 2, I::CF, I::CF);
+        table[0xF6] = entry(nullptr, I::Group, 1, 3, 0, ARITHMETIC, I::Unary);
+        table[0xF7] = entry(nullptr, I::Group, 2, 3, 0, ARITHMETIC, I::Unary);
+        table[0xF8] = entry("CLC", I::Implied, 1, 2, 0, I::CF);
+        table[0xF9] = entry("STC", I::Implied, 1, 2, 0, I::CF);
+        table[0xFA] = entry("CLI", I::Implied, 1, 2, 0, I::IF);
+        table[0xFB] = entry("STI", I::Implied, 1, 2, 0, I::IF);
+        table[0xFC] = entry("CLD", I::Implied, 1, 2, 0, I::DF);
+        table[0xFD] = entry("STD", I::Implied, 1, 2, 0, I::DF);
+        table[0xFE] = entry(nullptr, I::Group, 1, 3, 0, COUNTED, I::IncrementByte);
+        table[0xFF] = entry(nullptr, I::Group, 2, 3, 0, COUNTED, I::IncrementWord);
+        return table;
+    }
+
+    static const std::array<OpcodeInfo, 256> TABLE;
+};
+
+// Defined outside the class, build() cannot run while OpcodeTable is still incomplete.
+inline constexpr std::array<OpcodeInfo, 256> OpcodeTable::TABLE = OpcodeTable::build();
+
+static_assert(OpcodeTable::info(0x90).form == OpcodeInfo::Implied, "NOP is implied");
+static_assert(OpcodeTable::info(0x26).form == OpcodeInfo::Prefix && OpcodeTable::info(0x0F).form == OpcodeInfo::Invalid,
+              "segment prefixes and the unused 0F are told apart");
+static_assert(OpcodeTable::info(0x64).form == OpcodeInfo::Invalid && OpcodeTable::info(0x64).alias == 0x74
+              && OpcodeTable::info(0xC1).alias == 0xC3 && OpcodeTable::info(0xC3).alias < 0,
+              "undocumented aliases name the opcode they execute as");
+static_assert(OpcodeTable::info(0x74).flagsRead == OpcodeInfo::ZF && OpcodeTable::info(0x7E).flagsRead == 0x8C0,
+              "conditional jumps read the flags of their condition");
+
+#endif // OPCODETABLE_H
@@ -0,0 +1,398 @@
+#include "peepholeoptimizer.h"
+#include "instructionencoder.h"
+#include <QRegularExpression>
+#include <QHash>
+#include <QSet>
+
+namespace {
+
+enum Flag {
+    CF = 0x001,
+    PF = 0x004,
+    AF = 0x010,
+    ZF = 0x040,
+    SF = 0x080,
+    OF = 0x800
+};
+
+const int ALL_FLAGS = CF | PF | AF | ZF | SF | OF;
+
+const QHash<QString, int> BRANCH_CONDITIONS = {
+    {"JO", OF}, {"JNO", OF}, {"JB", CF}, {"JC", CF}, {"JNAE", CF}, {"JAE", CF}, {"JNB", CF}, {"JNC", CF},
+    {"JE", ZF}, {"JZ", ZF}, {"JNE", ZF}, {"JNZ", ZF}, {"JBE", CF | ZF}, {"JNA", CF | ZF}, {"JA", CF | ZF}, {"JNBE", CF | ZF},
+    {"JS", SF}, {"JNS", SF}, {"JP", PF}, {"JPE", PF}, {"JNP", PF}, {"JPO", PF}, {"JL", SF | OF}, {"JNGE", SF | OF},
+    {"JGE", SF | OF}, {"JNL", SF | OF}, {"JLE", ZF | SF | OF}, {"JNG", ZF | SF | OF}, {"JG", ZF | SF | OF}, {"JNLE", ZF | SF | OF},
+    {"LOOPNE", ZF}, {"LOOPNZ", ZF}, {"LOOPE", ZF}, {"LOOPZ", ZF}, {"LOOP", 0}, {"JCXZ", 0}
+};
+
+const QSet<QString> WRITES_ALL_FLAGS = {
+    "ADD", "SUB", "CMP", "NEG", "AND", "OR", "XOR", "TEST", "MUL", "IMUL", "DIV", "IDIV", "AAM", "AAD", "POPF"
+};
+
+const QSet<QString> NO_FLAGS = {
+    "MOV", "PUSH", "POP", "XCHG", "LEA", "LDS", "LES", "IN", "OUT", "NOP", "NOT", "CBW", "CWD", "XLAT", "WAIT",
+    "MOVSB", "MOVSW", "STOSB", "STOSW", "LODSB", "LODSW", "CLD", "STD", "CLI", "STI", "HLT", "LOCK"
+};
+
+const QSet<QString> STRING_COMPARES = {"CMPSB", "CMPSW", "SCASB", "SCASW"};
+const QSet<QString> ROTATES = {"ROL", "ROR", "RCL", "RCR"};
+const QSet<QString> SHIFTS = {"ROL", "ROR", "RCL", "RCR", "SHL", "SAL", "SHR", "SAR"};
+
+const int JMP_CYCLES = 15;
+
+struct Instruction {
+    int line = 0;
+    int address = 0;
+    int size = 0;
+    int block = 0;
+    bool valid = true;
+    bool stable = true;
+    bool fallsThrough = true;
+    int target = -1;
+    int reads = 0;
+    int writes = 0;
+    int liveOut = ALL_FLAGS;
+    QByteArray bytes;
+};
+
+struct Reference {
+    int line;
+    int address;
+};
+
+bool isRegister(const Operand& op) {
+    return op.type == Operand::Register8 || op.type == Operand::Register16;
+}
+
+bool isZero(const Operand& op, int value) {
+    return op.type == Operand::Immediate && op.label.isEmpty() && op.value == value;
+}
+
+bool sameOperand(const Operand& a, const Operand& b) {
+    if (a.type != b.type || !a.label.isEmpty() || !b.label.isEmpty()) return false;
+    switch (a.type) {
+    case Operand::Register8:
+    case Operand::Register16:
+    case Operand::SegmentRegister:
+        return a.reg == b.reg;
+    case Operand::Immediate:
+        return a.value == b.value;
+    case Operand::Memory:
+        return a.rm == b.rm && a.value == b.value && a.segmentOverride == b.segmentOverride && a.size == b.size;
+    default:
+        return false;
+    }
+}
+
+// True when writing the register changes the address the memory operand refers to.
+bool feedsAddress(const Operand& reg, const Operand& mem) {
+    if (mem.type != Operand::Memory || mem.rm < 0) return false;
+    int word;
+    if (reg.type == Operand::Register16) word = reg.reg;
+    else if (reg.type == Operand::Register8) word = reg.reg & 3;
+    else return false;
+
+    static const QVector<QVector<int>> BASES = {{3, 6}, {3, 7}, {5, 6}, {5, 7}, {6}, {7}, {5}, {3}};
+    return BASES[mem.rm].contains(word);
+}
+
+int effectiveAddressCycles(const Operand& op) {
+    static const int BASE[] = {7, 8, 8, 7, 5, 5, 5, 5};
+    int cycles = op.rm < 0 ? 6 : BASE[op.rm] + (op.value != 0 || op.rm == 6 ? 4 : 0);
+    if (op.segmentOverride >= 0) cycles += 2;
+    return cycles;
+}
+
+int movCycles(const ScriptLine& line) {
+    const Operand& dst = line.operands[0];
+    const Operand& src = line.operands[1];
+    if (dst.type == Operand::Memory) {
+        if (src.type == Operand::Immediate) return 10 + effectiveAddressCycles(dst);
+        if (dst.rm < 0 && src.type != Operand::SegmentRegister && src.reg == 0) return 10;
+        return 9 + effectiveAddressCycles(dst);
+    }
+    if (src.type == Operand::Memory) {
+        if (src.rm < 0 && dst.type != Operand::SegmentRegister && dst.reg == 0) return 10;
+        return 8 + effectiveAddressCycles(src);
+    }
+    return src.type == Operand::Immediate ? 4 : 2;
+}
+
+void describeEffects(const ScriptLine& line, Instruction& instruction, bool& indirect) {
+    const QString& mnemonic = line.mnemonic;
+    const bool direct = line.operands.size() == 1 && line.operands[0].type == Operand::Immediate;
+
+    if (BRANCH_CONDITIONS.contains(mnemonic)) {
+        instruction.reads = BRANCH_CONDITIONS.value(mnemonic);
+        if (direct) instruction.target = line.operands[0].value & 0xFFFF;
+    } else if (mnemonic == "JMP") {
+        instruction.fallsThrough = false;
+        if (direct) {
+            instruction.target = line.operands[0].value & 0xFFFF;
+        } else {
+            instruction.reads = ALL_FLAGS;
+            indirect = true;
+        }
+    } else if (mnemonic == "CALL") {
+        instruction.reads = ALL_FLAGS;
+        if (!direct) indirect = true;
+    } else if (mnemonic == "RET" || mnemonic == "RETF" || mnemonic == "IRET") {
+        instruction.reads = ALL_FLAGS;
+        instruction.fallsThrough = false;
+    } else if (mnemonic == "LAHF") {
+        instruction.reads = SF | ZF | AF | PF | CF;
+    } else if (mnemonic == "SAHF") {
+        instruction.writes = SF | ZF | AF | PF | CF;
+    } else if (mnemonic == "ADC" || mnemonic == "SBB") {
+        instruction.reads = CF;
+        instruction.writes = ALL_FLAGS;
+    } else if (mnemonic == "AAA" || mnemonic == "AAS" || mnemonic == "DAA" || mnemonic == "DAS") {
+        instruction.reads = AF | CF;
+        instruction.writes = ALL_FLAGS;
+    } else if (mnemonic == "INC" || mnemonic == "DEC") {
+        instruction.writes = ALL_FLAGS & ~CF;
+    } else if (mnemonic == "CLC" || mnemonic == "STC") {
+        instruction.writes = CF;
+    } else if (mnemonic == "CMC") {
+        instruction.reads = CF;
+        instruction.writes = CF;
+    } else if (SHIFTS.contains(mnemonic)) {
+        // A count in CL may be zero, which leaves every flag untouched.
+        const bool byOne = line.operands.size() == 2 && line.operands[1].type == Operand::Immediate;
+        if (mnemonic == "RCL" || mnemonic == "RCR") instruction.reads = CF;
+        if (byOne) instruction.writes = ROTATES.contains(mnemonic) ? CF | OF : ALL_FLAGS;
+    } else if (STRING_COMPARES.contains(mnemonic)) {
+        if (line.prefix.isEmpty()) instruction.writes = ALL_FLAGS;
+    } else if (WRITES_ALL_FLAGS.contains(mnemonic)) {
+        instruction.writes = ALL_FLAGS;
+    } else if (!NO_FLAGS.contains(mnemonic)) {
+        instruction.reads = ALL_FLAGS;
+    }
+}
+
+QString indentOf(const QString& text) {
+    int length = 0;
+    while (length < text.size() && text[length].isSpace()) ++length;
+    return text.left(length);
+}
+
+QString spelled(const ScriptLine& line, const QString& text) {
+    int index = line.text.indexOf(line.mnemonic, 0, Qt::CaseInsensitive);
+    return index >= 0 && line.text[index].isLower() ? text.toLower() : text.toUpper();
+}
+
+QString savings(int bytes, int cycles) {
+    QStringList parts;
+    if (bytes > 0) parts.append(PeepholeOptimizer::tr("%1 byte(s)").arg(bytes));
+    if (cycles > 0) parts.append(PeepholeOptimizer::tr("%1 cycle(s)").arg(cycles));
+    return parts.join(", ");
+}
+
+}
+
+QVector<PeepholeSuggestion> PeepholeOptimizer::analyze(const QVector<ScriptLine>& lines, const QVector<LineEncoding>& encodings) {
+    QVector<Instruction> code;
+    QVector<int> blockEnds;
+    QVector<Reference> references;
+    QSet<int> entryPoints;
+    QHash<int, int> byteOwners;
+    bool indirect = false;
+
+    static const QRegularExpression numberSeparator("[^0-9A-Fa-f]+");
+    bool assembling = false;
+    int address = DEFAULT_ASSEMBLY_ADDRESS;
+    for (int i = 0; i < lines.size(); ++i) {
+        const ScriptLine& line = lines[i];
+        if (assembling) {
+            if (line.empty) {
+                assembling = false;
+                continue;
+            }
+            if (line.comment) continue;
+
+            EncodedInstruction encoded = InstructionEncoder::encode(encodings, i, line, address);
+            Instruction instruction;
+            instruction.line = i;
+            instruction.address = address;
+            instruction.size = encoded.bytes.size();
+            instruction.block = blockEnds.size() - 1;
+            instruction.valid = encoded.isValid() && InstructionEncoder::isKnownMnemonic(line.mnemonic);
+            instruction.bytes = encoded.bytes;
+            describeEffects(line, instruction, indirect);
+            if (!instruction.valid) {
+                instruction.reads = ALL_FLAGS;
+                instruction.target = -1;
+            }
+            if (instruction.target >= 0) {
+                entryPoints.insert(instruction.target);
+            } else if (line.mnemonic == "CALL" && line.operands.size() == 1 && line.operands[0].type == Operand::Immediate) {
+                entryPoints.insert(line.operands[0].value & 0xFFFF);
+            }
+            for (const Operand& op : line.operands) {
+                if (op.type == Operand::Immediate || op.type == Operand::FarAddress || (op.type == Operand::Memory && op.value != 0)) {
+                    references.append({i, op.value & 0xFFFF});
+                }
+            }
+            for (int k = 0; k < instruction.size; ++k) {
+                ++byteOwners[(address + k) & 0xFFFF];
+            }
+            code.append(instruction);
+            address += instruction.size;
+            blockEnds.last() = address;
+            continue;
+        }
+
+        if (line.empty || line.comment) continue;
+        if (line.head == "A") {
+            assembling = true;
+            if (line.commandAddress >= 0) {
+                address = line.commandAddress;
+            }
+            references.append({i, address});
+            blockEnds.append(address);
+        } else if (line.head == "E") {
+            if (line.commandAddress < 0) continue;
+            references.append({i, line.commandAddress});
+            for (int k = 0; k < line.editData.size(); ++k) {
+                ++byteOwners[(line.commandAddress + k) & 0xFFFF];
+            }
+        } else if (line.head != "N") {
+            for (const QString& token : line.tail.split(numberSeparator, Qt::SkipEmptyParts)) {
+                int value;
+                if (ScriptParser::parseNumber(token, value)) {
+                    references.append({i, value & 0xFFFF});
+                }
+            }
+        }
+    }
+
+    // Code that is overwritten by another A or E line is not what actually runs, leave it alone.
+    QHash<int, int> instructionAt;
+    for (int k = 0; k < code.size(); ++k) {
+        Instruction& instruction = code[k];
+        for (int offset = 0; offset < instruction.size; ++offset) {
+            if (byteOwners.value((instruction.address + offset) & 0xFFFF) > 1) {
+                instruction.stable = false;
+                break;
+            }
+        }
+        instructionAt[instruction.address] = instructionAt.contains(instruction.address) ? -1 : k;
+    }
+
+    QVector<int> liveIn(code.size(), 0);
+    auto liveAt = [&](int target) {
+        int index = instructionAt.value(target & 0xFFFF, -1);
+        return index >= 0 ? liveIn[index] : ALL_FLAGS;
+    };
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int k = code.size() - 1; k >= 0; --k) {
+            Instruction& instruction = code[k];
+            int out = 0;
+            if (instruction.fallsThrough) out |= liveAt(instruction.address + instruction.size);
+            if (instruction.target >= 0) out |= liveAt(instruction.target);
+            instruction.liveOut = out;
+            int in = instruction.reads | (out & ~instruction.writes);
+            if (in != liveIn[k]) {
+                liveIn[k] = in;
+                changed = true;
+            }
+        }
+    }
+
+    // DEBUG scripts use literal addresses, so shrinking code is only safe when nothing else points past it.
+    auto canShrink = [&](const Instruction& instruction) {
+        const int end = blockEnds[instruction.block];
+        for (const Reference& reference : references) {
+            if (reference.line != instruction.line && reference.address > instruction.address && reference.address <= end) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    QVector<PeepholeSuggestion> suggestions;
+    auto replace = [&](const Instruction& instruction, const QString& text, int cyclesSaved, const char* reason) {
+        const ScriptLine& line = lines[instruction.line];
+        QString replacement = indentOf(line.text) + spelled(line, text);
+        EncodedInstruction encoded = InstructionEncoder::encode(ScriptParser::parse(replacement), instruction.address);
+        if (!encoded.isValid()) return;
+        int bytesSaved = instruction.size - int(encoded.bytes.size());
+        if (bytesSaved < 0 || (bytesSaved == 0 && cyclesSaved <= 0)) return;
+        if (bytesSaved > 0 && !canShrink(instruction)) return;
+
+        PeepholeSuggestion suggestion;
+        suggestion.line = instruction.line;
+        suggestion.replacement = replacement;
+        suggestion.bytesSaved = bytesSaved;
+        suggestion.cyclesSaved = cyclesSaved;
+        suggestion.message = tr("%1: \"%2\", saves %3").arg(tr(reason), replacement.trimmed(), savings(bytesSaved, cyclesSaved));
+        suggestions.append(suggestion);
+    };
+    auto remove = [&](const Instruction& instruction, int cyclesSaved, const char* reason) {
+        if (!canShrink(instruction)) return;
+        PeepholeSuggestion suggestion;
+        suggestion.line = instruction.line;
+        suggestion.removesLine = true;
+        suggestion.bytesSaved = instruction.size;
+        suggestion.cyclesSaved = cyclesSaved;
+        suggestion.message = tr("%1, removing it saves %2").arg(tr(reason), savings(instruction.size, cyclesSaved));
+        suggestions.append(suggestion);
+    };
+
+    for (int k = 0; k < code.size(); ++k) {
+        const Instruction& instruction = code[k];
+        const ScriptLine& line = lines[instruction.line];
+        if (!instruction.valid || !instruction.stable || !line.prefix.isEmpty()) continue;
+        const QVector<Operand>& ops = line.operands;
+        const QString& mnemonic = line.mnemonic;
+
+        if (mnemonic == "MOV" && ops.size() == 2 && isRegister(ops[0]) && isZero(ops[1], 0)) {
+            if (!(instruction.liveOut & ALL_FLAGS)) {
+                replace(instruction, QString("XOR %1,%1").arg(ops[0].text), 1,
+                        QT_TRANSLATE_NOOP("PeepholeOptimizer", "Flags are not used afterwards, zero the register with XOR"));
+            }
+        } else if ((mnemonic == "ADD" || mnemonic == "SUB") && ops.size() == 2 && isRegister(ops[0]) && isZero(ops[1], 1)) {
+            if (!(instruction.liveOut & CF)) {
+                const int cycles = ops[0].type == Operand::Register16 ? 2 : 3;
+                replace(instruction, QString("%1 %2").arg(mnemonic == "ADD" ? "INC" : "DEC", ops[0].text), 4 - cycles,
+                        QT_TRANSLATE_NOOP("PeepholeOptimizer", "CF is not used afterwards, INC/DEC does the same"));
+            }
+        } else if (mnemonic == "CMP" && ops.size() == 2 && isRegister(ops[0]) && isZero(ops[1], 0)) {
+            if (!(instruction.liveOut & AF)) {
+                replace(instruction, QString("TEST %1,%1").arg(ops[0].text), 1,
+                        QT_TRANSLATE_NOOP("PeepholeOptimizer", "Comparing with zero sets the same flags as TEST"));
+            }
+        } else if (mnemonic == "MOV" && ops.size() == 2 && k > 0) {
+            const Instruction& previous = code[k - 1];
+            const ScriptLine& before = lines[previous.line];
+            if (previous.block != instruction.block || !previous.valid || !previous.stable || before.mnemonic != "MOV"
+                || !before.prefix.isEmpty() || before.operands.size() != 2) continue;
+            if (indirect || entryPoints.contains(instruction.address)) continue;
+
+            const Operand& dst = before.operands[0];
+            const Operand& src = before.operands[1];
+            const bool repeats = sameOperand(ops[0], dst) && sameOperand(ops[1], src) && !sameOperand(dst, src)
+                                 && !feedsAddress(dst, src);
+            const bool reverses = sameOperand(ops[0], src) && sameOperand(ops[1], dst) && src.type != Operand::Immediate
+                                  && !feedsAddress(dst, src);
+            if (repeats || reverses) {
+                remove(instruction, movCycles(line),
+                       QT_TRANSLATE_NOOP("PeepholeOptimizer", "This MOV repeats the previous one"));
+            }
+        } else if (mnemonic == "JMP" && instruction.target >= 0) {
+            if (instruction.target == ((instruction.address + instruction.size) & 0xFFFF)) {
+                remove(instruction, JMP_CYCLES,
+                       QT_TRANSLATE_NOOP("PeepholeOptimizer", "JMP to the next instruction does nothing"));
+            } else if (!instruction.bytes.isEmpty() && quint8(instruction.bytes[0]) == 0xE9) {
+                // Only the rest of the jump's own A block moves up when it shrinks, code elsewhere stays put.
+                const bool moves = instruction.target > instruction.address && instruction.target < blockEnds[instruction.block];
+                const int target = moves ? instruction.target - 1 : instruction.target;
+                replace(instruction, QString("JMP %1").arg(target, 0, 16), 0,
+                        QT_TRANSLATE_NOOP("PeepholeOptimizer", "The target is in range of a short jump"));
+            }
+        }
+    }
+    return suggestions;
+}
@@ -0,0 +1,29 @@
+#ifndef PEEPHOLEOPTIMIZER_H
+#define PEEPHOLEOPTIMIZER_H
+
+#include <QCoreApplication>
+#include <QString>
+#include <QVector>
+#include "scriptparser.h"
+#include "instructionencoder.h"
+
+struct PeepholeSuggestion {
+    int line = 0;
+    QString message;
+    QString replacement;
+    bool removesLine = false;
+    int bytesSaved = 0;
+    int cyclesSaved = 0;
+};
+
+class PeepholeOptimizer {
+    Q_DECLARE_TR_FUNCTIONS(PeepholeOptimizer)
+public:
+    // encodings may hold the lines already encoded by the caller, see InstructionEncoder::encode.
+    static QVector<PeepholeSuggestion> analyze(const QVector<ScriptLine>& lines,
+                                               const QVector<LineEncoding>& encodings = QVector<LineEncoding>());
+private:
+    static constexpr int DEFAULT_ASSEMBLY_ADDRESS = 0x100;
+};
+
+#endif // PEEPHOLEOPTIMIZER_H
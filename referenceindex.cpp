@@ -0,0 +1,113 @@
+#include "referenceindex.h"
+#include <algorithm>
+
+namespace {
+
+int lowLine(const CodeReference& reference) {
+    return qMin(reference.line, reference.targetLine);
+}
+
+int highLine(const CodeReference& reference) {
+    return qMax(reference.line, reference.targetLine);
+}
+
+}
+
+void ReferenceIndex::rebuild(const QVector<CodeReference>& references) {
+    bySource = references;
+    std::stable_sort(bySource.begin(), bySource.end(), [](const CodeReference& a, const CodeReference& b) {
+        return a.line < b.line;
+    });
+
+    byTarget = references;
+    std::stable_sort(byTarget.begin(), byTarget.end(), [](const CodeReference& a, const CodeReference& b) {
+        return a.target < b.target || (a.target == b.target && a.line < b.line);
+    });
+
+    callTargets.clear();
+    arcs.clear();
+    for (const CodeReference& reference : byTarget) {
+        if (reference.kind == CodeReference::Call && (callTargets.isEmpty() || callTargets.last() != reference.target)) {
+            callTargets.append(reference.target);
+        }
+        if ((reference.kind == CodeReference::Jump || reference.kind == CodeReference::Branch)
+            && reference.targetLine >= 0 && reference.targetLine != reference.line) {
+            arcs.append(reference);
+        }
+    }
+
+    // Arcs are ordered by their lower end. arcReach is a max segment tree over that order, node 1 covers every
+    // arc and node n's children are 2n and 2n + 1, each holding the furthest line any arc below it reaches.
+    std::sort(arcs.begin(), arcs.end(), [](const CodeReference& a, const CodeReference& b) {
+        return lowLine(a) < lowLine(b);
+    });
+    arcLeaves = 1;
+    while (arcLeaves < arcs.size()) {
+        arcLeaves *= 2;
+    }
+    arcReach.fill(-1, 2 * arcLeaves);
+    for (int i = 0; i < arcs.size(); ++i) {
+        arcReach[arcLeaves + i] = highLine(arcs[i]);
+    }
+    for (int node = arcLeaves - 1; node >= 1; --node) {
+        arcReach[node] = qMax(arcReach[2 * node], arcReach[2 * node + 1]);
+    }
+}
+
+bool ReferenceIndex::hasArcs() const {
+    return !arcs.isEmpty();
+}
+
+QVector<CodeReference> ReferenceIndex::referencesFrom(int line) const {
+    auto first = std::lower_bound(bySource.constBegin(), bySource.constEnd(), line,
+                                  [](const CodeReference& reference, int value) { return reference.line < value; });
+    QVector<CodeReference> result;
+    for (auto it = first; it != bySource.constEnd() && it->line == line; ++it) {
+        result.append(*it);
+    }
+    return result;
+}
+
+QVector<CodeReference> ReferenceIndex::referencesTo(int address) const {
+    auto first = std::lower_bound(byTarget.constBegin(), byTarget.constEnd(), address,
+                                  [](const CodeReference& reference, int value) { return reference.target < value; });
+    QVector<CodeReference> result;
+    for (auto it = first; it != byTarget.constEnd() && it->target == address; ++it) {
+        result.append(*it);
+    }
+    return result;
+}
+
+QVector<CodeReference> ReferenceIndex::callersOf(int address) const {
+    auto it = std::upper_bound(callTargets.constBegin(), callTargets.constEnd(), address);
+    if (it == callTargets.constBegin()) return QVector<CodeReference>();
+
+    QVector<CodeReference> result;
+    for (const CodeReference& reference : referencesTo(*(it - 1))) {
+        if (reference.kind == CodeReference::Call) {
+            result.append(reference);
+        }
+    }
+    return result;
+}
+
+// Arcs starting at or before lastLine are a prefix of arcs; only subtrees reaching firstLine are searched,
+// so a query costs O((k + 1) log n) for k arcs returned.
+QVector<CodeReference> ReferenceIndex::arcsInRange(int firstLine, int lastLine) const {
+    auto end = std::upper_bound(arcs.constBegin(), arcs.constEnd(), lastLine,
+                                [](int value, const CodeReference& reference) { return value < lowLine(reference); });
+    QVector<CodeReference> result;
+    collectArcs(1, 0, arcLeaves, int(end - arcs.constBegin()), firstLine, result);
+    return result;
+}
+
+void ReferenceIndex::collectArcs(int node, int first, int last, int end, int firstLine, QVector<CodeReference>& result) const {
+    if (first >= end || arcReach[node] < firstLine) return;
+    if (last - first == 1) {
+        result.append(arcs[first]);
+        return;
+    }
+    const int middle = (first + last) / 2;
+    collectArcs(2 * node + 1, middle, last, end, firstLine, result);
+    collectArcs(2 * node, first, middle, end, firstLine, result);
+}
@@ -0,0 +1,37 @@
+#ifndef REFERENCEINDEX_H
+#define REFERENCEINDEX_H
+
+#include <QVector>
+
+struct CodeReference {
+    enum Kind { Jump, Branch, Call, Data };
+    Kind kind = Jump;
+    int line = -1;
+    int address = 0;
+    int target = 0;
+    int targetLine = -1;
+    bool operator==(const CodeReference& other) const {
+        return kind == other.kind && line == other.line && address == other.address && target == other.target
+               && targetLine == other.targetLine;
+    }
+};
+
+class ReferenceIndex {
+public:
+    void rebuild(const QVector<CodeReference>& references);
+    bool hasArcs() const;
+    QVector<CodeReference> referencesFrom(int line) const;
+    QVector<CodeReference> referencesTo(int address) const;
+    QVector<CodeReference> callersOf(int address) const;
+    QVector<CodeReference> arcsInRange(int firstLine, int lastLine) const;
+private:
+    QVector<CodeReference> bySource;
+    QVector<CodeReference> byTarget;
+    QVector<int> callTargets;
+    QVector<CodeReference> arcs;
+    QVector<int> arcReach;
+    int arcLeaves = 1;
+    void collectArcs(int node, int first, int last, int end, int firstLine, QVector<CodeReference>& result) const;
+};
+
+#endif // REFERENCEINDEX_H
@@ -0,0 +1,104 @@
+#include "registerview.h"
+#include <QLabel>
+#include <QGridLayout>
+#include <QFontDatabase>
+#include "instructiondecoder.h"
+
+namespace {
+
+// Registers in the order DEBUG prints them.
+const char* const NAMES[] = {"AX", "BX", "CX", "DX", "SP", "BP", "SI", "DI", "DS", "ES", "SS", "CS", "IP"};
+const int NAME_COUNT = 13;
+
+// Flag names as DEBUG shows them: set state first, clear state second.
+struct FlagName {
+    int mask;
+    const char* set;
+    const char* clear;
+};
+const FlagName FLAG_NAMES[] = {
+    {Emulator::OF, "OV", "NV"}, {Emulator::DF, "DN", "UP"}, {Emulator::IF, "EI", "DI"}, {Emulator::SF, "NG", "PL"},
+    {Emulator::ZF, "ZR", "NZ"}, {Emulator::AF, "AC", "NA"}, {Emulator::PF, "PE", "PO"}, {Emulator::CF, "CY", "NC"}
+};
+
+quint16 valueOf(const CpuState& state, int index) {
+    static const int REGISTERS[] = {Emulator::AX, Emulator::BX, Emulator::CX, Emulator::DX,
+                                    Emulator::SP, Emulator::BP, Emulator::SI, Emulator::DI};
+    static const int SEGMENTS[] = {Emulator::DS, Emulator::ES, Emulator::SS, Emulator::CS};
+    if (index < 8) return state.registers[REGISTERS[index]];
+    if (index < 12) return state.segments[SEGMENTS[index - 8]];
+    return state.ip;
+}
+
+}
+
+const QString RegisterView::CHANGED_COLOR = "#E04040";
+
+RegisterView::RegisterView(QWidget* parent) : QWidget(parent) {
+    const QFont fixed = QFontDatabase::systemFont(QFontDatabase::FixedFont);
+    QGridLayout* layout = new QGridLayout(this);
+    for (int i = 0; i < NAME_COUNT; ++i) {
+        QLabel* name = new QLabel(QString(NAMES[i]) + "=", this);
+        QLabel* value = new QLabel(this);
+        name->setFont(fixed);
+        value->setFont(fixed);
+        value->setTextFormat(Qt::RichText);
+        value->setTextInteractionFlags(Qt::TextSelectableByMouse);
+        const int row = i / REGISTERS_PER_ROW;
+        const int column = (i % REGISTERS_PER_ROW) * 2;
+        layout->addWidget(name, row, column, Qt::AlignRight);
+        layout->addWidget(value, row, column + 1, Qt::AlignLeft);
+        valueLabels.append(value);
+    }
+    const int nextRow = (NAME_COUNT + REGISTERS_PER_ROW - 1) / REGISTERS_PER_ROW;
+    flagsLabel = new QLabel(this);
+    instructionLabel = new QLabel(this);
+    latencyLabel = new QLabel(this);
+    for (QLabel* label : {flagsLabel, instructionLabel, latencyLabel}) {
+        label->setFont(fixed);
+        label->setTextInteractionFlags(Qt::TextSelectableByMouse);
+    }
+    flagsLabel->setTextFormat(Qt::RichText);
+    layout->addWidget(flagsLabel, nextRow, 0, 1, REGISTERS_PER_ROW * 2);
+    layout->addWidget(instructionLabel, nextRow + 1, 0, 1, REGISTERS_PER_ROW * 2);
+    layout->addWidget(latencyLabel, nextRow + 2, 0, 1, REGISTERS_PER_ROW * 2);
+    layout->setRowStretch(nextRow + 3, 1);
+    layout->setColumnStretch(REGISTERS_PER_ROW * 2, 1);
+    clear();
+}
+
+void RegisterView::setState(const CpuState& state, const CpuState& previous, const QString& instruction, quint16 flagsRead,
+                            double latencyMicroseconds, quint64 clocks) {
+    for (int i = 0; i < NAME_COUNT; ++i) {
+        const quint16 value = valueOf(state, i);
+        valueLabels[i]->setText(formatValue(value, value != valueOf(previous, i)));
+    }
+
+    QStringList flags;
+    for (const FlagName& flag : FLAG_NAMES) {
+        const bool set = state.flags & flag.mask;
+        QString text = set ? flag.set : flag.clear;
+        if (flagsRead & flag.mask) text = "<u>" + text + "</u>";
+        flags.append((state.flags ^ previous.flags) & flag.mask
+                         ? QString("<b><font color=\"%1\">%2</font></b>").arg(CHANGED_COLOR, text)
+                         : text);
+    }
+    flagsLabel->setText(flags.join(' '));
+    instructionLabel->setText(QString("%1:%2  %3").arg(InstructionDecoder::hexWord(state.segments[Emulator::CS]),
+                                                       InstructionDecoder::hexWord(state.ip), instruction));
+    latencyLabel->setText(tr("Last command: %1 µs, about %2 clocks").arg(latencyMicroseconds, 0, 'f', 1).arg(clocks));
+}
+
+void RegisterView::clear() {
+    for (QLabel* label : valueLabels) {
+        label->setText("----");
+    }
+    flagsLabel->clear();
+    instructionLabel->setText(tr("Not debugging"));
+    latencyLabel->clear();
+}
+
+QString RegisterView::formatValue(quint16 value, bool changed) {
+    const QString text = InstructionDecoder::hexWord(value);
+    return changed ? QString("<b><font color=\"%1\">%2</font></b>").arg(CHANGED_COLOR, text) : text;
+}
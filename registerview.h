@@ -0,0 +1,31 @@
+#ifndef REGISTERVIEW_H
+#define REGISTERVIEW_H
+
+#include <QWidget>
+#include <QVector>
+#include "emulator.h"
+
+class QLabel;
+
+// The register and flag display of the debugger, in the layout of DEBUG's R command.
+class RegisterView : public QWidget {
+    Q_OBJECT
+public:
+    explicit RegisterView(QWidget* parent = nullptr);
+    // Flags in flagsRead are underlined: the next instruction depends on them.
+    void setState(const CpuState& state, const CpuState& previous, const QString& instruction, quint16 flagsRead,
+                  double latencyMicroseconds, quint64 clocks);
+    void clear();
+private:
+    static constexpr int REGISTERS_PER_ROW = 4;
+    static const QString CHANGED_COLOR;
+
+    QVector<QLabel*> valueLabels;
+    QLabel* flagsLabel;
+    QLabel* instructionLabel;
+    QLabel* latencyLabel;
+
+    static QString formatValue(quint16 value, bool changed);
+};
+
+#endif // REGISTERVIEW_H
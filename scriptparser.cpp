@@ -0,0 +1,270 @@
+#include "scriptparser.h"
+#include <QRegularExpression>
+
+namespace {
+
+const QStringList REGISTERS_8 = {"AL", "CL", "DL", "BL", "AH", "CH", "DH", "BH"};
+const QStringList REGISTERS_16 = {"AX", "CX", "DX", "BX", "SP", "BP", "SI", "DI"};
+const QStringList SEGMENT_REGISTERS = {"ES", "CS", "SS", "DS"};
+const QStringList PREFIXES = {"REP", "REPE", "REPZ", "REPNE", "REPNZ", "LOCK"};
+
+QString stripComment(const QString& text) {
+    QChar quote;
+    for (int i = 0; i < text.size(); ++i) {
+        QChar c = text[i];
+        if (!quote.isNull()) {
+            if (c == quote) quote = QChar();
+        } else if (c == '"' || c == '\'') {
+            quote = c;
+        } else if (c == ';') {
+            return text.left(i).trimmed();
+        }
+    }
+    return text.trimmed();
+}
+
+bool isIdentifier(const QString& text) {
+    static const QRegularExpression re("^[A-Z_.@$?][A-Z0-9_.@$?]*$");
+    return re.match(text).hasMatch();
+}
+
+}
+
+ScriptLine ScriptParser::parse(const QString& text) {
+    ScriptLine line;
+    line.text = text.trimmed();
+    line.empty = line.text.isEmpty();
+    if (line.empty) return line;
+
+    line.comment = line.text.startsWith(';');
+    if (line.comment) return line;
+
+    int space = line.text.indexOf(QRegularExpression("\\s"));
+    line.head = (space < 0 ? line.text : line.text.left(space)).toUpper();
+    line.tail = space < 0 ? QString() : line.text.mid(space).trimmed();
+
+    if (line.head == "A" && !line.tail.isEmpty()) {
+        QString address = line.tail.section(QRegularExpression("\\s+"), 0, 0).section(':', -1);
+        int value;
+        if (parseNumber(address, value)) {
+            line.commandAddress = value;
+        }
+    } else if (line.head == "E") {
+        parseEditCommand(line);
+    }
+
+    parseInstruction(line);
+    return line;
+}
+
+void ScriptParser::parseEditCommand(ScriptLine& line) {
+    static const QRegularExpression re("^E\\s+([0-9A-Fa-f]+:)?([0-9A-Fa-f]+)\\s+(.+)$", QRegularExpression::CaseInsensitiveOption);
+    QRegularExpressionMatch match = re.match(line.text);
+    if (!match.hasMatch()) return;
+
+    bool ok;
+    int address = match.captured(2).toInt(&ok, 16);
+    if (!ok) return;
+
+    QString dataPart = match.captured(3);
+    QByteArray data;
+
+    static const QRegularExpression stringRe("^\"(.+)\"$");
+    QRegularExpressionMatch stringMatch = stringRe.match(dataPart);
+    if (stringMatch.hasMatch()) {
+        data = stringMatch.captured(1).toLatin1();
+    } else {
+        QStringList byteParts = dataPart.split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
+        for (const QString& byteStr : byteParts) {
+            int byte = byteStr.toInt(&ok, 16);
+            if (ok && byte >= 0 && byte <= 255) {
+                data.append(static_cast<char>(byte));
+            }
+        }
+    }
+
+    if (!data.isEmpty()) {
+        line.commandAddress = address;
+        line.editData = data;
+    }
+}
+
+void ScriptParser::parseInstruction(ScriptLine& line) {
+    QString code = stripComment(line.text);
+    if (code.isEmpty()) return;
+
+    static const QRegularExpression wordRe("^(\\S+)\\s*(.*)$");
+    QRegularExpressionMatch match = wordRe.match(code);
+    QString mnemonic = match.captured(1).toUpper();
+    QString rest = match.captured(2).trimmed();
+
+    if (PREFIXES.contains(mnemonic) && !rest.isEmpty()) {
+        line.prefix = mnemonic;
+        match = wordRe.match(rest);
+        mnemonic = match.captured(1).toUpper();
+        rest = match.captured(2).trimmed();
+    }
+
+    line.mnemonic = mnemonic;
+    for (const QString& operand : splitOperands(rest)) {
+        line.operands.append(parseOperand(operand));
+    }
+}
+
+QStringList ScriptParser::splitOperands(const QString& text) {
+    QStringList operands;
+    if (text.trimmed().isEmpty()) return operands;
+
+    QString current;
+    QChar quote;
+    int depth = 0;
+    for (const QChar& c : text) {
+        if (!quote.isNull()) {
+            current += c;
+            if (c == quote) quote = QChar();
+            continue;
+        }
+        if (c == '"' || c == '\'') {
+            quote = c;
+        } else if (c == '[') {
+            ++depth;
+        } else if (c == ']') {
+            --depth;
+        } else if (c == ',' && depth == 0) {
+            operands.append(current.trimmed());
+            current.clear();
+            continue;
+        }
+        current += c;
+    }
+    operands.append(current.trimmed());
+    return operands;
+}
+
+Operand ScriptParser::parseOperand(const QString& text) {
+    Operand operand;
+    operand.text = text.trimmed();
+    if (operand.text.isEmpty()) {
+        operand.type = Operand::Invalid;
+        return operand;
+    }
+
+    if (operand.text.startsWith('"') || operand.text.startsWith('\'')) {
+        QChar quote = operand.text[0];
+        if (operand.text.size() >= 2 && operand.text.endsWith(quote)) {
+            operand.type = Operand::String;
+            operand.label = operand.text.mid(1, operand.text.size() - 2);
+        } else {
+            operand.type = Operand::Invalid;
+        }
+        return operand;
+    }
+
+    QString s = operand.text.toUpper();
+    static const QRegularExpression qualifierRe("^(BYTE|WORD|SHORT|NEAR|FAR)(\\s+PTR)?\\s+(.*)$");
+    for (QRegularExpressionMatch match = qualifierRe.match(s); match.hasMatch(); match = qualifierRe.match(s)) {
+        QString qualifier = match.captured(1);
+        if (qualifier == "BYTE") operand.size = 1;
+        else if (qualifier == "WORD") operand.size = 2;
+        else if (qualifier == "SHORT") operand.isShort = true;
+        else if (qualifier == "NEAR") operand.isNear = true;
+        else if (qualifier == "FAR") operand.isFar = true;
+        s = match.captured(3).trimmed();
+    }
+
+    static const QRegularExpression overrideRe("^(ES|CS|SS|DS)\\s*:\\s*(\\[.*)$");
+    QRegularExpressionMatch overrideMatch = overrideRe.match(s);
+    if (overrideMatch.hasMatch()) {
+        operand.segmentOverride = SEGMENT_REGISTERS.indexOf(overrideMatch.captured(1));
+        s = overrideMatch.captured(2);
+    }
+
+    if (s.startsWith('[') && s.endsWith(']')) {
+        operand.type = Operand::Memory;
+        QString inner = s.mid(1, s.size() - 2).remove(' ');
+        static const QRegularExpression termRe("([+-]?)([^+-]+)");
+        bool bx = false, bp = false, si = false, di = false;
+        QRegularExpressionMatchIterator it = termRe.globalMatch(inner);
+        if (!it.hasNext()) {
+            operand.type = Operand::Invalid;
+            return operand;
+        }
+        while (it.hasNext()) {
+            QRegularExpressionMatch term = it.next();
+            QString name = term.captured(2);
+            bool negative = term.captured(1) == "-";
+            int value;
+            if (name == "BX" && !negative && !bx) bx = true;
+            else if (name == "BP" && !negative && !bp) bp = true;
+            else if (name == "SI" && !negative && !si) si = true;
+            else if (name == "DI" && !negative && !di) di = true;
+            else if (parseNumber(name, value)) operand.value += negative ? -value : value;
+            else if (isIdentifier(name) && operand.label.isEmpty() && !negative) operand.label = name;
+            else {
+                operand.type = Operand::Invalid;
+                return operand;
+            }
+        }
+        if ((bx && bp) || (si && di)) {
+            operand.type = Operand::Invalid;
+        } else if (bx && si) operand.rm = 0;
+        else if (bx && di) operand.rm = 1;
+        else if (bp && si) operand.rm = 2;
+        else if (bp && di) operand.rm = 3;
+        else if (si) operand.rm = 4;
+        else if (di) operand.rm = 5;
+        else if (bp) operand.rm = 6;
+        else if (bx) operand.rm = 7;
+        return operand;
+    }
+
+    if (REGISTERS_8.contains(s)) {
+        operand.type = Operand::Register8;
+        operand.reg = REGISTERS_8.indexOf(s);
+        return operand;
+    }
+    if (REGISTERS_16.contains(s)) {
+        operand.type = Operand::Register16;
+        operand.reg = REGISTERS_16.indexOf(s);
+        return operand;
+    }
+    if (SEGMENT_REGISTERS.contains(s)) {
+        operand.type = Operand::SegmentRegister;
+        operand.reg = SEGMENT_REGISTERS.indexOf(s);
+        return operand;
+    }
+
+    static const QRegularExpression farRe("^([0-9A-F]+)\\s*:\\s*([0-9A-F]+)$");
+    QRegularExpressionMatch farMatch = farRe.match(s);
+    if (farMatch.hasMatch() && parseNumber(farMatch.captured(1), operand.segment) && parseNumber(farMatch.captured(2), operand.value)) {
+        operand.type = Operand::FarAddress;
+        return operand;
+    }
+
+    if (parseNumber(s, operand.value)) {
+        operand.type = Operand::Immediate;
+        return operand;
+    }
+    if (isIdentifier(s)) {
+        operand.type = Operand::Immediate;
+        operand.label = s;
+        return operand;
+    }
+
+    operand.type = Operand::Invalid;
+    return operand;
+}
+
+bool ScriptParser::parseNumber(const QString& text, int& value) {
+    QString s = text.trimmed();
+    bool negative = s.startsWith('-');
+    if (negative) s = s.mid(1);
+    if (s.endsWith('H', Qt::CaseInsensitive)) s.chop(1);
+    if (s.isEmpty() || s.size() > 8) return false;
+
+    bool ok;
+    qint64 parsed = s.toLongLong(&ok, 16);
+    if (!ok) return false;
+    value = int(negative ? -parsed : parsed);
+    return true;
+}
@@ -0,0 +1,49 @@
+#ifndef SCRIPTPARSER_H
+#define SCRIPTPARSER_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QVector>
+
+struct Operand {
+    enum Type { None, Register8, Register16, SegmentRegister, Immediate, Memory, FarAddress, String, Invalid };
+    Type type = None;
+    int reg = 0;
+    int value = 0;
+    int segment = 0;
+    int rm = -1;
+    int size = 0;
+    int segmentOverride = -1;
+    bool isShort = false;
+    bool isNear = false;
+    bool isFar = false;
+    QString label;
+    QString text;
+};
+
+struct ScriptLine {
+    QString text;
+    bool empty = true;
+    bool comment = false;
+    QString head;
+    QString tail;
+    int commandAddress = -1;
+    QByteArray editData;
+    QString prefix;
+    QString mnemonic;
+    QVector<Operand> operands;
+};
+
+class ScriptParser {
+public:
+    static ScriptLine parse(const QString& text);
+    static Operand parseOperand(const QString& text);
+    static bool parseNumber(const QString& text, int& value);
+    static QStringList splitOperands(const QString& text);
+private:
+    static void parseEditCommand(ScriptLine& line);
+    static void parseInstruction(ScriptLine& line);
+};
+
+#endif // SCRIPTPARSER_H
@@ -9,7 +9,6 @@ class ScriptRunner : public QObject {
 public:
     ScriptRunner(QObject* parent = nullptr);
     ~ScriptRunner();
-    QString convertComToTxt(const QString& path);
     QString pasteCodeToDebug(const QString& filePath);
     void compileAndRunCom(const QString& filePath);
 signals:
@@ -5,109 +5,111 @@
 #include <QDialogButtonBox>
 #include <QRegularExpressionValidator>
 #include <QColorDialog>
+#include <QEvent>
 
 SettingsDialog::SettingsDialog(QWidget* parent) : QDialog(parent) {
-    setWindowTitle(tr("Settings"));
-
     QVBoxLayout* mainLayout = new QVBoxLayout(this);
 
-    QLabel* themeLabel = new QLabel(tr("Theme:"), this);
+    themeLabel = new QLabel(this);
     themeComboBox = new QComboBox(this);
-    themeComboBox->addItem(tr("Light"), "Light");
-    themeComboBox->addItem(tr("Dark"), "Dark");
-    themeComboBox->addItem(tr("Custom"), "Custom");
+    themeComboBox->addItem(QString(), "Light");
+    themeComboBox->addItem(QString(), "Dark");
+    themeComboBox->addItem(QString(), "Custom");
     mainLayout->addWidget(themeLabel);
     mainLayout->addWidget(themeComboBox);
 
-    QLabel* backgroundColorLabel = new QLabel(tr("Background Color:"), this);
-    backgroundColorButton = new QPushButton(tr("Select Color"), this);
+    backgroundColorLabel = new QLabel(this);
+    backgroundColorButton = new QPushButton(this);
     connect(backgroundColorButton, &QPushButton::clicked, this, &SettingsDialog::selectBackgroundColor);
     mainLayout->addWidget(backgroundColorLabel);
     mainLayout->addWidget(backgroundColorButton);
 
-    QLabel* textColorLabel = new QLabel(tr("Text Color:"), this);
-    textColorButton = new QPushButton(tr("Select Color"), this);
+    textColorLabel = new QLabel(this);
+    textColorButton = new QPushButton(this);
     connect(textColorButton, &QPushButton::clicked, this, &SettingsDialog::selectTextColor);
     mainLayout->addWidget(textColorLabel);
     mainLayout->addWidget(textColorButton);
 
-    QLabel* highlightColorLabel = new QLabel(tr("Highlight Color:"), this);
-    highlightColorButton = new QPushButton(tr("Select Color"), this);
+    highlightColorLabel = new QLabel(this);
+    highlightColorButton = new QPushButton(this);
     connect(highlightColorButton, &QPushButton::clicked, this, &SettingsDialog::selectHighlightColor);
     mainLayout->addWidget(highlightColorLabel);
     mainLayout->addWidget(highlightColorButton);
 
-    QLabel* fontLabel = new QLabel(tr("Font:"), this);
+    fontLabel = new QLabel(this);
     fontComboBox = new QFontComboBox(this);
     mainLayout->addWidget(fontLabel);
     mainLayout->addWidget(fontComboBox);
 
-    QLabel* fontSizeLabel = new QLabel(tr("Font Size:"), this);
+    fontSizeLabel = new QLabel(this);
     fontSizeSpinBox = new QSpinBox(this);
     fontSizeSpinBox->setRange(8, 24);
     mainLayout->addWidget(fontSizeLabel);
     mainLayout->addWidget(fontSizeSpinBox);
 
-    standardLineNumberingCheckBox = new QCheckBox(tr("Show Line Numbers"), this);
+    standardLineNumberingCheckBox = new QCheckBox(this);
     mainLayout->addWidget(standardLineNumberingCheckBox);
 
-    addressLineNumberingCheckBox = new QCheckBox(tr("Show Instruction Addresses"), this);
+    addressLineNumberingCheckBox = new QCheckBox(this);
     mainLayout->addWidget(addressLineNumberingCheckBox);
 
-    lineWrapCheckBox = new QCheckBox(tr("Line Wrap"), this);
+    lineWrapCheckBox = new QCheckBox(this);
     mainLayout->addWidget(lineWrapCheckBox);
 
-    autoSaveCheckBox = new QCheckBox(tr("Enable Auto-Save"), this);
+    autoSaveCheckBox = new QCheckBox(this);
     mainLayout->addWidget(autoSaveCheckBox);
 
-    syntaxHighlightingCheckBox = new QCheckBox(tr("Enable Syntax Highlighting"), this);
+    syntaxHighlightingCheckBox = new QCheckBox(this);
     mainLayout->addWidget(syntaxHighlightingCheckBox);
 
-    QLabel* languageLabel = new QLabel(tr("Language:"), this);
+    languageLabel = new QLabel(this);
     languageComboBox = new QComboBox(this);
-    languageComboBox->addItem(tr("English"), "English");
-    languageComboBox->addItem(tr("Russian"), "Russian");
+    languageComboBox->addItem(QString(), "English");
+    languageComboBox->addItem(QString(), "Russian");
     mainLayout->addWidget(languageLabel);
     mainLayout->addWidget(languageComboBox);
-    connect(languageComboBox, &QComboBox::currentTextChanged, this, [this](const QString&) {
-        emit languageChanged(languageComboBox->itemData(languageComboBox->currentIndex()).toString());
+    connect(languageComboBox, &QComboBox::currentIndexChanged, this, [this](int index) {
+        emit languageChanged(languageComboBox->itemData(index).toString());
     });
 
-    showMemoryDumpCheckBox = new QCheckBox(tr("Show Memory Dump"), this);
+    showMemoryDumpCheckBox = new QCheckBox(this);
     mainLayout->addWidget(showMemoryDumpCheckBox);
 
-    QLabel* memoryDumpSegmentLabel = new QLabel(tr("Memory Dump Segment:"), this);
+    memoryDumpSegmentLabel = new QLabel(this);
     memoryDumpSegmentEdit = new QLineEdit(this);
     memoryDumpSegmentEdit->setPlaceholderText("1000");
     memoryDumpSegmentEdit->setValidator(new QRegularExpressionValidator(QRegularExpression("[0-9A-Fa-f]{1,4}"), memoryDumpSegmentEdit));
     mainLayout->addWidget(memoryDumpSegmentLabel);
     mainLayout->addWidget(memoryDumpSegmentEdit);
 
-    QLabel* memoryDumpOffsetLabel = new QLabel(tr("Memory Dump Offset:"), this);
+    memoryDumpOffsetLabel = new QLabel(this);
     memoryDumpOffsetEdit = new QLineEdit(this);
     memoryDumpOffsetEdit->setPlaceholderText("200");
     memoryDumpOffsetEdit->setValidator(new QRegularExpressionValidator(QRegularExpression("[0-9A-Fa-f]{1,4}"), memoryDumpOffsetEdit));
     mainLayout->addWidget(memoryDumpOffsetLabel);
     mainLayout->addWidget(memoryDumpOffsetEdit);
 
-    QLabel* memoryDumpLineCountLabel = new QLabel(tr("Memory Dump Line Count:"), this);
+    memoryDumpLineCountLabel = new QLabel(this);
     memoryDumpLineCountSpinBox = new QSpinBox(this);
     memoryDumpLineCountSpinBox->setRange(1, 32);
     memoryDumpLineCountSpinBox->setValue(8);
     mainLayout->addWidget(memoryDumpLineCountLabel);
     mainLayout->addWidget(memoryDumpLineCountSpinBox);
 
-    showOutputConsoleCheckBox = new QCheckBox(tr("Show Output Console"), this);
+    showOutputConsoleCheckBox = new QCheckBox(this);
     mainLayout->addWidget(showOutputConsoleCheckBox);
 
-    resetButton = new QPushButton(tr("Reset to Defaults"), this);
+    unloadIdleTabsCheckBox = new QCheckBox(this);
+    mainLayout->addWidget(unloadIdleTabsCheckBox);
+
+    resetButton = new QPushButton(this);
     mainLayout->addWidget(resetButton);
     connect(resetButton, &QPushButton::clicked, this, &SettingsDialog::resetToDefaults);
 
     QDialogButtonBox* buttonBox = new QDialogButtonBox(this);
-    okButton = buttonBox->addButton(tr("OK"), QDialogButtonBox::AcceptRole);
+    okButton = buttonBox->addButton(QString(), QDialogButtonBox::AcceptRole);
     okButton->setIcon(style()->standardIcon(QStyle::SP_DialogOkButton));
-    cancelButton = buttonBox->addButton(tr("Cancel"), QDialogButtonBox::RejectRole);
+    cancelButton = buttonBox->addButton(QString(), QDialogButtonBox::RejectRole);
     cancelButton->setIcon(style()->standardIcon(QStyle::SP_DialogCancelButton));
     mainLayout->addWidget(buttonBox);
 
@@ -116,6 +118,48 @@ SettingsDialog::SettingsDialog(QWidget* parent) : QDialog(parent) {
         accept();
     });
     connect(buttonBox, &QDialogButtonBox::rejected, this, &QDialog::reject);
+
+    retranslateUi();
+}
+
+void SettingsDialog::changeEvent(QEvent* event) {
+    if (event->type() == QEvent::LanguageChange) {
+        retranslateUi();
+    }
+    QDialog::changeEvent(event);
+}
+
+void SettingsDialog::retranslateUi() {
+    setWindowTitle(tr("Settings"));
+    themeLabel->setText(tr("Theme:"));
+    themeComboBox->setItemText(0, tr("Light"));
+    themeComboBox->setItemText(1, tr("Dark"));
+    themeComboBox->setItemText(2, tr("Custom"));
+    backgroundColorLabel->setText(tr("Background Color:"));
+    backgroundColorButton->setText(tr("Select Color"));
+    textColorLabel->setText(tr("Text Color:"));
+    textColorButton->setText(tr("Select Color"));
+    highlightColorLabel->setText(tr("Highlight Color:"));
+    highlightColorButton->setText(tr("Select Color"));
+    fontLabel->setText(tr("Font:"));
+    fontSizeLabel->setText(tr("Font Size:"));
+    standardLineNumberingCheckBox->setText(tr("Show Line Numbers"));
+    addressLineNumberingCheckBox->setText(tr("Show Instruction Addresses"));
+    lineWrapCheckBox->setText(tr("Line Wrap"));
+    autoSaveCheckBox->setText(tr("Enable Auto-Save"));
+    syntaxHighlightingCheckBox->setText(tr("Enable Syntax Highlighting"));
+    languageLabel->setText(tr("Language:"));
+    languageComboBox->setItemText(0, tr("English"));
+    languageComboBox->setItemText(1, tr("Russian"));
+    showMemoryDumpCheckBox->setText(tr("Show Memory Dump"));
+    memoryDumpSegmentLabel->setText(tr("Memory Dump Segment:"));
+    memoryDumpOffsetLabel->setText(tr("Memory Dump Offset:"));
+    memoryDumpLineCountLabel->setText(tr("Memory Dump Line Count:"));
+    showOutputConsoleCheckBox->setText(tr("Show Output Console"));
+    unloadIdleTabsCheckBox->setText(tr("Unload Idle Tabs"));
+    resetButton->setText(tr("Reset to Defaults"));
+    okButton->setText(tr("OK"));
+    cancelButton->setText(tr("Cancel"));
 }
 
 QMap<QString, QVariant> SettingsDialog::getSettings() const {
@@ -138,6 +182,7 @@ QMap<QString, QVariant> SettingsDialog::getSettings() const {
     settings["memoryDumpOffset"] = memoryDumpOffsetEdit->text();
     settings["memoryDumpLineCount"] = memoryDumpLineCountSpinBox->value();
     settings["showOutputConsole"] = showOutputConsoleCheckBox->isChecked();
+    settings["unloadIdleTabs"] = unloadIdleTabsCheckBox->isChecked();
     return settings;
 }
 
@@ -167,6 +212,7 @@ void SettingsDialog::setSettings(const QMap<QString, QVariant>& settings) {
     memoryDumpOffsetEdit->setText(settings["memoryDumpOffset"].toString());
     memoryDumpLineCountSpinBox->setValue(settings["memoryDumpLineCount"].toInt());
     showOutputConsoleCheckBox->setChecked(settings["showOutputConsole"].toBool());
+    unloadIdleTabsCheckBox->setChecked(settings["unloadIdleTabs"].toBool());
 }
 
 void SettingsDialog::resetToDefaults() {
@@ -188,6 +234,7 @@ void SettingsDialog::resetToDefaults() {
     memoryDumpOffsetEdit->setText("200");
     memoryDumpLineCountSpinBox->setValue(8);
     showOutputConsoleCheckBox->setChecked(false);
+    unloadIdleTabsCheckBox->setChecked(false);
 }
 
 void SettingsDialog::selectBackgroundColor() {
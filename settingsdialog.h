@@ -9,6 +9,7 @@
 #include <QPushButton>
 #include <QColorDialog>
 #include <QLineEdit>
+#include <QLabel>
 
 class SettingsDialog : public QDialog {
     Q_OBJECT
@@ -16,6 +17,8 @@ public:
     explicit SettingsDialog(QWidget* parent = nullptr);
     QMap<QString, QVariant> getSettings() const;
     void setSettings(const QMap<QString, QVariant>& settings);
+protected:
+    void changeEvent(QEvent* event) override;
 signals:
     void saveSettingsRequested(const QMap<QString, QVariant>& settings);
     void languageChanged(const QString& language);
@@ -25,6 +28,17 @@ private slots:
     void selectTextColor();
     void selectHighlightColor();
 private:
+    void retranslateUi();
+    QLabel* themeLabel;
+    QLabel* backgroundColorLabel;
+    QLabel* textColorLabel;
+    QLabel* highlightColorLabel;
+    QLabel* fontLabel;
+    QLabel* fontSizeLabel;
+    QLabel* languageLabel;
+    QLabel* memoryDumpSegmentLabel;
+    QLabel* memoryDumpOffsetLabel;
+    QLabel* memoryDumpLineCountLabel;
     QComboBox* themeComboBox;
     QFontComboBox* fontComboBox;
     QSpinBox* fontSizeSpinBox;
@@ -42,6 +56,7 @@ private:
     QLineEdit* memoryDumpOffsetEdit;
     QSpinBox* memoryDumpLineCountSpinBox;
     QCheckBox* showOutputConsoleCheckBox;
+    QCheckBox* unloadIdleTabsCheckBox;
     QPushButton* resetButton;
     QPushButton* okButton;
     QPushButton* cancelButton;
@@ -7,61 +7,81 @@ const QString SettingsManager::APPLICATION_NAME = "Debug3000";
 
 SettingsManager::SettingsManager(QObject* parent) : QObject(parent) {
     settings = new QSettings(ORGANIZATION_NAME, APPLICATION_NAME, this);
+    readFromStorage();
 }
 
 SettingsManager::~SettingsManager() {
 }
 
-QMap<QString, QVariant> SettingsManager::loadSettings() {
-    QMap<QString, QVariant> result;
-    result["theme"] = settings->value("theme", "Light").toString();
-    result["backgroundColor"] = settings->value("backgroundColor", QColor(Qt::white)).value<QColor>();
-    result["textColor"] = settings->value("textColor", QColor(Qt::black)).value<QColor>();
-    result["highlightColor"] = settings->value("highlightColor", QColor(Qt::darkGray).lighter(160)).value<QColor>();
-    result["font"] = settings->value("font", QFont("Courier New", 10));
-    result["standardLineNumbering"] = settings->value("standardLineNumbering", true).toBool();
-    result["addressLineNumbering"] = settings->value("addressLineNumbering", true).toBool();
-    result["lineWrap"] = settings->value("lineWrap", false).toBool();
-    result["autoSave"] = settings->value("autoSave", false).toBool();
-    result["syntaxHighlighting"] = settings->value("syntaxHighlighting", true).toBool();
-    result["language"] = settings->value("language", "English").toString();
-    result["showMemoryDump"] = settings->value("showMemoryDump", false).toBool();
-    result["memoryDumpSegment"] = settings->value("memoryDumpSegment", "1000").toString();
-    result["memoryDumpOffset"] = settings->value("memoryDumpOffset", "200").toString();
-    result["memoryDumpLineCount"] = settings->value("memoryDumpLineCount", 8).toInt();
-    result["showOutputConsole"] = settings->value("showOutputConsole", false).toBool();
-    return result;
+void SettingsManager::readFromStorage() {
+    const EditorSettings defaults = EditorSettings::defaults();
+    QMap<QString, QVariant> stored = defaults.toMap();
+    for (auto it = stored.begin(); it != stored.end(); ++it) {
+        it.value() = settings->value(it.key(), it.value());
+    }
+    cache = EditorSettings::fromMap(stored, defaults);
+}
+
+const EditorSettings& SettingsManager::currentSettings() const {
+    return cache;
+}
+
+QMap<QString, QVariant> SettingsManager::loadSettings() const {
+    return cache.toMap();
 }
 
 void SettingsManager::saveSettings(const QMap<QString, QVariant>& settingsMap) {
-    for (auto it = settingsMap.constBegin(); it != settingsMap.constEnd(); ++it) {
-        settings->setValue(it.key(), it.value());
+    EditorSettings updated = EditorSettings::fromMap(settingsMap, cache);
+    QSet<QString> changedKeys = cache.changedKeys(updated);
+    if (changedKeys.isEmpty()) {
+        return;
+    }
+
+    cache = updated;
+    const QMap<QString, QVariant> values = cache.toMap();
+    for (const QString& key : changedKeys) {
+        settings->setValue(key, values[key]);
     }
     settings->sync();
-    emit settingsChanged(settingsMap);
+    emit settingsChanged(cache, changedKeys);
 }
 
 void SettingsManager::applySettings() {
-    emit settingsChanged(loadSettings());
+    emit settingsChanged(cache, EditorSettings::allKeys());
 }
 
 void SettingsManager::resetToDefaults() {
-    QMap<QString, QVariant> defaultSettings;
-    defaultSettings["theme"] = "Light";
-    defaultSettings["backgroundColor"] = QColor(Qt::white);
-    defaultSettings["textColor"] = QColor(Qt::black);
-    defaultSettings["highlightColor"] = QColor(Qt::darkGray).lighter(160);
-    defaultSettings["font"] = QFont("Courier New", 10);
-    defaultSettings["standardLineNumbering"] = true;
-    defaultSettings["addressLineNumbering"] = true;
-    defaultSettings["lineWrap"] = false;
-    defaultSettings["autoSave"] = false;
-    defaultSettings["syntaxHighlighting"] = true;
-    defaultSettings["language"] = "English";
-    defaultSettings["showMemoryDump"] = false;
-    defaultSettings["memoryDumpSegment"] = "1000";
-    defaultSettings["memoryDumpOffset"] = "200";
-    defaultSettings["memoryDumpLineCount"] = 8;
-    defaultSettings["showOutputConsole"] = false;
-    saveSettings(defaultSettings);
+    saveSettings(EditorSettings::defaults().toMap());
+}
+
+QList<SessionTab> SettingsManager::loadSession() const {
+    QList<SessionTab> tabs;
+    int count = settings->beginReadArray("session");
+    for (int i = 0; i < count; ++i) {
+        settings->setArrayIndex(i);
+        SessionTab tab;
+        tab.filePath = settings->value("filePath").toString();
+        tab.cursorPosition = settings->value("cursorPosition", 0).toInt();
+        tab.scrollPosition = settings->value("scrollPosition", 0).toInt();
+        tab.current = settings->value("current", false).toBool();
+        if (!tab.filePath.isEmpty()) {
+            tabs.append(tab);
+        }
+    }
+    settings->endArray();
+    return tabs;
+}
+
+void SettingsManager::saveSession(const QList<SessionTab>& tabs) {
+    settings->remove("session");
+    settings->beginWriteArray("session", tabs.size());
+    for (int i = 0; i < tabs.size(); ++i) {
+        settings->setArrayIndex(i);
+        settings->setValue("filePath", tabs[i].filePath);
+        settings->setValue("cursorPosition", tabs[i].cursorPosition);
+        settings->setValue("scrollPosition", tabs[i].scrollPosition);
+        settings->setValue("current", tabs[i].current);
+    }
+    settings->endArray();
+    settings->sync();
 }
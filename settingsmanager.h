@@ -4,23 +4,38 @@
 #include <QObject>
 #include <QSettings>
 #include <QMap>
+#include <QSet>
 #include <QVariant>
+#include <QList>
+#include "editorsettings.h"
+
+struct SessionTab {
+    QString filePath;
+    int cursorPosition = 0;
+    int scrollPosition = 0;
+    bool current = false;
+};
 
 class SettingsManager : public QObject {
     Q_OBJECT
 public:
     SettingsManager(QObject* parent = nullptr);
     ~SettingsManager();
-    QMap<QString, QVariant> loadSettings();
+    const EditorSettings& currentSettings() const;
+    QMap<QString, QVariant> loadSettings() const;
     void saveSettings(const QMap<QString, QVariant>& settings);
     void applySettings();
     void resetToDefaults();
+    QList<SessionTab> loadSession() const;
+    void saveSession(const QList<SessionTab>& tabs);
 signals:
-    void settingsChanged(const QMap<QString, QVariant>& settings);
+    void settingsChanged(const EditorSettings& settings, const QSet<QString>& changedKeys);
 private:
     static const QString ORGANIZATION_NAME;
     static const QString APPLICATION_NAME;
     QSettings* settings;
+    EditorSettings cache;
+    void readFromStorage();
 };
 
 #endif // SETTINGSMANAGER_H
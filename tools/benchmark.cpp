@@ -0,0 +1,326 @@
+// Micro-benchmarks for the editor's hot paths over synthetic DEBUG scripts, reported as JSON.
+//
+// Each benchmark repeats until it has run for at least MIN_BENCHMARK_MS, then reports the minimum, median and
+// mean of the individual runs so results from different machines and builds can be tracked over time.
+
+#include <QApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QScrollBar>
+#include <QSyntaxHighlighter>
+#include <QSysInfo>
+#include <QTemporaryDir>
+#include <QTextBlock>
+#include <QTextCursor>
+#include <QTextStream>
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include "../codeeditor.h"
+#include "../filecontroller.h"
+#include "../scriptparser.h"
+#include "../instructionencoder.h"
+#include "../instructiondecoder.h"
+#include "../disassembler.h"
+
+namespace {
+
+const int MIN_BENCHMARK_MS = 200;
+const int MIN_ITERATIONS = 3;
+const int MAX_ITERATIONS = 1000;
+const int LINES_PER_BLOCK = 4000;
+const int EDITOR_WIDTH = 1000;
+const int EDITOR_HEIGHT = 700;
+const int MAX_COM_SIZE = 0xFF00;
+const int DEFAULT_SIZES[] = {1000, 10000, 100000};
+
+const char* const INSTRUCTIONS[] = {
+    "MOV AX,1234", "MOV BX,[SI+10]", "ADD AX,BX", "SUB CX,[BP-2]", "CMP AL,0D", "JMP 0100",
+    "MOV DX,0200", "MOV AH,09", "INT 21", "PUSH AX", "POP BX", "XOR SI,SI", "INC DI", "LODSB",
+    "MOV [0300],AX", "SHL DX,1", "CALL 0100", "RET", "; reload the counter", "MOV CX,0010",
+};
+
+struct Script {
+    QString kind;
+    QString text;
+    int lines = 0;
+};
+
+struct Result {
+    QString name;
+    QString script;
+    int lines = 0;
+    QVector<qint64> nanoseconds;
+};
+
+int countLines(const QString& text) {
+    return text.count('\n') + 1;
+}
+
+// An "A" block of instructions, restarted at 100 every LINES_PER_BLOCK lines so addresses stay inside the segment.
+Script codeScript(int lines) {
+    QString text;
+    QTextStream out(&text);
+    const int instructionCount = int(sizeof(INSTRUCTIONS) / sizeof(INSTRUCTIONS[0]));
+    for (int i = 0; i < lines; ++i) {
+        if (i % LINES_PER_BLOCK == 0) {
+            if (i > 0) out << '\n';
+            out << "A 100\n";
+            continue;
+        }
+        out << INSTRUCTIONS[i % instructionCount] << '\n';
+    }
+    out << "\nR CX\n100\nN BENCH.COM\nW\nQ";
+    return {"code", text, countLines(text)};
+}
+
+// Mostly E commands of 16 hex bytes, with a quoted string every eighth line.
+Script dataScript(int lines) {
+    QString text;
+    QTextStream out(&text);
+    for (int i = 0; i < lines; ++i) {
+        const int address = 0x200 + (i * 0x10) % 0xFD00;
+        out << "E " << QString::number(address, 16).toUpper();
+        if (i % 8 == 7) {
+            out << " \"Line " << i << " of the data\"";
+        } else {
+            for (int j = 0; j < 16; ++j) {
+                out << ' ' << InstructionDecoder::hexByte((i * 31 + j * 7) & 0xFF);
+            }
+        }
+        out << '\n';
+    }
+    out << "Q";
+    return {"data", text, countLines(text)};
+}
+
+// A COM image of encoded instructions, about three bytes per requested line up to the size DEBUG can write.
+QByteArray comImage(int lines) {
+    const int size = qMin(lines * 3, MAX_COM_SIZE);
+    const int instructionCount = int(sizeof(INSTRUCTIONS) / sizeof(INSTRUCTIONS[0]));
+    QByteArray image;
+    for (int i = 0; image.size() < size; ++i) {
+        const ScriptLine line = ScriptParser::parse(INSTRUCTIONS[i % instructionCount]);
+        if (line.mnemonic.isEmpty()) continue;
+        image.append(InstructionEncoder::encode(line, 0x100 + int(image.size())).bytes);
+    }
+    return image.left(size);
+}
+
+Script disassemblyScript(const QByteArray& image) {
+    const QString text = Disassembler::toScript(Disassembler::disassemble(image));
+    return {"disassembly", text, countLines(text)};
+}
+
+Result measure(const QString& name, const Script& script, const std::function<void()>& run,
+               const std::function<void()>& prepare = std::function<void()>()) {
+    Result result;
+    result.name = name;
+    result.script = script.kind;
+    result.lines = script.lines;
+    QElapsedTimer total;
+    total.start();
+    while (result.nanoseconds.size() < MAX_ITERATIONS
+           && (result.nanoseconds.size() < MIN_ITERATIONS || total.elapsed() < MIN_BENCHMARK_MS)) {
+        if (prepare) prepare();
+        QElapsedTimer timer;
+        timer.start();
+        run();
+        result.nanoseconds.append(timer.nsecsElapsed());
+    }
+    std::fprintf(stderr, "%-34s %-12s %7d lines %10.3f ms\n", qPrintable(name), qPrintable(script.kind), script.lines,
+                 *std::min_element(result.nanoseconds.begin(), result.nanoseconds.end()) / 1e6);
+    return result;
+}
+
+QJsonObject toJson(const Result& result) {
+    QVector<qint64> sorted = result.nanoseconds;
+    std::sort(sorted.begin(), sorted.end());
+    double sum = 0;
+    for (qint64 value : sorted) {
+        sum += value;
+    }
+    QJsonObject object;
+    object["name"] = result.name;
+    object["script"] = result.script;
+    object["lines"] = result.lines;
+    object["iterations"] = int(sorted.size());
+    object["min_ms"] = sorted.first() / 1e6;
+    object["median_ms"] = sorted[sorted.size() / 2] / 1e6;
+    object["mean_ms"] = sum / sorted.size() / 1e6;
+    return object;
+}
+
+// The gutter and the memory dump are plain child widgets without Q_OBJECT, so they are found by type.
+template <typename Area>
+Area* editorArea(CodeEditor& editor) {
+    for (QWidget* child : editor.findChildren<QWidget*>()) {
+        if (Area* area = dynamic_cast<Area*>(child)) return area;
+    }
+    return nullptr;
+}
+
+void benchmarkEditor(const Script& script, QVector<Result>& results) {
+    CodeEditor editor;
+    editor.resize(EDITOR_WIDTH, EDITOR_HEIGHT);
+    editor.setStandardLineNumbering(true);
+    editor.setAddressLineNumbering(true);
+    editor.setSyntaxHighlighting(true);
+    editor.setShowMemoryDump(true, "1000", "200", 8);
+    editor.show();
+    QApplication::processEvents();
+
+    results.append(measure("setPlainText", script, [&]() { editor.setText(script.text); },
+                           [&]() { editor.setText(QString()); }));
+
+    QSyntaxHighlighter* highlighter = editor.document()->findChild<QSyntaxHighlighter*>();
+    if (highlighter) {
+        results.append(measure("SyntaxHighlighter::highlightBlock", script, [&]() { highlighter->rehighlight(); }));
+    }
+
+    // The middle of the document, so the gutter has to find its first visible block away from the start.
+    editor.verticalScrollBar()->setValue(editor.verticalScrollBar()->maximum() / 2);
+    QApplication::processEvents();
+    if (LineNumberArea* gutter = editorArea<LineNumberArea>(editor)) {
+        QImage image(gutter->size(), QImage::Format_ARGB32_Premultiplied);
+        results.append(measure("lineNumberAreaPaintEvent", script, [&]() { gutter->render(&image); }));
+    }
+    if (MemoryDumpArea* dump = editorArea<MemoryDumpArea>(editor)) {
+        QImage image(dump->size(), QImage::Format_ARGB32_Premultiplied);
+        results.append(measure("memoryDumpAreaPaintEvent", script, [&]() { dump->render(&image); }));
+    }
+
+    // With nothing edited this is the cost every keystroke pays to find out which dump rows changed.
+    results.append(measure("updateMemoryDump", script, [&]() { editor.updateMemoryDump(); }));
+
+    // One keystroke in the middle line: parses the line again, rebuilds the address table and patches the dump.
+    const QTextBlock middle = editor.document()->findBlockByNumber(editor.document()->blockCount() / 2);
+    int toggle = 0;
+    results.append(measure("edit line", script, [&]() {
+        QTextCursor cursor(middle);
+        cursor.movePosition(QTextCursor::EndOfBlock);
+        if (toggle++ % 2 == 0) {
+            cursor.insertText(" 00");
+        } else {
+            cursor.movePosition(QTextCursor::Left, QTextCursor::KeepAnchor, 3);
+            cursor.removeSelectedText();
+        }
+    }));
+}
+
+void benchmarkParser(const Script& script, QVector<Result>& results) {
+    const QStringList lines = script.text.split('\n');
+    results.append(measure("ScriptParser::parse", script, [&]() {
+        for (const QString& text : lines) {
+            ScriptParser::parse(text);
+        }
+    }));
+
+    QVector<ScriptLine> parsed;
+    parsed.reserve(lines.size());
+    for (const QString& text : lines) {
+        parsed.append(ScriptParser::parse(text));
+    }
+    // The walk CodeEditor::updateAddressTable does to place each instruction of an A block.
+    results.append(measure("InstructionEncoder::encode", script, [&]() {
+        int address = -1;
+        for (const ScriptLine& line : parsed) {
+            if (line.head == "A") {
+                address = line.commandAddress;
+            } else if (line.empty) {
+                address = -1;
+            } else if (address >= 0 && !line.mnemonic.isEmpty()) {
+                address += int(InstructionEncoder::encode(line, address).bytes.size());
+            }
+        }
+    }));
+}
+
+void benchmarkOpenFile(const Script& script, const QString& path, QVector<Result>& results) {
+    FileController controller;
+    results.append(measure("FileController::openFile", script, [&]() { controller.openFile(path); }));
+}
+
+bool writeFile(const QString& path, const QByteArray& data) {
+    QFile file(path);
+    return file.open(QIODevice::WriteOnly) && file.write(data) == data.size();
+}
+
+QVector<int> parseSizes(const QString& text) {
+    QVector<int> sizes;
+    for (const QString& part : text.split(',', Qt::SkipEmptyParts)) {
+        bool ok;
+        const int size = part.trimmed().toInt(&ok);
+        if (ok && size > 0) sizes.append(size);
+    }
+    return sizes;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    // Everything is rendered into images, no window ever has to reach the screen.
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication application(argc, argv);
+
+    QVector<int> sizes(std::begin(DEFAULT_SIZES), std::end(DEFAULT_SIZES));
+    QString outputPath;
+    const QStringList arguments = application.arguments();
+    for (int i = 1; i < arguments.size(); ++i) {
+        if (arguments[i] == "--sizes" && i + 1 < arguments.size()) {
+            sizes = parseSizes(arguments[++i]);
+        } else if (arguments[i] == "--output" && i + 1 < arguments.size()) {
+            outputPath = arguments[++i];
+        } else {
+            std::fprintf(stderr, "Usage: %s [--sizes 1000,10000,100000] [--output results.json]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    QTemporaryDir directory;
+    if (!directory.isValid()) {
+        std::fprintf(stderr, "Cannot create a temporary directory.\n");
+        return 1;
+    }
+
+    QVector<Result> results;
+    for (int size : sizes) {
+        const QByteArray image = comImage(size);
+        const Script scripts[] = {codeScript(size), dataScript(size), disassemblyScript(image)};
+        for (const Script& script : scripts) {
+            benchmarkParser(script, results);
+            benchmarkEditor(script, results);
+            const QString path = directory.filePath(QString("%1_%2.txt").arg(script.kind).arg(size));
+            if (writeFile(path, script.text.toUtf8())) benchmarkOpenFile(script, path, results);
+        }
+        // Opening a COM file disassembles it, which is what produced the disassembly script above.
+        const QString comPath = directory.filePath(QString("image_%1.com").arg(size));
+        if (writeFile(comPath, image)) benchmarkOpenFile(scripts[2], comPath, results);
+    }
+
+    QJsonArray entries;
+    for (const Result& result : results) {
+        entries.append(toJson(result));
+    }
+    QJsonObject report;
+    report["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    report["qt"] = QString(qVersion());
+    report["cpu"] = QSysInfo::currentCpuArchitecture();
+    report["os"] = QSysInfo::prettyProductName();
+    report["results"] = entries;
+    const QByteArray json = QJsonDocument(report).toJson();
+
+    if (outputPath.isEmpty()) {
+        std::fwrite(json.constData(), 1, size_t(json.size()), stdout);
+    } else if (!writeFile(outputPath, json)) {
+        std::fprintf(stderr, "Cannot write %s.\n", qPrintable(QDir::toNativeSeparators(outputPath)));
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,453 @@
+// Round-trip fuzzer for the assembler and the disassembler, and a consistency check of the emulator's interpreter
+// paths. The latter compares the interpreter with itself, not with an independent model of the 8086.
+//
+// Every case is derived from the seed and its own index only, so a failure reported as
+// "case 1234" replays with --seed <seed> --case 1234 whatever the thread count was.
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+#include "../scriptparser.h"
+#include "../instructionencoder.h"
+#include "../instructiondecoder.h"
+#include "../emulator.h"
+#include "../opcodetable.h"
+
+namespace {
+
+const int MAX_INSTRUCTION_BYTES = 6;
+const int PROGRAM_ORIGIN = 0x100;
+const int PROGRAM_INSTRUCTIONS = 48;
+const int PROGRAM_STEPS = 4000;
+const int MAX_REPORTED_FAILURES = 20;
+const quint8 PREFIXES[] = {0x26, 0x2E, 0x36, 0x3E, 0xF0, 0xF2, 0xF3};
+
+// Instructions that once failed to round trip, checked at PROGRAM_ORIGIN on every run before the random cases.
+const char* const REGRESSIONS[] = {
+    "C2 04 00",  // RET 4 went through the implied table, which rejects operands
+    "CA 04 00",  // RETF 4
+    "F2 7C 54",  // relative targets were counted from before the prefix byte
+    "F0 EB 05",
+    "F3 E8 10 00",
+};
+
+// Forms the disassembler prints but the assembler refuses on purpose, by opcode and ModR/M reg field.
+const struct {
+    quint8 opcode;
+    int reg;
+    const char* reason;
+} REFUSED_FORMS[] = {
+    {0x8E, 1, "MOV CS jumps without setting IP, the assembler rejects it"},
+};
+
+struct Options {
+    quint64 seed = 1;
+    qint64 cases = 1000000;
+    qint64 programs = 20000;
+    qint64 onlyCase = -1;
+    int threads = 0;
+};
+
+struct Failure {
+    qint64 index;
+    QString message;
+};
+
+// splitmix64, so neighbouring case numbers still get unrelated generator states.
+quint64 caseSeed(quint64 seed, qint64 index) {
+    quint64 z = seed + 0x9E3779B97F4A7C15ULL * quint64(index + 1);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+class Random {
+public:
+    explicit Random(quint64 seed) : engine(seed) {}
+    int below(int limit) { return int(engine() % quint64(limit)); }
+private:
+    std::mt19937_64 engine;
+};
+
+// Bytes of one instruction the disassembler accepts, opcode picked among the defined entries of the opcode table.
+QByteArray randomInstruction(Random& random, int address) {
+    for (;;) {
+        QByteArray bytes;
+        if (random.below(8) == 0) bytes.append(char(PREFIXES[random.below(int(sizeof(PREFIXES)))]));
+        int opcode;
+        do {
+            opcode = random.below(0x100);
+        } while (OpcodeTable::info(opcode).form == OpcodeInfo::Invalid || OpcodeTable::info(opcode).form == OpcodeInfo::Prefix);
+        bytes.append(char(opcode));
+        for (int i = 0; i < MAX_INSTRUCTION_BYTES - 1; ++i) {
+            bytes.append(char(random.below(0x100)));
+        }
+        const DecodedInstruction decoded = InstructionDecoder::decode(bytes, 0, address);
+        // A segment prefix without a memory operand comes back as DB, which is data rather than an instruction.
+        if (decoded.isValid() && decoded.mnemonic != "DB") return bytes.left(decoded.size);
+    }
+}
+
+bool hasModRm(int opcode) {
+    switch (OpcodeTable::info(opcode).form) {
+    case OpcodeInfo::RegisterMemory:
+    case OpcodeInfo::MemoryRegister:
+    case OpcodeInfo::SegmentMemory:
+    case OpcodeInfo::LoadAddress:
+    case OpcodeInfo::Group:
+        return true;
+    default:
+        return false;
+    }
+}
+
+int opcodeOffset(const QByteArray& bytes) {
+    int offset = 0;
+    while (offset < bytes.size() - 1 && OpcodeTable::info(quint8(bytes[offset])).form == OpcodeInfo::Prefix) {
+        ++offset;
+    }
+    return offset;
+}
+
+int displacementSize(int modrm) {
+    const int mod = modrm >> 6;
+    if (mod == 0) return (modrm & 7) == 6 ? 2 : 0;
+    return mod == 3 ? 0 : mod;
+}
+
+bool fitsSignedByte(int low, int high) {
+    const qint16 value = qint16(quint8(low) | (quint8(high) << 8));
+    return value >= -128 && value <= 127;
+}
+
+// Rewrites one alternate encoding into the one the assembler prefers, returns false when none applies:
+// displacements and word immediates are shortened to sign-extended bytes, XCHG with AX and INT 3 take their
+// one-byte forms and 82, the undocumented copy of 80, becomes 80.
+bool preferEncoding(QByteArray& bytes) {
+    const int at = opcodeOffset(bytes);
+    const quint8 opcode = quint8(bytes[at]);
+    if (opcode == 0x82) {
+        bytes[at] = char(0x80);
+        return true;
+    }
+    if (opcode == 0xCD && bytes.size() == at + 2 && quint8(bytes[at + 1]) == 3) {
+        bytes = bytes.left(at) + char(0xCC);
+        return true;
+    }
+    if (opcode < 0x40 && (opcode & 7) == 5 && fitsSignedByte(bytes[at + 1], bytes[at + 2])) {
+        bytes = bytes.left(at) + char(0x83) + char(0xC0 | (opcode & 0x38)) + bytes[at + 1];
+        return true;
+    }
+    if (!hasModRm(opcode) || bytes.size() < at + 2) return false;
+
+    const quint8 modrm = quint8(bytes[at + 1]);
+    const int displacement = at + 2;
+    if (opcode == 0x87 && (modrm >> 6) == 3 && ((modrm & 7) == 0 || (modrm & 0x38) == 0)) {
+        bytes = bytes.left(at) + char(0x90 | (modrm & 7) | ((modrm >> 3) & 7));
+        return true;
+    }
+    if ((modrm >> 6) == 1 && (modrm & 7) != 6 && bytes[displacement] == 0) {
+        bytes[at + 1] = char(modrm & 0x3F);
+        bytes.remove(displacement, 1);
+        return true;
+    }
+    if ((modrm >> 6) == 2 && fitsSignedByte(bytes[displacement], bytes[displacement + 1])) {
+        bytes[at + 1] = char((modrm & 0x3F) | 0x40);
+        bytes.remove(displacement + 1, 1);
+        return true;
+    }
+    const int immediate = displacement + displacementSize(modrm);
+    if (opcode == 0x81 && bytes.size() == immediate + 2 && fitsSignedByte(bytes[immediate], bytes[immediate + 1])) {
+        bytes[at] = char(0x83);
+        bytes.chop(1);
+        return true;
+    }
+    return false;
+}
+
+bool assemble(const QString& text, int address, QByteArray& bytes, QString& error) {
+    const ScriptLine line = ScriptParser::parse(text);
+    if (line.mnemonic.isEmpty()) {
+        error = "not parsed as an instruction";
+        return false;
+    }
+    EncodeOptions options;
+    EncodedInstruction encoded = InstructionEncoder::encode(line, address, options);
+    if (encoded.isValid() && encoded.needsLongJump) {
+        options.longJump = true;
+        encoded = InstructionEncoder::encode(line, address, options);
+    }
+    if (!encoded.isValid()) {
+        error = encoded.error;
+        return false;
+    }
+    bytes = encoded.bytes;
+    return true;
+}
+
+QString hexBytes(const QByteArray& bytes) {
+    QStringList parts;
+    for (char byte : bytes) {
+        parts.append(InstructionDecoder::hexByte(quint8(byte)));
+    }
+    return parts.join(' ');
+}
+
+// The assembler must accept whatever the disassembler prints and give back the same text, or else the bytes
+// preferEncoding() turns the original into. The result has to survive another pass unchanged as well.
+QString checkRoundTrip(const QByteArray& original, int address) {
+    const QString text = InstructionDecoder::decode(original, 0, address).text();
+    const int at = opcodeOffset(original);
+    for (const auto& refused : REFUSED_FORMS) {
+        if (quint8(original[at]) == refused.opcode && original.size() > at + 1
+            && ((quint8(original[at + 1]) >> 3) & 7) == refused.reg) {
+            return QString();
+        }
+    }
+
+    QByteArray bytes;
+    QString error;
+    if (!assemble(text, address, bytes, error)) {
+        return QString("%1 (%2): %3").arg(text, hexBytes(original), error);
+    }
+    const DecodedInstruction canonical = InstructionDecoder::decode(bytes, 0, address);
+    if (!canonical.isValid() || canonical.size != bytes.size()) {
+        return QString("%1 (%2) assembled to %3, which does not disassemble").arg(text, hexBytes(original), hexBytes(bytes));
+    }
+    if (canonical.text() != text) {
+        QByteArray preferred = original;
+        while (preferEncoding(preferred)) {
+        }
+        if (preferred != bytes) {
+            return QString("%1 (%2) assembled to %3 (%4)").arg(text, hexBytes(original), canonical.text(), hexBytes(bytes));
+        }
+    }
+
+    QByteArray again;
+    if (!assemble(canonical.text(), address, again, error)) {
+        return QString("%1 (%2): %3").arg(canonical.text(), hexBytes(bytes), error);
+    }
+    const QString result = InstructionDecoder::decode(again, 0, address).text();
+    if (result != canonical.text()) {
+        return QString("%1 (%2) came back as %3 (%4)").arg(canonical.text(), hexBytes(bytes), result, hexBytes(again));
+    }
+    return QString();
+}
+
+QString roundTripCase(quint64 seed) {
+    Random random(seed);
+    const int address = PROGRAM_ORIGIN + random.below(0xFE00);
+    return checkRoundTrip(randomInstruction(random, address), address);
+}
+
+QString regressionCase(qint64 index) {
+    QByteArray bytes;
+    for (const QString& byte : QString(REGRESSIONS[index]).split(' ', Qt::SkipEmptyParts)) {
+        bytes.append(char(byte.toInt(nullptr, 16)));
+    }
+    return checkRoundTrip(bytes, PROGRAM_ORIGIN);
+}
+
+QByteArray randomProgram(Random& random) {
+    QByteArray image(0x10000, 0);
+    int address = PROGRAM_ORIGIN;
+    for (int i = 0; i < PROGRAM_INSTRUCTIONS; ++i) {
+        const QByteArray instruction = randomInstruction(random, address);
+        image.replace(address, instruction.size(), instruction);
+        address += instruction.size();
+    }
+    return image;
+}
+
+struct Outcome {
+    Emulator::StopReason reason = Emulator::Stepped;
+    CpuState state;
+    quint64 executed = 0;
+    QString output;
+};
+
+QString compareOutcomes(const char* name, const Outcome& expected, const Emulator& reference,
+                        const Outcome& actual, const Emulator& machine) {
+    if (actual.reason != expected.reason) {
+        return QString("%1 stopped with %2 instead of %3").arg(name).arg(int(actual.reason)).arg(int(expected.reason));
+    }
+    if (actual.state != expected.state) {
+        return QString("%1 ended at IP %2 with different registers or flags")
+            .arg(name, InstructionDecoder::hexWord(actual.state.ip));
+    }
+    if (actual.executed != expected.executed) {
+        return QString("%1 executed %2 instructions instead of %3").arg(name).arg(actual.executed).arg(expected.executed);
+    }
+    if (actual.output != expected.output) return QString("%1 printed different output").arg(name);
+    if (std::memcmp(reference.memoryData(), machine.memoryData(), Emulator::MEMORY_SIZE) != 0) {
+        return QString("%1 left different memory").arg(name);
+    }
+    return QString();
+}
+
+// The same random program through every way the debugger drives the interpreter: the run() fast loop,
+// single steps, and run() with a never-true breakpoint on every program byte. This catches the paths drifting
+// apart, not an instruction the interpreter gets wrong on all of them.
+class ProgramChecker {
+public:
+    ProgramChecker() {
+        QHash<int, ConditionExpression> breakpoints;
+        const ConditionExpression never = ConditionExpression::compile("0");
+        for (int offset = PROGRAM_ORIGIN; offset < PROGRAM_ORIGIN + PROGRAM_INSTRUCTIONS * MAX_INSTRUCTION_BYTES; ++offset) {
+            breakpoints.insert(offset, never);
+        }
+        guarded.setBreakpoints(breakpoints);
+    }
+
+    QString check(quint64 seed) {
+        Random random(seed);
+        const QByteArray image = randomProgram(random);
+
+        fast.load(image, PROGRAM_ORIGIN);
+        Outcome expected;
+        expected.reason = fast.run(PROGRAM_STEPS);
+        finishOutcome(fast, expected);
+
+        stepped.load(image, PROGRAM_ORIGIN);
+        Outcome single;
+        quint64 steps = 0;
+        do {
+            single.reason = stepped.step();
+        } while (single.reason == Emulator::Stepped && ++steps < quint64(PROGRAM_STEPS));
+        if (single.reason == Emulator::Stepped) single.reason = Emulator::StepLimit;
+        finishOutcome(stepped, single);
+        QString difference = compareOutcomes("step()", expected, fast, single, stepped);
+        if (!difference.isEmpty()) return difference;
+
+        guarded.load(image, PROGRAM_ORIGIN);
+        Outcome conditional;
+        conditional.reason = guarded.run(PROGRAM_STEPS);
+        finishOutcome(guarded, conditional);
+        return compareOutcomes("run() with breakpoints", expected, fast, conditional, guarded);
+    }
+private:
+    Emulator fast;
+    Emulator stepped;
+    Emulator guarded;
+
+    static void finishOutcome(Emulator& machine, Outcome& outcome) {
+        outcome.state = machine.state();
+        outcome.executed = machine.instructionCount();
+        outcome.output = machine.takeOutput();
+    }
+};
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const QString argument = argv[i];
+        if (argument == "--help" || i + 1 >= argc) {
+            std::printf("Usage: %s [--seed N] [--cases N] [--programs N] [--threads N] [--case N]\n"
+                        "  --cases     assembler/disassembler round trips (default 1000000)\n"
+                        "  --programs  random programs compared across interpreter paths (default 20000)\n"
+                        "  --case      replay a single case of both kinds\n", argv[0]);
+            return false;
+        }
+        bool ok = false;
+        const qint64 value = QString(argv[++i]).toLongLong(&ok, 0);
+        if (!ok || value < 0) {
+            std::fprintf(stderr, "Invalid value for %s\n", qPrintable(argument));
+            return false;
+        }
+        if (argument == "--seed") options.seed = quint64(value);
+        else if (argument == "--cases") options.cases = value;
+        else if (argument == "--programs") options.programs = value;
+        else if (argument == "--threads") options.threads = int(value);
+        else if (argument == "--case") options.onlyCase = value;
+        else {
+            std::fprintf(stderr, "Unknown option %s\n", qPrintable(argument));
+            return false;
+        }
+    }
+    return true;
+}
+
+// Runs count cases on all threads; each thread takes every threads-th index, failures are sorted by index afterwards.
+template <typename Check>
+std::vector<Failure> runCases(qint64 first, qint64 count, int threads, Check makeCheck) {
+    std::vector<Failure> failures;
+    std::mutex failuresMutex;
+    std::vector<std::thread> workers;
+    for (int worker = 0; worker < threads; ++worker) {
+        workers.emplace_back([&, worker]() {
+            auto check = makeCheck();
+            for (qint64 index = first + worker; index < first + count; index += threads) {
+                const QString message = check(index);
+                if (message.isEmpty()) continue;
+                std::lock_guard<std::mutex> lock(failuresMutex);
+                failures.push_back({index, message});
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    std::sort(failures.begin(), failures.end(), [](const Failure& a, const Failure& b) { return a.index < b.index; });
+    return failures;
+}
+
+void report(const char* kind, qint64 count, const std::vector<Failure>& failures, double seconds) {
+    std::printf("%s: %lld cases, %zu failures, %.1f s (%.0f cases/min)\n", kind, count, failures.size(), seconds,
+                seconds > 0 ? count * 60.0 / seconds : 0.0);
+    for (size_t i = 0; i < failures.size() && i < size_t(MAX_REPORTED_FAILURES); ++i) {
+        std::printf("  case %lld: %s\n", failures[i].index, qPrintable(failures[i].message));
+    }
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) return 2;
+    const int threads = options.threads > 0 ? options.threads : int(qMax(1u, std::thread::hardware_concurrency()));
+    const quint64 seed = options.seed;
+
+    qint64 first = 0;
+    qint64 cases = options.cases;
+    qint64 programs = options.programs;
+    if (options.onlyCase >= 0) {
+        first = options.onlyCase;
+        cases = 1;
+        programs = 1;
+    }
+    std::printf("seed %llu, %d threads\n", static_cast<unsigned long long>(seed), threads);
+
+    const qint64 regressionCount = qint64(sizeof(REGRESSIONS) / sizeof(REGRESSIONS[0]));
+    auto start = std::chrono::steady_clock::now();
+    const std::vector<Failure> regressions = runCases(0, regressionCount, 1, []() { return regressionCase; });
+    auto end = std::chrono::steady_clock::now();
+    report("regressions", regressionCount, regressions, std::chrono::duration<double>(end - start).count());
+
+    start = std::chrono::steady_clock::now();
+    const std::vector<Failure> roundTrips = runCases(first, cases, threads, [seed]() {
+        return [seed](qint64 index) { return roundTripCase(caseSeed(seed, index)); };
+    });
+    end = std::chrono::steady_clock::now();
+    report("round trip", cases, roundTrips, std::chrono::duration<double>(end - start).count());
+
+    start = std::chrono::steady_clock::now();
+    const std::vector<Failure> differences = runCases(first, programs, threads, [seed]() {
+        // Each worker owns its emulators, loading resets them between programs.
+        auto checker = std::make_shared<ProgramChecker>();
+        return [seed, checker](qint64 index) { return checker->check(caseSeed(~seed, index)); };
+    });
+    end = std::chrono::steady_clock::now();
+    report("interpreter paths", programs, differences, std::chrono::duration<double>(end - start).count());
+
+    return regressions.empty() && roundTrips.empty() && differences.empty() ? 0 : 1;
+}
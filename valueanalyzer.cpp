@@ -0,0 +1,861 @@
+#include "valueanalyzer.h"
+#include "instructionencoder.h"
+#include "instructiondecoder.h"
+#include <QQueue>
+#include <QSet>
+#include <QStringList>
+
+namespace {
+
+enum Flag {
+    CF = 0x001,
+    ZF = 0x040,
+    SF = 0x080,
+    OF = 0x800
+};
+
+const int TRACKED_FLAGS = CF | ZF | SF | OF;
+const int MAX_STACK_DEPTH = 16;
+const int AX = 0, CX = 1, DX = 2, SP = 4, SI = 6, DI = 7;
+const int ES = 0, SS = 2, DS = 3;
+
+const QStringList REGISTER_NAMES = {"AX", "CX", "DX", "BX", "SP", "BP", "SI", "DI"};
+const QStringList BYTE_REGISTER_NAMES = {"AL", "CL", "DL", "BL", "AH", "CH", "DH", "BH"};
+const QStringList SEGMENT_NAMES = {"ES", "CS", "SS", "DS"};
+
+const QSet<QString> ARITHMETIC = {"ADD", "ADC", "SUB", "SBB", "CMP", "AND", "OR", "XOR", "TEST"};
+const QSet<QString> SHIFTS = {"ROL", "ROR", "RCL", "RCR", "SHL", "SAL", "SHR", "SAR"};
+const QSet<QString> STRING_OPERATIONS = {
+    "MOVSB", "MOVSW", "CMPSB", "CMPSW", "SCASB", "SCASW", "LODSB", "LODSW", "STOSB", "STOSW"
+};
+const QSet<QString> UNTRACKED = {"NOP", "OUT", "CLD", "STD", "CLI", "STI", "WAIT", "LOCK", "HLT"};
+
+AbstractValue knownValue(int value, quint16 mask = 0xFFFF) {
+    AbstractValue result;
+    result.known = mask;
+    result.bits = quint16(value) & mask;
+    return result;
+}
+
+void joinValue(AbstractValue& value, const AbstractValue& other) {
+    value.known &= other.known & ~(value.bits ^ other.bits);
+    value.bits &= value.known;
+}
+
+AbstractState unknownState() {
+    AbstractState state;
+    state.reached = true;
+    return state;
+}
+
+int effectiveAddress(const AbstractState& state, const Operand& operand) {
+    if (!operand.label.isEmpty()) return -1;
+    if (operand.rm < 0) return operand.value & 0xFFFF;
+
+    static const QVector<QVector<int>> BASES = {{3, 6}, {3, 7}, {5, 6}, {5, 7}, {6}, {7}, {5}, {3}};
+    int address = operand.value;
+    for (int reg : BASES[operand.rm]) {
+        if (!state.registers[reg].isKnown()) return -1;
+        address += state.registers[reg].bits;
+    }
+    return address & 0xFFFF;
+}
+
+// Memory cells are keyed by the segment register used to reach them and the offset. A segment register known to
+// hold the same value as DS shares its cells, BP-based addresses default to SS.
+int segmentOf(const AbstractState& state, const Operand& operand) {
+    int segment = operand.segmentOverride;
+    if (segment < 0) {
+        segment = operand.rm == 2 || operand.rm == 3 || operand.rm == 6 ? SS : DS;
+    }
+    if (segment != DS && state.segments[segment].isKnown() && state.segments[segment] == state.segments[DS]) return DS;
+    return segment;
+}
+
+int cellKey(int segment, int offset) {
+    return segment << 16 | (offset & 0xFFFF);
+}
+
+// Segments of unknown value may overlap, so a write to an offset drops that offset in all of them.
+void forgetOffset(AbstractState& state, int offset) {
+    for (int segment = 0; segment < AbstractState::SEGMENT_COUNT; ++segment) {
+        state.memory.remove(cellKey(segment, offset));
+    }
+}
+
+// Cells reached through a segment register no longer describe the memory it points at once it is reloaded.
+void forgetSegment(AbstractState& state, int segment) {
+    auto first = state.memory.lowerBound(cellKey(segment, 0));
+    auto last = state.memory.lowerBound(cellKey(segment + 1, 0));
+    while (first != last) {
+        first = state.memory.erase(first);
+    }
+}
+
+AbstractValue readByteRegister(const AbstractState& state, int reg) {
+    const AbstractValue& word = state.registers[reg & 3];
+    const int shift = reg >= 4 ? 8 : 0;
+    AbstractValue result;
+    result.bits = (word.bits >> shift) & 0xFF;
+    result.known = (word.known >> shift) & 0xFF;
+    return result;
+}
+
+void writeByteRegister(AbstractState& state, int reg, const AbstractValue& value) {
+    AbstractValue& word = state.registers[reg & 3];
+    const int shift = reg >= 4 ? 8 : 0;
+    const quint16 mask = quint16(0xFF << shift);
+    word.known = (word.known & ~mask) | ((value.known & 0xFF) << shift);
+    word.bits = ((word.bits & ~mask) | ((value.bits & 0xFF) << shift)) & word.known;
+}
+
+AbstractValue read(const AbstractState& state, const Operand& operand, int width) {
+    switch (operand.type) {
+    case Operand::Register16:
+        return state.registers[operand.reg];
+    case Operand::Register8:
+        return readByteRegister(state, operand.reg);
+    case Operand::SegmentRegister:
+        return state.segments[operand.reg];
+    case Operand::Immediate:
+        return operand.label.isEmpty() ? knownValue(operand.value, width == 1 ? 0xFF : 0xFFFF) : AbstractValue();
+    case Operand::Memory: {
+        AbstractValue result;
+        const int address = effectiveAddress(state, operand);
+        if (address < 0) return result;
+        const int segment = segmentOf(state, operand);
+        for (int k = 0; k < width; ++k) {
+            auto it = state.memory.constFind(cellKey(segment, address + k));
+            if (it == state.memory.constEnd()) continue;
+            result.bits |= *it << (8 * k);
+            result.known |= 0xFF << (8 * k);
+        }
+        return result;
+    }
+    default:
+        return AbstractValue();
+    }
+}
+
+void write(AbstractState& state, const Operand& operand, int width, const AbstractValue& value) {
+    switch (operand.type) {
+    case Operand::Register16:
+        state.registers[operand.reg] = value;
+        break;
+    case Operand::Register8:
+        writeByteRegister(state, operand.reg, value);
+        break;
+    case Operand::SegmentRegister:
+        if (state.segments[operand.reg] != value || !value.isKnown()) forgetSegment(state, operand.reg);
+        state.segments[operand.reg] = value;
+        break;
+    case Operand::Memory: {
+        const int address = effectiveAddress(state, operand);
+        if (address < 0) {
+            state.memory.clear();
+            break;
+        }
+        const int segment = segmentOf(state, operand);
+        for (int k = 0; k < width; ++k) {
+            forgetOffset(state, address + k);
+            if (value.isKnown(quint16(0xFF << (8 * k)))) {
+                state.memory.insert(cellKey(segment, address + k), quint8(value.bits >> (8 * k)));
+            }
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+int widthOf(const ScriptLine& line) {
+    for (const Operand& operand : line.operands) {
+        if (operand.type == Operand::Register16 || operand.type == Operand::SegmentRegister) return 2;
+        if (operand.type == Operand::Register8) return 1;
+    }
+    for (const Operand& operand : line.operands) {
+        if (operand.type == Operand::Memory && operand.size > 0) return operand.size;
+    }
+    return 2;
+}
+
+bool sameRegister(const Operand& a, const Operand& b) {
+    return (a.type == Operand::Register8 || a.type == Operand::Register16) && a.type == b.type && a.reg == b.reg;
+}
+
+void setFlags(AbstractState& state, int mask, int values) {
+    state.knownFlags |= mask;
+    state.flags = (state.flags & ~mask) | (values & mask);
+}
+
+void forgetFlags(AbstractState& state, int mask = TRACKED_FLAGS) {
+    state.knownFlags &= ~mask;
+    state.flags &= ~mask;
+}
+
+int resultFlags(int result, int width) {
+    const int mask = width == 1 ? 0xFF : 0xFFFF;
+    const int sign = width == 1 ? 0x80 : 0x8000;
+    return ((result & mask) == 0 ? ZF : 0) | ((result & sign) ? SF : 0);
+}
+
+// Calls and interrupts may change anything but the stack pointer and the code, stack and data segments.
+void forgetAcrossCall(AbstractState& state) {
+    for (int reg = 0; reg < AbstractState::REGISTER_COUNT; ++reg) {
+        if (reg != SP) state.registers[reg] = AbstractValue();
+    }
+    state.segments[ES] = AbstractValue();
+    state.memory.clear();
+    forgetFlags(state);
+}
+
+void push(AbstractState& state, const AbstractValue& value) {
+    if (state.stack.size() >= MAX_STACK_DEPTH) state.stack.removeFirst();
+    state.stack.append(value);
+    AbstractValue& sp = state.registers[SP];
+    if (sp.isKnown()) {
+        sp = knownValue(sp.bits - 2);
+        // The pushed word lands at SS:SP, which may also be reachable through DS or ES.
+        forgetOffset(state, sp.bits);
+        forgetOffset(state, sp.bits + 1);
+    } else {
+        state.memory.clear();
+    }
+}
+
+AbstractValue pop(AbstractState& state) {
+    AbstractValue& sp = state.registers[SP];
+    if (sp.isKnown()) sp = knownValue(sp.bits + 2);
+    return state.stack.isEmpty() ? AbstractValue() : state.stack.takeLast();
+}
+
+// Three-valued logic for branch conditions: 1 true, 0 false, -1 unknown.
+int flagValue(const AbstractState& state, int flag) {
+    if (!(state.knownFlags & flag)) return -1;
+    return (state.flags & flag) ? 1 : 0;
+}
+
+int negate(int value) {
+    return value < 0 ? -1 : 1 - value;
+}
+
+int either(int a, int b) {
+    if (a == 1 || b == 1) return 1;
+    return a == 0 && b == 0 ? 0 : -1;
+}
+
+int differ(int a, int b) {
+    return a < 0 || b < 0 ? -1 : int(a != b);
+}
+
+int condition(const QString& mnemonic, const AbstractState& state) {
+    const int cf = flagValue(state, CF);
+    const int zf = flagValue(state, ZF);
+    const int sf = flagValue(state, SF);
+    const int of = flagValue(state, OF);
+    if (mnemonic == "JO") return of;
+    if (mnemonic == "JNO") return negate(of);
+    if (mnemonic == "JB" || mnemonic == "JC" || mnemonic == "JNAE") return cf;
+    if (mnemonic == "JAE" || mnemonic == "JNB" || mnemonic == "JNC") return negate(cf);
+    if (mnemonic == "JE" || mnemonic == "JZ") return zf;
+    if (mnemonic == "JNE" || mnemonic == "JNZ") return negate(zf);
+    if (mnemonic == "JBE" || mnemonic == "JNA") return either(cf, zf);
+    if (mnemonic == "JA" || mnemonic == "JNBE") return negate(either(cf, zf));
+    if (mnemonic == "JS") return sf;
+    if (mnemonic == "JNS") return negate(sf);
+    if (mnemonic == "JL" || mnemonic == "JNGE") return differ(sf, of);
+    if (mnemonic == "JGE" || mnemonic == "JNL") return negate(differ(sf, of));
+    if (mnemonic == "JLE" || mnemonic == "JNG") return either(zf, differ(sf, of));
+    if (mnemonic == "JG" || mnemonic == "JNLE") return negate(either(zf, differ(sf, of)));
+    return -1;
+}
+
+bool isConditional(const QString& mnemonic) {
+    return (mnemonic.startsWith('J') && mnemonic != "JMP") || mnemonic.startsWith("LOOP");
+}
+
+void arithmetic(AbstractState& state, const ScriptLine& line, int width) {
+    const QString& mnemonic = line.mnemonic;
+    const Operand& destination = line.operands[0];
+    const int mask = width == 1 ? 0xFF : 0xFFFF;
+    const int sign = width == 1 ? 0x80 : 0x8000;
+    const bool usesCarry = mnemonic == "ADC" || mnemonic == "SBB";
+    const bool stores = mnemonic != "CMP" && mnemonic != "TEST";
+    const AbstractValue a = read(state, destination, width);
+    const AbstractValue b = read(state, line.operands[1], width);
+
+    // XOR AX,AX and SUB AX,AX give zero whatever AX held.
+    if ((mnemonic == "XOR" || mnemonic == "SUB") && sameRegister(destination, line.operands[1])) {
+        write(state, destination, width, knownValue(0, quint16(mask)));
+        setFlags(state, TRACKED_FLAGS, ZF);
+        return;
+    }
+    if (!a.isKnown(quint16(mask)) || !b.isKnown(quint16(mask)) || (usesCarry && flagValue(state, CF) < 0)) {
+        if (stores) write(state, destination, width, AbstractValue());
+        forgetFlags(state);
+        return;
+    }
+
+    const int x = a.bits & mask;
+    const int y = b.bits & mask;
+    const int carry = usesCarry ? flagValue(state, CF) : 0;
+    int result;
+    int flags = 0;
+    if (mnemonic == "ADD" || mnemonic == "ADC") {
+        result = x + y + carry;
+        if (result > mask) flags |= CF;
+        if (~(x ^ y) & (x ^ result) & sign) flags |= OF;
+    } else if (mnemonic == "SUB" || mnemonic == "SBB" || mnemonic == "CMP") {
+        result = x - y - carry;
+        if (x < y + carry) flags |= CF;
+        if ((x ^ y) & (x ^ result) & sign) flags |= OF;
+    } else if (mnemonic == "OR") {
+        result = x | y;
+    } else if (mnemonic == "XOR") {
+        result = x ^ y;
+    } else {
+        result = x & y;
+    }
+    setFlags(state, TRACKED_FLAGS, flags | resultFlags(result, width));
+    if (stores) write(state, destination, width, knownValue(result, quint16(mask)));
+}
+
+void unary(AbstractState& state, const ScriptLine& line, int width) {
+    const QString& mnemonic = line.mnemonic;
+    const Operand& operand = line.operands[0];
+    const int mask = width == 1 ? 0xFF : 0xFFFF;
+    const int sign = width == 1 ? 0x80 : 0x8000;
+    const AbstractValue value = read(state, operand, width);
+
+    if (mnemonic == "NOT") {
+        AbstractValue result;
+        result.known = value.known & mask;
+        result.bits = ~value.bits & result.known;
+        write(state, operand, width, result);
+        return;
+    }
+    const int written = mnemonic == "NEG" ? TRACKED_FLAGS : TRACKED_FLAGS & ~CF;
+    if (!value.isKnown(quint16(mask))) {
+        write(state, operand, width, AbstractValue());
+        forgetFlags(state, written);
+        return;
+    }
+
+    const int x = value.bits & mask;
+    int result;
+    int flags = 0;
+    if (mnemonic == "INC") {
+        result = (x + 1) & mask;
+        if (result == sign) flags |= OF;
+    } else if (mnemonic == "DEC") {
+        result = (x - 1) & mask;
+        if (x == sign) flags |= OF;
+    } else {
+        result = -x & mask;
+        if (x != 0) flags |= CF;
+        if (x == sign) flags |= OF;
+    }
+    setFlags(state, written, flags | resultFlags(result, width));
+    write(state, operand, width, knownValue(result, quint16(mask)));
+}
+
+void shift(AbstractState& state, const ScriptLine& line, int width) {
+    const QString& mnemonic = line.mnemonic;
+    const Operand& operand = line.operands[0];
+    const Operand& source = line.operands[1];
+    const int mask = width == 1 ? 0xFF : 0xFFFF;
+    const int sign = width == 1 ? 0x80 : 0x8000;
+
+    int count = -1;
+    if (source.type == Operand::Immediate && source.label.isEmpty()) {
+        count = source.value & 0xFF;
+    } else if (source.type == Operand::Register8 && source.reg == 1 && readByteRegister(state, 1).isKnown(0xFF)) {
+        count = readByteRegister(state, 1).bits;
+    }
+    if (count == 0) return;
+
+    const bool rotate = mnemonic == "ROL" || mnemonic == "ROR" || mnemonic == "RCL" || mnemonic == "RCR";
+    const bool throughCarry = mnemonic == "RCL" || mnemonic == "RCR";
+    const int written = rotate ? CF | OF : TRACKED_FLAGS;
+    const AbstractValue value = read(state, operand, width);
+    if (count < 0 || !value.isKnown(quint16(mask)) || (throughCarry && flagValue(state, CF) < 0)) {
+        write(state, operand, width, AbstractValue());
+        forgetFlags(state, written);
+        return;
+    }
+
+    int x = value.bits & mask;
+    int carry = throughCarry ? flagValue(state, CF) : 0;
+    for (int k = 0; k < count; ++k) {
+        if (mnemonic == "SHL" || mnemonic == "SAL") {
+            carry = (x & sign) ? 1 : 0;
+            x = (x << 1) & mask;
+        } else if (mnemonic == "SHR") {
+            carry = x & 1;
+            x >>= 1;
+        } else if (mnemonic == "SAR") {
+            carry = x & 1;
+            x = (x >> 1) | (x & sign);
+        } else if (mnemonic == "ROL") {
+            carry = (x & sign) ? 1 : 0;
+            x = ((x << 1) | carry) & mask;
+        } else if (mnemonic == "ROR") {
+            carry = x & 1;
+            x = (x >> 1) | (carry ? sign : 0);
+        } else if (mnemonic == "RCL") {
+            const int out = (x & sign) ? 1 : 0;
+            x = ((x << 1) | carry) & mask;
+            carry = out;
+        } else {
+            const int out = x & 1;
+            x = (x >> 1) | (carry ? sign : 0);
+            carry = out;
+        }
+    }
+    // OF is only defined for a count of one, leave it unknown rather than model that case.
+    forgetFlags(state, OF);
+    setFlags(state, written & ~OF, (carry ? CF : 0) | (rotate ? 0 : resultFlags(x, width)));
+    write(state, operand, width, knownValue(x, quint16(mask)));
+}
+
+void multiplyOrDivide(AbstractState& state, const ScriptLine& line, int width) {
+    const QString& mnemonic = line.mnemonic;
+    const AbstractValue source = read(state, line.operands[0], width);
+    const AbstractValue ax = state.registers[AX];
+    const AbstractValue dx = state.registers[DX];
+    forgetFlags(state);
+    state.registers[AX] = AbstractValue();
+    if (width == 2) state.registers[DX] = AbstractValue();
+
+    if (mnemonic == "MUL") {
+        if (width == 1 && source.isKnown(0xFF) && ax.isKnown(0xFF)) {
+            const int product = (ax.bits & 0xFF) * (source.bits & 0xFF);
+            state.registers[AX] = knownValue(product);
+            setFlags(state, CF | OF, product > 0xFF ? CF | OF : 0);
+        } else if (width == 2 && source.isKnown() && ax.isKnown()) {
+            const quint32 product = quint32(ax.bits) * source.bits;
+            state.registers[AX] = knownValue(int(product & 0xFFFF));
+            state.registers[DX] = knownValue(int(product >> 16));
+            setFlags(state, CF | OF, product > 0xFFFF ? CF | OF : 0);
+        }
+    } else if (mnemonic == "DIV") {
+        if (width == 1 && source.isKnown(0xFF) && (source.bits & 0xFF) != 0 && ax.isKnown()) {
+            const int quotient = ax.bits / (source.bits & 0xFF);
+            if (quotient <= 0xFF) {
+                state.registers[AX] = knownValue(((ax.bits % (source.bits & 0xFF)) << 8) | quotient);
+            }
+        } else if (width == 2 && source.isKnown() && source.bits != 0 && ax.isKnown() && dx.isKnown()) {
+            const quint32 dividend = (quint32(dx.bits) << 16) | ax.bits;
+            const quint32 quotient = dividend / source.bits;
+            if (quotient <= 0xFFFF) {
+                state.registers[AX] = knownValue(int(quotient));
+                state.registers[DX] = knownValue(int(dividend % source.bits));
+            }
+        }
+    }
+}
+
+void stringOperation(AbstractState& state, const ScriptLine& line) {
+    const QString& mnemonic = line.mnemonic;
+    const bool word = mnemonic.endsWith('W');
+    if (!mnemonic.startsWith("STOS") && !mnemonic.startsWith("SCAS")) state.registers[SI] = AbstractValue();
+    if (!mnemonic.startsWith("LODS")) state.registers[DI] = AbstractValue();
+    if (mnemonic.startsWith("MOVS") || mnemonic.startsWith("STOS")) state.memory.clear();
+    if (mnemonic.startsWith("LODS")) {
+        if (word) state.registers[AX] = AbstractValue();
+        else writeByteRegister(state, 0, AbstractValue());
+    }
+    if (mnemonic.startsWith("CMPS") || mnemonic.startsWith("SCAS")) {
+        forgetFlags(state);
+    }
+    if (!line.prefix.isEmpty()) {
+        // A plain REP always runs CX down to zero, REPE and REPNE may stop early.
+        const bool counted = line.prefix == "REP" && !mnemonic.startsWith("CMPS") && !mnemonic.startsWith("SCAS");
+        state.registers[CX] = counted ? knownValue(0) : AbstractValue();
+    }
+}
+
+QString describeChanges(const AbstractState& before, const AbstractState& after) {
+    QStringList parts;
+    for (int reg = 0; reg < AbstractState::REGISTER_COUNT; ++reg) {
+        const AbstractValue& old = before.registers[reg];
+        const AbstractValue& now = after.registers[reg];
+        if (old == now) continue;
+        if (now.isKnown()) {
+            parts.append(REGISTER_NAMES[reg] + "=" + InstructionDecoder::hexWord(now.bits));
+            continue;
+        }
+        if (reg >= 4) continue;
+        for (int high = 0; high < 2; ++high) {
+            const quint16 mask = quint16(0xFF << (8 * high));
+            if (now.isKnown(mask) && (!old.isKnown(mask) || ((old.bits ^ now.bits) & mask))) {
+                parts.append(BYTE_REGISTER_NAMES[reg + 4 * high] + "="
+                             + InstructionDecoder::hexByte((now.bits >> (8 * high)) & 0xFF));
+            }
+        }
+    }
+    for (int reg = 0; reg < AbstractState::SEGMENT_COUNT; ++reg) {
+        const AbstractValue& now = after.segments[reg];
+        if (now != before.segments[reg] && now.isKnown()) {
+            parts.append(SEGMENT_NAMES[reg] + "=" + InstructionDecoder::hexWord(now.bits));
+        }
+    }
+
+    QVector<int> changed;
+    for (auto it = after.memory.constBegin(); it != after.memory.constEnd(); ++it) {
+        auto old = before.memory.constFind(it.key());
+        if (old == before.memory.constEnd() || *old != *it) changed.append(it.key());
+    }
+    for (int k = 0; k < changed.size(); ++k) {
+        const int cell = changed[k];
+        const int segment = cell >> 16;
+        const QString address = (segment == DS ? QString() : SEGMENT_NAMES[segment] + ":")
+                                + "[" + InstructionDecoder::hexWord(cell & 0xFFFF) + "]=";
+        if (k + 1 < changed.size() && changed[k + 1] == cell + 1 && (cell & 0xFFFF) != 0xFFFF) {
+            const int value = after.memory.value(cell) | (after.memory.value(cell + 1) << 8);
+            parts.append(address + InstructionDecoder::hexWord(value));
+            ++k;
+        } else {
+            parts.append(address + InstructionDecoder::hexByte(after.memory.value(cell)));
+        }
+    }
+
+    // Flags use the names DEBUG prints in its R output.
+    static const struct {
+        int flag;
+        const char* set;
+        const char* clear;
+    } FLAG_NAMES[] = {{OF, "OV", "NV"}, {SF, "NG", "PL"}, {ZF, "ZR", "NZ"}, {CF, "CY", "NC"}};
+    for (const auto& name : FLAG_NAMES) {
+        if (!(after.knownFlags & name.flag)) continue;
+        if ((before.knownFlags & name.flag) && !((before.flags ^ after.flags) & name.flag)) continue;
+        parts.append(QLatin1String((after.flags & name.flag) ? name.set : name.clear));
+    }
+    return parts.join(' ');
+}
+
+struct Node {
+    int line = 0;
+    int address = 0;
+    int size = 0;
+    bool valid = true;
+    bool entry = false;
+    int next = -1;
+    int target = -1;
+    QString key;
+    QVector<int> predecessors;
+};
+
+void transfer(const ScriptLine& line, const Node& node, AbstractState& state, bool& fallsThrough, bool& branches) {
+    fallsThrough = true;
+    branches = false;
+    const QString& mnemonic = line.mnemonic;
+    const QVector<Operand>& operands = line.operands;
+    const int count = operands.size();
+    const int width = widthOf(line);
+
+    if (!node.valid) {
+        state = unknownState();
+        return;
+    }
+    if (mnemonic == "DB" || mnemonic == "DW") {
+        fallsThrough = false;
+        return;
+    }
+    if (mnemonic == "MOV" && count == 2) {
+        write(state, operands[0], width, read(state, operands[1], width));
+    } else if (ARITHMETIC.contains(mnemonic) && count == 2) {
+        arithmetic(state, line, width);
+    } else if ((mnemonic == "INC" || mnemonic == "DEC" || mnemonic == "NEG" || mnemonic == "NOT") && count == 1) {
+        unary(state, line, width);
+    } else if (SHIFTS.contains(mnemonic) && count == 2) {
+        shift(state, line, width);
+    } else if ((mnemonic == "MUL" || mnemonic == "DIV" || mnemonic == "IMUL" || mnemonic == "IDIV") && count == 1) {
+        multiplyOrDivide(state, line, width);
+    } else if (mnemonic == "XCHG" && count == 2) {
+        const AbstractValue a = read(state, operands[0], width);
+        write(state, operands[0], width, read(state, operands[1], width));
+        write(state, operands[1], width, a);
+    } else if (mnemonic == "LEA" && count == 2) {
+        const int address = effectiveAddress(state, operands[1]);
+        write(state, operands[0], 2, address >= 0 ? knownValue(address) : AbstractValue());
+    } else if (mnemonic == "CBW") {
+        const AbstractValue al = readByteRegister(state, 0);
+        writeByteRegister(state, 4, al.isKnown(0x80) ? knownValue((al.bits & 0x80) ? 0xFF : 0, 0xFF) : AbstractValue());
+    } else if (mnemonic == "CWD") {
+        const AbstractValue& ax = state.registers[AX];
+        state.registers[DX] = ax.isKnown(0x8000) ? knownValue((ax.bits & 0x8000) ? 0xFFFF : 0) : AbstractValue();
+    } else if (mnemonic == "PUSH" && count == 1) {
+        push(state, read(state, operands[0], 2));
+    } else if (mnemonic == "POP" && count == 1) {
+        write(state, operands[0], 2, pop(state));
+    } else if (mnemonic == "PUSHF") {
+        push(state, AbstractValue());
+    } else if (mnemonic == "POPF") {
+        pop(state);
+        forgetFlags(state);
+    } else if (mnemonic == "CLC" || mnemonic == "STC") {
+        setFlags(state, CF, mnemonic == "STC" ? CF : 0);
+    } else if (mnemonic == "CMC") {
+        if (flagValue(state, CF) >= 0) state.flags ^= CF;
+    } else if (mnemonic == "SAHF") {
+        // SAHF copies AH bits 7, 6 and 0 straight into SF, ZF and CF.
+        const AbstractValue ah = readByteRegister(state, 4);
+        forgetFlags(state, SF | ZF | CF);
+        setFlags(state, ah.known & (SF | ZF | CF), ah.bits);
+    } else if (mnemonic == "LAHF") {
+        AbstractValue ah;
+        ah.known = quint16((state.knownFlags & (SF | ZF | CF)) | 0x02);
+        ah.bits = quint16((state.flags & ah.known) | 0x02);
+        writeByteRegister(state, 4, ah);
+    } else if (STRING_OPERATIONS.contains(mnemonic)) {
+        stringOperation(state, line);
+    } else if (mnemonic.startsWith("LOOP") || mnemonic == "JCXZ") {
+        AbstractValue& cx = state.registers[CX];
+        if (mnemonic != "JCXZ" && cx.isKnown()) cx = knownValue(cx.bits - 1);
+        else if (mnemonic != "JCXZ") cx = AbstractValue();
+        int taken = cx.isKnown() ? int(mnemonic == "JCXZ" ? cx.bits == 0 : cx.bits != 0) : -1;
+        if (mnemonic == "LOOPE" || mnemonic == "LOOPZ") taken = taken == 0 ? 0 : (taken == 1 ? flagValue(state, ZF) : -1);
+        if (mnemonic == "LOOPNE" || mnemonic == "LOOPNZ") taken = taken == 0 ? 0 : (taken == 1 ? negate(flagValue(state, ZF)) : -1);
+        fallsThrough = taken != 1;
+        branches = taken != 0;
+    } else if (mnemonic == "JMP") {
+        fallsThrough = false;
+        branches = true;
+    } else if (isConditional(mnemonic)) {
+        const int taken = condition(mnemonic, state);
+        fallsThrough = taken != 1;
+        branches = taken != 0;
+    } else if (mnemonic == "RET" || mnemonic == "RETF" || mnemonic == "IRET") {
+        fallsThrough = false;
+    } else if (mnemonic == "CALL") {
+        forgetAcrossCall(state);
+    } else if (mnemonic == "INT" && count == 1) {
+        const int number = operands[0].value;
+        const AbstractValue ah = readByteRegister(state, 4);
+        const bool exits = number == 0x20 || number == 0x27
+                           || (number == 0x21 && ah.isKnown(0xFF) && (ah.bits == 0x00 || ah.bits == 0x4C || ah.bits == 0x31));
+        fallsThrough = !exits;
+        forgetAcrossCall(state);
+    } else if (mnemonic == "LDS" || mnemonic == "LES") {
+        if (count >= 1) write(state, operands[0], 2, AbstractValue());
+        forgetSegment(state, mnemonic == "LDS" ? DS : ES);
+        state.segments[mnemonic == "LDS" ? DS : ES] = AbstractValue();
+    } else if (!UNTRACKED.contains(mnemonic)) {
+        // Anything else is modelled as clobbering its first operand and the flags.
+        if (mnemonic == "IN" || mnemonic == "XLAT") {
+            if (width == 2 && mnemonic == "IN") state.registers[AX] = AbstractValue();
+            else writeByteRegister(state, 0, AbstractValue());
+        } else if (mnemonic.startsWith("AA") || mnemonic.startsWith("DA")) {
+            state.registers[AX] = AbstractValue();
+        } else if (count >= 1) {
+            write(state, operands[0], width, AbstractValue());
+        }
+        forgetFlags(state);
+    }
+    if (node.target < 0) branches = false;
+}
+
+}
+
+void AbstractState::join(const AbstractState& other) {
+    if (!other.reached) return;
+    if (!reached) {
+        *this = other;
+        return;
+    }
+    for (int reg = 0; reg < REGISTER_COUNT; ++reg) {
+        joinValue(registers[reg], other.registers[reg]);
+    }
+    for (int reg = 0; reg < SEGMENT_COUNT; ++reg) {
+        joinValue(segments[reg], other.segments[reg]);
+    }
+    knownFlags &= other.knownFlags & ~(flags ^ other.flags);
+    flags &= knownFlags;
+    for (auto it = memory.begin(); it != memory.end();) {
+        auto match = other.memory.constFind(it.key());
+        if (match == other.memory.constEnd() || *match != *it) {
+            it = memory.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    if (stack.size() != other.stack.size()) {
+        stack.clear();
+    } else {
+        for (int k = 0; k < stack.size(); ++k) {
+            joinValue(stack[k], other.stack[k]);
+        }
+    }
+}
+
+bool AbstractState::operator==(const AbstractState& other) const {
+    if (reached != other.reached || flags != other.flags || knownFlags != other.knownFlags) return false;
+    for (int reg = 0; reg < REGISTER_COUNT; ++reg) {
+        if (registers[reg] != other.registers[reg]) return false;
+    }
+    for (int reg = 0; reg < SEGMENT_COUNT; ++reg) {
+        if (segments[reg] != other.segments[reg]) return false;
+    }
+    return memory == other.memory && stack == other.stack;
+}
+
+QVector<ValueHint> ValueAnalyzer::analyze(const QVector<ScriptLine>& lines, const QVector<LineEncoding>& encodings) {
+    QVector<Node> nodes;
+    QHash<int, int> nodeAt;
+    QHash<QString, int> keyCount;
+    QSet<int> callTargets;
+
+    bool assembling = false;
+    bool blockStart = false;
+    int address = DEFAULT_ASSEMBLY_ADDRESS;
+    for (int i = 0; i < lines.size(); ++i) {
+        const ScriptLine& line = lines[i];
+        if (assembling) {
+            if (line.empty) {
+                assembling = false;
+                continue;
+            }
+            if (line.comment) continue;
+
+            EncodedInstruction encoded = InstructionEncoder::encode(encodings, i, line, address);
+            Node node;
+            node.line = i;
+            node.address = address;
+            node.size = encoded.bytes.size();
+            node.valid = encoded.isValid() && InstructionEncoder::isKnownMnemonic(line.mnemonic);
+            node.entry = blockStart;
+            node.key = QString::number(address, 16) + ':' + line.text.trimmed().toUpper();
+            const int occurrence = keyCount[node.key]++;
+            if (occurrence > 0) node.key += '#' + QString::number(occurrence);
+            blockStart = false;
+
+            const bool direct = line.operands.size() == 1 && line.operands[0].type == Operand::Immediate;
+            if (direct && line.mnemonic == "CALL") callTargets.insert(line.operands[0].value & 0xFFFF);
+            if (!nodeAt.contains(address)) nodeAt.insert(address, nodes.size());
+            nodes.append(node);
+            address = (address + node.size) & 0xFFFF;
+            continue;
+        }
+
+        if (line.empty || line.comment) continue;
+        if (line.head == "A") {
+            assembling = true;
+            blockStart = true;
+            if (line.commandAddress >= 0) {
+                address = line.commandAddress;
+            }
+        }
+    }
+
+    for (int k = 0; k < nodes.size(); ++k) {
+        Node& node = nodes[k];
+        const ScriptLine& line = lines[node.line];
+        const bool direct = line.operands.size() == 1 && line.operands[0].type == Operand::Immediate;
+        if (node.size > 0) node.next = nodeAt.value((node.address + node.size) & 0xFFFF, -1);
+        if (direct && line.mnemonic != "CALL" && (line.mnemonic.startsWith('J') || line.mnemonic.startsWith("LOOP"))) {
+            node.target = nodeAt.value(line.operands[0].value & 0xFFFF, -1);
+        }
+        if (callTargets.contains(node.address) && nodeAt.value(node.address) == k) node.entry = true;
+        if (node.next >= 0) nodes[node.next].predecessors.append(k);
+        if (node.target >= 0 && node.target != node.next) nodes[node.target].predecessors.append(k);
+    }
+
+    // Start over only where the code or its incoming edges changed, and everywhere that region can flow to.
+    QVector<Result> current(nodes.size());
+    QVector<bool> affected(nodes.size(), false);
+    QVector<int> pending;
+    for (int k = 0; k < nodes.size(); ++k) {
+        Node& node = nodes[k];
+        if (node.predecessors.isEmpty()) node.entry = true;
+        QStringList keys;
+        if (node.entry) keys.append(QStringLiteral("*"));
+        for (int predecessor : node.predecessors) {
+            keys.append(nodes[predecessor].key);
+        }
+        current[k].predecessors = keys.join('\n');
+
+        auto cached = results.constFind(node.key);
+        if (cached != results.constEnd() && cached->predecessors == current[k].predecessors) {
+            current[k] = *cached;
+        } else {
+            affected[k] = true;
+            pending.append(k);
+        }
+    }
+    while (!pending.isEmpty()) {
+        const Node& node = nodes[pending.takeLast()];
+        for (int successor : {node.next, node.target}) {
+            if (successor >= 0 && !affected[successor]) {
+                affected[successor] = true;
+                pending.append(successor);
+            }
+        }
+    }
+
+    QQueue<int> worklist;
+    QVector<bool> queued(nodes.size(), false);
+    QVector<int> visits(nodes.size(), 0);
+    for (int k = 0; k < nodes.size(); ++k) {
+        if (!affected[k]) continue;
+        const QString predecessors = current[k].predecessors;
+        current[k] = Result();
+        current[k].predecessors = predecessors;
+        worklist.enqueue(k);
+        queued[k] = true;
+    }
+    while (!worklist.isEmpty()) {
+        const int k = worklist.dequeue();
+        queued[k] = false;
+        const Node& node = nodes[k];
+
+        AbstractState in;
+        if (node.entry) in = unknownState();
+        for (int predecessor : node.predecessors) {
+            const Result& from = current[predecessor];
+            if ((nodes[predecessor].next == k && from.fallsThrough) || (nodes[predecessor].target == k && from.branches)) {
+                in.join(from.out);
+            }
+        }
+        // A loop that keeps refining the same line is cut short by giving up on everything it knew.
+        if (++visits[k] > MAX_VISITS && in.reached) in = unknownState();
+
+        Result& result = current[k];
+        AbstractState out = in;
+        bool fallsThrough = false;
+        bool branches = false;
+        if (in.reached) transfer(lines[node.line], node, out, fallsThrough, branches);
+        result.in = in;
+        if (out == result.out && fallsThrough == result.fallsThrough && branches == result.branches) continue;
+        result.out = out;
+        result.fallsThrough = fallsThrough;
+        result.branches = branches;
+        for (int successor : {node.next, node.target}) {
+            if (successor >= 0 && affected[successor] && !queued[successor]) {
+                worklist.enqueue(successor);
+                queued[successor] = true;
+            }
+        }
+    }
+
+    results.clear();
+    QVector<ValueHint> hints;
+    for (int k = 0; k < nodes.size(); ++k) {
+        Result& result = current[k];
+        const ScriptLine& line = lines[nodes[k].line];
+        if (affected[k] && result.in.reached) {
+            QString text = describeChanges(result.in, result.out);
+            if (isConditional(line.mnemonic) && nodes[k].target >= 0 && result.fallsThrough != result.branches) {
+                const QString decision = result.branches ? tr("always taken") : tr("never taken");
+                text = text.isEmpty() ? decision : text + "  " + decision;
+            }
+            result.hint = text;
+        } else if (affected[k]) {
+            result.hint.clear();
+        }
+        if (!result.hint.isEmpty()) hints.append({nodes[k].line, result.hint});
+        results.insert(nodes[k].key, result);
+    }
+    return hints;
+}
@@ -0,0 +1,65 @@
+#ifndef VALUEANALYZER_H
+#define VALUEANALYZER_H
+
+#include <QCoreApplication>
+#include <QString>
+#include <QVector>
+#include <QHash>
+#include <QMap>
+#include "scriptparser.h"
+#include "instructionencoder.h"
+
+struct ValueHint {
+    int line = 0;
+    QString text;
+};
+
+// A 16-bit value of which only the bits in `known` are determined.
+struct AbstractValue {
+    quint16 bits = 0;
+    quint16 known = 0;
+    bool isKnown(quint16 mask = 0xFFFF) const { return (known & mask) == mask; }
+    bool operator==(const AbstractValue& other) const { return known == other.known && bits == other.bits; }
+    bool operator!=(const AbstractValue& other) const { return !(*this == other); }
+};
+
+struct AbstractState {
+    static constexpr int REGISTER_COUNT = 8;
+    static constexpr int SEGMENT_COUNT = 4;
+
+    bool reached = false;
+    AbstractValue registers[REGISTER_COUNT];
+    AbstractValue segments[SEGMENT_COUNT];
+    int flags = 0;
+    int knownFlags = 0;
+    QMap<int, quint8> memory; // segment register << 16 | offset
+    QVector<AbstractValue> stack;
+
+    void join(const AbstractState& other);
+    bool operator==(const AbstractState& other) const;
+    bool operator!=(const AbstractState& other) const { return !(*this == other); }
+};
+
+class ValueAnalyzer {
+    Q_DECLARE_TR_FUNCTIONS(ValueAnalyzer)
+public:
+    // encodings may hold the lines already encoded by the caller, see InstructionEncoder::encode.
+    QVector<ValueHint> analyze(const QVector<ScriptLine>& lines, const QVector<LineEncoding>& encodings = QVector<LineEncoding>());
+private:
+    static constexpr int DEFAULT_ASSEMBLY_ADDRESS = 0x100;
+    static constexpr int MAX_VISITS = 32;
+
+    struct Result {
+        QString predecessors;
+        AbstractState in;
+        AbstractState out;
+        bool fallsThrough = false;
+        bool branches = false;
+        QString hint;
+    };
+
+    // Results of the previous run keyed by address and text, so an edit only re-analyses what it can reach.
+    QHash<QString, Result> results;
+};
+
+#endif // VALUEANALYZER_H